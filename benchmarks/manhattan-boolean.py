@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+# Copyright 2020 Lucas Heitzmann Gabrielli.
+# This file is part of gdstk, distributed under the terms of the
+# Boost Software License - Version 1.0.  See the accompanying
+# LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+
+import numpy
+import gdspy
+import gdstk
+
+# Two layers of overlapping wires and pads
+rng = numpy.random.default_rng(0)
+layers = []
+for _ in range(2):
+    corners = rng.uniform(0, 100, (1000, 2))
+    sizes = rng.uniform(0.1, 4, (1000, 2))
+    sizes[::2, 0] *= 0.1
+    sizes[1::2, 1] *= 0.1
+    layers.append([(tuple(c), tuple(c + s)) for c, s in zip(corners, sizes)])
+
+
+def bench_gdspy():
+    a = [gdspy.Rectangle(*r) for r in layers[0]]
+    b = [gdspy.Rectangle(*r) for r in layers[1]]
+    for operation in ["or", "and", "xor", "not"]:
+        gdspy.boolean(a, b, operation)
+
+
+def bench_gdstk():
+    a = [gdstk.rectangle(*r) for r in layers[0]]
+    b = [gdstk.rectangle(*r) for r in layers[1]]
+    for operation in ["or", "and", "xor", "not"]:
+        gdstk.boolean(a, b, operation, rectilinear=True)
+
+
+if __name__ == "__main__":
+    bench_gdspy()
+    bench_gdstk()
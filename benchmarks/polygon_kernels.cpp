@@ -0,0 +1,124 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Micro-benchmark for the vectorized polygon kernels: each kernel is timed
+// at every supported SimdLevel for polygons with 4, 100 and 10k vertices, and
+// the speedup relative to the scalar kernel is reported.  Build in release
+// mode (target polygon_kernels_benchmark) for meaningful numbers.
+
+#define __STDC_FORMAT_MACROS 1
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include <gdstk/gdstk.hpp>
+
+using namespace gdstk;
+
+// Keep the compiler from discarding the kernel results
+static volatile double sink;
+
+struct Benchmark {
+    const char* name;
+    double (*run)(const Polygon& polygon, const Array<Vec2>& queries);
+};
+
+static double bench_contain(const Polygon& polygon, const Array<Vec2>& queries) {
+    double result = 0;
+    for (uint64_t i = 0; i < queries.count; i++) result += polygon.contain(queries[i]) ? 1 : 0;
+    return result;
+}
+
+static double bench_area(const Polygon& polygon, const Array<Vec2>& queries) {
+    double result = 0;
+    for (uint64_t i = 0; i < queries.count; i++) result += polygon.signed_area();
+    return result;
+}
+
+static double bench_perimeter(const Polygon& polygon, const Array<Vec2>& queries) {
+    double result = 0;
+    for (uint64_t i = 0; i < queries.count; i++) result += polygon.perimeter();
+    return result;
+}
+
+static double bench_bounding_box(const Polygon& polygon, const Array<Vec2>& queries) {
+    double result = 0;
+    for (uint64_t i = 0; i < queries.count; i++) {
+        Vec2 min, max;
+        polygon.bounding_box(min, max);
+        result += max.x - min.x;
+    }
+    return result;
+}
+
+// Best time per call, in ns, out of a few repetitions
+static double time_benchmark(const Benchmark& benchmark, const Polygon& polygon,
+                             const Array<Vec2>& queries) {
+    double best = 1e300;
+    for (int repeat = 0; repeat < 5; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        sink = benchmark.run(polygon, queries);
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double, std::nano>(end - start).count() / queries.count;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    const char* level_names[] = {"Scalar", "AVX2", "AVX-512"};
+    const SimdLevel supported = simd_supported_level();
+    printf("Supported SIMD level: %s\n\n", level_names[(int)supported]);
+
+    const Benchmark benchmarks[] = {{"contain", bench_contain},
+                                    {"signed_area", bench_area},
+                                    {"perimeter", bench_perimeter},
+                                    {"bounding_box", bench_bounding_box}};
+    const uint64_t sizes[] = {4, 100, 10000};
+
+    printf("| Kernel       | Vertices |");
+    for (int level = 0; level <= (int)supported; level++) printf(" %9s (ns) |", level_names[level]);
+    printf(" Speedup |\n|:-------------|---------:|");
+    for (int level = 0; level <= (int)supported; level++) printf("---------------:|");
+    printf("--------:|\n");
+
+    for (uint64_t s = 0; s < COUNT(sizes); s++) {
+        const uint64_t size = sizes[s];
+        Polygon polygon = regular_polygon(Vec2{0, 0}, 1, size, 0, 0);
+
+        // Keep the total work roughly constant among sizes
+        Array<Vec2> queries = {};
+        const uint64_t count = 20000000 / (size + 16);
+        queries.ensure_slots(count);
+        Vec2 min, max;
+        polygon.bounding_box(min, max);
+        for (uint64_t i = 0; i < count; i++) {
+            const Vec2 t = {(double)i / count, (double)((i * 7919) % count) / count};
+            queries.append_unsafe(min + t * (max - min));
+        }
+
+        for (uint64_t b = 0; b < COUNT(benchmarks); b++) {
+            double scalar_time = 0;
+            double best_time = 0;
+            printf("| %-12s | %8" PRIu64 " |", benchmarks[b].name, size);
+            for (int level = 0; level <= (int)supported; level++) {
+                set_simd_level((SimdLevel)level);
+                best_time = time_benchmark(benchmarks[b], polygon, queries);
+                if (level == 0) scalar_time = best_time;
+                printf(" %14.3g |", best_time);
+            }
+            printf(" %7.2f |\n", scalar_time / best_time);
+        }
+        set_simd_level(supported);
+
+        queries.clear();
+        polygon.clear();
+    }
+    return 0;
+}
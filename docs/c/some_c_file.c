@@ -6,7 +6,7 @@
 
 int main() {
     GDSTK_ErrorCode err;
-    struct GDSTK_Library* lib = gdstk_read_gds("../../../../gds/oleg_full.gds", 1e-6, 1e-9, NULL, &err);
+    struct GDSTK_Library* lib = gdstk_read_gds("../../../../gds/oleg_full.gds", 1e-6, 1e-9, NULL, NULL, 0, 0, &err);
     struct GDSTK_Array cells = gdstk_array_create(0);
     struct GDSTK_Array raw_cells = gdstk_array_create(0);
     gdstk_library_get_top_level(lib, cells, raw_cells);
@@ -27,7 +27,7 @@ int main() {
     double value = gdstk_library_get_unit(lib);
 
     if (lib) {
-        gdstk_library_write_gds(lib, "output.gds", 1000, NULL);
+        gdstk_library_write_gds(lib, "output.gds", 1000, NULL, 0);
         gdstk_library_free(lib);
     }
     return 0;
@@ -1112,15 +1112,45 @@ void ClipperBase::Clear() {
     m_edges.clear();
     m_UseFullRange = false;
     m_HasOpenPaths = false;
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: See AddScanbeams
+    m_ExtraScanbeams.clear();
+    /////////////////////////////////////////////////////////////
 }
 //------------------------------------------------------------------------------
 
+////////////////// CAESAREALABS EDIT //////////////////////
+//////// REASON: See clipper.hpp
+void ClipperBase::GetScanbeams(std::vector<cInt>& ys) const {
+    // Every scanbeam comes from a local minimum or from the top of an edge in a bound
+    for (MinimaList::const_iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end(); ++lm) {
+        ys.push_back(lm->Y);
+        for (TEdge* e = lm->LeftBound; e; e = e->NextInLML) ys.push_back(e->Top.Y);
+        for (TEdge* e = lm->RightBound; e; e = e->NextInLML) ys.push_back(e->Top.Y);
+    }
+}
+//------------------------------------------------------------------------------
+
+void ClipperBase::AddScanbeams(const cInt* ys, size_t count) {
+    m_ExtraScanbeams.insert(m_ExtraScanbeams.end(), ys, ys + count);
+}
+/////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+
 void ClipperBase::Reset() {
     m_CurrentLM = m_MinimaList.begin();
     if (m_CurrentLM == m_MinimaList.end()) return;  // ie nothing to process
-    std::sort(m_MinimaList.begin(), m_MinimaList.end(), LocMinSorter());
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: Local minima at the same Y are processed in the order they were added, so
+    //////// the result for a group of paths does not depend on unrelated paths
+    std::stable_sort(m_MinimaList.begin(), m_MinimaList.end(), LocMinSorter());
+    /////////////////////////////////////////////////////////////
 
     m_Scanbeam = ScanbeamList();  // clears/resets priority_queue
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: See AddScanbeams
+    for (size_t i = 0; i < m_ExtraScanbeams.size(); ++i) InsertScanbeam(m_ExtraScanbeams[i]);
+    /////////////////////////////////////////////////////////////
     // reset all edges ...
     for (MinimaList::iterator lm = m_MinimaList.begin(); lm != m_MinimaList.end(); ++lm) {
         InsertScanbeam(lm->Y);
@@ -2609,7 +2639,10 @@ bool Clipper::FixupIntersectionOrder() {
     // Now it's crucial that intersections are made only between adjacent edges,
     // so to ensure this the order of intersections may need adjusting ...
     CopyAELToSEL();
-    std::sort(m_IntersectList.begin(), m_IntersectList.end(), IntersectListSort);
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: Same as the sorting of local minima in Reset
+    std::stable_sort(m_IntersectList.begin(), m_IntersectList.end(), IntersectListSort);
+    /////////////////////////////////////////////////////////////
     size_t cnt = m_IntersectList.size();
     for (size_t i = 0; i < cnt; ++i) {
         if (!EdgesAdjacent(*m_IntersectList[i])) {
@@ -3452,14 +3485,40 @@ void ClipperOffset::Execute(Paths& solution, double delta) {
 }
 //------------------------------------------------------------------------------
 
+////////////////// CAESAREALABS EDIT //////////////////////
+//////// REASON: See GetOffsetPaths and JoinOffsetPaths in clipper.hpp
 void ClipperOffset::Execute(PolyTree& solution, double delta) {
-    solution.Clear();
     FixOrientations();
     DoOffset(delta);
+    JoinOffsetPaths(m_destPolys, delta, solution, NULL, 0);
+}
+//------------------------------------------------------------------------------
 
+void ClipperOffset::GetOffsetPaths(Paths& paths, double delta, int orientation) {
+    if (orientation == 0) {
+        FixOrientations();
+    } else {
+        // as FixOrientations, with the given orientation for the lowermost path
+        for (int i = 0; i < m_polyNodes.ChildCount(); ++i) {
+            PolyNode& node = *m_polyNodes.Childs[i];
+            if ((node.m_endtype == etClosedPolygon && orientation < 0) ||
+                (node.m_endtype == etClosedLine && Orientation(node.Contour) == (orientation < 0)))
+                ReversePath(node.Contour);
+        }
+    }
+    DoOffset(delta);
+    paths.swap(m_destPolys);
+    m_destPolys.clear();
+}
+//------------------------------------------------------------------------------
+
+void ClipperOffset::JoinOffsetPaths(const Paths& paths, double delta, PolyTree& solution,
+                                    const cInt* scanbeams, size_t count) {
+    solution.Clear();
     // now clean up 'corners' ...
     Clipper clpr;
-    clpr.AddPaths(m_destPolys, ptSubject, true);
+    clpr.AddPaths(paths, ptSubject, true);
+    clpr.AddScanbeams(scanbeams, count);
     if (delta > 0) {
         clpr.Execute(ctUnion, solution, pftPositive, pftPositive);
     } else {
@@ -3485,6 +3544,7 @@ void ClipperOffset::Execute(PolyTree& solution, double delta) {
             solution.Clear();
     }
 }
+/////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
 
 void ClipperOffset::DoOffset(double delta) {
@@ -236,6 +236,14 @@ class ClipperBase {
     IntRect GetBounds();
     bool PreserveCollinear() { return m_PreserveCollinear; };
     void PreserveCollinear(bool value) { m_PreserveCollinear = value; };
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: Each band in gdstk::boolean_parallel must sweep the same scanbeams as a
+    //////// single operation over all bands to give identical results
+    // Y coordinates of the vertices of all paths added so far (unsorted, with repetitions)
+    void GetScanbeams(std::vector<cInt>& ys) const;
+    // Additional scanbeams processed during execution
+    void AddScanbeams(const cInt* ys, size_t count);
+    /////////////////////////////////////////////////////////////
 
    protected:
     void DisposeLocalMinimaList();
@@ -266,6 +274,10 @@ class ClipperBase {
 
     typedef std::priority_queue<cInt> ScanbeamList;
     ScanbeamList m_Scanbeam;
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: See AddScanbeams
+    std::vector<cInt> m_ExtraScanbeams;
+    /////////////////////////////////////////////////////////////
 };
 //------------------------------------------------------------------------------
 
@@ -366,6 +378,19 @@ class ClipperOffset {
     void AddPaths(const Paths& paths, JoinType joinType, EndType endType);
     void Execute(Paths& solution, double delta);
     void Execute(PolyTree& solution, double delta);
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: gdstk joins the offset paths with its rectilinear engine when possible, and
+    //////// each band in gdstk::offset_parallel must sweep the same scanbeams as a single
+    //////// offset over all bands (and orient their paths the same way) to give identical
+    //////// results
+    // Execute(solution, delta) in 2 steps: GetOffsetPaths replaces paths with the offset paths
+    // (before joining) and JoinOffsetPaths joins them, also processing the given additional
+    // scanbeams.  A non-zero orientation replaces the one from the path with the lowermost
+    // vertex, which decides whether all paths are reversed.
+    void GetOffsetPaths(Paths& paths, double delta, int orientation = 0);
+    static void JoinOffsetPaths(const Paths& paths, double delta, PolyTree& solution,
+                                const cInt* scanbeams, size_t count);
+    /////////////////////////////////////////////////////////////
     void Clear();
     double MiterLimit;
     double ArcTolerance;
@@ -48,13 +48,17 @@ class Cell:
         paths: bool = True,
         labels: bool = True,
     ) -> Self: ...
-    def flatten(self, apply_repetitions: bool = True) -> Self: ...
+    def flatten(
+        self, apply_repetitions: bool = True, parallel: bool = False, keep_repetitions: bool = False
+    ) -> Self: ...
+    def extract_repetitions(self, precision: float = 1e-3) -> Self: ...
     def get_labels(
         self,
         apply_repetitions: bool = True,
         depth: Optional[int] = None,
         layer: Optional[int] = None,
         texttype: Optional[int] = None,
+        tags: Optional[Iterable[tuple[int, int]]] = None,
     ) -> list[Label]: ...
     def get_paths(
         self,
@@ -62,6 +66,7 @@ class Cell:
         depth: Optional[int] = None,
         layer: Optional[int] = None,
         datatype: Optional[int] = None,
+        tags: Optional[Iterable[tuple[int, int]]] = None,
     ) -> list[RobustPath | FlexPath]: ...
     def get_polygons(
         self,
@@ -70,8 +75,21 @@ class Cell:
         depth: Optional[int] = None,
         layer: Optional[int] = None,
         datatype: Optional[int] = None,
+        tags: Optional[Iterable[tuple[int, int]]] = None,
+        parallel: bool = False,
+        keep_repetitions: bool = False,
     ) -> list[Polygon]: ...
     def get_property(self, name: str) -> Optional[list[list[str | bytes | float]]]: ...
+    def query_region(
+        self,
+        corner1: tuple[float, float] | complex,
+        corner2: tuple[float, float] | complex,
+        include_paths: bool = True,
+        depth: Optional[int] = None,
+        tags: Optional[Iterable[tuple[int, int]]] = None,
+        clip: bool = False,
+        precision: float = 1e-3,
+    ) -> list[Polygon]: ...
     def remove(self, *elements: Label | Polygon | RobustPath | FlexPath | Reference) -> Self: ...
     def set_property(
         self, name: str, value: str | bytes | float | Sequence[str | bytes | float]
@@ -428,11 +446,18 @@ class Library:
         self, name: str, value: str | bytes | float | Sequence[str | bytes | float]
     ) -> Self: ...
     def top_level(self) -> list[Cell | RawCell]: ...
+    def bounding_boxes(
+        self, parallel: bool = False
+    ) -> dict[str, Optional[tuple[tuple[float, float], tuple[float, float]]]]: ...
+    def convex_hulls(
+        self, parallel: bool = False
+    ) -> dict[str, numpy.ndarray[Any, numpy.dtype[numpy.float64]]]: ...
     def write_gds(
         self,
         outfile: str | pathlib.Path,
         max_points: int = 199,
         timestamp: Optional[datetime.datetime] = None,
+        extract_repetitions: bool = False,
     ) -> None: ...
     def write_oas(
         self,
@@ -443,6 +468,9 @@ class Library:
         circletolerance: float = 0,
         standard_properties: bool = False,
         validation: Optional[Literal["crc32", "checksum32"]] = None,
+        parallel: bool = False,
+        sort_by_tag: bool = False,
+        extract_repetitions: bool = False,
     ) -> None: ...
 
 class Polygon:
@@ -882,6 +910,8 @@ def boolean(
     precision: float = 1e-3,
     layer: int = 0,
     datatype: int = 0,
+    parallel: bool = False,
+    rectilinear: bool = False,
 ) -> list[Polygon]: ...
 def contour(
     data: ArrayLike, # type: ignore
@@ -919,6 +949,7 @@ def inside(
     | RobustPath
     | Reference
     | Sequence[Polygon | FlexPath | RobustPath | Reference],
+    parallel: bool = False,
 ) -> tuple[bool, ...]: ...
 def oas_precision(infile: str | pathlib.Path) -> float: ...
 def oas_validate(infile: str | pathlib.Path) -> tuple[bool, int]: ...
@@ -935,6 +966,8 @@ def offset(
     use_union: bool = False,
     layer: int = 0,
     datatype: int = 0,
+    parallel: bool = False,
+    rectilinear: bool = False,
 ) -> list[Polygon]: ...
 def racetrack(
     center: tuple[float, float] | complex,
@@ -951,8 +984,19 @@ def read_gds(
     unit: float = 0,
     tolerance: float = 0,
     filter: Optional[Iterable[tuple[int, int]]] = None,
+    cells: Optional[Iterable[str]] = None,
+    memory_map: bool = False,
+    parallel: bool = False,
+) -> Library: ...
+def read_oas(
+    infile: str | pathlib.Path,
+    unit: float = 0,
+    tolerance: float = 0,
+    filter: Optional[Iterable[tuple[int, int]]] = None,
+    label_filter: Optional[Iterable[tuple[int, int]]] = None,
+    cells: Optional[Iterable[str]] = None,
+    parallel: bool = False,
 ) -> Library: ...
-def read_oas(infile: str | pathlib.Path, unit: float = 0, tolerance: float = 0) -> Library: ...
 def read_rawcells(infile: str | pathlib.Path) -> dict[str, RawCell]: ...
 def rectangle(
     corner1: tuple[float, float] | complex,
@@ -30,6 +30,11 @@ typedef struct GDSTK_StyleMap GDSTK_StyleMap;
 GDSTK_API GDSTK_Cell* gdstk_cell_create(const char* name);
 GDSTK_API void gdstk_cell_free(GDSTK_Cell* cell);
 GDSTK_API void gdstk_cell_clear(GDSTK_Cell* cell);
+// Record that the cell contents changed, so that library geometry caches are
+// updated.  Needed only for elements modified in place: the functions that
+// add elements to the cell do it automatically.  Cells returned by
+// gdstk_library_get_cell are copies: use gdstk_library_mark_cell_modified.
+GDSTK_API void gdstk_cell_mark_modified(GDSTK_Cell* cell);
 
 // Basic properties
 GDSTK_API const char* gdstk_cell_get_name(const GDSTK_Cell* cell);
@@ -79,6 +84,55 @@ GDSTK_API void gdstk_cell_get_robustpaths(const GDSTK_Cell* cell, int apply_repe
 GDSTK_API void gdstk_cell_get_labels(const GDSTK_Cell* cell, int apply_repetitions, int64_t depth, 
                           int filter, Tag tag, struct GDSTK_Array result);
 
+// Multi-tag element retrieval: only elements with one of the tag_count tags
+// are included, in a single pass over the cell hierarchy.
+GDSTK_API void gdstk_cell_get_polygons_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                            int include_paths, int64_t depth, const Tag* tags,
+                            uint64_t tag_count, struct GDSTK_Array result);
+GDSTK_API void gdstk_cell_get_flexpaths_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                            int64_t depth, const Tag* tags, uint64_t tag_count,
+                            struct GDSTK_Array result);
+GDSTK_API void gdstk_cell_get_robustpaths_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                            int64_t depth, const Tag* tags, uint64_t tag_count,
+                            struct GDSTK_Array result);
+GDSTK_API void gdstk_cell_get_labels_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                            int64_t depth, const Tag* tags, uint64_t tag_count,
+                            struct GDSTK_Array result);
+// Same as gdstk_cell_get_polygons_by_tags, but the polygons are split by tag:
+// results must hold tag_count arrays and polygons with tags[i] are appended
+// to results[i].
+GDSTK_API void gdstk_cell_get_polygons_per_tag(const GDSTK_Cell* cell, int apply_repetitions,
+                            int include_paths, int64_t depth, const Tag* tags,
+                            uint64_t tag_count, struct GDSTK_Array* results);
+// Parallel version of gdstk_cell_get_polygons_by_tags using up to num_threads
+// threads (all hardware threads if zero).  If tags is NULL, no filtering is
+// applied.  The result is the same as from the sequential version.
+GDSTK_API void gdstk_cell_get_polygons_parallel(const GDSTK_Cell* cell, int apply_repetitions,
+                            int include_paths, int64_t depth, const Tag* tags,
+                            uint64_t tag_count, uint32_t num_threads, struct GDSTK_Array result);
+
+// Window query: polygons whose bounding boxes overlap the rectangle defined by
+// corner1 and corner2 are appended to result.  If tags is not NULL, only
+// polygons with one of the tag_count tags are included.  If clip is not zero,
+// the polygons are clipped to the rectangle on a grid with the given
+// precision.
+GDSTK_API void gdstk_cell_query_region(const GDSTK_Cell* cell, const GDSTK_Vec2* corner1,
+                            const GDSTK_Vec2* corner2, int include_paths, int64_t depth, const Tag* tags,
+                            uint64_t tag_count, int clip, double precision,
+                            struct GDSTK_Array result);
+
+// Streaming traversal: callback is called for every polygon in the hierarchy
+// without copying it.  Argument transform holds the accumulated affine
+// transformation {xx, xy, yx, yy, tx, ty}, mapping a polygon point (x, y) to
+// (xx * x + xy * y + tx, yx * x + yy * y + ty).  If transform_points is not
+// zero, points holds the count transformed vertices (in a buffer reused between
+// calls); otherwise it holds the original polygon vertices.
+typedef void (*GDSTK_PolygonVisitor)(const GDSTK_Polygon* polygon, const double* transform,
+                                     const GDSTK_Vec2* points, uint64_t count, void* data);
+GDSTK_API void gdstk_cell_visit_polygons(const GDSTK_Cell* cell, int apply_repetitions, int64_t depth,
+                              int filter, Tag tag, int transform_points,
+                              GDSTK_PolygonVisitor callback, void* data);
+
 // Dependency management
 GDSTK_API void gdstk_cell_get_dependencies(const GDSTK_Cell* cell, int recursive, GDSTK_Map_Cell* result);
 GDSTK_API void gdstk_cell_get_raw_dependencies(const GDSTK_Cell* cell, int recursive, GDSTK_Map_RawCell* result);
@@ -90,6 +144,8 @@ GDSTK_API void gdstk_cell_remap_tags(GDSTK_Cell* cell, const GDSTK_TagMap* map);
 
 // Cell operations
 GDSTK_API void gdstk_cell_flatten(GDSTK_Cell* cell, int apply_repetitions, struct GDSTK_Array removed_references);
+GDSTK_API void gdstk_cell_flatten_parallel(GDSTK_Cell* cell, int apply_repetitions,
+                            uint32_t num_threads, struct GDSTK_Array removed_references);
 
 // File output
 GDSTK_API int gdstk_cell_to_gds(const GDSTK_Cell* cell, FILE* out, double scaling, uint64_t max_points, 
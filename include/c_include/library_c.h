@@ -22,6 +22,7 @@ struct GDSTK_Property;
 struct GDSTK_TagSet;
 struct GDSTK_LibraryInfo;
 struct GDSTK_TagMap;
+struct GDSTK_Vec2;
 
 typedef enum  {
     GDSTK_NoError = 0,
@@ -45,6 +46,16 @@ typedef enum  {
     GDSTK_ZlibError,
 } GDSTK_ErrorCode;
 
+// Configuration flags for gdstk_read_gds
+#define GDSTK_GDSII_READ_CONFIG_MEMORY_MAP 0x0001
+#define GDSTK_GDSII_READ_CONFIG_PARALLEL 0x0002
+#define GDSTK_GDSII_READ_CONFIG_LAZY 0x0004
+
+// Configuration flags for gdstk_read_oas
+#define GDSTK_OASIS_READ_CONFIG_PARALLEL 0x0001
+
+// Configuration flags for gdstk_library_write_gds
+#define GDSTK_GDSII_CONFIG_EXTRACT_REPETITIONS 0x0001
 
 
 
@@ -59,7 +70,8 @@ GDSTK_API struct GDSTK_Cell* gdstk_library_get_cell(const struct GDSTK_Library*
 GDSTK_API struct GDSTK_RawCell* gdstk_library_get_rawcell(const struct GDSTK_Library* library, const char* name);
 
 GDSTK_API GDSTK_ErrorCode gdstk_library_write_gds(const struct GDSTK_Library* library, const char* filename,
-                                      uint64_t max_points, const struct tm* timestamp);
+                                      uint64_t max_points, const struct tm* timestamp,
+                                      uint16_t config_flags);
 GDSTK_API GDSTK_ErrorCode gdstk_library_write_oas(struct GDSTK_Library* library, const char* filename,
                                        double circle_tolerance, uint8_t deflate_level,
                                        uint16_t config_flags);
@@ -90,6 +102,20 @@ struct GDSTK_Array;  // Forward declaration
 GDSTK_API void gdstk_library_get_top_level(const struct GDSTK_Library* library,struct GDSTK_Array top_cells,
                                           struct GDSTK_Array top_rawcells);
 
+// Library geometry cache, updated incrementally for cells modified since the
+// last update (see gdstk_cell_mark_modified)
+GDSTK_API void gdstk_library_update_geometry_cache(struct GDSTK_Library* library, int convex_hulls,
+                                                  uint32_t num_threads);
+// Bounding box of a cell from the geometry cache.  Returns 0 if the cell is
+// not in the cache.  For empty cells, min.x > max.x.
+GDSTK_API int gdstk_library_get_cached_bounding_box(const struct GDSTK_Library* library,
+                                                   const char* name, struct GDSTK_Vec2* min,
+                                                   struct GDSTK_Vec2* max);
+// Mark a library cell as modified (see gdstk_cell_mark_modified).  Cells
+// returned by gdstk_library_get_cell are copies, so this must be used for
+// those.  Returns 0 if the cell is not found.
+GDSTK_API int gdstk_library_mark_cell_modified(struct GDSTK_Library* library, const char* name);
+
 // Cell replacement functions
 GDSTK_API void gdstk_library_replace_cell_with_cell(struct GDSTK_Library* library, struct GDSTK_Cell* old_cell,
                                                    struct GDSTK_Cell* new_cell);
@@ -122,9 +148,16 @@ GDSTK_API double gdstk_library_info_get_unit(const struct GDSTK_LibraryInfo* inf
 GDSTK_API double gdstk_library_info_get_precision(const struct GDSTK_LibraryInfo* info);
 
 // File I/O functions
+// If cell_names is not NULL, only those cell_name_count cells and their
+// dependencies are read.
 GDSTK_API struct GDSTK_Library* gdstk_read_gds(const char* filename, double unit, double tolerance,
-                             const struct GDSTK_TagSet* shape_tags, GDSTK_ErrorCode* error_code);
+                             const struct GDSTK_TagSet* shape_tags, const char* const* cell_names,
+                             uint64_t cell_name_count, uint16_t config_flags,
+                             GDSTK_ErrorCode* error_code);
 GDSTK_API struct GDSTK_Library* gdstk_read_oas(const char* filename, double unit, double tolerance,
+                             const struct GDSTK_TagSet* shape_tags,
+                             const struct GDSTK_TagSet* label_tags, const char* const* cell_names,
+                             uint64_t cell_name_count, uint16_t config_flags,
                              GDSTK_ErrorCode* error_code);
 GDSTK_API GDSTK_ErrorCode gdstk_gds_units(const char* filename, double* unit, double* precision);
 GDSTK_API GDSTK_ErrorCode gdstk_gds_info(const char* filename, struct GDSTK_LibraryInfo* info);
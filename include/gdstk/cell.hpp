@@ -23,23 +23,31 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "reference.hpp"
 #include "robustpath.hpp"
 #include "set.hpp"
+#include "spatialindex.hpp"
 #include "style.hpp"
 #include "tagmap.hpp"
 
 namespace gdstk {
 
+struct GdsiiLazySource;
+
 // Must return true if the first argument is ordered before (is less than) the
 // second argument.
 typedef bool (*PolygonComparisonFunction)(Polygon* const&, Polygon* const&);
 
 // This structure is used for caching bounding box and convex hull results from
 // cells.  This is a snapshot of the cells at a specific point in time.  It
-// must be invalidated whenever the cell contents changes.
+// must be invalidated whenever the cell contents changes (Library::geometry_info
+// does that automatically based on Cell::generation).
 struct GeometryInfo {
     Array<Vec2> convex_hull;
     Vec2 bounding_box_min;
     Vec2 bounding_box_max;
 
+    // Cell generation when this information was computed by
+    // Library::geometry_info (zero if computed elsewhere)
+    uint64_t generation;
+
     // These flags indicate whether the convex hull and bounding box values are
     // valid, even when convex_hull.count == 0 or bounding_box_min.x >
     // bounding_box_max.x (empty cell)
@@ -50,9 +58,87 @@ struct GeometryInfo {
         convex_hull.clear();
         convex_hull_valid = false;
         bounding_box_valid = false;
+        generation = 0;
+    }
+};
+
+// This structure is used for caching the flattened polygons of cells in
+// get_polygons, so that each cell is only flattened once, no matter how many
+// times it is referenced.  Polygons are stored in the coordinate system of
+// the cell, before the transformations of any references to it.  As with
+// GeometryInfo, the cache must be invalidated whenever the cell contents
+// changes, and it can only be shared between calls with the same
+// apply_repetitions, include_paths and tag filtering arguments.
+struct FlattenInfo {
+    Array<Polygon*> polygon_array;
+    // Depth used in get_polygons to create polygon_array
+    int64_t depth;
+    // Number of uses left, as counted by count_flatten_uses.  The entry is
+    // dropped after its last use, which takes the polygons instead of copying
+    // them, and cells used only once are never stored.  Zero means the
+    // uses are not counted, and the entry is kept until the cache is cleared.
+    uint64_t remaining;
+    bool valid;
+
+    void clear() {
+        for (uint64_t i = 0; i < polygon_array.count; i++) {
+            polygon_array[i]->clear();
+            free_allocation(polygon_array[i]);
+        }
+        polygon_array.clear();
+        valid = false;
     }
 };
 
+// Affine transformation accumulated through a cell hierarchy.  A point p is
+// mapped to {xx * p.x + xy * p.y + translation.x, yx * p.x + yy * p.y +
+// translation.y}.
+struct AffineTransform {
+    double xx, xy;
+    double yx, yy;
+    Vec2 translation;
+
+    Vec2 apply(const Vec2 p) const {
+        return Vec2{xx * p.x + xy * p.y + translation.x, yx * p.x + yy * p.y + translation.y};
+    }
+
+    // Transformation equivalent to applying inner first, then this one.
+    AffineTransform compose(const AffineTransform& inner) const {
+        return AffineTransform{xx * inner.xx + xy * inner.yx, xx * inner.xy + xy * inner.yy,
+                               yx * inner.xx + yy * inner.yx, yx * inner.xy + yy * inner.yy,
+                               apply(inner.translation)};
+    }
+};
+
+inline AffineTransform identity_transform() { return AffineTransform{1, 0, 0, 1, Vec2{0, 0}}; }
+
+// Same transformation as Polygon::transform with the same arguments.
+inline AffineTransform make_transform(double magnification, bool x_reflection, double rotation,
+                                      const Vec2 origin) {
+    const double r = x_reflection ? -magnification : magnification;
+    double ca, sa;
+    cos_sin(rotation, ca, sa);
+    return AffineTransform{magnification * ca, -r * sa, magnification * sa, r * ca, origin};
+}
+
+// Callbacks used by Cell::visit_shapes.  Any of them can be NULL to skip the
+// respective element kind.  The elements passed to the callbacks are the
+// originals from the cells in the hierarchy, in their own coordinate system,
+// and the transform maps them to the coordinate system of the visited cell.
+// If transform_points is true, the polygon callback receives the transformed
+// vertices in points (a scratch buffer reused between calls, valid only
+// during the callback); otherwise points is the original polygon's
+// point_array.  Data is passed unchanged to the callbacks.
+struct ShapeVisitor {
+    void (*polygon)(const Polygon& polygon, const AffineTransform& transform,
+                    const Array<Vec2>& points, void* data);
+    void (*flexpath)(const FlexPath& path, const AffineTransform& transform, void* data);
+    void (*robustpath)(const RobustPath& path, const AffineTransform& transform, void* data);
+    void (*label)(const Label& label, const AffineTransform& transform, void* data);
+    bool transform_points;
+    void* data;
+};
+
 struct Cell {
     // NULL-terminated string with cell name.  The GDSII specification allows
     // only ASCII-encoded strings.  The OASIS specification restricts the
@@ -73,6 +159,23 @@ struct Cell {
 
     Property* properties;
 
+    // Cells read with GDSII_READ_CONFIG_LAZY are not loaded in memory until
+    // used.  For those, lazy_source is not NULL and, while the cell is not
+    // loaded, its contents are found at lazy_offset in the source file, with
+    // lazy_size bytes.  After loading, lazy_size is zero.
+    GdsiiLazySource* lazy_source;
+    uint64_t lazy_offset;
+    uint64_t lazy_size;
+
+    // Spatial index over the cell elements, built on demand by
+    // get_spatial_index.  It should not be accessed directly.
+    SpatialIndex spatial_index;
+
+    // Modification counter, updated by mark_modified.  Values come from a
+    // global counter, so they are never shared by cells with different
+    // contents.  Zero means the cell was never marked.
+    uint64_t generation;
+
     // Used by the python interface to store the associated PyObject* (if any).
     // No functions in gdstk namespace should touch this value!
     void* owner;
@@ -83,6 +186,15 @@ struct Cell {
 
     void clear();
 
+    // Load the contents of a lazy cell from its source file.  All cell
+    // methods that need the cell contents (and Library::get_cell) do that
+    // automatically, but it must be called explicitly before accessing the
+    // element arrays of a lazy cell directly.  Nothing is done if the cell is
+    // not lazy or is already loaded.
+    ErrorCode load() const;
+
+    bool is_loaded() const { return lazy_source == NULL || lazy_size == 0; }
+
     void free_all() {
         for (uint64_t j = 0; j < polygon_array.count; j++) {
             polygon_array[j]->clear();
@@ -123,6 +235,39 @@ struct Cell {
     // Caching version of the convex hull calculation.
     GeometryInfo convex_hull(Map<GeometryInfo>& cache) const;
 
+    // Spatial index over the polygons, paths, labels and references of this
+    // cell (not the elements from referenced cells), with the bounding box of
+    // each element including its repetition.  Items refer to elements by
+    // their position in the respective array.  The index is built the first
+    // time it is requested and rebuilt when it is out of date (see
+    // has_spatial_index).  Building the index modifies the cell, so it must
+    // not be requested concurrently with any other use of the cell.  The
+    // caching version uses the cache for the bounding boxes of references, as
+    // in bounding_box.
+    const SpatialIndex& get_spatial_index();
+    const SpatialIndex& get_spatial_index(Map<GeometryInfo>& cache);
+
+    // Return true if the spatial index is built and up to date: the element
+    // counts of this cell are unchanged and neither this cell nor any of its
+    // dependencies was marked as modified (see mark_modified) after the index
+    // was built.  Modifications that are not marked must be followed by a
+    // call to invalidate_spatial_index.  Checking the dependencies walks the
+    // cell hierarchy; the second version memoizes the largest generation in
+    // the hierarchy of each visited cell in generations, by cell name, so
+    // that it can be reused in checks for other cells of the same hierarchy.
+    bool has_spatial_index() const;
+    bool has_spatial_index(Map<uint64_t>& generations) const;
+
+    void invalidate_spatial_index() { spatial_index.valid = false; }
+
+    // Record that the cell contents have changed by assigning a new
+    // generation to the cell and invalidating its spatial index (the indexes
+    // of cells that depend on it become out of date as well).  The Python and
+    // C interfaces call it from all functions that modify the cell.  C++ code
+    // must call it after adding, removing or modifying elements, so that the
+    // caches updated by Library::geometry_info are kept up to date.
+    void mark_modified();
+
     // This cell instance must be zeroed before copy_from.  If a new_name is
     // NULL, use the same name as the source cell.  If deep_copy == true, new
     // elements (polygons, paths, references, and labels) are allocated and
@@ -136,17 +281,103 @@ struct Cell {
     // included, depth == 1 includes polygons from referenced cells (with their
     // transformation properly applied), but not from references thereof, and
     // so on.  Depth < 0, removes the limit in the recursion depth.  If filter
-    // is true, only polygons with the indicated tag are appended.
+    // is true, only polygons with the indicated tag are appended.  In the
+    // forms with a tags argument, if tags is not NULL, only polygons with tags
+    // in that set are appended, so that any number of layers can be extracted
+    // in a single pass over the hierarchy.
     void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
                       Tag tag, Array<Polygon*>& result) const;
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, Array<Polygon*>& result) const;
+    // Caching versions of get_polygons.  The flattened polygons of referenced
+    // cells are taken from (or added to) cache (see FlattenInfo).  Internally,
+    // the non-caching versions simply call these with an empty cache.
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
+                      Tag tag, Map<FlattenInfo>& cache, Array<Polygon*>& result) const;
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                      Array<Polygon*>& result) const;
+    // Set FlattenInfo::remaining in cache for each cell flattened by the
+    // caching get_polygons (or get_polygons_with_repetitions) when called with
+    // depth, so that entries are only kept while they are still needed.
+    void count_flatten_uses(int64_t depth, Map<FlattenInfo>& cache) const;
+    // Parallel version of get_polygons using up to num_threads threads
+    // (hardware_thread_count() if zero).  Referenced cells are flattened
+    // bottom-up, with all cells at the same hierarchy level processed
+    // concurrently, and the transformed copies for each reference (and its
+    // repetition) are generated in parallel chunks.  The result is the same,
+    // in the same order, as with the sequential versions.
+    void get_polygons_parallel(bool apply_repetitions, bool include_paths, int64_t depth,
+                               const Set<Tag>* tags, uint32_t num_threads,
+                               Array<Polygon*>& result) const;
 
-    // Similar to get_polygons, but for paths and labels.
+    // Similar to get_polygons, but for paths and labels.  Paths are included
+    // with only their elements that pass the tag filter.
     void get_flexpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                        Array<FlexPath*>& result) const;
+    void get_flexpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                       Array<FlexPath*>& result) const;
     void get_robustpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                          Array<RobustPath*>& result) const;
+    void get_robustpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                         Array<RobustPath*>& result) const;
     void get_labels(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                     Array<Label*>& result) const;
+    void get_labels(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                    Array<Label*>& result) const;
+
+    // Similar to get_polygons, get_flexpaths, etc. with apply_repetitions ==
+    // false, but reference repetitions are also kept, composed with the
+    // repetitions of the referenced elements (see
+    // Reference::get_polygons_with_repetitions), so that arrays of references
+    // are not expanded into one element per copy.  The cache in the caching
+    // version must not be shared with get_polygons.
+    void get_polygons_with_repetitions(bool include_paths, int64_t depth, const Set<Tag>* tags,
+                                       Array<Polygon*>& result) const;
+    void get_polygons_with_repetitions(bool include_paths, int64_t depth, const Set<Tag>* tags,
+                                       Map<FlattenInfo>& cache, Array<Polygon*>& result) const;
+    void get_flexpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                        Array<FlexPath*>& result) const;
+    void get_robustpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                          Array<RobustPath*>& result) const;
+    void get_labels_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                     Array<Label*>& result) const;
+
+    // Append a (newly allocated) copy of the polygons in the cell hierarchy
+    // whose bounding boxes overlap the rectangle defined by corner1 and
+    // corner2.  Arguments include_paths, depth, and tags have the same
+    // meaning as in get_polygons.  References and repetition copies are only
+    // expanded when their bounding boxes overlap the region, so the cost
+    // depends on the size of the region, not on the whole hierarchy.  Cells
+    // with an up-to-date spatial index (see has_spatial_index) use it to find
+    // the elements in the region; out-of-date indexes are ignored, not
+    // rebuilt.  Repetitions are always applied.  If clip is true, the
+    // polygons that are not completely inside the region are intersected with
+    // it (see boolean) on a grid with the given precision.  Internally, this
+    // function simply calls the caching version with an empty cache.
+    void query_region(const Vec2 corner1, const Vec2 corner2, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, bool clip, double precision,
+                      Array<Polygon*>& result) const;
+    // Caching version of query_region.  Bounding boxes of referenced cells
+    // are taken from (or added to) cache (see GeometryInfo).
+    void query_region(const Vec2 corner1, const Vec2 corner2, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, bool clip, double precision,
+                      Map<GeometryInfo>& cache, Array<Polygon*>& result) const;
+
+    // Walk the cell hierarchy calling the visitor callbacks for every polygon,
+    // path, and label (in this order for each cell, before its references),
+    // with the same depth and filter semantics as get_polygons and friends
+    // (paths are visited if any of their elements passes the filter).  No
+    // elements are copied: the visitor receives the original elements and
+    // their accumulated transformation, which includes the repetitions from
+    // references.  If apply_repetitions is true, elements with repetitions
+    // are visited once per repetition offset (folded into the
+    // transformation); otherwise they are visited once, with their repetition
+    // untouched.
+    void visit_shapes(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
+                      const ShapeVisitor& visitor) const;
+    void visit_shapes(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                      const ShapeVisitor& visitor) const;
 
     // Insert all dependencies in result.  Dependencies are cells that appear
     // in this cell's references. If recursive, include the whole dependency
@@ -164,6 +395,26 @@ struct Cell {
     // cell (with the corresponding transformations).  Removed references are
     // appended to removed_references.
     void flatten(bool apply_repetitions, Array<Reference*>& removed_references);
+    // Parallel version of flatten: polygons are generated as in
+    // get_polygons_parallel.  The final cell contents are the same as with
+    // the sequential version.
+    void flatten_parallel(bool apply_repetitions, uint32_t num_threads,
+                          Array<Reference*>& removed_references);
+    // Version of flatten that keeps all repetitions, including the ones from
+    // references, in the inserted elements (see
+    // get_polygons_with_repetitions).
+    void flatten_with_repetitions(Array<Reference*>& removed_references);
+
+    // Fold polygons and references that only differ by a translation into
+    // repetitions.  Vertices and positions are compared on a grid with the
+    // given precision and only elements without repetition or properties are
+    // considered.  Copies on evenly spaced rows and columns are folded into
+    // rectangular repetitions; the remaining copies of an element are folded
+    // into a regular (when collinear and evenly spaced) or explicit
+    // repetition.  Folded elements are removed from the cell and appended to
+    // removed_polygons and removed_references.
+    void extract_repetitions(double precision, Array<Polygon*>& removed_polygons,
+                             Array<Reference*>& removed_references);
 
     // Change the tags of all elements in this cell.  Map keys are the current
     // tags and map values are the desired new tags.  Elements in references
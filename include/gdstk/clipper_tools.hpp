@@ -16,6 +16,9 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "array.hpp"
 #include "polygon.hpp"
 
+// Target number of polygons in each band of boolean_parallel and offset_parallel
+#define GDSTK_BOOLEAN_BAND_POLYGONS 2048
+
 namespace gdstk {
 
 enum struct Operation { Or, And, Xor, Not };
@@ -53,12 +56,43 @@ inline ErrorCode boolean(const Polygon& poly1, const Polygon& poly2, Operation o
     return boolean(polys1, polys2, operation, scaling, result);
 }
 
+// Same as boolean, but if all polygons are rectilinear in the integer grid, a
+// dedicated scanline engine is used instead of Clipper, which is considerably
+// faster.  The resulting region is the same, but not the polygons describing
+// it: their order and starting vertices differ, and polygons that Clipper
+// splits along shared edges (or leaves with zero-width spikes) are joined.
+ErrorCode boolean_rectilinear(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                              Operation operation, double scaling, Array<Polygon*>& result);
+
+// Parallel version of boolean for very large inputs.  Polygons (from both
+// operands) with overlapping or touching bounding boxes are grouped in
+// clusters, which cannot interact with each other.  Clusters are distributed
+// in horizontal bands and each band is processed by an independent Clipper
+// run, using up to num_threads threads (if zero, hardware_thread_count() is
+// used).  No polygon is cut at band boundaries, so there are no seams to
+// stitch, and each band also sweeps the scanbeams from the rest of the input
+// that cross its clusters, so the resulting polygons are identical to the ones
+// from boolean.  They are appended ordered by band.  Small inputs are passed
+// directly to boolean.  If rectilinear is true, bands are processed as in
+// boolean_rectilinear (and small inputs are passed to it).
+ErrorCode boolean_parallel(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                           Operation operation, double scaling, bool rectilinear,
+                           uint32_t num_threads, Array<Polygon*>& result);
+
 // Shorthand for joining a set of polygons
 inline ErrorCode merge(const Array<Polygon*>& polygons, double scaling, Array<Polygon*>& result) {
     const Array<Polygon*> empty = {};
     return boolean(polygons, empty, Operation::Or, scaling, result);
 }
 
+inline ErrorCode merge_parallel(const Array<Polygon*>& polygons, double scaling,
+                                bool rectilinear, uint32_t num_threads,
+                                Array<Polygon*>& result) {
+    const Array<Polygon*> empty = {};
+    return boolean_parallel(polygons, empty, Operation::Or, scaling, rectilinear, num_threads,
+                            result);
+}
+
 // Dilates or erodes polygons according to distance (negative distance results
 // in erosion).  The effects of internal polygon edges (in polygons with holes,
 // for example) can be suppressed by setting use_union to true.  Resulting
@@ -73,6 +107,26 @@ inline ErrorCode offset(const Polygon& poly, double distance, OffsetJoin join, d
     return offset(polys, distance, join, tolerance, scaling, use_union, result);
 }
 
+// Same as offset, but the union of rectilinear polygons (with use_union) and
+// the joining of rectilinear offset paths (usually the case with miter joins)
+// are done by the scanline engine from boolean_rectilinear, with the same
+// differences in the resulting polygons.
+ErrorCode offset_rectilinear(const Array<Polygon*>& polys, double distance, OffsetJoin join,
+                             double tolerance, double scaling, bool use_union,
+                             Array<Polygon*>& result);
+
+// Parallel version of offset for very large inputs, such as sizing a whole
+// layer.  Clusters are formed as in boolean_parallel, but with bounding boxes
+// expanded by a margin larger than the reach of the offset (which depends on
+// distance and, for miter joins, tolerance), so that the offset of each band
+// can be computed independently.  As in boolean_parallel, the result is
+// identical to the one from offset, appended ordered by band.  Small inputs
+// are passed directly to offset.  If rectilinear is true, bands are processed
+// as in offset_rectilinear (and small inputs are passed to it).
+ErrorCode offset_parallel(const Array<Polygon*>& polys, double distance, OffsetJoin join,
+                          double tolerance, double scaling, bool use_union, bool rectilinear,
+                          uint32_t num_threads, Array<Polygon*>& result);
+
 // Slice the given polygon along the coordinates in positions.  Positions must be sorted.  Cuts are
 // vertical (horizontal) when x_axis is set to true (false).  Argument result must be an array with
 // length at least positions.count + 1.  The resulting slices are appended to the arrays in their
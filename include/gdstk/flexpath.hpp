@@ -21,6 +21,7 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "property.hpp"
 #include "raithdata.hpp"
 #include "repetition.hpp"
+#include "set.hpp"
 #include "utils.hpp"
 
 namespace gdstk {
@@ -149,15 +150,21 @@ struct FlexPath {
     uint64_t commands(const CurveInstruction* items, uint64_t count);
 
     // Append the polygonal representation of this path to result.  If filter
-    // is true, only elements with the indicated tag are processed.
-    // Overlapping points are removed from the path before any processing is
-    // executed.
+    // is true, only elements with the indicated tag are processed.  In the
+    // second form, if tags is not NULL, only elements with tags in that set
+    // are processed.  Overlapping points are removed from the path before any
+    // processing is executed.
     ErrorCode to_polygons(bool filter, Tag tag, Array<Polygon*>& result);
+    ErrorCode to_polygons(const Set<Tag>* tags, Array<Polygon*>& result);
 
     // Calculate the center of an element of this path and append the resulting
     // curve to result.
     ErrorCode element_center(const FlexPathElement* el, Array<Vec2>& result);
 
+    // Remove spine points closer than the spine tolerance to their
+    // predecessors.  This is called by to_polygons and the output functions.
+    void remove_overlapping_points();
+
     // These functions output the polygon in the GDSII, OASIS and SVG formats.
     // They are not supposed to be called by the user.  Because fracturing
     // occurs at cell_to_gds, the polygons must be checked there and, if
@@ -169,7 +176,6 @@ struct FlexPath {
     ErrorCode to_svg(FILE* out, double scaling, uint32_t precision);
 
    private:
-    void remove_overlapping_points();
     void fill_offsets_and_widths(const double* width, const double* offset);
 };
 
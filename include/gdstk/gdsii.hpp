@@ -14,10 +14,21 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <stdint.h>
 #include <stdio.h>
 
+#include "map.hpp"
+#include "set.hpp"
 #include "utils.hpp"
+#include "vec.hpp"
 
 namespace gdstk {
 
+// Configuration flags for read_gds
+#define GDSII_READ_CONFIG_MEMORY_MAP 0x0001
+#define GDSII_READ_CONFIG_PARALLEL 0x0002
+#define GDSII_READ_CONFIG_LAZY 0x0004
+
+// Configuration flags for Library::write_gds
+#define GDSII_CONFIG_EXTRACT_REPETITIONS 0x0001
+
 enum struct GdsiiRecord : uint8_t {
     HEADER = 0X00,
     BGNLIB = 0X01,
@@ -102,6 +113,70 @@ double gdsii_real_to_double(uint64_t real);
 // (including header) is returned in buffer_count.
 ErrorCode gdsii_read_record(FILE* in, uint8_t* buffer, uint64_t& buffer_count);
 
+// Read-only memory mapping of a complete GDSII file.  Records can be parsed in
+// place with gdsii_next_record, avoiding the copies made by the stream reader.
+struct GdsiiMemoryMap {
+    const uint8_t* data;
+    uint64_t size;
+#ifdef _WIN32
+    void* mapping;
+#endif
+
+    // Map the whole contents of file in memory.  Return false if the file
+    // cannot be mapped (pipes or empty files, for example), in which case the
+    // caller should fall back to reading the stream with gdsii_read_record.
+    bool map(FILE* file);
+
+    void unmap();
+};
+
+// Find the record starting at data + position and advance position to the
+// next one.  The record (including header) is returned in place, in record,
+// without any byte swapping.  The record length (including header) is
+// returned in record_length.
+ErrorCode gdsii_next_record(const uint8_t* data, uint64_t size, uint64_t& position,
+                            const uint8_t*& record, uint64_t& record_length);
+
+// Convert count big-endian pairs of 4-byte signed integers from bytes
+// (usually the contents of an XY record) into points, scaled by factor.
+void gdsii_read_points(const uint8_t* bytes, uint64_t count, double factor, Vec2* result);
+
+struct Cell;
+
+// Source shared by all cells lazily read from a GDSII file (see
+// GDSII_READ_CONFIG_LAZY).  The file remains open (or mapped) while any of
+// those cells exist, which is controlled by reference counting.
+struct GdsiiLazySource {
+    FILE* file;
+    GdsiiMemoryMap memory_map;  // Used instead of file if memory_map.data is not NULL
+    uint64_t uses;
+    double tolerance;
+    double factor;
+    bool filter;
+    Set<Tag> shape_tags;
+    // Cells from this source by (original) name, used to resolve references
+    // when cells are loaded.
+    Map<Cell*> cell_map;
+    // Names of the cells referenced (SREF or AREF) by each structure, without
+    // repetition, indexed by the (original) structure name.  Dependencies of
+    // cells not yet loaded are found from these, so that Cell::get_dependencies
+    // and Library::top_level do not need to load any cells.
+    Map<Array<char*>> reference_names;
+};
+
+// Parse the contents of a lazy cell from its source.  Use Cell::load instead.
+ErrorCode gdsii_load_lazy_cell(Cell& cell);
+
+// Detach a cell from its lazy source, releasing the source if it is no
+// longer used.  This is called by Cell::clear.
+void gdsii_release_lazy_cell(Cell& cell);
+
+// Append to result the cells referenced by a lazy cell that is not loaded yet,
+// as recorded when the file was indexed.  Returns false if the cell was not
+// indexed (for example, if its name is repeated in the file), in which case it
+// must be loaded instead.  Use Cell::get_dependencies instead.
+bool gdsii_get_lazy_dependencies(const Cell& cell, Array<Cell*>& result);
+
 }  // namespace gdstk
 
 #endif
@@ -20,7 +20,9 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 // void* allocate_clear(uint64_t size);
 // void free_allocation(void* ptr);
 // They will be used throughout the library instead of malloc, realloc, calloc
-// and free.
+// and free.  Parallel operations (the *_CONFIG_PARALLEL flags and the
+// *_parallel functions) call them concurrently from worker threads, so they
+// must be thread-safe for those to be used.
 //
 // #define GDSTK_CUSTOM_ALLOCATOR
 
@@ -46,7 +48,9 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "repetition.hpp"
 #include "robustpath.hpp"
 #include "set.hpp"
+#include "simd.hpp"
 #include "sort.hpp"
+#include "spatialindex.hpp"
 #include "style.hpp"
 #include "utils.hpp"
 #include "vec.hpp"
@@ -39,6 +39,10 @@ struct Library {
 
     Property* properties;
 
+    // Bounding boxes and convex hulls of the library cells, kept up to date
+    // incrementally by update_geometry_cache.
+    Map<GeometryInfo> geometry_cache;
+
     // Used by the python interface to store the associated PyObject* (if any).
     // No functions in gdstk namespace should touch this value!
     void* owner;
@@ -57,6 +61,11 @@ struct Library {
         cell_array.clear();
         rawcell_array.clear();
         properties_clear(properties);
+        for (MapItem<GeometryInfo>* item = geometry_cache.next(NULL); item;
+             item = geometry_cache.next(item)) {
+            item->value.clear();
+        }
+        geometry_cache.clear();
     }
 
     // Clear and free the memory of the whole library (this should be used with
@@ -86,10 +95,33 @@ struct Library {
     // cells in the library.
     void top_level(Array<Cell*>& top_cells, Array<RawCell*>& top_rawcells) const;
 
-    // Find cell or rawcell by name. Return NULL if not found.
+    // Compute the bounding boxes of all cells in the library (and their
+    // dependencies) into cache, which can be reused by any later query that
+    // takes a Map<GeometryInfo> (see GeometryInfo).  If convex_hulls is true,
+    // the convex hulls of all cells are computed as well; otherwise only the
+    // ones required by references with arbitrary rotations.  The cell
+    // dependency graph is processed level by level from the bottom up, with
+    // the cells in each level distributed among num_threads threads (if zero,
+    // hardware_thread_count() is used).  The cache can be kept between calls:
+    // entries are only recomputed for cells modified since the previous call
+    // (see Cell::mark_modified) and their ancestors.  Cells with zero
+    // generation are marked as modified.  The caller is responsible for
+    // clearing the cache entries and the cache itself.
+    void geometry_info(bool convex_hulls, uint32_t num_threads, Map<GeometryInfo>& cache) const;
+
+    // Update geometry_cache with geometry_info.
+    void update_geometry_cache(bool convex_hulls, uint32_t num_threads) {
+        geometry_info(convex_hulls, num_threads, geometry_cache);
+    }
+
+    // Find cell or rawcell by name. Return NULL if not found.  Lazy cells
+    // (see GDSII_READ_CONFIG_LAZY) are loaded by get_cell.
     Cell* get_cell(const char* name) const;
     RawCell* get_rawcell(const char* name) const;
 
+    // Load all lazy cells in the library (see Cell::load).
+    ErrorCode load_all() const;
+
     // Rename a cell in the library, updating any references that use the old
     // name with the new one.  Note: these assume cell names are dynamically
     // allocated in cells and references throughout the library.
@@ -113,8 +145,14 @@ struct Library {
     // Output this library to a GDSII file.  All polygons are fractured to
     // max_points before saving (but the originals are kept) if max_points > 4.
     // GDSII files include a timestamp, which can be specified by the caller or
-    // left NULL, in which case the current time will be used.
+    // left NULL, in which case the current time will be used.  Argument
+    // config_flags can be any combination of the GDSII_CONFIG_* flags defined
+    // in gdsii.hpp.  With GDSII_CONFIG_EXTRACT_REPETITIONS, references that
+    // only differ by their origin are written as arrays (see
+    // Cell::extract_repetitions); the cells themselves are not modified.
     ErrorCode write_gds(const char* filename, uint64_t max_points, tm* timestamp) const;
+    ErrorCode write_gds(const char* filename, uint64_t max_points, tm* timestamp,
+                        uint16_t config_flags) const;
 
     // Output this library to an OASIS file.  The OASIS specification includes
     // support for a few special shapes, which can significantly decrease the
@@ -122,7 +160,16 @@ struct Library {
     // Rectangles and trapezoids are enabled via config_flags.  Further size
     // reduction can be achieved by setting deflate_level > 0 (up to 9, for
     // maximal compression).  Finally, config_flags is a bit-field value
-    // obtained by or-ing OASIS_CONFIG_* constants, defined in oasis.h
+    // obtained by or-ing OASIS_CONFIG_* constants, defined in oasis.h.  With
+    // OASIS_CONFIG_PARALLEL, cells are encoded and compressed on all available
+    // hardware threads; the resulting file is identical to the sequential one.
+    // Values repeated between consecutive records are always omitted through
+    // the OASIS modal variables.  With OASIS_CONFIG_SORT_BY_TAG, polygons and
+    // labels are grouped by tag within each cell to improve that reuse (which
+    // changes the order in which they are read back).  With
+    // OASIS_CONFIG_EXTRACT_REPETITIONS, polygons and references are folded
+    // into repetitions before being written (see Cell::extract_repetitions),
+    // without modifying the cells.
     ErrorCode write_oas(const char* filename, double circle_tolerance, uint8_t deflate_level,
                         uint16_t config_flags);
 };
@@ -161,20 +208,44 @@ struct LibraryInfo {
 // the units in the file are converted (all elements are properly scaled to the
 // desired unit).  The value of tolerance is used as the default tolerance for
 // paths in the library.  If shape_tags is not empty, only shapes in those
-// tags will be imported.  If not NULL, any errors will be reported through
-// error_code.
+// tags will be imported.  If cell_names is not NULL, only the named cells and
+// their dependencies are imported; the remaining structures are indexed but
+// never parsed.  Argument config_flags can be any combination of the
+// GDSII_READ_CONFIG_* flags defined in gdsii.hpp.  With
+// GDSII_READ_CONFIG_MEMORY_MAP, the file is memory-mapped and parsed in place
+// (if the file cannot be mapped, e.g. a pipe, it is read as a stream).  With
+// GDSII_READ_CONFIG_PARALLEL, the memory-mapped file is first scanned for
+// structure boundaries, then the structures are parsed into cells on all
+// available hardware threads (with GDSTK_CUSTOM_ALLOCATOR, the allocation
+// functions must be thread-safe).  Cells are always in file order.  With
+// GDSII_READ_CONFIG_LAZY, only the cell names and the location of their
+// contents in the file are read; each cell is parsed when first used (see
+// Cell::load), so the file remains open while there are lazy cells.  If not
+// NULL, any errors will be reported through error_code.
 Library read_gds(const char* filename, double unit, double tolerance, const Set<Tag>* shape_tags,
+                 const Array<const char*>* cell_names, uint16_t config_flags,
                  ErrorCode* error_code);
 
 // Read the contents of an OASIS file into a new library.  If unit is not zero,
 // the units in the file are converted (all elements are properly scaled to the
 // desired unit).  The value of tolerance is used as the default tolerance for
 // paths in the library and for the creation of circles.  If shape_tags is not
-// empty, only shapes in those tags will be imported.  If not NULL, any errors
-// will be reported through error_code.
-Library read_oas(const char* filename, double unit,
-                 double tolerance,  // TODO: const Set<Tag>* shape_tags,
-                 ErrorCode* error_code);
+// NULL, only shapes in those tags will be imported; the remaining shape
+// records are decoded only as far as needed to keep the modal variables
+// updated.  Likewise, if label_tags is not NULL, only labels with those tags
+// (layer and text type) are imported.  If cell_names is not NULL, only the
+// named cells and their dependencies are kept in the library.  In that case,
+// if the file has strict name tables and S_CELL_OFFSET properties (see
+// OASIS_CONFIG_PROPERTY_CELL_OFFSET), only the name tables and the required
+// cells are read from the file.  Argument config_flags can be any combination
+// of the OASIS_READ_CONFIG_* flags defined in oasis.hpp.  With
+// OASIS_READ_CONFIG_PARALLEL, consecutive CBLOCK records are located ahead of
+// the parser and decompressed on all available hardware threads (up to
+// GDSTK_OASIS_PREFETCH_SIZE bytes at a time).  If not NULL, any errors will be
+// reported through error_code.
+Library read_oas(const char* filename, double unit, double tolerance, const Set<Tag>* shape_tags,
+                 const Set<Tag>* label_tags, const Array<const char*>* cell_names,
+                 uint16_t config_flags, ErrorCode* error_code);
 
 // Read the unit and precision of a GDSII file and return in the respective
 // arguments.
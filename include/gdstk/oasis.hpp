@@ -33,11 +33,24 @@ namespace gdstk {
 #define OASIS_CONFIG_INCLUDE_CRC32 0x0040
 #define OASIS_CONFIG_INCLUDE_CHECKSUM32 0x0080
 
+#define OASIS_CONFIG_PARALLEL 0x0100
+
+#define OASIS_CONFIG_SORT_BY_TAG 0x0200
+
+#define OASIS_CONFIG_EXTRACT_REPETITIONS 0x0400
+
 #define OASIS_CONFIG_STANDARD_PROPERTIES                                  \
     (OASIS_CONFIG_PROPERTY_MAX_COUNTS | OASIS_CONFIG_PROPERTY_TOP_LEVEL | \
      OASIS_CONFIG_PROPERTY_BOUNDING_BOX | OASIS_CONFIG_PROPERTY_CELL_OFFSET)
 #define OASIS_CONFIG_DETECT_ALL (OASIS_CONFIG_DETECT_RECTANGLES | OASIS_CONFIG_DETECT_TRAPEZOIDS)
 
+// Configuration flags for read_oas
+#define OASIS_READ_CONFIG_PARALLEL 0x0001
+
+// Maximal amount of uncompressed data inflated ahead of the parser when
+// reading with OASIS_READ_CONFIG_PARALLEL
+#define GDSTK_OASIS_PREFETCH_SIZE (64 * 1024 * 1024)
+
 // Types and functions in this header are not meant to be used by the end user
 // of the library.  They are for internal use only.
 
@@ -156,12 +169,96 @@ struct OasisStream {
     ErrorCode error_code;
 };
 
+// Modal variables used by the OASIS writer to omit record fields that repeat
+// the previous value.  They are reset at the start of each cell.  Point lists
+// and repetitions are stored in their encoded form (empty if undefined).
+struct OasisModal {
+    bool layer_defined;
+    bool datatype_defined;
+    bool textlayer_defined;
+    bool texttype_defined;
+    bool text_string_defined;
+    bool placement_cell_defined;
+    bool geometry_w_defined;
+    bool geometry_h_defined;
+    bool path_halfwidth_defined;
+    bool path_extensions_defined;
+    bool circle_radius_defined;
+    bool ctrapezoid_type_defined;
+    uint32_t layer;
+    uint32_t datatype;
+    uint32_t textlayer;
+    uint32_t texttype;
+    uint64_t text_string;
+    uint64_t placement_cell;
+    uint64_t geometry_w;
+    uint64_t geometry_h;
+    uint64_t path_halfwidth;
+    int64_t path_start_extension;
+    int64_t path_end_extension;
+    uint64_t circle_radius;
+    uint8_t ctrapezoid_type;
+    IntVec2 placement_position;
+    IntVec2 geometry_position;
+    IntVec2 text_position;
+    Array<uint8_t> polygon_point_list;
+    Array<uint8_t> path_point_list;
+    Array<uint8_t> repetition;
+    Array<uint8_t> buffer;  // scratch space for encoding
+
+    void reset() {
+        layer_defined = false;
+        datatype_defined = false;
+        textlayer_defined = false;
+        texttype_defined = false;
+        text_string_defined = false;
+        placement_cell_defined = false;
+        geometry_w_defined = false;
+        geometry_h_defined = false;
+        path_halfwidth_defined = false;
+        path_extensions_defined = false;
+        circle_radius_defined = false;
+        ctrapezoid_type_defined = false;
+        placement_position = IntVec2{0, 0};
+        geometry_position = IntVec2{0, 0};
+        text_position = IntVec2{0, 0};
+        polygon_point_list.count = 0;
+        path_point_list.count = 0;
+        repetition.count = 0;
+    }
+
+    void clear() {
+        polygon_point_list.clear();
+        path_point_list.clear();
+        repetition.clear();
+        buffer.clear();
+    }
+};
+
+// Update a modal variable, returning true if the value must be written to the
+// file, i.e., if it is undefined or different from value.
+template <class T>
+inline bool oasis_modal_update(bool& defined, T& variable, T value) {
+    if (defined && variable == value) return false;
+    defined = true;
+    variable = value;
+    return true;
+}
+
+// Info bits (X = 0x10 and Y = 0x08) for the coordinates of position that
+// differ from the modal ones
+inline uint8_t oasis_position_info(const IntVec2 modal_position, const IntVec2 position) {
+    return (position.x != modal_position.x ? 0x10 : 0) |
+           (position.y != modal_position.y ? 0x08 : 0);
+}
+
 struct OasisState {
     double scaling;
     double circle_tolerance;
     Map<uint64_t> property_name_map;
     Array<PropertyValue*> property_value_array;
     uint16_t config_flags;
+    OasisModal modal;
 };
 
 ErrorCode oasis_read(void* buffer, size_t size, size_t count, OasisStream& in);
@@ -225,6 +322,23 @@ void oasis_write_point_list(OasisStream& out, const Array<Vec2> points, double s
 // This should only be called with repetition.get_count() > 1
 void oasis_write_repetition(OasisStream& out, const Repetition repetition, double scaling);
 
+// Same as above, but a reference to the modal repetition is written instead,
+// if they are equal.
+void oasis_write_repetition(OasisStream& out, const Repetition repetition, double scaling,
+                            OasisModal& modal);
+
+// Encode the point list into the modal polygon point list (if closed) or path
+// point list (otherwise).  Return true if the list has changed, in which case
+// the encoded list must be written to the file.  Points are modified as in
+// oasis_write_point_list.
+bool oasis_update_point_list(OasisModal& modal, Array<IntVec2>& points, bool closed);
+
+// Write a PATH record (without properties) using the modal variables in
+// state.  The path points are scaled by state.scaling.
+void oasis_write_path(OasisStream& out, OasisState& state, Tag tag, uint64_t half_width,
+                      int64_t start_extension, int64_t end_extension, const Array<Vec2> points,
+                      const Repetition& repetition);
+
 }  // namespace gdstk
 
 #endif
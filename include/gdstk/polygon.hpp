@@ -18,9 +18,18 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "oasis.hpp"
 #include "property.hpp"
 #include "repetition.hpp"
+#include "spatialindex.hpp"
 #include "utils.hpp"
 #include "vec.hpp"
 
+// Polygons with at least this many vertices have their edges bucketed in
+// horizontal slabs by PolygonIndex
+#define GDSTK_POLYGON_INDEX_BUCKET_THRESHOLD 64
+
+// Minimal number of points for which inside, all_inside and any_inside build a
+// PolygonIndex instead of testing each point against every polygon
+#define GDSTK_POLYGON_INDEX_MIN_POINTS 8
+
 namespace gdstk {
 
 struct Polygon {
@@ -128,10 +137,59 @@ void text(const char* s, double size, const Vec2 position, bool vertical, Tag ta
 ErrorCode contour(const double* data, uint64_t rows, uint64_t cols, double level, double scaling,
                   Array<Polygon*>& result);
 
+// Edges of a single polygon grouped in horizontal slabs of equal height.  The
+// edges that intersect slab i (edge j goes from point j - 1 to point j) are
+// edge_array[offset_array[i]] to edge_array[offset_array[i + 1] - 1].
+struct PolygonEdgeBuckets {
+    double y0;
+    double inv_height;
+    Array<uint64_t> offset_array;
+    Array<uint64_t> edge_array;
+
+    void clear() {
+        offset_array.clear();
+        edge_array.clear();
+    }
+};
+
+// Point location structure over a fixed set of polygons.  Polygon bounding
+// boxes are stored in a SpatialIndex, so that each point is only tested
+// against the polygons that might contain it, and polygons with at least
+// GDSTK_POLYGON_INDEX_BUCKET_THRESHOLD vertices have their edges bucketed, so
+// that only the edges in the slab of the point are visited.  Polygon
+// repetitions are ignored, as in Polygon::contain.  The polygons are not
+// owned by the index and must not be modified while it is in use; the index
+// must be rebuilt when they change.  Queries are const and can run
+// concurrently.
+struct PolygonIndex {
+    Array<Polygon*> polygon_array;
+    // Same count as polygon_array.  Empty buckets (no offsets) for polygons
+    // below the vertex threshold.
+    Array<PolygonEdgeBuckets> bucket_array;
+    SpatialIndex spatial_index;
+
+    void clear();
+
+    void build(const Array<Polygon*>& polygons);
+
+    // Equivalent to testing contain on each of the indexed polygons.
+    bool contain(const Vec2 point) const;
+
+    // Test all points, writing the results to result (with size for at least
+    // points.count bools).  Points are divided among up to num_threads
+    // threads.  If num_threads is zero, hardware_thread_count() is used.
+    void contain(const Array<Vec2>& points, uint32_t num_threads, bool* result) const;
+};
+
 // Check if the points are inside a set of polygons (points lying on the edges
 // or coinciding with a vertex of the polygons are considered inside).  Result
-// must be an array with size for at least points.count bools.
+// must be an array with size for at least points.count bools.  For more than
+// GDSTK_POLYGON_INDEX_MIN_POINTS points, a PolygonIndex is used.  The overload
+// with num_threads divides the points among threads, as in
+// PolygonIndex::contain.
 void inside(const Array<Vec2>& points, const Array<Polygon*>& polygons, bool* result);
+void inside(const Array<Vec2>& points, const Array<Polygon*>& polygons, uint32_t num_threads,
+            bool* result);
 bool all_inside(const Array<Vec2>& points, const Array<Polygon*>& polygons);
 bool any_inside(const Array<Vec2>& points, const Array<Polygon*>& polygons);
 
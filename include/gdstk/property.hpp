@@ -88,6 +88,10 @@ PropertyValue* get_gds_property(Property* properties, uint16_t attribute);
 ErrorCode properties_to_gds(const Property* properties, FILE* out);
 ErrorCode properties_to_oas(const Property* properties, OasisStream& out, OasisState& state);
 
+// Add the property names and string values to the OASIS tables in state, in the
+// same order used by properties_to_oas, without writing anything.
+void properties_register_oas(const Property* properties, OasisState& state);
+
 }  // namespace gdstk
 
 #endif
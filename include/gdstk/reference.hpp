@@ -26,6 +26,7 @@ namespace gdstk {
 struct Cell;
 struct RawCell;
 struct GeometryInfo;
+struct FlattenInfo;
 
 enum struct ReferenceType { Cell = 0, RawCell, Name };
 
@@ -104,15 +105,51 @@ struct Reference {
     // negative, all levels are included.  If include_paths is true, the
     // polygonal representation of paths are also included in polygons.  If
     // filter is true, only polygons in the indicated layer and data type are
-    // created.
+    // created.  In the forms with a tags argument, if tags is not NULL, only
+    // elements with tags in that set are created.
     void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
                       Tag tag, Array<Polygon*>& result) const;
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, Array<Polygon*>& result) const;
+    // Caching versions of get_polygons: the flattened polygons of the
+    // referenced cell are computed only once and kept in cache (see
+    // Cell::get_polygons).
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
+                      Tag tag, Map<FlattenInfo>& cache, Array<Polygon*>& result) const;
+    void get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                      const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                      Array<Polygon*>& result) const;
+    // Same as Cell::count_flatten_uses for the uses by this reference
+    void count_flatten_uses(int64_t depth, Map<FlattenInfo>& cache) const;
     void get_flexpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                        Array<FlexPath*>& result) const;
+    void get_flexpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                       Array<FlexPath*>& result) const;
     void get_robustpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                          Array<RobustPath*>& result) const;
+    void get_robustpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                         Array<RobustPath*>& result) const;
     void get_labels(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                     Array<Label*>& result) const;
+    void get_labels(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                    Array<Label*>& result) const;
+
+    // Similar to the functions above with apply_repetitions == false, but the
+    // repetition of this reference is not expanded either.  Created elements
+    // carry a repetition composed from their own (transformed) repetition
+    // and the reference repetition: when both exist, the one with fewer
+    // copies is expanded and the other is kept.  The cache in the caching
+    // version must not be shared with get_polygons.
+    void get_polygons_with_repetitions(bool include_paths, int64_t depth, const Set<Tag>* tags,
+                                       Array<Polygon*>& result) const;
+    void get_polygons_with_repetitions(bool include_paths, int64_t depth, const Set<Tag>* tags,
+                                       Map<FlattenInfo>& cache, Array<Polygon*>& result) const;
+    void get_flexpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                        Array<FlexPath*>& result) const;
+    void get_robustpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                          Array<RobustPath*>& result) const;
+    void get_labels_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                     Array<Label*>& result) const;
 
     // These functions output the reference in the GDSII and SVG formats.  They
     // are not supposed to be called by the user.
@@ -21,6 +21,7 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include "polygon.hpp"
 #include "property.hpp"
 #include "repetition.hpp"
+#include "set.hpp"
 #include "utils.hpp"
 
 namespace gdstk {
@@ -263,10 +264,12 @@ struct RobustPath {
     ErrorCode element_center(const RobustPathElement* el, Array<Vec2>& result) const;
 
     // Append the polygonal representation of this path to result.  If filter
-    // is true, only elements with the indicated tag are processed.
-    // Overlapping points are removed from the path before any processing is
-    // executed.
+    // is true, only elements with the indicated tag are processed.  In the
+    // second form, if tags is not NULL, only elements with tags in that set
+    // are processed.  Overlapping points are removed from the path before any
+    // processing is executed.
     ErrorCode to_polygons(bool filter, Tag tag, Array<Polygon*>& result) const;
+    ErrorCode to_polygons(const Set<Tag>* tags, Array<Polygon*>& result) const;
 
     // These functions output the polygon in the GDSII, OASIS and SVG formats.
     // They are not supposed to be called by the user.  Because fracturing
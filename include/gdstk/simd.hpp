@@ -0,0 +1,96 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+#ifndef GDSTK_HEADER_SIMD
+#define GDSTK_HEADER_SIMD
+
+#define __STDC_FORMAT_MACROS 1
+#define _USE_MATH_DEFINES
+
+#include <stdint.h>
+
+#include "vec.hpp"
+
+namespace gdstk {
+
+// Instruction sets used by the vectorized point array kernels below.  The
+// best level supported by the processor is selected at runtime, so the
+// library does not have to be compiled for a specific target.  Builds for
+// other architectures (or compilers without support for target-specific
+// functions) only use the portable Scalar kernels.
+enum struct SimdLevel { Scalar = 0, AVX2, AVX512 };
+
+// Best level supported by both the build and the processor.
+SimdLevel simd_supported_level();
+
+// Level currently used by the kernels.  It defaults to the supported level
+// and can be lowered (for testing or benchmarking) with set_simd_level.
+// Levels above the supported one are clamped.
+SimdLevel simd_level();
+void set_simd_level(SimdLevel level);
+
+// Cross product (p0 - point) × (p1 - point).  Its sign decides the
+// containment of points close to the edge, so it is computed out of line,
+// without contracting the products into fused multiply-adds, to give the
+// same result in every kernel (regardless of the instructions available to
+// the caller).
+double edge_determinant(const Vec2 p0, const Vec2 p1, const Vec2 point);
+
+// Winding number contribution of the edge from p0 to p1 around point,
+// accumulated in winding.  Returns false if the point lies on the edge (or on
+// vertex p1).
+//
+// Based on algorithm 7 from: Kai Hormann, Alexander Agathos, “The point in
+// polygon problem for arbitrary polygons,” Computational Geometry, Volume 20,
+// Issue 3, 2001, Pages 131-144, ISSN 0925-7721.
+// https://doi.org/10.1016/S0925-7721(01)00012-8
+inline bool edge_winding(const Vec2 p0, const Vec2 p1, const Vec2 point, int64_t& winding) {
+    if (p1.y == point.y &&
+        (p1.x == point.x || (p0.y == point.y && (p1.x > point.x) == (p0.x < point.x)))) {
+        return false;
+    }
+    if ((p0.y < point.y) != (p1.y < point.y)) {
+        if (p0.x >= point.x) {
+            if (p1.x > point.x) {
+                winding += p1.y > p0.y ? 1 : -1;
+            } else {
+                double det = edge_determinant(p0, p1, point);
+                if (det == 0) {
+                    return false;
+                }
+                if ((det > 0) == (p1.y > p0.y)) {
+                    winding += p1.y > p0.y ? 1 : -1;
+                }
+            }
+        } else if (p1.x > point.x) {
+            double det = edge_determinant(p0, p1, point);
+            if (det == 0) {
+                return false;
+            }
+            if ((det > 0) == (p1.y > p0.y)) {
+                winding += p1.y > p0.y ? 1 : -1;
+            }
+        }
+    }
+    return true;
+}
+
+// Kernels over the vertices of a closed polygon.  Point containment gives
+// exactly the same results at all levels (points on the boundary are
+// inside).  Area and perimeter are computed with the same per-edge
+// operations, but the partial sums are accumulated in a different order by
+// the vectorized kernels, so the results can differ in the last bits.
+bool simd_contain(const Vec2* points, uint64_t count, const Vec2 point);
+double simd_signed_area(const Vec2* points, uint64_t count);
+double simd_perimeter(const Vec2* points, uint64_t count);
+// For empty arrays, min is set to (DBL_MAX, DBL_MAX) and max to (-DBL_MAX,
+// -DBL_MAX), as in Polygon::bounding_box.
+void simd_bounding_box(const Vec2* points, uint64_t count, Vec2& min, Vec2& max);
+
+}  // namespace gdstk
+
+#endif
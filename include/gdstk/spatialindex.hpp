@@ -0,0 +1,90 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+#ifndef GDSTK_HEADER_SPATIALINDEX
+#define GDSTK_HEADER_SPATIALINDEX
+
+#define __STDC_FORMAT_MACROS 1
+#define _USE_MATH_DEFINES
+
+#include <stdint.h>
+
+#include "array.hpp"
+#include "vec.hpp"
+
+// Maximal number of children of each node in SpatialIndex
+#define GDSTK_SPATIAL_INDEX_NODE_SIZE 16
+
+namespace gdstk {
+
+enum struct SpatialItemType : uint8_t { Polygon = 0, FlexPath, RobustPath, Label, Reference };
+
+// Element indexed by SpatialIndex.  Index is the position of the element in
+// the array of its type (for cells: polygon_array, flexpath_array, etc.) and
+// min/max are the corners of its bounding box.
+struct SpatialItem {
+    Vec2 min;
+    Vec2 max;
+    uint64_t index;
+    SpatialItemType type;
+};
+
+// Static bounding volume hierarchy (packed Hilbert R-tree).  Items are sorted
+// along a Hilbert curve by the centers of their bounding boxes and grouped in
+// nodes of up to GDSTK_SPATIAL_INDEX_NODE_SIZE children, level by level, up to
+// a single root.  The index cannot be modified after being built: it must be
+// rebuilt when the indexed elements change.
+struct SpatialIndex {
+    // Items in Hilbert order
+    Array<SpatialItem> item_array;
+    // Bounding boxes of the tree nodes, stored level by level starting from
+    // the nodes just above the items.  Node i in a level covers children
+    // [i * GDSTK_SPATIAL_INDEX_NODE_SIZE, (i + 1) * GDSTK_SPATIAL_INDEX_NODE_SIZE)
+    // of the level below.
+    Array<Vec2> node_min;
+    Array<Vec2> node_max;
+    // Start of each level in node_min/node_max, with an extra entry for the
+    // total node count.
+    Array<uint64_t> level_offsets;
+    // Used by Cell to know when the index must be rebuilt (see
+    // Cell::has_spatial_index)
+    uint64_t element_counts[5];
+    uint64_t generation;
+    bool valid;
+
+    void print(bool all) const;
+
+    void clear() {
+        item_array.clear();
+        node_min.clear();
+        node_max.clear();
+        level_offsets.clear();
+        valid = false;
+    }
+
+    // Build the index from the items in items (the array is emptied).  The
+    // index is marked as valid.
+    void build(Array<SpatialItem>& items);
+
+    // Bounding box of all indexed items.  If the index is empty, min.x >
+    // max.x.
+    void bounding_box(Vec2& min, Vec2& max) const;
+
+    // Append to result the items with bounding boxes intersecting the
+    // rectangle with corners min and max (touching boxes are included).
+    void query(const Vec2 min, const Vec2 max, Array<SpatialItem>& result) const;
+
+    // Call the callback for each item with bounding box intersecting the
+    // rectangle with corners min and max.  The search stops early if the
+    // callback returns false.  Data is passed unchanged to the callback.
+    void query(const Vec2 min, const Vec2 max,
+               bool (*callback)(const SpatialItem& item, void* data), void* data) const;
+};
+
+}  // namespace gdstk
+
+#endif
@@ -124,6 +124,18 @@ char* copy_string(const char* str, uint64_t* len);
 // If true, m is set to the multiplicative factor, i.e., angle = 0.5 * M_PI * m
 bool is_multiple_of_pi_over_2(double angle, int64_t& m);
 
+// Cosine and sine of angle.  For multiples of π/2 (see
+// is_multiple_of_pi_over_2) the results are exactly 0 or ±1.
+void cos_sin(double angle, double& c, double& s);
+
+// Transform count points in place by scaling, reflecting across the x axis
+// (if x_reflection), rotating and translating them, in this order (the same
+// transformation defined by a Reference).  Rotations by multiples of π/2 only
+// swap and negate coordinates, without trigonometry, so the results are
+// exact when magnification is 1.
+void transform_points(Vec2* points, uint64_t count, double magnification, bool x_reflection,
+                      double rotation, const Vec2 translation);
+
 // Number of points needed to approximate an arc within some tolerance
 uint64_t arc_num_points(double angle, double radius, double tolerance);
 
@@ -205,6 +217,17 @@ const char* default_svg_label_style(Tag tag);
 // Thread-safe version of localtime.
 tm* get_now(tm& result);
 
+// Number of concurrent threads supported by the hardware (at least 1).
+uint32_t hardware_thread_count();
+
+// Call function(index, data) for all indices in [0, count) using up to
+// num_threads threads (the calling thread included).  If num_threads is zero,
+// hardware_thread_count() is used.  Indices are handed out dynamically, one
+// at a time, so uneven workloads are balanced among threads.  The function
+// returns after all calls are finished.
+void parallel_for(uint64_t count, uint32_t num_threads, void (*function)(uint64_t, void*),
+                  void* data);
+
 // FNV-1a hash function (64 bits)
 #define HASH_FNV_PRIME 0x00000100000001b3
 #define HASH_FNV_OFFSET 0xcbf29ce484222325
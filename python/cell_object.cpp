@@ -72,6 +72,7 @@ static int cell_object_init(CellObject* self, PyObject* args, PyObject* kwds) {
 static PyObject* cell_object_add(CellObject* self, PyObject* args) {
     uint64_t len = PyTuple_GET_SIZE(args);
     Cell* cell = self->cell;
+    cell->mark_modified();
     for (uint64_t i = 0; i < len; i++) {
         PyObject* arg = PyTuple_GET_ITEM(args, i);
         Py_INCREF(arg);
@@ -248,13 +249,24 @@ static PyObject* cell_object_get_polygons(CellObject* self, PyObject* args, PyOb
     PyObject* py_depth = Py_None;
     PyObject* py_layer = Py_None;
     PyObject* py_datatype = Py_None;
-    const char* keywords[] = {
-        "apply_repetitions", "include_paths", "depth", "layer", "datatype", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ppOOO:get_polygons", (char**)keywords,
+    PyObject* py_tags = Py_None;
+    int parallel = 0;
+    int keep_repetitions = 0;
+    const char* keywords[] = {"apply_repetitions", "include_paths", "depth",
+                              "layer",             "datatype",      "tags",
+                              "parallel",          "keep_repetitions",
+                              NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ppOOOOpp:get_polygons", (char**)keywords,
                                      &apply_repetitions, &include_paths, &py_depth, &py_layer,
-                                     &py_datatype))
+                                     &py_datatype, &py_tags, &parallel, &keep_repetitions))
         return NULL;
 
+    if (parallel > 0 && keep_repetitions > 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Arguments parallel and keep_repetitions cannot be used together.");
+        return NULL;
+    }
+
     int64_t depth = -1;
     if (py_depth != Py_None) {
         depth = PyLong_AsLongLong(py_depth);
@@ -286,9 +298,22 @@ static PyObject* cell_object_get_polygons(CellObject* self, PyObject* args, PyOb
         }
     }
 
+    Set<Tag> tags = {};
+    if (parse_tag_filter(py_tags, filter, make_tag(layer, datatype), tags) < 0) return NULL;
+
     Array<Polygon*> array = {};
-    self->cell->get_polygons(apply_repetitions > 0, include_paths > 0, depth, filter,
-                             make_tag(layer, datatype), array);
+    if (keep_repetitions > 0) {
+        self->cell->get_polygons_with_repetitions(include_paths > 0, depth,
+                                                  filter || py_tags != Py_None ? &tags : NULL,
+                                                  array);
+    } else if (parallel > 0) {
+        self->cell->get_polygons_parallel(apply_repetitions > 0, include_paths > 0, depth,
+                                          filter || py_tags != Py_None ? &tags : NULL, 0, array);
+    } else {
+        self->cell->get_polygons(apply_repetitions > 0, include_paths > 0, depth,
+                                 filter || py_tags != Py_None ? &tags : NULL, array);
+    }
+    tags.clear();
 
     PyObject* result = PyList_New(array.count);
     if (!result) {
@@ -319,9 +344,11 @@ static PyObject* cell_object_get_paths(CellObject* self, PyObject* args, PyObjec
     PyObject* py_depth = Py_None;
     PyObject* py_layer = Py_None;
     PyObject* py_datatype = Py_None;
-    const char* keywords[] = {"apply_repetitions", "depth", "layer", "datatype", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pOOO:get_polygons", (char**)keywords,
-                                     &apply_repetitions, &py_depth, &py_layer, &py_datatype))
+    PyObject* py_tags = Py_None;
+    const char* keywords[] = {"apply_repetitions", "depth", "layer", "datatype", "tags", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pOOOO:get_paths", (char**)keywords,
+                                     &apply_repetitions, &py_depth, &py_layer, &py_datatype,
+                                     &py_tags))
         return NULL;
 
     int64_t depth = -1;
@@ -349,13 +376,16 @@ static PyObject* cell_object_get_paths(CellObject* self, PyObject* args, PyObjec
         }
     }
 
+    Set<Tag> tags = {};
+    if (parse_tag_filter(py_tags, filter, make_tag(layer, datatype), tags) < 0) return NULL;
+    const Set<Tag>* tags_ptr = filter || py_tags != Py_None ? &tags : NULL;
+
     Array<FlexPath*> fp_array = {};
-    self->cell->get_flexpaths(apply_repetitions > 0, depth, filter, make_tag(layer, datatype),
-                              fp_array);
+    self->cell->get_flexpaths(apply_repetitions > 0, depth, tags_ptr, fp_array);
 
     Array<RobustPath*> rp_array = {};
-    self->cell->get_robustpaths(apply_repetitions > 0, depth, filter, make_tag(layer, datatype),
-                                rp_array);
+    self->cell->get_robustpaths(apply_repetitions > 0, depth, tags_ptr, rp_array);
+    tags.clear();
 
     PyObject* result = PyList_New(fp_array.count + rp_array.count);
     if (!result) {
@@ -395,14 +425,81 @@ static PyObject* cell_object_get_paths(CellObject* self, PyObject* args, PyObjec
     return result;
 }
 
+static PyObject* cell_object_query_region(CellObject* self, PyObject* args, PyObject* kwds) {
+    PyObject* py_corner1 = NULL;
+    PyObject* py_corner2 = NULL;
+    int include_paths = 1;
+    PyObject* py_depth = Py_None;
+    PyObject* py_tags = Py_None;
+    int clip = 0;
+    double precision = 1e-3;
+    const char* keywords[] = {"corner1", "corner2", "include_paths", "depth", "tags",
+                              "clip",    "precision", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|pOOpd:query_region", (char**)keywords,
+                                     &py_corner1, &py_corner2, &include_paths, &py_depth,
+                                     &py_tags, &clip, &precision))
+        return NULL;
+
+    Vec2 corner1, corner2;
+    if (parse_point(py_corner1, corner1, "corner1") != 0) return NULL;
+    if (parse_point(py_corner2, corner2, "corner2") != 0) return NULL;
+
+    if (precision <= 0) {
+        PyErr_SetString(PyExc_ValueError, "Precision must be positive.");
+        return NULL;
+    }
+
+    int64_t depth = -1;
+    if (py_depth != Py_None) {
+        depth = PyLong_AsLongLong(py_depth);
+        if (PyErr_Occurred()) {
+            PyErr_SetString(PyExc_RuntimeError, "Unable to convert depth to integer.");
+            return NULL;
+        }
+    }
+
+    Set<Tag> tags = {};
+    if (parse_tag_filter(py_tags, false, 0, tags) < 0) return NULL;
+
+    Array<Polygon*> array = {};
+    self->cell->query_region(corner1, corner2, include_paths > 0, depth,
+                             py_tags != Py_None ? &tags : NULL, clip > 0, precision, array);
+    tags.clear();
+
+    PyObject* result = PyList_New(array.count);
+    if (!result) {
+        PyErr_SetString(PyExc_RuntimeError, "Unable to create return list.");
+        for (uint64_t i = 0; i < array.count; i++) {
+            array[i]->clear();
+            free_allocation(array[i]);
+        }
+        array.clear();
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < array.count; i++) {
+        Polygon* poly = array[i];
+        PolygonObject* obj = PyObject_New(PolygonObject, &polygon_object_type);
+        obj = (PolygonObject*)PyObject_Init((PyObject*)obj, &polygon_object_type);
+        obj->polygon = poly;
+        poly->owner = obj;
+        PyList_SET_ITEM(result, i, (PyObject*)obj);
+    }
+
+    array.clear();
+    return result;
+}
+
 static PyObject* cell_object_get_labels(CellObject* self, PyObject* args, PyObject* kwds) {
     int apply_repetitions = 1;
     PyObject* py_depth = Py_None;
     PyObject* py_layer = Py_None;
     PyObject* py_texttype = Py_None;
-    const char* keywords[] = {"apply_repetitions", "depth", "layer", "texttype", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pOOO:get_polygons", (char**)keywords,
-                                     &apply_repetitions, &py_depth, &py_layer, &py_texttype))
+    PyObject* py_tags = Py_None;
+    const char* keywords[] = {"apply_repetitions", "depth", "layer", "texttype", "tags", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pOOOO:get_labels", (char**)keywords,
+                                     &apply_repetitions, &py_depth, &py_layer, &py_texttype,
+                                     &py_tags))
         return NULL;
 
     int64_t depth = -1;
@@ -430,8 +527,13 @@ static PyObject* cell_object_get_labels(CellObject* self, PyObject* args, PyObje
         }
     }
 
+    Set<Tag> tags = {};
+    if (parse_tag_filter(py_tags, filter, make_tag(layer, texttype), tags) < 0) return NULL;
+
     Array<Label*> array = {};
-    self->cell->get_labels(apply_repetitions > 0, depth, filter, make_tag(layer, texttype), array);
+    self->cell->get_labels(apply_repetitions > 0, depth,
+                           filter || py_tags != Py_None ? &tags : NULL, array);
+    tags.clear();
 
     PyObject* result = PyList_New(array.count);
     if (!result) {
@@ -459,11 +561,19 @@ static PyObject* cell_object_get_labels(CellObject* self, PyObject* args, PyObje
 
 static PyObject* cell_object_flatten(CellObject* self, PyObject* args, PyObject* kwds) {
     int apply_repetitions = 1;
-    const char* keywords[] = {"apply_repetitions", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p:flatten", (char**)keywords,
-                                     &apply_repetitions))
+    int parallel = 0;
+    int keep_repetitions = 0;
+    const char* keywords[] = {"apply_repetitions", "parallel", "keep_repetitions", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ppp:flatten", (char**)keywords,
+                                     &apply_repetitions, &parallel, &keep_repetitions))
         return NULL;
 
+    if (parallel > 0 && keep_repetitions > 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Arguments parallel and keep_repetitions cannot be used together.");
+        return NULL;
+    }
+
     Cell* cell = self->cell;
     uint64_t last_polygon = cell->polygon_array.count;
     uint64_t last_flexpath = cell->flexpath_array.count;
@@ -471,7 +581,13 @@ static PyObject* cell_object_flatten(CellObject* self, PyObject* args, PyObject*
     uint64_t last_label = cell->label_array.count;
 
     Array<Reference*> reference_array = {};
-    cell->flatten(apply_repetitions > 0, reference_array);
+    if (keep_repetitions > 0) {
+        cell->flatten_with_repetitions(reference_array);
+    } else if (parallel > 0) {
+        cell->flatten_parallel(apply_repetitions > 0, 0, reference_array);
+    } else {
+        cell->flatten(apply_repetitions > 0, reference_array);
+    }
     Reference** ref = reference_array.items;
     for (uint64_t i = reference_array.count; i > 0; i--, ref++) Py_XDECREF((*ref)->owner);
     reference_array.clear();
@@ -536,6 +652,32 @@ static PyObject* cell_object_flatten(CellObject* self, PyObject* args, PyObject*
     return (PyObject*)self;
 }
 
+static PyObject* cell_object_extract_repetitions(CellObject* self, PyObject* args,
+                                                 PyObject* kwds) {
+    double precision = 1e-3;
+    const char* keywords[] = {"precision", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d:extract_repetitions", (char**)keywords,
+                                     &precision))
+        return NULL;
+    if (precision <= 0) {
+        PyErr_SetString(PyExc_ValueError, "Precision must be positive.");
+        return NULL;
+    }
+
+    Array<Polygon*> polygon_array = {};
+    Array<Reference*> reference_array = {};
+    self->cell->extract_repetitions(precision, polygon_array, reference_array);
+    Polygon** poly = polygon_array.items;
+    for (uint64_t i = polygon_array.count; i > 0; i--, poly++) Py_XDECREF((*poly)->owner);
+    polygon_array.clear();
+    Reference** ref = reference_array.items;
+    for (uint64_t i = reference_array.count; i > 0; i--, ref++) Py_XDECREF((*ref)->owner);
+    reference_array.clear();
+
+    Py_INCREF(self);
+    return (PyObject*)self;
+}
+
 static PyObject* cell_object_copy(CellObject* self, PyObject* args, PyObject* kwds) {
     char* name = NULL;
     int deep_copy = 1;
@@ -759,6 +901,7 @@ static PyObject* cell_object_write_svg(CellObject* self, PyObject* args, PyObjec
 
 static PyObject* cell_object_remove(CellObject* self, PyObject* args) {
     uint64_t len = PyTuple_GET_SIZE(args);
+    self->cell->mark_modified();
     for (uint64_t i = 0; i < len; i++) {
         PyObject* arg = PyTuple_GET_ITEM(args, i);
         if (PolygonObject_Check(arg)) {
@@ -821,6 +964,7 @@ static PyObject* cell_object_filter(CellObject* self, PyObject* args, PyObject*
     }
 
     Cell* cell = self->cell;
+    cell->mark_modified();
 
     if (polygons > 0) {
         uint64_t i = 0;
@@ -1020,6 +1164,12 @@ static PyObject* cell_object_delete_property(CellObject* self, PyObject* args) {
     return (PyObject*)self;
 }
 
+static PyObject* cell_object_mark_modified(CellObject* self, PyObject*) {
+    self->cell->mark_modified();
+    Py_INCREF(self);
+    return (PyObject*)self;
+}
+
 static PyMethodDef cell_object_methods[] = {
     {"add", (PyCFunction)cell_object_add, METH_VARARGS, cell_object_add_doc},
     {"area", (PyCFunction)cell_object_area, METH_VARARGS, cell_object_area_doc},
@@ -1030,14 +1180,20 @@ static PyMethodDef cell_object_methods[] = {
      cell_object_get_polygons_doc},
     {"get_paths", (PyCFunction)cell_object_get_paths, METH_VARARGS | METH_KEYWORDS,
      cell_object_get_paths_doc},
+    {"query_region", (PyCFunction)cell_object_query_region, METH_VARARGS | METH_KEYWORDS,
+     cell_object_query_region_doc},
     {"get_labels", (PyCFunction)cell_object_get_labels, METH_VARARGS | METH_KEYWORDS,
      cell_object_get_labels_doc},
     {"flatten", (PyCFunction)cell_object_flatten, METH_VARARGS | METH_KEYWORDS,
      cell_object_flatten_doc},
+    {"extract_repetitions", (PyCFunction)cell_object_extract_repetitions,
+     METH_VARARGS | METH_KEYWORDS, cell_object_extract_repetitions_doc},
     {"copy", (PyCFunction)cell_object_copy, METH_VARARGS | METH_KEYWORDS, cell_object_copy_doc},
     {"write_svg", (PyCFunction)cell_object_write_svg, METH_VARARGS | METH_KEYWORDS,
      cell_object_write_svg_doc},
     {"remove", (PyCFunction)cell_object_remove, METH_VARARGS, cell_object_remove_doc},
+    {"mark_modified", (PyCFunction)cell_object_mark_modified, METH_NOARGS,
+     cell_object_mark_modified_doc},
     {"filter", (PyCFunction)cell_object_filter, METH_VARARGS | METH_KEYWORDS,
      cell_object_filter_doc},
     {"remap", (PyCFunction)cell_object_remap, METH_VARARGS | METH_KEYWORDS, cell_object_remap_doc},
@@ -2522,7 +2522,7 @@ Notes:
 
 PyDoc_STRVAR(
     cell_object_get_polygons_doc,
-    R"!(get_polygons(apply_repetitions=True, include_paths=True, depth=None, layer=None, datatype=None) -> list
+    R"!(get_polygons(apply_repetitions=True, include_paths=True, depth=None, layer=None, datatype=None, tags=None, parallel=False, keep_repetitions=False) -> list
 
 Return a copy of all polygons in the cell.
 
@@ -2539,14 +2539,28 @@ Args:
       returned.
     datatype: If set, only polygons in the defined layer and data type
       are returned.
+    tags (iterable of tuples): If not ``None``, only polygons with
+      (layer, data type) in this list are returned.
+    parallel: If ``True``, referenced cells are flattened on all
+      available hardware threads.  The result is the same, in the same
+      order, as in the sequential case.
+    keep_repetitions: If ``True``, no repetitions are expanded, not even
+      the ones from references: each polygon carries the composition of
+      its own repetition with the repetitions of the references above
+      it, so that arrays of references do not create one polygon per
+      copy.  Argument ``apply_repetitions`` is ignored in this case.
 
 Notes:
     Arguments ``layer`` and ``datatype`` must both be set to integers
     for the filtering to be executed.  If either one is ``None`` they
-    are both ignored.)!");
+    are both ignored.
+
+    Argument ``tags`` can be used to extract polygons from multiple
+    layers in a single pass over the cell hierarchy.  It cannot be used
+    together with ``layer`` and ``datatype``.)!");
 
 PyDoc_STRVAR(cell_object_get_paths_doc,
-             R"!(get_paths(apply_repetitions=True, depth=None, layer=None, datatype=None) -> list
+             R"!(get_paths(apply_repetitions=True, depth=None, layer=None, datatype=None, tags=None) -> list
 
 Return a copy of all paths in the cell.
 
@@ -2561,14 +2575,54 @@ Args:
       returned.
     datatype: If set, only paths in the defined layer and data type are
       returned.
+    tags (iterable of tuples): If not ``None``, only paths with
+      (layer, data type) in this list are returned.
 
 Notes:
     Arguments ``layer`` and ``datatype`` must both be set to integers
     for the filtering to be executed.  If either one is ``None`` they
-    are both ignored.)!");
+    are both ignored.  Argument ``tags`` cannot be used together with
+    them.
+
+    Only the path elements that pass the filter are included in the
+    returned paths.)!");
+
+PyDoc_STRVAR(
+    cell_object_query_region_doc,
+    R"!(query_region(corner1, corner2, include_paths=True, depth=None, tags=None, clip=False, precision=1e-3) -> list
+
+Return a copy of the polygons in the cell that overlap a rectangular
+region.
+
+Args:
+    corner1 (coordinate pair or complex): First corner of the region.
+    corner2 (coordinate pair or complex): Second corner of the region.
+    include_paths: If ``True``, polygonal representation of paths are
+      also included in the result.
+    depth: If non negative, indicates the number of reference levels
+      processed recursively.  A value of 0 will result in no references
+      being visited.  A value of ``None`` (the default) or a negative
+      integer will include all reference levels below the cell.
+    tags (iterable of tuples): If not ``None``, only polygons with
+      (layer, data type) in this list are returned.
+    clip: If ``True``, polygons are clipped to the region.
+    precision: Desired precision for rounding vertex coordinates when
+      clipping.
+
+Notes:
+    Polygons are selected by their bounding boxes.  References and
+    repetitions are only expanded where their bounding boxes overlap the
+    region, which is much faster than :meth:`gdstk.Cell.get_polygons`
+    for small regions.  Repetitions are always applied.
+
+Examples:
+    >>> polygons = top_cell.query_region((0, 0), (10, 10), tags=[(1, 0)])
+
+See also:
+    :meth:`gdstk.Cell.get_polygons`)!");
 
 PyDoc_STRVAR(cell_object_get_labels_doc,
-             R"!(get_labels(apply_repetitions=True, depth=None, layer=None, texttype=None) -> list
+             R"!(get_labels(apply_repetitions=True, depth=None, layer=None, texttype=None, tags=None) -> list
 
 Return a copy of all labels in the cell.
 
@@ -2583,13 +2637,16 @@ Args:
       returned.
     texttype: If set, only labels in the defined layer and text type
       are returned.
+    tags (iterable of tuples): If not ``None``, only labels with
+      (layer, text type) in this list are returned.
 
 Notes:
     Arguments ``layer`` and ``texttype`` must both be set to integers
     for the filtering to be executed.  If either one is ``None`` they
-    are both ignored.)!");
+    are both ignored.  Argument ``tags`` cannot be used together with
+    them.)!");
 
-PyDoc_STRVAR(cell_object_flatten_doc, R"!(flatten(apply_repetitions=True) -> self
+PyDoc_STRVAR(cell_object_flatten_doc, R"!(flatten(apply_repetitions=True, parallel=False, keep_repetitions=False) -> self
 
 Transform all references into polygons, paths and labels.
 
@@ -2597,6 +2654,13 @@ Args:
     apply_repetitions: Define whether repetitions should be flattened
       for polygons, paths and labels (reference repetitions are always
       applied).
+    parallel: If ``True``, polygons from references are created on all
+      available hardware threads.  The resulting cell is the same as in
+      the sequential case.
+    keep_repetitions: If ``True``, repetitions are kept in the inserted
+      elements, including the ones from references (see
+      :meth:`Cell.get_polygons`).  Argument ``apply_repetitions`` is
+      ignored in this case.
 
 Examples:
     >>> poly1 = gdstk.Polygon([(0, 0), (1, 0), (0.5, 1)])
@@ -2619,6 +2683,32 @@ Examples:
     .. image:: ../cell/flatten.svg
        :align: center)!");
 
+PyDoc_STRVAR(cell_object_extract_repetitions_doc,
+             R"!(extract_repetitions(precision=1e-3) -> self
+
+Fold identical polygons and references into repetitions.
+
+Polygons and references that only differ by a translation are replaced
+by a single element with a repetition.  Copies placed on evenly spaced
+rows and columns become rectangular repetitions.  The remaining copies
+of each element become a regular or explicit repetition.
+
+Args:
+    precision: Grid used to compare vertices and positions.
+
+Examples:
+    >>> cell = gdstk.Cell("CELL")
+    >>> for i in range(4):
+    ...     for j in range(3):
+    ...         cell.add(gdstk.rectangle((2 * i, 3 * j), (2 * i + 1, 3 * j + 1)))
+    >>> cell.extract_repetitions()
+    >>> print(len(cell.polygons), cell.polygons[0].repetition.size)
+    1 12
+
+Notes:
+    Only elements without repetitions or properties are folded.  The
+    folded elements are removed from the cell.)!");
+
 PyDoc_STRVAR(
     cell_object_copy_doc,
     R"!(copy(name, translation=(0, 0), rotation=0, magnification=1, x_reflection=False, deep_copy=True) -> gdstk.Cell
@@ -2708,6 +2798,18 @@ Examples:
     .. image:: ../cell/remove.svg
        :align: center)!");
 
+PyDoc_STRVAR(cell_object_mark_modified_doc, R"!(mark_modified() -> self
+
+Record that the contents of this cell have changed.
+
+The geometry cached by :meth:`gdstk.Library.bounding_boxes` and
+:meth:`gdstk.Library.convex_hulls` is only recomputed for modified cells
+and the cells that depend on them.  Methods that add or remove elements
+from the cell mark it automatically, but elements modified in place after
+being added to the cell (for example, with :meth:`gdstk.Polygon.translate`
+or by setting :attr:`gdstk.Reference.origin`) are not tracked, so this
+method must be called for the cells that contain them.)!");
+
 PyDoc_STRVAR(cell_object_filter_doc,
              R"!(filter(spec, remove=True, polygons=True, paths=True, labels=True) -> self
 
@@ -2902,6 +3004,54 @@ Return the top-level cells in the library.
 Top-level cells are cells that do not appear as dependency of any other
 cells in the library.)!");
 
+PyDoc_STRVAR(library_object_bounding_boxes_doc, R"!(bounding_boxes(parallel=False) -> dict
+
+Calculate the bounding boxes of all cells in the library.
+
+Each cell in the dependency graph is processed only once, from the
+bottom of the hierarchy up, so this is much faster than calling
+:meth:`gdstk.Cell.bounding_box` for each cell.
+
+Args:
+    parallel: If ``True``, the cells in each level of the hierarchy are
+      processed by multiple threads.
+
+Returns:
+    Dictionary with the bounding box of each cell (as returned by
+    :meth:`gdstk.Cell.bounding_box`), indexed by the cell name.
+
+Notes:
+    The dictionary includes the cells referenced by library cells even if
+    they are not part of the library.
+
+    Results are cached in the library and, in later calls, only
+    recomputed for the cells modified in the meantime and the cells that
+    depend on them (see :meth:`gdstk.Cell.mark_modified`).)!");
+
+PyDoc_STRVAR(library_object_convex_hulls_doc, R"!(convex_hulls(parallel=False) -> dict
+
+Calculate the convex hulls of all cells in the library.
+
+Each cell in the dependency graph is processed only once, from the
+bottom of the hierarchy up, so this is much faster than calling
+:meth:`gdstk.Cell.convex_hull` for each cell.
+
+Args:
+    parallel: If ``True``, the cells in each level of the hierarchy are
+      processed by multiple threads.
+
+Returns:
+    Dictionary with the convex hull of each cell (as returned by
+    :meth:`gdstk.Cell.convex_hull`), indexed by the cell name.
+
+Notes:
+    The dictionary includes the cells referenced by library cells even if
+    they are not part of the library.
+
+    Results are cached in the library and, in later calls, only
+    recomputed for the cells modified in the meantime and the cells that
+    depend on them (see :meth:`gdstk.Cell.mark_modified`).)!");
+
 PyDoc_STRVAR(library_object_layers_and_datatypes_doc, R"!(layers_and_datatypes() -> set
 
 Return a set of tuples with the layer and data types in the library.)!");
@@ -2919,7 +3069,7 @@ Args:
       desired (layer, type) tuples.)!");
 
 PyDoc_STRVAR(library_object_write_gds_doc,
-             R"!(write_gds(outfile, max_points=199, timestamp=None) -> None
+             R"!(write_gds(outfile, max_points=199, timestamp=None, extract_repetitions=False) -> None
 
 Save this library to a GDSII file.
 
@@ -2929,13 +3079,16 @@ Args:
       more vertices that this are automatically fractured.
     timestamp (datetime object): Timestamp to be stored in the GDSII
       file. If ``None``, the current time is used.
+    extract_repetitions: Write references that only differ by their
+      origin as arrays (see :meth:`gdstk.Cell.extract_repetitions`).
+      The library cells are not modified.
 
 See also:
     :ref:`getting-started`)!");
 
 PyDoc_STRVAR(
     library_object_write_oas_doc,
-    R"!(write_oas(outfile, compression_level=6, detect_rectangles=True, detect_trapezoids=True, circletolerance=0, standard_properties=False, validation=None) -> None
+    R"!(write_oas(outfile, compression_level=6, detect_rectangles=True, detect_trapezoids=True, circletolerance=0, standard_properties=False, validation=None, parallel=False, sort_by_tag=False, extract_repetitions=False) -> None
 
 Save this library to an OASIS file.
 
@@ -2952,6 +3105,15 @@ Args:
     validation ("crc32", "checksum32", None): type of validation to
       include in the saved file.
     standard_properties: Store standard OASIS properties in the file.
+    parallel: Encode and compress cells on multiple threads.  The output
+      file is identical to the one written sequentially.
+    sort_by_tag: Group polygons and labels by layer and data (text) type
+      within each cell, so that these values are not repeated in the
+      file.  The order of the elements read back from the file changes.
+    extract_repetitions: Fold identical polygons and references into
+      repetitions before writing (see
+      :meth:`gdstk.Cell.extract_repetitions`).  The library cells are not
+      modified.
 
 Notes:
     The standard OASIS options include the maximal string length and
@@ -2960,6 +3122,10 @@ Notes:
     Some of these properties are computationally expensive to calculate.
     Use only when required.
 
+    Values repeated between consecutive elements (layer, data type,
+    position, dimensions, vertices, repetitions, etc.) are omitted from
+    the file following the OASIS modal variable rules.
+
 See also:
     :ref:`getting-started`)!");
 
@@ -3346,7 +3512,7 @@ Notes:
 
 PyDoc_STRVAR(
     offset_function_doc,
-    R"!(offset(polygons, distance, join="miter", tolerance=2, precision=1e-3, use_union=False, layer=0, datatype=0) -> list
+    R"!(offset(polygons, distance, join="miter", tolerance=2, precision=1e-3, use_union=False, layer=0, datatype=0, parallel=False, rectilinear=False) -> list
 
 Dilate or erode polygons.
 
@@ -3369,6 +3535,12 @@ Args:
       adjacent polygons.
     layer: layer number assigned to the resulting polygons.
     datatype: data type number assigned to the resulting polygons.
+    parallel: If `True`, groups of polygons farther apart than the
+      offset reach are distributed in horizontal bands, which are
+      processed by multiple threads.
+    rectilinear: If `True`, rectilinear polygons are merged (with
+      `use_union`) and joined after the offset by the scanline
+      algorithm used in :func:`gdstk.boolean`.
 
 Returns:
     List of :class:`gdstk.Polygon`.
@@ -3386,12 +3558,19 @@ Examples:
     .. image:: ../function/offset.svg
        :align: center
 
+Notes:
+    1. The resulting polygons of a parallel offset are the same as the
+       ones from a serial offset, but their order is different.  Small
+       inputs are always processed serially.
+    2. With `rectilinear`, the resulting polygons differ from the
+       default ones as described for :func:`gdstk.boolean`.
+
 Notes:
     Repetitions are not applied to any elements, except references and
     their contents.)!");
 
 PyDoc_STRVAR(boolean_function_doc,
-             R"!(boolean(operand1, operand2, operation, precision=1e-3, layer=0, datatype=0) -> list
+             R"!(boolean(operand1, operand2, operation, precision=1e-3, layer=0, datatype=0, parallel=False, rectilinear=False) -> list
 
 Execute boolean (clipping) operations between polygons.
 
@@ -3408,6 +3587,12 @@ Args:
     precision: Desired precision for rounding vertex coordinates.
     layer: layer number assigned to the resulting polygons.
     datatype: data type number assigned to the resulting polygons.
+    parallel: If `True`, groups of polygons that do not touch each other
+      are distributed in horizontal bands, which are processed by
+      multiple threads.
+    rectilinear: If `True` and all polygons are rectilinear after
+      rounding, a dedicated scanline algorithm is used, which is
+      considerably faster.
 
 Returns:
     List of :class:`gdstk.Polygon`.
@@ -3430,6 +3615,13 @@ Notes:
        well as those in `operand2`.  As such, if, for example,
        `operand2` is an empty list, the result of the operation will be
        the union of polygons in `operand1`.
+    3. The resulting polygons of a parallel operation are the same as
+       the ones from a serial operation, but their order is different.
+       Small inputs are always processed serially.
+    4. The region covered by the result of a `rectilinear` operation is
+       the same, but the polygons describing it can be split
+       differently, and their order and starting vertices are
+       different.  In particular, polygons sharing an edge are joined.
     )!");
 
 PyDoc_STRVAR(slice_function_doc, R"!(slice(polygons, position, axis, precision=1e-3) -> list
@@ -3466,7 +3658,7 @@ Notes:
     Repetitions are not applied to any elements, except references and
     their contents.)!");
 
-PyDoc_STRVAR(inside_function_doc, R"!(inside(points, polygons) -> tuple
+PyDoc_STRVAR(inside_function_doc, R"!(inside(points, polygons, parallel=False) -> tuple
 
 Check whether each point is inside the set of polygons.
 
@@ -3480,6 +3672,13 @@ Args:
       Polygons to test against. If this is a sequence, each element can
       be any of the polygonal types or a sequence of points (coordinate
       pairs or complex).
+    parallel: If `True`, the points are divided among multiple threads.
+
+Notes:
+    For large sets of points, the polygons are indexed by their bounding
+    boxes and the edges of polygons with many vertices are grouped in
+    horizontal slabs, so that each point is only tested against nearby
+    geometry.
 
 Returns:
     Tuple of booleans (one for each point).)!");
@@ -3521,7 +3720,7 @@ Returns:
     `True` if any point is inside the polygon set, `False` otherwise.)!");
 
 PyDoc_STRVAR(read_gds_function_doc,
-             R"!(read_gds(infile, unit=0, tolerance=0, filter=None) -> gdstk.Library
+             R"!(read_gds(infile, unit=0, tolerance=0, filter=None, cells=None, memory_map=False, parallel=False) -> gdstk.Library
 
 Import a library from a GDSII stream file.
 
@@ -3533,6 +3732,15 @@ Args:
       negative, the library rounding size is used (`precision / unit`).
     filter (iterable of tuples): If not ``None``, only shapes with
       layer and data type in the iterable are read.
+    cells (iterable of str): If not ``None``, only the cells with these
+      names and their dependencies are read.  Other structures in the
+      file are skipped without being parsed.
+    memory_map (bool): If ``True``, the file is memory-mapped and parsed
+      in place, which is usually faster for large files.  Files that
+      cannot be mapped (pipes, for example) are read normally.
+    parallel (bool): If ``True``, the file is memory-mapped and its
+      cells are parsed on multiple threads.  The resulting library is
+      the same as the one loaded sequentially.
 
 Returns:
     The imported library.
@@ -3540,9 +3748,10 @@ Returns:
 Examples:
     >>> library = gdstk.read_gds("layout.gds")
     >>> top_cells = library.top_level()
-    >>> filtered_lib = gdstk.read_gds("layout.gds", filter={(0, 1)}))!");
+    >>> filtered_lib = gdstk.read_gds("layout.gds", filter={(0, 1)})
+    >>> partial_lib = gdstk.read_gds("layout.gds", cells=["TOP"]))!");
 
-PyDoc_STRVAR(read_oas_function_doc, R"!(read_oas(infile, unit=0, tolerance=0) -> gdstk.Library
+PyDoc_STRVAR(read_oas_function_doc, R"!(read_oas(infile, unit=0, tolerance=0, filter=None, label_filter=None, cells=None, parallel=False) -> gdstk.Library
 
 Import a library from an OASIS stream file.
 
@@ -3553,13 +3762,25 @@ Args:
     tolerance (number): Default tolerance for loaded paths and round
       shapes.  If zero or negative, the library rounding size is used
       (`precision / unit`).
+    filter (iterable of tuples): If not ``None``, only shapes with
+      layer and data type in the iterable are read.
+    label_filter (iterable of tuples): If not ``None``, only labels with
+      layer and text type in the iterable are read.
+    cells (iterable of str): If not ``None``, only the cells with these
+      names and their dependencies are kept in the library.  If the
+      file includes the cell offsets (see ``standard_properties`` in
+      :meth:`gdstk.Library.write_oas`), only those cells are read.
+    parallel (bool): If ``True``, compressed blocks in the file are
+      decompressed ahead of time on multiple threads.  The resulting
+      library is the same as the one loaded sequentially.
 
 Returns:
     The imported library.
 
 Examples:
     >>> library = gdstk.read_oas("layout.oas")
-    >>> top_cells = library.top_level())!");
+    >>> top_cells = library.top_level()
+    >>> filtered_lib = gdstk.read_oas("layout.oas", filter={(0, 1)}))!");
 
 PyDoc_STRVAR(read_rawcells_function_doc, R"!(read_rawcells(infile) -> dict
 
@@ -1066,11 +1066,14 @@ static PyObject* offset_function(PyObject* mod, PyObject* args, PyObject* kwds)
     int use_union = 0;
     unsigned long layer = 0;
     unsigned long datatype = 0;
-    const char* keywords[] = {"polygons",  "distance", "join",     "tolerance", "precision",
-                              "use_union", "layer",    "datatype", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Od|sddpkk:offset", (char**)keywords, &py_polygons,
-                                     &distance, &join, &tolerance, &precision, &use_union, &layer,
-                                     &datatype))
+    int parallel = 0;
+    int rectilinear = 0;
+    const char* keywords[] = {"polygons", "distance", "join",     "tolerance", "precision",
+                              "use_union", "layer",   "datatype", "parallel",  "rectilinear",
+                              NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Od|sddpkkpp:offset", (char**)keywords,
+                                     &py_polygons, &distance, &join, &tolerance, &precision,
+                                     &use_union, &layer, &datatype, &parallel, &rectilinear))
         return NULL;
 
     if (tolerance <= 0) {
@@ -1102,8 +1105,18 @@ static PyObject* offset_function(PyObject* mod, PyObject* args, PyObject* kwds)
     if (parse_polygons(py_polygons, polygon_array, "polygons") < 0) return NULL;
 
     Array<Polygon*> result_array = {};
-    ErrorCode error_code = offset(polygon_array, distance, offset_join, tolerance, 1 / precision,
-                                  use_union > 0, result_array);
+    ErrorCode error_code;
+    if (parallel) {
+        error_code = offset_parallel(polygon_array, distance, offset_join, tolerance,
+                                     1 / precision, use_union > 0, rectilinear > 0, 0,
+                                     result_array);
+    } else if (rectilinear) {
+        error_code = offset_rectilinear(polygon_array, distance, offset_join, tolerance,
+                                        1 / precision, use_union > 0, result_array);
+    } else {
+        error_code = offset(polygon_array, distance, offset_join, tolerance, 1 / precision,
+                            use_union > 0, result_array);
+    }
 
     if (return_error(error_code)) {
         for (uint64_t j = 0; j < polygon_array.count; j++) {
@@ -1148,10 +1161,13 @@ static PyObject* boolean_function(PyObject* mod, PyObject* args, PyObject* kwds)
     double precision = 0.001;
     unsigned long layer = 0;
     unsigned long datatype = 0;
-    const char* keywords[] = {"operand1", "operand2", "operation", "precision",
-                              "layer",    "datatype", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOs|dkk:boolean", (char**)keywords, &py_polygons1,
-                                     &py_polygons2, &operation, &precision, &layer, &datatype))
+    int parallel = 0;
+    int rectilinear = 0;
+    const char* keywords[] = {"operand1", "operand2", "operation",   "precision", "layer",
+                              "datatype", "parallel", "rectilinear", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOs|dkkpp:boolean", (char**)keywords,
+                                     &py_polygons1, &py_polygons2, &operation, &precision, &layer,
+                                     &datatype, &parallel, &rectilinear))
         return NULL;
 
     if (precision <= 0) {
@@ -1187,8 +1203,16 @@ static PyObject* boolean_function(PyObject* mod, PyObject* args, PyObject* kwds)
     }
 
     Array<Polygon*> result_array = {};
-    ErrorCode error_code =
-        boolean(polygon_array1, polygon_array2, oper, 1 / precision, result_array);
+    ErrorCode error_code;
+    if (parallel) {
+        error_code = boolean_parallel(polygon_array1, polygon_array2, oper, 1 / precision,
+                                      rectilinear > 0, 0, result_array);
+    } else if (rectilinear) {
+        error_code = boolean_rectilinear(polygon_array1, polygon_array2, oper, 1 / precision,
+                                         result_array);
+    } else {
+        error_code = boolean(polygon_array1, polygon_array2, oper, 1 / precision, result_array);
+    }
 
     if (return_error(error_code)) {
         for (uint64_t j = 0; j < polygon_array1.count; j++) {
@@ -1332,9 +1356,10 @@ static PyObject* slice_function(PyObject* mod, PyObject* args, PyObject* kwds) {
 static PyObject* inside_function(PyObject* mod, PyObject* args, PyObject* kwds) {
     PyObject* py_points;
     PyObject* py_polygons;
-    const char* keywords[] = {"points", "polygons", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO:inside", (char**)keywords, &py_points,
-                                     &py_polygons))
+    int parallel = 0;
+    const char* keywords[] = {"points", "polygons", "parallel", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|p:inside", (char**)keywords, &py_points,
+                                     &py_polygons, &parallel))
         return NULL;
 
     Array<Vec2> points = {};
@@ -1350,7 +1375,7 @@ static PyObject* inside_function(PyObject* mod, PyObject* args, PyObject* kwds)
     }
 
     bool* values = (bool*)allocate(points.count * sizeof(bool));
-    inside(points, polygons, values);
+    inside(points, polygons, parallel ? 0 : 1, values);
 
     PyObject* result = PyTuple_New(points.count);
     for (uint64_t i = 0; i < points.count; i++) {
@@ -1513,11 +1538,20 @@ static PyObject* read_gds_function(PyObject* mod, PyObject* args, PyObject* kwds
     double unit = 0;
     double tolerance = 0;
     PyObject* pyfilter = Py_None;
-    const char* keywords[] = {"infile", "unit", "tolerance", "filter", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|ddO:read_gds", (char**)keywords,
-                                     PyUnicode_FSConverter, &pybytes, &unit, &tolerance, &pyfilter))
+    PyObject* pycells = Py_None;
+    int memory_map = 0;
+    int parallel = 0;
+    const char* keywords[] = {"infile",     "unit",     "tolerance", "filter",
+                              "cells",      "memory_map", "parallel", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|ddOOpp:read_gds", (char**)keywords,
+                                     PyUnicode_FSConverter, &pybytes, &unit, &tolerance, &pyfilter,
+                                     &pycells, &memory_map, &parallel))
         return NULL;
 
+    uint16_t config_flags = 0;
+    if (memory_map == 1) config_flags |= GDSII_READ_CONFIG_MEMORY_MAP;
+    if (parallel == 1) config_flags |= GDSII_READ_CONFIG_PARALLEL;
+
     Set<Tag> shape_tags = {};
     Set<Tag>* shape_tags_ptr = NULL;
     if (pyfilter != Py_None) {
@@ -1529,13 +1563,29 @@ static PyObject* read_gds_function(PyObject* mod, PyObject* args, PyObject* kwds
         shape_tags_ptr = &shape_tags;
     }
 
+    Array<const char*> cell_names = {};
+    Array<const char*>* cell_names_ptr = NULL;
+    if (pycells != Py_None) {
+        if (parse_string_sequence(pycells, cell_names, "cells") < 0) {
+            for (uint64_t i = 0; i < cell_names.count; i++) free_allocation((char*)cell_names[i]);
+            cell_names.clear();
+            shape_tags.clear();
+            Py_DECREF(pybytes);
+            return NULL;
+        }
+        cell_names_ptr = &cell_names;
+    }
+
     const char* filename = PyBytes_AS_STRING(pybytes);
     Library* library = (Library*)allocate_clear(sizeof(Library));
     ErrorCode error_code = ErrorCode::NoError;
-    *library = read_gds(filename, unit, tolerance, shape_tags_ptr, &error_code);
+    *library = read_gds(filename, unit, tolerance, shape_tags_ptr, cell_names_ptr, config_flags,
+                        &error_code);
     Py_DECREF(pybytes);
 
     shape_tags.clear();
+    for (uint64_t i = 0; i < cell_names.count; i++) free_allocation((char*)cell_names[i]);
+    cell_names.clear();
 
     if (return_error(error_code)) {
         library->free_all();
@@ -1550,17 +1600,67 @@ static PyObject* read_oas_function(PyObject* mod, PyObject* args, PyObject* kwds
     PyObject* pybytes = NULL;
     double unit = 0;
     double tolerance = 0;
-    const char* keywords[] = {"infile", "unit", "tolerance", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|dd:read_oas", (char**)keywords,
-                                     PyUnicode_FSConverter, &pybytes, &unit, &tolerance))
+    PyObject* pyfilter = Py_None;
+    PyObject* pylabel_filter = Py_None;
+    PyObject* pycells = Py_None;
+    int parallel = 0;
+    const char* keywords[] = {"infile",       "unit",  "tolerance", "filter",
+                              "label_filter", "cells", "parallel",  NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|ddOOOp:read_oas", (char**)keywords,
+                                     PyUnicode_FSConverter, &pybytes, &unit, &tolerance, &pyfilter,
+                                     &pylabel_filter, &pycells, &parallel))
         return NULL;
 
+    Set<Tag> shape_tags = {};
+    Set<Tag>* shape_tags_ptr = NULL;
+    if (pyfilter != Py_None) {
+        if (parse_tag_sequence(pyfilter, shape_tags, "filter") < 0) {
+            shape_tags.clear();
+            Py_DECREF(pybytes);
+            return NULL;
+        }
+        shape_tags_ptr = &shape_tags;
+    }
+
+    Set<Tag> label_tags = {};
+    Set<Tag>* label_tags_ptr = NULL;
+    if (pylabel_filter != Py_None) {
+        if (parse_tag_sequence(pylabel_filter, label_tags, "label_filter") < 0) {
+            label_tags.clear();
+            shape_tags.clear();
+            Py_DECREF(pybytes);
+            return NULL;
+        }
+        label_tags_ptr = &label_tags;
+    }
+
+    Array<const char*> cell_names = {};
+    Array<const char*>* cell_names_ptr = NULL;
+    if (pycells != Py_None) {
+        if (parse_string_sequence(pycells, cell_names, "cells") < 0) {
+            for (uint64_t i = 0; i < cell_names.count; i++) free_allocation((char*)cell_names[i]);
+            cell_names.clear();
+            label_tags.clear();
+            shape_tags.clear();
+            Py_DECREF(pybytes);
+            return NULL;
+        }
+        cell_names_ptr = &cell_names;
+    }
+
     const char* filename = PyBytes_AS_STRING(pybytes);
     Library* library = (Library*)allocate_clear(sizeof(Library));
     ErrorCode error_code = ErrorCode::NoError;
-    *library = read_oas(filename, unit, tolerance, &error_code);
+    uint16_t config_flags = parallel ? OASIS_READ_CONFIG_PARALLEL : 0;
+    *library = read_oas(filename, unit, tolerance, shape_tags_ptr, label_tags_ptr, cell_names_ptr,
+                        config_flags, &error_code);
     Py_DECREF(pybytes);
 
+    shape_tags.clear();
+    label_tags.clear();
+    for (uint64_t i = 0; i < cell_names.count; i++) free_allocation((char*)cell_names[i]);
+    cell_names.clear();
+
     if (return_error(error_code)) {
         library->free_all();
         free_allocation(library);
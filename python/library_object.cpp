@@ -318,6 +318,80 @@ static PyObject* library_object_top_level(LibraryObject* self, PyObject*) {
     return result;
 }
 
+// Dictionary with the bounding box or convex hull from the cache for each
+// cell in cells
+static PyObject* build_geometry_info_dict(const Map<Cell*>& cells, const Map<GeometryInfo>& cache,
+                                          bool convex_hulls) {
+    PyObject* result = PyDict_New();
+    if (!result) {
+        PyErr_SetString(PyExc_RuntimeError, "Unable to create dictionary.");
+        return NULL;
+    }
+    for (MapItem<Cell*>* item = cells.next(NULL); item; item = cells.next(item)) {
+        const GeometryInfo info = cache.get(item->key);
+        PyObject* value;
+        if (convex_hulls) {
+            npy_intp dims[] = {(npy_intp)info.convex_hull.count, 2};
+            value = PyArray_SimpleNew(2, dims, NPY_DOUBLE);
+            if (!value) {
+                PyErr_SetString(PyExc_MemoryError, "Unable to create return array.");
+                Py_DECREF(result);
+                return NULL;
+            }
+            double* data = (double*)PyArray_DATA((PyArrayObject*)value);
+            memcpy(data, info.convex_hull.items, sizeof(double) * info.convex_hull.count * 2);
+        } else if (info.bounding_box_min.x > info.bounding_box_max.x) {
+            Py_INCREF(Py_None);
+            value = Py_None;
+        } else {
+            value = Py_BuildValue("((dd)(dd))", info.bounding_box_min.x, info.bounding_box_min.y,
+                                  info.bounding_box_max.x, info.bounding_box_max.y);
+        }
+        if (!value || PyDict_SetItemString(result, item->key, value) < 0) {
+            PyErr_SetString(PyExc_RuntimeError, "Unable to insert value in dictionary.");
+            Py_XDECREF(value);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(value);
+    }
+    return result;
+}
+
+static PyObject* library_object_geometry_info(LibraryObject* self, PyObject* args,
+                                              PyObject* kwds, bool convex_hulls) {
+    int parallel = 0;
+    const char* keywords[] = {"parallel", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds,
+                                     convex_hulls ? "|p:convex_hulls" : "|p:bounding_boxes",
+                                     (char**)keywords, &parallel))
+        return NULL;
+
+    Library* library = self->library;
+    library->update_geometry_cache(convex_hulls, parallel > 0 ? 0 : 1);
+
+    // The cache may also hold entries for cells removed from the library
+    Map<Cell*> cells = {};
+    for (uint64_t i = 0; i < library->cell_array.count; i++) {
+        Cell* cell = library->cell_array[i];
+        cells.set(cell->name, cell);
+        cell->get_dependencies(true, cells);
+    }
+    PyObject* result = build_geometry_info_dict(cells, library->geometry_cache, convex_hulls);
+    cells.clear();
+    return result;
+}
+
+static PyObject* library_object_bounding_boxes(LibraryObject* self, PyObject* args,
+                                               PyObject* kwds) {
+    return library_object_geometry_info(self, args, kwds, false);
+}
+
+static PyObject* library_object_convex_hulls(LibraryObject* self, PyObject* args,
+                                             PyObject* kwds) {
+    return library_object_geometry_info(self, args, kwds, true);
+}
+
 static PyObject* library_object_layers_and_datatypes(LibraryObject* self, PyObject*) {
     Set<Tag> tags = {};
     self->library->get_shape_tags(tags);
@@ -384,14 +458,16 @@ static PyObject* library_object_remap(LibraryObject* self, PyObject* args, PyObj
 }
 
 static PyObject* library_object_write_gds(LibraryObject* self, PyObject* args, PyObject* kwds) {
-    const char* keywords[] = {"outfile", "max_points", "timestamp", NULL};
+    const char* keywords[] = {"outfile", "max_points", "timestamp", "extract_repetitions", NULL};
     PyObject* pybytes = NULL;
     PyObject* pytimestamp = Py_None;
     tm* timestamp = NULL;
     tm _timestamp = {};
     uint64_t max_points = 199;
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|KO:write_gds", (char**)keywords,
-                                     PyUnicode_FSConverter, &pybytes, &max_points, &pytimestamp))
+    int extract_repetitions = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|KOp:write_gds", (char**)keywords,
+                                     PyUnicode_FSConverter, &pybytes, &max_points, &pytimestamp,
+                                     &extract_repetitions))
         return NULL;
 
     if (pytimestamp != Py_None) {
@@ -410,7 +486,9 @@ static PyObject* library_object_write_gds(LibraryObject* self, PyObject* args, P
     }
 
     const char* filename = PyBytes_AS_STRING(pybytes);
-    ErrorCode error_code = self->library->write_gds(filename, max_points, timestamp);
+    uint16_t config_flags = 0;
+    if (extract_repetitions == 1) config_flags |= GDSII_CONFIG_EXTRACT_REPETITIONS;
+    ErrorCode error_code = self->library->write_gds(filename, max_points, timestamp, config_flags);
     Py_DECREF(pybytes);
     if (return_error(error_code)) return NULL;
 
@@ -421,7 +499,8 @@ static PyObject* library_object_write_gds(LibraryObject* self, PyObject* args, P
 static PyObject* library_object_write_oas(LibraryObject* self, PyObject* args, PyObject* kwds) {
     const char* keywords[] = {
         "outfile",          "compression_level",   "detect_rectangles", "detect_trapezoids",
-        "circle_tolerance", "standard_properties", "validation",        NULL};
+        "circle_tolerance", "standard_properties", "validation",        "parallel",
+        "sort_by_tag",      "extract_repetitions", NULL};
     PyObject* pybytes = NULL;
     uint8_t compression_level = 6;
     int detect_rectangles = 1;
@@ -429,16 +508,23 @@ static PyObject* library_object_write_oas(LibraryObject* self, PyObject* args, P
     double circle_tolerance = 0;
     int standard_properties = 0;
     char* validation = NULL;
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|bppdpz:write_oas", (char**)keywords,
+    int parallel = 0;
+    int sort_by_tag = 0;
+    int extract_repetitions = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|bppdpzppp:write_oas", (char**)keywords,
                                      PyUnicode_FSConverter, &pybytes, &compression_level,
                                      &detect_rectangles, &detect_trapezoids, &circle_tolerance,
-                                     &standard_properties, &validation))
+                                     &standard_properties, &validation, &parallel, &sort_by_tag,
+                                     &extract_repetitions))
         return NULL;
 
-    uint8_t config_flags = 0;
+    uint16_t config_flags = 0;
     if (detect_rectangles == 1) config_flags |= OASIS_CONFIG_DETECT_RECTANGLES;
     if (detect_trapezoids == 1) config_flags |= OASIS_CONFIG_DETECT_TRAPEZOIDS;
     if (standard_properties == 1) config_flags |= OASIS_CONFIG_STANDARD_PROPERTIES;
+    if (parallel == 1) config_flags |= OASIS_CONFIG_PARALLEL;
+    if (sort_by_tag == 1) config_flags |= OASIS_CONFIG_SORT_BY_TAG;
+    if (extract_repetitions == 1) config_flags |= OASIS_CONFIG_EXTRACT_REPETITIONS;
     if (validation != NULL) {
         if (strcmp(validation, "crc32") == 0) {
             config_flags |= OASIS_CONFIG_INCLUDE_CRC32;
@@ -488,6 +574,10 @@ static PyMethodDef library_object_methods[] = {
     {"rename_cell", (PyCFunction)library_object_rename_cell, METH_VARARGS | METH_KEYWORDS,
      library_object_rename_cell_doc},
     {"top_level", (PyCFunction)library_object_top_level, METH_NOARGS, library_object_top_level_doc},
+    {"bounding_boxes", (PyCFunction)library_object_bounding_boxes, METH_VARARGS | METH_KEYWORDS,
+     library_object_bounding_boxes_doc},
+    {"convex_hulls", (PyCFunction)library_object_convex_hulls, METH_VARARGS | METH_KEYWORDS,
+     library_object_convex_hulls_doc},
     {"layers_and_datatypes", (PyCFunction)library_object_layers_and_datatypes, METH_NOARGS,
      library_object_layers_and_datatypes_doc},
     {"layers_and_texttypes", (PyCFunction)library_object_layers_and_texttypes, METH_NOARGS,
@@ -171,6 +171,49 @@ static int64_t parse_tag_sequence(PyObject* iterable, Set<Tag>& dest, const char
     return count;
 }
 
+// Tag filter for get_polygons and friends: either a sequence of tags or a
+// single tag (if filter is true).  Return -1 on error.
+static int64_t parse_tag_filter(PyObject* py_tags, bool filter, Tag tag, Set<Tag>& dest) {
+    if (py_tags == Py_None) {
+        if (filter) dest.add(tag);
+        return filter ? 1 : 0;
+    }
+    if (filter) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Argument tags cannot be used together with layer and type filtering.");
+        return -1;
+    }
+    int64_t count = parse_tag_sequence(py_tags, dest, "tags");
+    if (count < 0) dest.clear();
+    return count;
+}
+
+// Strings are copied into dest and must be freed by the caller.
+static int64_t parse_string_sequence(PyObject* iterable, Array<const char*>& dest,
+                                     const char* name) {
+    PyObject* iterator = PyObject_GetIter(iterable);
+    if (!iterator) {
+        PyErr_Format(PyExc_RuntimeError, "Unable to get an iterator from %s.", name);
+        return -1;
+    }
+    int64_t count = 0;
+    PyObject* item;
+    while ((item = PyIter_Next(iterator))) {
+        const char* string = PyUnicode_Check(item) ? PyUnicode_AsUTF8(item) : NULL;
+        if (!string) {
+            PyErr_Format(PyExc_TypeError, "Items in argument %s must be strings.", name);
+            Py_DECREF(item);
+            Py_DECREF(iterator);
+            return -1;
+        }
+        dest.append(copy_string(string, NULL));
+        Py_DECREF(item);
+        count++;
+    }
+    Py_DECREF(iterator);
+    return count;
+}
+
 // polygon_array should be zero-initialized
 static int64_t parse_polygons(PyObject* py_polygons, Array<Polygon*>& polygon_array,
                               const char* name) {
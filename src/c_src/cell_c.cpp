@@ -33,7 +33,7 @@ GDSTK_Cell* gdstk_cell_create(const char* name) {
     if (!name) {
         fprintf(stderr, "Warning: gdstk_cell_create received null name parameter\n");
     }
-    auto* wrapper = new GDSTK_Cell;
+    auto* wrapper = new GDSTK_Cell();
     wrapper->cell.init(name);
     return wrapper;
 }
@@ -55,6 +55,14 @@ void gdstk_cell_clear(GDSTK_Cell* cell) {
     cell->cell.clear();
 }
 
+void gdstk_cell_mark_modified(GDSTK_Cell* cell) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_mark_modified received null cell parameter\n");
+        return;
+    }
+    cell->cell.mark_modified();
+}
+
 // Basic properties
 const char* gdstk_cell_get_name(const GDSTK_Cell* cell) {
     if (!cell) {
@@ -193,6 +201,7 @@ void gdstk_cell_add_flexpath(GDSTK_Cell* cell, GDSTK_FlexPath* flexpath) {
         return;
     }
     cell->cell.flexpath_array.append(reinterpret_cast<FlexPath*>(flexpath));
+    cell->cell.mark_modified();
 }
 
 uint64_t gdstk_cell_robustpath_count(const GDSTK_Cell* cell) {
@@ -224,6 +233,7 @@ void gdstk_cell_add_robustpath(GDSTK_Cell* cell, GDSTK_RobustPath* robustpath) {
         return;
     }
     cell->cell.robustpath_array.append(reinterpret_cast<RobustPath*>(robustpath));
+    cell->cell.mark_modified();
 }
 
 uint64_t gdstk_cell_label_count(const GDSTK_Cell* cell) {
@@ -255,6 +265,7 @@ void gdstk_cell_add_label(GDSTK_Cell* cell, GDSTK_Label* label) {
         return;
     }
     cell->cell.label_array.append(reinterpret_cast<Label*>(label));
+    cell->cell.mark_modified();
 }
 
 // Property accessors
@@ -372,6 +383,203 @@ void gdstk_cell_get_labels(const GDSTK_Cell* cell, int apply_repetitions, int64_
                           *reinterpret_cast<Array<Label*>*>(result.array));
 }
 
+void gdstk_cell_get_polygons_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                                     int include_paths, int64_t depth, const Tag* tags,
+                                     uint64_t tag_count, GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_polygons_by_tags received null cell parameter\n");
+        return;
+    }
+    if (!result.array || (tag_count > 0 && !tags)) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_polygons_by_tags received null result or tags parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    cell->cell.get_polygons(apply_repetitions != 0, include_paths != 0, depth, &tag_set,
+                            *reinterpret_cast<Array<Polygon*>*>(result.array));
+    tag_set.clear();
+}
+
+void gdstk_cell_get_polygons_parallel(const GDSTK_Cell* cell, int apply_repetitions,
+                                      int include_paths, int64_t depth, const Tag* tags,
+                                      uint64_t tag_count, uint32_t num_threads,
+                                      GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_polygons_parallel received null cell parameter\n");
+        return;
+    }
+    if (!result.array) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_polygons_parallel received null result parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    if (tags) {
+        for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    }
+    cell->cell.get_polygons_parallel(apply_repetitions != 0, include_paths != 0, depth,
+                                     tags ? &tag_set : NULL, num_threads,
+                                     *reinterpret_cast<Array<Polygon*>*>(result.array));
+    tag_set.clear();
+}
+
+void gdstk_cell_get_flexpaths_by_tags(const GDSTK_Cell* cell, int apply_repetitions, int64_t depth,
+                                      const Tag* tags, uint64_t tag_count, GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_flexpaths_by_tags received null cell parameter\n");
+        return;
+    }
+    if (!result.array || (tag_count > 0 && !tags)) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_flexpaths_by_tags received null result or tags parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    cell->cell.get_flexpaths(apply_repetitions != 0, depth, &tag_set,
+                             *reinterpret_cast<Array<FlexPath*>*>(result.array));
+    tag_set.clear();
+}
+
+void gdstk_cell_get_robustpaths_by_tags(const GDSTK_Cell* cell, int apply_repetitions,
+                                        int64_t depth, const Tag* tags, uint64_t tag_count,
+                                        GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_robustpaths_by_tags received null cell parameter\n");
+        return;
+    }
+    if (!result.array || (tag_count > 0 && !tags)) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_robustpaths_by_tags received null result or tags parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    cell->cell.get_robustpaths(apply_repetitions != 0, depth, &tag_set,
+                               *reinterpret_cast<Array<RobustPath*>*>(result.array));
+    tag_set.clear();
+}
+
+void gdstk_cell_get_labels_by_tags(const GDSTK_Cell* cell, int apply_repetitions, int64_t depth,
+                                   const Tag* tags, uint64_t tag_count, GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_labels_by_tags received null cell parameter\n");
+        return;
+    }
+    if (!result.array || (tag_count > 0 && !tags)) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_labels_by_tags received null result or tags parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    cell->cell.get_labels(apply_repetitions != 0, depth, &tag_set,
+                          *reinterpret_cast<Array<Label*>*>(result.array));
+    tag_set.clear();
+}
+
+void gdstk_cell_get_polygons_per_tag(const GDSTK_Cell* cell, int apply_repetitions,
+                                     int include_paths, int64_t depth, const Tag* tags,
+                                     uint64_t tag_count, GDSTK_Array* results) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_get_polygons_per_tag received null cell parameter\n");
+        return;
+    }
+    if (tag_count == 0) return;
+    if (!tags || !results) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_get_polygons_per_tag received null tags or results parameter\n");
+        return;
+    }
+    for (uint64_t i = 0; i < tag_count; i++) {
+        if (!results[i].array) {
+            fprintf(stderr,
+                    "Warning: gdstk_cell_get_polygons_per_tag received null result array\n");
+            return;
+        }
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; i < tag_count; i++) tag_set.add(tags[i]);
+    Array<Polygon*> array = {};
+    cell->cell.get_polygons(apply_repetitions != 0, include_paths != 0, depth, &tag_set, array);
+    tag_set.clear();
+
+    // Polygons are bucketed with a linear search in tags, which is meant for
+    // a modest number of tags (layers).  Repeated tags use the first bucket.
+    for (uint64_t i = 0; i < array.count; i++) {
+        Polygon* polygon = array[i];
+        uint64_t j = 0;
+        while (tags[j] != polygon->tag) j++;
+        reinterpret_cast<Array<Polygon*>*>(results[j].array)->append(polygon);
+    }
+    array.clear();
+}
+
+void gdstk_cell_query_region(const GDSTK_Cell* cell, const GDSTK_Vec2* corner1,
+                             const GDSTK_Vec2* corner2, int include_paths, int64_t depth,
+                             const Tag* tags, uint64_t tag_count, int clip, double precision,
+                             GDSTK_Array result) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_query_region received null cell parameter\n");
+        return;
+    }
+    if (!corner1 || !corner2) {
+        fprintf(stderr, "Warning: gdstk_cell_query_region received null corner parameter\n");
+        return;
+    }
+    if (!result.array) {
+        fprintf(stderr, "Warning: gdstk_cell_query_region received null result parameter\n");
+        return;
+    }
+    Set<Tag> tag_set = {};
+    for (uint64_t i = 0; tags && i < tag_count; i++) tag_set.add(tags[i]);
+    cell->cell.query_region(*reinterpret_cast<const Vec2*>(corner1),
+                            *reinterpret_cast<const Vec2*>(corner2), include_paths != 0, depth,
+                            tags ? &tag_set : NULL, clip != 0, precision,
+                            *reinterpret_cast<Array<Polygon*>*>(result.array));
+    tag_set.clear();
+}
+
+struct PolygonVisitorData {
+    GDSTK_PolygonVisitor callback;
+    void* data;
+};
+
+static void polygon_visitor(const Polygon& polygon, const AffineTransform& transform,
+                            const Array<Vec2>& points, void* data) {
+    const PolygonVisitorData* visitor_data = static_cast<const PolygonVisitorData*>(data);
+    const double matrix[] = {transform.xx,
+                             transform.xy,
+                             transform.yx,
+                             transform.yy,
+                             transform.translation.x,
+                             transform.translation.y};
+    visitor_data->callback(reinterpret_cast<const GDSTK_Polygon*>(&polygon), matrix,
+                           reinterpret_cast<const GDSTK_Vec2*>(points.items), points.count,
+                           visitor_data->data);
+}
+
+void gdstk_cell_visit_polygons(const GDSTK_Cell* cell, int apply_repetitions, int64_t depth,
+                               int filter, Tag tag, int transform_points,
+                               GDSTK_PolygonVisitor callback, void* data) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_visit_polygons received null cell parameter\n");
+        return;
+    }
+    if (!callback) {
+        fprintf(stderr, "Warning: gdstk_cell_visit_polygons received null callback parameter\n");
+        return;
+    }
+    PolygonVisitorData visitor_data = {callback, data};
+    ShapeVisitor visitor = {};
+    visitor.polygon = polygon_visitor;
+    visitor.transform_points = transform_points != 0;
+    visitor.data = &visitor_data;
+    cell->cell.visit_shapes(apply_repetitions != 0, depth, filter != 0, tag, visitor);
+}
+
 // Dependency management
 void gdstk_cell_get_dependencies(const GDSTK_Cell* cell, int recursive, GDSTK_Map_Cell* result) {
     if (!cell) {
@@ -455,6 +663,21 @@ void gdstk_cell_flatten(GDSTK_Cell* cell, int apply_repetitions, GDSTK_Array rem
                        *reinterpret_cast<Array<Reference*>*>(removed_references.array));
 }
 
+void gdstk_cell_flatten_parallel(GDSTK_Cell* cell, int apply_repetitions, uint32_t num_threads,
+                                 GDSTK_Array removed_references) {
+    if (!cell) {
+        fprintf(stderr, "Warning: gdstk_cell_flatten_parallel received null cell parameter\n");
+        return;
+    }
+    if (!removed_references.array) {
+        fprintf(stderr,
+                "Warning: gdstk_cell_flatten_parallel received null removed_references parameter\n");
+        return;
+    }
+    cell->cell.flatten_parallel(apply_repetitions != 0, num_threads,
+                                *reinterpret_cast<Array<Reference*>*>(removed_references.array));
+}
+
 // File output
 int gdstk_cell_to_gds(const GDSTK_Cell* cell, FILE* out, double scaling, uint64_t max_points,
                       double precision, const struct tm* timestamp) {
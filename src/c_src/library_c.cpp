@@ -93,6 +93,8 @@ GDSTK_Cell* gdstk_library_get_cell(const GDSTK_Library* library, const char* nam
     if (!cell) return nullptr;
     auto* wrapper = new GDSTK_Cell;
     wrapper->cell = *cell;
+    // The wrapper holds a copy: the lazy source (if any) belongs to the library cell.
+    wrapper->cell.lazy_source = nullptr;
     return wrapper;
 }
 
@@ -113,7 +115,8 @@ GDSTK_RawCell* gdstk_library_get_rawcell(const GDSTK_Library* library, const cha
 }
 
 GDSTK_ErrorCode gdstk_library_write_gds(const GDSTK_Library* library, const char* filename,
-                                      uint64_t max_points, const struct tm* timestamp) {
+                                      uint64_t max_points, const struct tm* timestamp,
+                                      uint16_t config_flags) {
     if (!library) {
         fprintf(stderr, "Warning: gdstk_library_write_gds received null library parameter\n");
         return GDSTK_FileError;
@@ -122,7 +125,8 @@ GDSTK_ErrorCode gdstk_library_write_gds(const GDSTK_Library* library, const char
         fprintf(stderr, "Warning: gdstk_library_write_gds received null filename parameter\n");
         return GDSTK_FileError;
     }
-    ErrorCode result = library->lib.write_gds(filename, max_points, const_cast<tm*>(timestamp));
+    ErrorCode result =
+        library->lib.write_gds(filename, max_points, const_cast<tm*>(timestamp), config_flags);
     return static_cast<GDSTK_ErrorCode>(result);
 }
 
@@ -208,8 +212,12 @@ GDSTK_Cell* gdstk_library_get_cell_by_index(const GDSTK_Library* library, uint64
         fprintf(stderr, "Warning: gdstk_library_get_cell_by_index index out of bounds\n");
         return nullptr;
     }
+    Cell* cell = library->lib.cell_array[index];
+    cell->load();
     auto* wrapper = new GDSTK_Cell;
-    wrapper->cell = *library->lib.cell_array[index];
+    wrapper->cell = *cell;
+    // The wrapper holds a copy: the lazy source (if any) belongs to the library cell.
+    wrapper->cell.lazy_source = nullptr;
     return wrapper;
 }
 
@@ -320,15 +328,20 @@ void gdstk_library_rename_cell(GDSTK_Library* library, const char* old_name, con
 
 // File I/O implementation
 GDSTK_Library* gdstk_read_gds(const char* filename, double unit, double tolerance,
-                             const GDSTK_TagSet* shape_tags, GDSTK_ErrorCode* error_code) {
+                             const GDSTK_TagSet* shape_tags, const char* const* cell_names,
+                             uint64_t cell_name_count, uint16_t config_flags,
+                             GDSTK_ErrorCode* error_code) {
     if (!filename) {
         fprintf(stderr, "Warning: gdstk_read_gds received null filename parameter\n");
         if (error_code) *error_code = GDSTK_FileError;
         return nullptr;
     }
     
+    // Non-owning view of the caller's names
+    Array<const char*> names = {cell_name_count, cell_name_count, (const char**)cell_names};
     ErrorCode ec = ErrorCode::NoError;
-    Library lib = read_gds(filename, unit, tolerance, shape_tags ? &shape_tags->set : nullptr, &ec);
+    Library lib = read_gds(filename, unit, tolerance, shape_tags ? &shape_tags->set : nullptr,
+                           cell_names ? &names : nullptr, config_flags, &ec);
     
     if (error_code) *error_code = static_cast<GDSTK_ErrorCode>(ec);
     if (ec != ErrorCode::NoError) return nullptr;
@@ -339,15 +352,21 @@ GDSTK_Library* gdstk_read_gds(const char* filename, double unit, double toleranc
 }
 
 GDSTK_Library* gdstk_read_oas(const char* filename, double unit, double tolerance,
-                             GDSTK_ErrorCode* error_code) {
+                             const GDSTK_TagSet* shape_tags, const GDSTK_TagSet* label_tags,
+                             const char* const* cell_names, uint64_t cell_name_count,
+                             uint16_t config_flags, GDSTK_ErrorCode* error_code) {
     if (!filename) {
         fprintf(stderr, "Warning: gdstk_read_oas received null filename parameter\n");
         if (error_code) *error_code = GDSTK_FileError;
         return nullptr;
     }
     
+    // Non-owning view of the caller's names
+    Array<const char*> names = {cell_name_count, cell_name_count, (const char**)cell_names};
     ErrorCode ec = ErrorCode::NoError;
-    Library lib = read_oas(filename, unit, tolerance, &ec);
+    Library lib = read_oas(filename, unit, tolerance, shape_tags ? &shape_tags->set : nullptr,
+                           label_tags ? &label_tags->set : nullptr, cell_names ? &names : nullptr,
+                           config_flags, &ec);
     
     if (error_code) *error_code = static_cast<GDSTK_ErrorCode>(ec);
     if (ec != ErrorCode::NoError) return nullptr;
@@ -557,6 +576,57 @@ void gdstk_library_get_top_level(const GDSTK_Library* library, GDSTK_Array top_c
                           *static_cast<Array<RawCell*>*>(top_rawcells.array));
 }
 
+// Geometry cache
+void gdstk_library_update_geometry_cache(GDSTK_Library* library, int convex_hulls,
+                                         uint32_t num_threads) {
+    if (!library) {
+        fprintf(stderr,
+                "Warning: gdstk_library_update_geometry_cache received null library parameter\n");
+        return;
+    }
+    library->lib.update_geometry_cache(convex_hulls != 0, num_threads);
+}
+
+int gdstk_library_get_cached_bounding_box(const GDSTK_Library* library, const char* name,
+                                          struct GDSTK_Vec2* min, struct GDSTK_Vec2* max) {
+    if (!library) {
+        fprintf(stderr,
+                "Warning: gdstk_library_get_cached_bounding_box received null library parameter\n");
+        return 0;
+    }
+    if (!name) {
+        fprintf(stderr,
+                "Warning: gdstk_library_get_cached_bounding_box received null name parameter\n");
+        return 0;
+    }
+    if (!min || !max) {
+        fprintf(stderr,
+                "Warning: gdstk_library_get_cached_bounding_box received null min/max parameter\n");
+        return 0;
+    }
+    GeometryInfo info = library->lib.geometry_cache.get(name);
+    if (!info.bounding_box_valid) return 0;
+    *reinterpret_cast<Vec2*>(min) = info.bounding_box_min;
+    *reinterpret_cast<Vec2*>(max) = info.bounding_box_max;
+    return 1;
+}
+
+int gdstk_library_mark_cell_modified(GDSTK_Library* library, const char* name) {
+    if (!library) {
+        fprintf(stderr,
+                "Warning: gdstk_library_mark_cell_modified received null library parameter\n");
+        return 0;
+    }
+    if (!name) {
+        fprintf(stderr, "Warning: gdstk_library_mark_cell_modified received null name parameter\n");
+        return 0;
+    }
+    Cell* cell = library->lib.get_cell(name);
+    if (!cell) return 0;
+    cell->mark_modified();
+    return 1;
+}
+
 // Cell replacement functions
 void gdstk_library_replace_cell_with_cell(GDSTK_Library* library, GDSTK_Cell* old_cell,
                                         GDSTK_Cell* new_cell) {
@@ -15,8 +15,12 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <string.h>
 #include <time.h>
 
+#include <atomic>
+
 #include <gdstk/allocator.hpp>
 #include <gdstk/cell.hpp>
+#include <gdstk/clipper_tools.hpp>
+#include <gdstk/gdsii.hpp>
 #include <gdstk/rawcell.hpp>
 #include <gdstk/sort.hpp>
 #include <gdstk/utils.hpp>
@@ -65,6 +69,7 @@ void Cell::print(bool all) const {
 }
 
 void Cell::clear() {
+    if (lazy_source) gdsii_release_lazy_cell(*this);
     if (name) free_allocation(name);
     name = NULL;
     polygon_array.clear();
@@ -73,6 +78,22 @@ void Cell::clear() {
     robustpath_array.clear();
     label_array.clear();
     properties_clear(properties);
+    spatial_index.clear();
+    generation = 0;
+}
+
+// Source of cell generations (see Cell::mark_modified)
+static std::atomic<uint64_t> cell_generation_counter{0};
+
+void Cell::mark_modified() {
+    generation = ++cell_generation_counter;
+    invalidate_spatial_index();
+}
+
+ErrorCode Cell::load() const {
+    if (is_loaded()) return ErrorCode::NoError;
+    // Loading does not change the logical contents of the cell, only brings them into memory.
+    return gdsii_load_lazy_cell(*(Cell*)this);
 }
 
 void Cell::bounding_box(Vec2& min, Vec2& max) const {
@@ -87,6 +108,7 @@ void Cell::bounding_box(Vec2& min, Vec2& max) const {
 }
 
 GeometryInfo Cell::bounding_box(Map<GeometryInfo>& cache) const {
+    load();
     Vec2 min, max;
     min.x = min.y = DBL_MAX;
     max.x = max.y = -DBL_MAX;
@@ -185,6 +207,7 @@ void Cell::convex_hull(Array<Vec2>& result) const {
 }
 
 GeometryInfo Cell::convex_hull(Map<GeometryInfo>& cache) const {
+    load();
     Array<Vec2> points = {};
     Array<Vec2> offsets = {};
 
@@ -297,7 +320,142 @@ GeometryInfo Cell::convex_hull(Map<GeometryInfo>& cache) const {
     return info;
 }
 
+// Bounding box of polygons including their repetitions.  Polygons are freed.
+static void add_polygon_boxes(Array<Polygon*>& polygons, Vec2& min, Vec2& max) {
+    for (uint64_t i = 0; i < polygons.count; i++) {
+        Polygon* polygon = polygons[i];
+        Vec2 pmin, pmax;
+        polygon->bounding_box(pmin, pmax);
+        if (pmin.x < min.x) min.x = pmin.x;
+        if (pmin.y < min.y) min.y = pmin.y;
+        if (pmax.x > max.x) max.x = pmax.x;
+        if (pmax.y > max.y) max.y = pmax.y;
+        polygon->clear();
+        free_allocation(polygon);
+    }
+    polygons.count = 0;
+}
+
+// Largest generation among the cell and all its dependencies.  Results are
+// stored in generations (plus one, to tell them apart from missing keys).
+static uint64_t hierarchy_generation(const Cell& cell, Map<uint64_t>& generations) {
+    uint64_t result = generations.get(cell.name);
+    if (result > 0) return result - 1;
+    cell.load();
+    result = cell.generation;
+    for (uint64_t i = 0; i < cell.reference_array.count; i++) {
+        const Reference* reference = cell.reference_array[i];
+        if (reference->type != ReferenceType::Cell) continue;
+        const uint64_t generation = hierarchy_generation(*reference->cell, generations);
+        if (generation > result) result = generation;
+    }
+    generations.set(cell.name, result + 1);
+    return result;
+}
+
+const SpatialIndex& Cell::get_spatial_index() {
+    if (has_spatial_index()) return spatial_index;
+    Map<GeometryInfo> cache = {};
+    get_spatial_index(cache);
+    for (MapItem<GeometryInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+    return spatial_index;
+}
+
+const SpatialIndex& Cell::get_spatial_index(Map<GeometryInfo>& cache) {
+    load();
+    Map<uint64_t> generations = {};
+    const uint64_t index_generation = hierarchy_generation(*this, generations);
+    const bool valid = has_spatial_index(generations);
+    generations.clear();
+    if (valid) return spatial_index;
+
+    Array<SpatialItem> items = {};
+    items.ensure_slots(polygon_array.count + flexpath_array.count + robustpath_array.count +
+                       label_array.count + reference_array.count);
+    SpatialItem item = {};
+
+    item.type = SpatialItemType::Polygon;
+    for (uint64_t i = 0; i < polygon_array.count; i++) {
+        polygon_array[i]->bounding_box(item.min, item.max);
+        item.index = i;
+        items.append_unsafe(item);
+    }
+
+    Array<Polygon*> array = {};
+    item.type = SpatialItemType::FlexPath;
+    for (uint64_t i = 0; i < flexpath_array.count; i++) {
+        item.min.x = item.min.y = DBL_MAX;
+        item.max.x = item.max.y = -DBL_MAX;
+        // NOTE: return ErrorCode ignored here
+        flexpath_array[i]->to_polygons(false, 0, array);
+        add_polygon_boxes(array, item.min, item.max);
+        item.index = i;
+        if (item.min.x <= item.max.x) items.append_unsafe(item);
+    }
+
+    item.type = SpatialItemType::RobustPath;
+    for (uint64_t i = 0; i < robustpath_array.count; i++) {
+        item.min.x = item.min.y = DBL_MAX;
+        item.max.x = item.max.y = -DBL_MAX;
+        // NOTE: return ErrorCode ignored here
+        robustpath_array[i]->to_polygons(false, 0, array);
+        add_polygon_boxes(array, item.min, item.max);
+        item.index = i;
+        if (item.min.x <= item.max.x) items.append_unsafe(item);
+    }
+    array.clear();
+
+    item.type = SpatialItemType::Label;
+    for (uint64_t i = 0; i < label_array.count; i++) {
+        label_array[i]->bounding_box(item.min, item.max);
+        item.index = i;
+        items.append_unsafe(item);
+    }
+
+    item.type = SpatialItemType::Reference;
+    for (uint64_t i = 0; i < reference_array.count; i++) {
+        reference_array[i]->bounding_box(item.min, item.max, cache);
+        item.index = i;
+        if (item.min.x <= item.max.x) items.append_unsafe(item);
+    }
+
+    spatial_index.build(items);
+    spatial_index.element_counts[(uint8_t)SpatialItemType::Polygon] = polygon_array.count;
+    spatial_index.element_counts[(uint8_t)SpatialItemType::FlexPath] = flexpath_array.count;
+    spatial_index.element_counts[(uint8_t)SpatialItemType::RobustPath] = robustpath_array.count;
+    spatial_index.element_counts[(uint8_t)SpatialItemType::Label] = label_array.count;
+    spatial_index.element_counts[(uint8_t)SpatialItemType::Reference] = reference_array.count;
+    spatial_index.generation = index_generation;
+    return spatial_index;
+}
+
+bool Cell::has_spatial_index() const {
+    Map<uint64_t> generations = {};
+    bool result = has_spatial_index(generations);
+    generations.clear();
+    return result;
+}
+
+bool Cell::has_spatial_index(Map<uint64_t>& generations) const {
+    // Lazy cells are not loaded just to find out that there is no index
+    if (!spatial_index.valid || !is_loaded()) return false;
+    return spatial_index.element_counts[(uint8_t)SpatialItemType::Polygon] ==
+               polygon_array.count &&
+           spatial_index.element_counts[(uint8_t)SpatialItemType::FlexPath] ==
+               flexpath_array.count &&
+           spatial_index.element_counts[(uint8_t)SpatialItemType::RobustPath] ==
+               robustpath_array.count &&
+           spatial_index.element_counts[(uint8_t)SpatialItemType::Label] == label_array.count &&
+           spatial_index.element_counts[(uint8_t)SpatialItemType::Reference] ==
+               reference_array.count &&
+           spatial_index.generation == hierarchy_generation(*this, generations);
+}
+
 void Cell::copy_from(const Cell& cell, const char* new_name, bool deep_copy) {
+    cell.load();
     name = copy_string(new_name ? new_name : cell.name, NULL);
     properties = properties_copy(cell.properties);
 
@@ -364,12 +522,50 @@ void Cell::copy_from(const Cell& cell, const char* new_name, bool deep_copy) {
 
 void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
                         Tag tag, Array<Polygon*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_polygons(apply_repetitions, include_paths, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                        const Set<Tag>* tags, Array<Polygon*>& result) const {
+    Map<FlattenInfo> cache = {};
+    count_flatten_uses(depth, cache);
+    get_polygons(apply_repetitions, include_paths, depth, tags, cache, result);
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+void Cell::count_flatten_uses(int64_t depth, Map<FlattenInfo>& cache) const {
+    if (depth == 0) return;
+    load();
+    Reference** ref = reference_array.items;
+    for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
+        (*ref)->count_flatten_uses(depth > 0 ? depth - 1 : -1, cache);
+    }
+}
+
+void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
+                        Tag tag, Map<FlattenInfo>& cache, Array<Polygon*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_polygons(apply_repetitions, include_paths, depth, filter ? &tags : NULL, cache, result);
+    tags.clear();
+}
+
+void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                        const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                        Array<Polygon*>& result) const {
+    load();
     uint64_t start = result.count;
 
-    if (filter) {
+    if (tags) {
         for (uint64_t i = 0; i < polygon_array.count; i++) {
             Polygon* psrc = polygon_array[i];
-            if (psrc->tag != tag) continue;
+            if (!tags->has_value(psrc->tag)) continue;
             Polygon* poly = (Polygon*)allocate_clear(sizeof(Polygon));
             poly->copy_from(*psrc);
             result.append(poly);
@@ -387,13 +583,13 @@ void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t dept
         FlexPath** flexpath = flexpath_array.items;
         for (uint64_t i = 0; i < flexpath_array.count; i++, flexpath++) {
             // NOTE: return ErrorCode ignored here
-            (*flexpath)->to_polygons(filter, tag, result);
+            (*flexpath)->to_polygons(tags, result);
         }
 
         RobustPath** robustpath = robustpath_array.items;
         for (uint64_t i = 0; i < robustpath_array.count; i++, robustpath++) {
             // NOTE: return ErrorCode ignored here
-            (*robustpath)->to_polygons(filter, tag, result);
+            (*robustpath)->to_polygons(tags, result);
         }
     }
 
@@ -408,22 +604,31 @@ void Cell::get_polygons(bool apply_repetitions, bool include_paths, int64_t dept
         Reference** ref = reference_array.items;
         for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
             (*ref)->get_polygons(apply_repetitions, include_paths, depth > 0 ? depth - 1 : -1,
-                                 filter, tag, result);
+                                 tags, cache, result);
         }
     }
 }
 
 void Cell::get_flexpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                          Array<FlexPath*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_flexpaths(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Cell::get_flexpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                         Array<FlexPath*>& result) const {
+    load();
     uint64_t start = result.count;
 
-    if (filter) {
+    if (tags) {
         for (uint64_t i = 0; i < flexpath_array.count; i++) {
             FlexPath* psrc = flexpath_array[i];
             FlexPath* path = NULL;
             for (uint64_t j = 0; j < psrc->num_elements; j++) {
                 FlexPathElement* esrc = psrc->elements + j;
-                if (esrc->tag != tag) continue;
+                if (!tags->has_value(esrc->tag)) continue;
                 if (!path) {
                     path = (FlexPath*)allocate_clear(sizeof(FlexPath));
                     path->spine.copy_from(psrc->spine);
@@ -472,23 +677,31 @@ void Cell::get_flexpaths(bool apply_repetitions, int64_t depth, bool filter, Tag
     if (depth != 0) {
         Reference** ref = reference_array.items;
         for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
-            (*ref)->get_flexpaths(apply_repetitions, depth > 0 ? depth - 1 : -1, filter, tag,
-                                  result);
+            (*ref)->get_flexpaths(apply_repetitions, depth > 0 ? depth - 1 : -1, tags, result);
         }
     }
 }
 
 void Cell::get_robustpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                            Array<RobustPath*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_robustpaths(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Cell::get_robustpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                           Array<RobustPath*>& result) const {
+    load();
     uint64_t start = result.count;
 
-    if (filter) {
+    if (tags) {
         for (uint64_t i = 0; i < robustpath_array.count; i++) {
             RobustPath* psrc = robustpath_array[i];
             RobustPath* path = NULL;
             for (uint64_t j = 0; j < psrc->num_elements; j++) {
                 RobustPathElement* esrc = psrc->elements + j;
-                if (esrc->tag != tag) continue;
+                if (!tags->has_value(esrc->tag)) continue;
                 if (!path) {
                     path = (RobustPath*)allocate_clear(sizeof(RobustPath));
                     path->properties = properties_copy(psrc->properties);
@@ -538,20 +751,28 @@ void Cell::get_robustpaths(bool apply_repetitions, int64_t depth, bool filter, T
     if (depth != 0) {
         Reference** ref = reference_array.items;
         for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
-            (*ref)->get_robustpaths(apply_repetitions, depth > 0 ? depth - 1 : -1, filter, tag,
-                                    result);
+            (*ref)->get_robustpaths(apply_repetitions, depth > 0 ? depth - 1 : -1, tags, result);
         }
     }
 }
 
 void Cell::get_labels(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                       Array<Label*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_labels(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Cell::get_labels(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                      Array<Label*>& result) const {
+    load();
     uint64_t start = result.count;
 
-    if (filter) {
+    if (tags) {
         for (uint64_t i = 0; i < label_array.count; i++) {
             Label* lsrc = label_array[i];
-            if (lsrc->tag != tag) continue;
+            if (!tags->has_value(lsrc->tag)) continue;
             Label* label = (Label*)allocate_clear(sizeof(Label));
             label->copy_from(*lsrc);
             result.append(label);
@@ -575,19 +796,501 @@ void Cell::get_labels(bool apply_repetitions, int64_t depth, bool filter, Tag ta
     if (depth != 0) {
         Reference** ref = reference_array.items;
         for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
-            (*ref)->get_labels(apply_repetitions, depth > 0 ? depth - 1 : -1, filter, tag, result);
+            (*ref)->get_labels(apply_repetitions, depth > 0 ? depth - 1 : -1, tags, result);
+        }
+    }
+}
+
+void Cell::get_polygons_with_repetitions(bool include_paths, int64_t depth,
+                                         const Set<Tag>* tags, Array<Polygon*>& result) const {
+    Map<FlattenInfo> cache = {};
+    count_flatten_uses(depth, cache);
+    get_polygons_with_repetitions(include_paths, depth, tags, cache, result);
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+void Cell::get_polygons_with_repetitions(bool include_paths, int64_t depth,
+                                         const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                                         Array<Polygon*>& result) const {
+    get_polygons(false, include_paths, 0, tags, result);
+    if (depth != 0) {
+        Reference** ref = reference_array.items;
+        for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
+            (*ref)->get_polygons_with_repetitions(include_paths, depth > 0 ? depth - 1 : -1, tags,
+                                                  cache, result);
+        }
+    }
+}
+
+void Cell::get_flexpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                          Array<FlexPath*>& result) const {
+    get_flexpaths(false, 0, tags, result);
+    if (depth != 0) {
+        Reference** ref = reference_array.items;
+        for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
+            (*ref)->get_flexpaths_with_repetitions(depth > 0 ? depth - 1 : -1, tags, result);
+        }
+    }
+}
+
+void Cell::get_robustpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                            Array<RobustPath*>& result) const {
+    get_robustpaths(false, 0, tags, result);
+    if (depth != 0) {
+        Reference** ref = reference_array.items;
+        for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
+            (*ref)->get_robustpaths_with_repetitions(depth > 0 ? depth - 1 : -1, tags, result);
+        }
+    }
+}
+
+void Cell::get_labels_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                       Array<Label*>& result) const {
+    get_labels(false, 0, tags, result);
+    if (depth != 0) {
+        Reference** ref = reference_array.items;
+        for (uint64_t i = 0; i < reference_array.count; i++, ref++) {
+            (*ref)->get_labels_with_repetitions(depth > 0 ? depth - 1 : -1, tags, result);
+        }
+    }
+}
+
+static bool boxes_overlap(const Vec2 min1, const Vec2 max1, const Vec2 min2, const Vec2 max2) {
+    return min1.x <= max2.x && min2.x <= max1.x && min1.y <= max2.y && min2.y <= max1.y;
+}
+
+// Bounding box of polygon without its repetition
+static void polygon_extent(const Polygon* polygon, Vec2& min, Vec2& max) {
+    min.x = min.y = DBL_MAX;
+    max.x = max.y = -DBL_MAX;
+    const Vec2* p = polygon->point_array.items;
+    for (uint64_t num = polygon->point_array.count; num > 0; num--, p++) {
+        if (p->x < min.x) min.x = p->x;
+        if (p->x > max.x) max.x = p->x;
+        if (p->y < min.y) min.y = p->y;
+        if (p->y > max.y) max.y = p->y;
+    }
+}
+
+// Append to result the copies of polygon (including repetitions) that overlap
+// the region.  If owned is true, polygon is used for the first copy or freed.
+static void query_polygon(Polygon* polygon, bool owned, const Vec2 min, const Vec2 max,
+                          Array<Vec2>& offsets, Array<Polygon*>& result) {
+    Vec2 pmin, pmax;
+    polygon_extent(polygon, pmin, pmax);
+    offsets.count = 0;
+    if (polygon->repetition.type == RepetitionType::None) {
+        offsets.append(Vec2{0, 0});
+    } else {
+        polygon->repetition.get_offsets(offsets);
+    }
+    for (uint64_t i = 0; i < offsets.count; i++) {
+        const Vec2 offset = offsets[i];
+        if (!boxes_overlap(pmin + offset, pmax + offset, min, max)) continue;
+        Polygon* copy;
+        if (owned) {
+            copy = polygon;
+            owned = false;
+        } else {
+            copy = (Polygon*)allocate_clear(sizeof(Polygon));
+            copy->copy_from(*polygon);
+        }
+        copy->repetition.clear();
+        copy->translate(offset);
+        result.append(copy);
+    }
+    if (owned) {
+        polygon->clear();
+        free_allocation(polygon);
+    }
+}
+
+static void query_cell_region(const Cell& cell, const Vec2 min, const Vec2 max, bool include_paths,
+                              int64_t depth, const Set<Tag>* tags, Map<GeometryInfo>& cache,
+                              Map<uint64_t>& generations, Array<Polygon*>& result);
+
+// Append to result the polygons from the instances of reference that overlap
+// the region.
+static void query_reference_region(const Reference* reference, const Vec2 min, const Vec2 max,
+                                   bool include_paths, int64_t depth, const Set<Tag>* tags,
+                                   Map<GeometryInfo>& cache, Map<uint64_t>& generations,
+                                   Array<Vec2>& offsets, Array<Polygon*>& result) {
+    if (reference->type != ReferenceType::Cell) return;
+
+    Vec2 rmin, rmax;
+    reference->bounding_box(rmin, rmax, cache);
+    if (!boxes_overlap(rmin, rmax, min, max)) return;
+
+    // Bounding box of a single instance (shallow copy without the
+    // repetition, which is never cleared).
+    Reference instance = *reference;
+    instance.repetition.type = RepetitionType::None;
+    instance.bounding_box(rmin, rmax, cache);
+
+    offsets.count = 0;
+    if (reference->repetition.type == RepetitionType::None) {
+        offsets.append(Vec2{0, 0});
+    } else {
+        reference->repetition.get_offsets(offsets);
+    }
+
+    // Inverse of the reference transformation for the region corners
+    double ca, sa;
+    cos_sin(reference->rotation, ca, sa);
+    ca /= reference->magnification;
+    sa /= reference->magnification;
+    const double r = reference->x_reflection ? -1 : 1;
+    Array<Polygon*> array = {};
+    for (uint64_t j = 0; j < offsets.count; j++) {
+        const Vec2 offset = offsets[j];
+        if (!boxes_overlap(rmin + offset, rmax + offset, min, max)) continue;
+
+        const Vec2 translation = reference->origin + offset;
+        const Vec2 corners[4] = {min, Vec2{max.x, min.y}, max, Vec2{min.x, max.y}};
+        Vec2 cmin = {DBL_MAX, DBL_MAX};
+        Vec2 cmax = {-DBL_MAX, -DBL_MAX};
+        for (uint64_t k = 0; k < 4; k++) {
+            const Vec2 d = corners[k] - translation;
+            const Vec2 c = {d.x * ca + d.y * sa, r * (d.y * ca - d.x * sa)};
+            if (c.x < cmin.x) cmin.x = c.x;
+            if (c.x > cmax.x) cmax.x = c.x;
+            if (c.y < cmin.y) cmin.y = c.y;
+            if (c.y > cmax.y) cmax.y = c.y;
+        }
+
+        // The region in the referenced cell is only an approximation (for
+        // rotated references), so polygons are checked again.
+        query_cell_region(*reference->cell, cmin, cmax, include_paths, depth, tags, cache,
+                          generations, array);
+        for (uint64_t k = 0; k < array.count; k++) {
+            Polygon* polygon = array[k];
+            polygon->transform(reference->magnification, reference->x_reflection,
+                               reference->rotation, translation);
+            Vec2 pmin, pmax;
+            polygon_extent(polygon, pmin, pmax);
+            if (boxes_overlap(pmin, pmax, min, max)) {
+                result.append(polygon);
+            } else {
+                polygon->clear();
+                free_allocation(polygon);
+            }
+        }
+        array.count = 0;
+    }
+    array.clear();
+}
+
+static bool spatial_item_sorted(const SpatialItem& a, const SpatialItem& b) {
+    return a.type < b.type || (a.type == b.type && a.index < b.index);
+}
+
+static void query_cell_region(const Cell& cell, const Vec2 min, const Vec2 max, bool include_paths,
+                              int64_t depth, const Set<Tag>* tags, Map<GeometryInfo>& cache,
+                              Map<uint64_t>& generations, Array<Polygon*>& result) {
+    cell.load();
+    Array<Vec2> offsets = {};
+    Array<Polygon*> array = {};
+
+    if (cell.has_spatial_index(generations)) {
+        // Only the candidates from the index are checked, in the same order
+        // used in the linear search below.
+        Array<SpatialItem> items = {};
+        cell.spatial_index.query(min, max, items);
+        sort(items, spatial_item_sorted);
+        for (uint64_t i = 0; i < items.count; i++) {
+            const SpatialItem item = items[i];
+            switch (item.type) {
+                case SpatialItemType::Polygon: {
+                    Polygon* polygon = cell.polygon_array[item.index];
+                    if (tags && !tags->has_value(polygon->tag)) continue;
+                    query_polygon(polygon, false, min, max, offsets, result);
+                } break;
+                case SpatialItemType::FlexPath:
+                    // NOTE: return ErrorCode ignored here
+                    if (include_paths) cell.flexpath_array[item.index]->to_polygons(tags, array);
+                    break;
+                case SpatialItemType::RobustPath:
+                    // NOTE: return ErrorCode ignored here
+                    if (include_paths) cell.robustpath_array[item.index]->to_polygons(tags, array);
+                    break;
+                case SpatialItemType::Reference:
+                    if (depth != 0) {
+                        // Path polygons come before references
+                        for (uint64_t j = 0; j < array.count; j++) {
+                            query_polygon(array[j], true, min, max, offsets, result);
+                        }
+                        array.count = 0;
+                        query_reference_region(cell.reference_array[item.index], min, max,
+                                               include_paths, depth > 0 ? depth - 1 : -1, tags,
+                                               cache, generations, offsets, result);
+                    }
+                    break;
+                case SpatialItemType::Label:
+                    break;
+            }
+        }
+        items.clear();
+        for (uint64_t i = 0; i < array.count; i++) {
+            query_polygon(array[i], true, min, max, offsets, result);
+        }
+        array.clear();
+        offsets.clear();
+        return;
+    }
+
+    for (uint64_t i = 0; i < cell.polygon_array.count; i++) {
+        Polygon* polygon = cell.polygon_array[i];
+        if (tags && !tags->has_value(polygon->tag)) continue;
+        query_polygon(polygon, false, min, max, offsets, result);
+    }
+
+    if (include_paths) {
+        for (uint64_t i = 0; i < cell.flexpath_array.count; i++) {
+            // NOTE: return ErrorCode ignored here
+            cell.flexpath_array[i]->to_polygons(tags, array);
+        }
+        for (uint64_t i = 0; i < cell.robustpath_array.count; i++) {
+            // NOTE: return ErrorCode ignored here
+            cell.robustpath_array[i]->to_polygons(tags, array);
+        }
+        for (uint64_t i = 0; i < array.count; i++) {
+            query_polygon(array[i], true, min, max, offsets, result);
+        }
+        array.clear();
+    }
+
+    if (depth != 0) {
+        for (uint64_t i = 0; i < cell.reference_array.count; i++) {
+            query_reference_region(cell.reference_array[i], min, max, include_paths,
+                                   depth > 0 ? depth - 1 : -1, tags, cache, generations, offsets,
+                                   result);
+        }
+    }
+    offsets.clear();
+}
+
+void Cell::query_region(const Vec2 corner1, const Vec2 corner2, bool include_paths,
+                        int64_t depth, const Set<Tag>* tags, bool clip, double precision,
+                        Array<Polygon*>& result) const {
+    Map<GeometryInfo> cache = {};
+    query_region(corner1, corner2, include_paths, depth, tags, clip, precision, cache, result);
+    for (MapItem<GeometryInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+void Cell::query_region(const Vec2 corner1, const Vec2 corner2, bool include_paths,
+                        int64_t depth, const Set<Tag>* tags, bool clip, double precision,
+                        Map<GeometryInfo>& cache, Array<Polygon*>& result) const {
+    const Vec2 min = {corner1.x < corner2.x ? corner1.x : corner2.x,
+                      corner1.y < corner2.y ? corner1.y : corner2.y};
+    const Vec2 max = {corner1.x > corner2.x ? corner1.x : corner2.x,
+                      corner1.y > corner2.y ? corner1.y : corner2.y};
+    // Generations are shared by the index checks of all cells in the query
+    Map<uint64_t> generations = {};
+    if (!clip) {
+        query_cell_region(*this, min, max, include_paths, depth, tags, cache, generations, result);
+        generations.clear();
+        return;
+    }
+
+    Array<Polygon*> array = {};
+    query_cell_region(*this, min, max, include_paths, depth, tags, cache, generations, array);
+    generations.clear();
+    Polygon region = rectangle(min, max, 0);
+    const double scaling = 1 / precision;
+    for (uint64_t i = 0; i < array.count; i++) {
+        Polygon* polygon = array[i];
+        Vec2 pmin, pmax;
+        polygon_extent(polygon, pmin, pmax);
+        if (pmin.x >= min.x && pmin.y >= min.y && pmax.x <= max.x && pmax.y <= max.y) {
+            result.append(polygon);
+            continue;
+        }
+        uint64_t start = result.count;
+        // NOTE: return ErrorCode ignored here
+        boolean(*polygon, region, Operation::And, scaling, result);
+        for (uint64_t j = start; j < result.count; j++) {
+            result[j]->tag = polygon->tag;
+            result[j]->properties = properties_copy(polygon->properties);
+        }
+        polygon->clear();
+        free_allocation(polygon);
+    }
+    region.clear();
+    array.clear();
+}
+
+// Scratch buffers reused during the whole walk in Cell::visit_shapes.
+// Reference offsets must survive the recursion into the referenced cell, so
+// there is one array per hierarchy level.
+struct ShapeVisitState {
+    const ShapeVisitor* visitor;
+    bool apply_repetitions;
+    const Set<Tag>* tags;
+    Array<Vec2> points;
+    Array<Vec2> element_offsets;
+    Array<Array<Vec2>> reference_offsets;
+};
+
+// Offsets of the copies of an element: its repetition offsets if they must be
+// applied, or only the origin.
+static const Array<Vec2>& element_offsets(const Repetition& repetition, ShapeVisitState& state) {
+    Array<Vec2>& offsets = state.element_offsets;
+    offsets.count = 0;
+    if (state.apply_repetitions && repetition.type != RepetitionType::None) {
+        repetition.get_offsets(offsets);
+    } else {
+        offsets.append(Vec2{0, 0});
+    }
+    return offsets;
+}
+
+static AffineTransform translated(const AffineTransform& transform, const Vec2 offset) {
+    return AffineTransform{transform.xx, transform.xy, transform.yx, transform.yy,
+                           transform.apply(offset)};
+}
+
+template <class T>
+static bool path_has_tag(const T* path, const Set<Tag>* tags) {
+    for (uint64_t i = 0; i < path->num_elements; i++) {
+        if (tags->has_value(path->elements[i].tag)) return true;
+    }
+    return false;
+}
+
+static void visit_cell_shapes(const Cell& cell, int64_t depth, const AffineTransform& transform,
+                              uint64_t level, ShapeVisitState& state) {
+    cell.load();
+    const ShapeVisitor& visitor = *state.visitor;
+
+    if (visitor.polygon) {
+        for (uint64_t i = 0; i < cell.polygon_array.count; i++) {
+            const Polygon* polygon = cell.polygon_array[i];
+            if (state.tags && !state.tags->has_value(polygon->tag)) continue;
+            const Array<Vec2>& offsets = element_offsets(polygon->repetition, state);
+            for (uint64_t j = 0; j < offsets.count; j++) {
+                const AffineTransform tr = translated(transform, offsets[j]);
+                if (visitor.transform_points) {
+                    Array<Vec2>& points = state.points;
+                    points.count = 0;
+                    points.ensure_slots(polygon->point_array.count);
+                    const Vec2* src = polygon->point_array.items;
+                    Vec2* dst = points.items;
+                    for (uint64_t k = polygon->point_array.count; k > 0; k--) {
+                        *dst++ = tr.apply(*src++);
+                    }
+                    points.count = polygon->point_array.count;
+                    visitor.polygon(*polygon, tr, points, visitor.data);
+                } else {
+                    visitor.polygon(*polygon, tr, polygon->point_array, visitor.data);
+                }
+            }
+        }
+    }
+
+    if (visitor.flexpath) {
+        for (uint64_t i = 0; i < cell.flexpath_array.count; i++) {
+            const FlexPath* path = cell.flexpath_array[i];
+            if (state.tags && !path_has_tag(path, state.tags)) continue;
+            const Array<Vec2>& offsets = element_offsets(path->repetition, state);
+            for (uint64_t j = 0; j < offsets.count; j++) {
+                visitor.flexpath(*path, translated(transform, offsets[j]), visitor.data);
+            }
+        }
+    }
+
+    if (visitor.robustpath) {
+        for (uint64_t i = 0; i < cell.robustpath_array.count; i++) {
+            const RobustPath* path = cell.robustpath_array[i];
+            if (state.tags && !path_has_tag(path, state.tags)) continue;
+            const Array<Vec2>& offsets = element_offsets(path->repetition, state);
+            for (uint64_t j = 0; j < offsets.count; j++) {
+                visitor.robustpath(*path, translated(transform, offsets[j]), visitor.data);
+            }
+        }
+    }
+
+    if (visitor.label) {
+        for (uint64_t i = 0; i < cell.label_array.count; i++) {
+            const Label* label = cell.label_array[i];
+            if (state.tags && !state.tags->has_value(label->tag)) continue;
+            const Array<Vec2>& offsets = element_offsets(label->repetition, state);
+            for (uint64_t j = 0; j < offsets.count; j++) {
+                visitor.label(*label, translated(transform, offsets[j]), visitor.data);
+            }
+        }
+    }
+
+    if (depth == 0) return;
+
+    if (state.reference_offsets.count <= level) state.reference_offsets.append(Array<Vec2>{});
+    for (uint64_t i = 0; i < cell.reference_array.count; i++) {
+        const Reference* reference = cell.reference_array[i];
+        if (reference->type != ReferenceType::Cell) continue;
+
+        // Deeper levels may grow state.reference_offsets, but the items of
+        // this level's array are not moved.
+        Array<Vec2> offsets = state.reference_offsets[level];
+        offsets.count = 0;
+        if (reference->repetition.type != RepetitionType::None) {
+            reference->repetition.get_offsets(offsets);
+        } else {
+            offsets.append(Vec2{0, 0});
+        }
+        state.reference_offsets[level] = offsets;
+
+        for (uint64_t j = 0; j < offsets.count; j++) {
+            const AffineTransform tr = transform.compose(
+                make_transform(reference->magnification, reference->x_reflection,
+                               reference->rotation, reference->origin + offsets[j]));
+            visit_cell_shapes(*reference->cell, depth > 0 ? depth - 1 : -1, tr, level + 1, state);
         }
     }
 }
 
+void Cell::visit_shapes(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
+                        const ShapeVisitor& visitor) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    visit_shapes(apply_repetitions, depth, filter ? &tags : NULL, visitor);
+    tags.clear();
+}
+
+void Cell::visit_shapes(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                        const ShapeVisitor& visitor) const {
+    ShapeVisitState state = {};
+    state.visitor = &visitor;
+    state.apply_repetitions = apply_repetitions;
+    state.tags = tags;
+    visit_cell_shapes(*this, depth, identity_transform(), 0, state);
+    state.points.clear();
+    state.element_offsets.clear();
+    for (uint64_t i = 0; i < state.reference_offsets.count; i++) {
+        state.reference_offsets[i].clear();
+    }
+    state.reference_offsets.clear();
+}
+
 void Cell::flatten(bool apply_repetitions, Array<Reference*>& result) {
+    load();
+    mark_modified();
+    // Shared among references, so that each cell is flattened only once
+    Map<FlattenInfo> cache = {};
+    for (uint64_t j = 0; j < reference_array.count; j++) {
+        reference_array[j]->count_flatten_uses(-1, cache);
+    }
     uint64_t i = 0;
     while (i < reference_array.count) {
         Reference* ref = reference_array[i];
         if (ref->type == ReferenceType::Cell) {
             reference_array.remove_unordered(i);
             result.append(ref);
-            ref->get_polygons(apply_repetitions, false, -1, false, 0, polygon_array);
+            ref->get_polygons(apply_repetitions, false, -1, false, 0, cache, polygon_array);
             ref->get_flexpaths(apply_repetitions, -1, false, 0, flexpath_array);
             ref->get_robustpaths(apply_repetitions, -1, false, 0, robustpath_array);
             ref->get_labels(apply_repetitions, -1, false, 0, label_array);
@@ -595,9 +1298,614 @@ void Cell::flatten(bool apply_repetitions, Array<Reference*>& result) {
             ++i;
         }
     }
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+void Cell::flatten_with_repetitions(Array<Reference*>& result) {
+    load();
+    mark_modified();
+    Map<FlattenInfo> cache = {};
+    for (uint64_t j = 0; j < reference_array.count; j++) {
+        reference_array[j]->count_flatten_uses(-1, cache);
+    }
+    uint64_t i = 0;
+    while (i < reference_array.count) {
+        Reference* ref = reference_array[i];
+        if (ref->type == ReferenceType::Cell) {
+            reference_array.remove_unordered(i);
+            result.append(ref);
+            ref->get_polygons_with_repetitions(false, -1, NULL, cache, polygon_array);
+            ref->get_flexpaths_with_repetitions(-1, NULL, flexpath_array);
+            ref->get_robustpaths_with_repetitions(-1, NULL, robustpath_array);
+            ref->get_labels_with_repetitions(-1, NULL, label_array);
+        } else {
+            ++i;
+        }
+    }
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+// Node of the flattening graph used by get_polygons_parallel: the polygons
+// of cell flattened up to depth.  The first own_count polygons in
+// polygon_array belong to the cell's own polygons (shared by all nodes of the
+// same cell); the remaining ones are the transformed copies from references.
+struct FlattenNode {
+    const Cell* cell;
+    int64_t depth;
+    uint64_t height;      // Distance to the deepest node below this one
+    uint64_t own_index;   // Index in FlattenGraph::own_array
+    uint64_t next;        // Next node for the same cell (other depth) + 1, or 0
+    Array<uint64_t> children;  // Node for each reference (UINT64_MAX if not a cell reference)
+    Array<Polygon*> polygon_array;
+    uint64_t own_count;
+};
+
+struct FlattenGraph {
+    bool apply_repetitions;
+    bool include_paths;
+    const Set<Tag>* tags;
+    Array<FlattenNode> node_array;
+    Array<const Cell*> cell_array;
+    Array<Array<Polygon*>> own_array;  // Own polygons for each cell in cell_array
+    Map<uint64_t> first_node;          // First node for each cell name + 1
+};
+
+// Range of transformed copies generated by one task.  Copy j (start <= j <
+// end) is polygon source[j / offset_count] translated by
+// offsets[j % offset_count] and stored in destination[j].
+struct FlattenChunk {
+    const Reference* reference;
+    Polygon* const* source;
+    const Vec2* offsets;
+    uint64_t offset_count;
+    uint64_t start;
+    uint64_t end;
+    Polygon** destination;
+};
+
+#define GDSTK_FLATTEN_CHUNK_SIZE 1024
+
+static uint64_t add_flatten_node(FlattenGraph& graph, const Cell* cell, int64_t depth) {
+    uint64_t first = graph.first_node.get(cell->name);
+    for (uint64_t n = first; n > 0; n = graph.node_array[n - 1].next) {
+        if (graph.node_array[n - 1].depth == depth) return n - 1;
+    }
+
+    // Cells are loaded here, before any parallel work
+    cell->load();
+    FlattenNode node = {};
+    node.cell = cell;
+    node.depth = depth;
+    if (first > 0) {
+        node.own_index = graph.node_array[first - 1].own_index;
+    } else {
+        node.own_index = graph.cell_array.count;
+        graph.cell_array.append(cell);
+    }
+    const uint64_t index = graph.node_array.count;
+    graph.node_array.append(node);
+    if (first > 0) {
+        uint64_t n = first;
+        while (graph.node_array[n - 1].next > 0) n = graph.node_array[n - 1].next;
+        graph.node_array[n - 1].next = index + 1;
+    } else {
+        graph.first_node.set(cell->name, index + 1);
+    }
+
+    if (depth != 0) {
+        Array<uint64_t> children = {};
+        uint64_t height = 0;
+        children.ensure_slots(cell->reference_array.count);
+        for (uint64_t i = 0; i < cell->reference_array.count; i++) {
+            const Reference* reference = cell->reference_array[i];
+            if (reference->type != ReferenceType::Cell) {
+                children.append_unsafe(UINT64_MAX);
+                continue;
+            }
+            uint64_t child =
+                add_flatten_node(graph, reference->cell, depth > 0 ? depth - 1 : -1);
+            children.append_unsafe(child);
+            if (graph.node_array[child].height + 1 > height) {
+                height = graph.node_array[child].height + 1;
+            }
+        }
+        graph.node_array[index].children = children;
+        graph.node_array[index].height = height;
+    }
+    return index;
+}
+
+static void flatten_own_polygons(uint64_t index, void* data) {
+    FlattenGraph* graph = (FlattenGraph*)data;
+    graph->cell_array[index]->get_polygons(graph->apply_repetitions, graph->include_paths, 0,
+                                           graph->tags, graph->own_array[index]);
+}
+
+static void flatten_chunk(uint64_t index, void* data) {
+    const FlattenChunk chunk = ((FlattenChunk*)data)[index];
+    const Reference* reference = chunk.reference;
+    for (uint64_t j = chunk.start; j < chunk.end; j++) {
+        Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+        polygon->copy_from(*chunk.source[j / chunk.offset_count]);
+        polygon->transform(reference->magnification, reference->x_reflection, reference->rotation,
+                           reference->origin + chunk.offsets[j % chunk.offset_count]);
+        polygon->repetition.transform(reference->magnification, reference->x_reflection,
+                                      reference->rotation);
+        chunk.destination[j] = polygon;
+    }
+}
+
+// Append to chunks the tasks that generate the polygons of references
+// (through the respective nodes in children) into destination, which must
+// have enough room for all of them.  Returns the number of polygons.  The
+// repetition offsets are appended to offsets and must be kept until the
+// chunks are processed.
+static uint64_t add_flatten_chunks(const FlattenGraph& graph,
+                                   const Array<Reference*>& references,
+                                   const Array<uint64_t>& children, Polygon** destination,
+                                   Array<Array<Vec2>>& offsets, Array<FlattenChunk>& chunks) {
+    static const Vec2 zero = {0, 0};
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < references.count; i++) {
+        if (children[i] == UINT64_MAX) continue;
+        const Reference* reference = references[i];
+        const Array<Polygon*>& source = graph.node_array[children[i]].polygon_array;
+        FlattenChunk chunk = {reference, source.items, &zero, 1, 0, 0, destination + total};
+        if (reference->repetition.type != RepetitionType::None) {
+            Array<Vec2> array = {};
+            reference->repetition.get_offsets(array);
+            offsets.append(array);
+            chunk.offsets = array.items;
+            chunk.offset_count = array.count;
+        }
+        const uint64_t count = source.count * chunk.offset_count;
+        for (uint64_t start = 0; start < count; start += GDSTK_FLATTEN_CHUNK_SIZE) {
+            chunk.start = start;
+            chunk.end = start + GDSTK_FLATTEN_CHUNK_SIZE < count ? start + GDSTK_FLATTEN_CHUNK_SIZE
+                                                                  : count;
+            chunks.append(chunk);
+        }
+        total += count;
+    }
+    return total;
+}
+
+static uint64_t flatten_count(const FlattenGraph& graph, const Array<Reference*>& references,
+                              const Array<uint64_t>& children) {
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < references.count; i++) {
+        if (children[i] == UINT64_MAX) continue;
+        const Repetition& repetition = references[i]->repetition;
+        const uint64_t copies =
+            repetition.type == RepetitionType::None ? 1 : repetition.get_count();
+        total += graph.node_array[children[i]].polygon_array.count * copies;
+    }
+    return total;
+}
+
+// Append to result the polygons from references, as in
+// Reference::get_polygons, flattening the referenced cells in parallel.
+static void get_references_polygons_parallel(const Array<Reference*>& references,
+                                             bool apply_repetitions, bool include_paths,
+                                             int64_t depth, const Set<Tag>* tags,
+                                             uint32_t num_threads, Array<Polygon*>& result) {
+    FlattenGraph graph = {apply_repetitions, include_paths, tags};
+    Array<uint64_t> children = {};
+    children.ensure_slots(references.count);
+    uint64_t max_height = 0;
+    for (uint64_t i = 0; i < references.count; i++) {
+        const Reference* reference = references[i];
+        if (reference->type != ReferenceType::Cell) {
+            children.append_unsafe(UINT64_MAX);
+            continue;
+        }
+        uint64_t child = add_flatten_node(graph, reference->cell, depth);
+        children.append_unsafe(child);
+        if (graph.node_array[child].height > max_height) {
+            max_height = graph.node_array[child].height;
+        }
+    }
+
+    graph.own_array.ensure_slots(graph.cell_array.count);
+    memset(graph.own_array.items, 0, graph.cell_array.count * sizeof(Array<Polygon*>));
+    graph.own_array.count = graph.cell_array.count;
+    parallel_for(graph.cell_array.count, num_threads, flatten_own_polygons, &graph);
+
+    // Bottom-up, one hierarchy level at a time
+    Array<Array<Vec2>> offsets = {};
+    Array<FlattenChunk> chunks = {};
+    for (uint64_t height = 0; height <= max_height; height++) {
+        for (uint64_t i = 0; i < graph.node_array.count; i++) {
+            FlattenNode* node = graph.node_array.items + i;
+            if (node->height != height) continue;
+            const Array<Polygon*>& own = graph.own_array[node->own_index];
+            const Array<Reference*>& node_references = node->cell->reference_array;
+            uint64_t count = own.count;
+            if (node->children.count > 0) {
+                count += flatten_count(graph, node_references, node->children);
+            }
+            node->polygon_array.ensure_slots(count);
+            node->polygon_array.count = count;
+            node->own_count = own.count;
+            memcpy(node->polygon_array.items, own.items, own.count * sizeof(Polygon*));
+            if (node->children.count > 0) {
+                add_flatten_chunks(graph, node_references, node->children,
+                                   node->polygon_array.items + own.count, offsets, chunks);
+            }
+        }
+        parallel_for(chunks.count, num_threads, flatten_chunk, chunks.items);
+        chunks.count = 0;
+        for (uint64_t i = 0; i < offsets.count; i++) offsets[i].clear();
+        offsets.count = 0;
+    }
+
+    uint64_t count = flatten_count(graph, references, children);
+    result.ensure_slots(count);
+    add_flatten_chunks(graph, references, children, result.items + result.count, offsets,
+                       chunks);
+    parallel_for(chunks.count, num_threads, flatten_chunk, chunks.items);
+    result.count += count;
+
+    for (uint64_t i = 0; i < offsets.count; i++) offsets[i].clear();
+    offsets.clear();
+    chunks.clear();
+    children.clear();
+    for (uint64_t i = 0; i < graph.node_array.count; i++) {
+        FlattenNode* node = graph.node_array.items + i;
+        for (uint64_t j = node->own_count; j < node->polygon_array.count; j++) {
+            node->polygon_array[j]->clear();
+            free_allocation(node->polygon_array[j]);
+        }
+        node->polygon_array.clear();
+        node->children.clear();
+    }
+    for (uint64_t i = 0; i < graph.own_array.count; i++) {
+        Array<Polygon*>& own = graph.own_array[i];
+        for (uint64_t j = 0; j < own.count; j++) {
+            own[j]->clear();
+            free_allocation(own[j]);
+        }
+        own.clear();
+    }
+    graph.own_array.clear();
+    graph.node_array.clear();
+    graph.cell_array.clear();
+    graph.first_node.clear();
+}
+
+void Cell::get_polygons_parallel(bool apply_repetitions, bool include_paths, int64_t depth,
+                                 const Set<Tag>* tags, uint32_t num_threads,
+                                 Array<Polygon*>& result) const {
+    get_polygons(apply_repetitions, include_paths, 0, tags, result);
+    if (depth != 0) {
+        get_references_polygons_parallel(reference_array, apply_repetitions, include_paths,
+                                         depth > 0 ? depth - 1 : -1, tags, num_threads, result);
+    }
+}
+
+void Cell::flatten_parallel(bool apply_repetitions, uint32_t num_threads,
+                            Array<Reference*>& result) {
+    load();
+    mark_modified();
+    // References are removed in the same order as in flatten, so that the
+    // elements are appended in the same order.
+    Array<Reference*> removed = {};
+    uint64_t i = 0;
+    while (i < reference_array.count) {
+        Reference* ref = reference_array[i];
+        if (ref->type == ReferenceType::Cell) {
+            reference_array.remove_unordered(i);
+            removed.append(ref);
+        } else {
+            ++i;
+        }
+    }
+    get_references_polygons_parallel(removed, apply_repetitions, false, -1, NULL, num_threads,
+                                      polygon_array);
+    for (i = 0; i < removed.count; i++) {
+        Reference* ref = removed[i];
+        ref->get_flexpaths(apply_repetitions, -1, false, 0, flexpath_array);
+        ref->get_robustpaths(apply_repetitions, -1, false, 0, robustpath_array);
+        ref->get_labels(apply_repetitions, -1, false, 0, label_array);
+    }
+    result.extend(removed);
+    removed.clear();
+}
+
+// Elements considered by Cell::extract_repetitions
+struct RepetitionCandidate {
+    uint64_t signature;  // Hash invariant under translations on the grid
+    uint64_t index;      // Index of the element in the cell array
+    IntVec2 origin;      // Element position on the grid
+};
+
+// Evenly spaced elements along a row of the grid.  Members are
+// group[first] and group[next] through group[next + count - 2].
+struct RepetitionRun {
+    IntVec2 start;
+    int64_t step;
+    uint64_t count;
+    uint64_t first;
+    uint64_t next;
+};
+
+static bool repetition_signature_less(const RepetitionCandidate& a, const RepetitionCandidate& b) {
+    return a.signature < b.signature || (a.signature == b.signature && a.index < b.index);
+}
+
+static bool repetition_origin_less(const RepetitionCandidate& a, const RepetitionCandidate& b) {
+    if (a.origin.y != b.origin.y) return a.origin.y < b.origin.y;
+    if (a.origin.x != b.origin.x) return a.origin.x < b.origin.x;
+    return a.index < b.index;
+}
+
+static bool repetition_run_less(const RepetitionRun& a, const RepetitionRun& b) {
+    if (a.start.x != b.start.x) return a.start.x < b.start.x;
+    if (a.step != b.step) return a.step < b.step;
+    if (a.count != b.count) return a.count < b.count;
+    return a.start.y < b.start.y;
+}
+
+static inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+    return (seed ^ hash(value)) * HASH_FNV_PRIME;
+}
+
+static inline IntVec2 grid_point(const Vec2 point, double precision) {
+    return IntVec2{(int64_t)llround(point.x / precision), (int64_t)llround(point.y / precision)};
+}
+
+static bool repetition_candidate(const Polygon* polygon, double precision,
+                                 RepetitionCandidate& candidate) {
+    if (polygon->repetition.type != RepetitionType::None || polygon->properties ||
+        polygon->point_array.count == 0)
+        return false;
+    const Vec2* point = polygon->point_array.items;
+    candidate.origin = grid_point(*point, precision);
+    uint64_t signature = hash_combine(hash(polygon->tag), polygon->point_array.count);
+    for (uint64_t i = polygon->point_array.count; i > 0; i--) {
+        IntVec2 delta = grid_point(*point++, precision) - candidate.origin;
+        signature = hash_combine(hash_combine(signature, delta.x), delta.y);
+    }
+    candidate.signature = signature;
+    return true;
+}
+
+static bool repetition_match(const Polygon* polygon1, const Polygon* polygon2, double precision) {
+    if (polygon1->tag != polygon2->tag ||
+        polygon1->point_array.count != polygon2->point_array.count)
+        return false;
+    const Vec2* p1 = polygon1->point_array.items;
+    const Vec2* p2 = polygon2->point_array.items;
+    const IntVec2 origin1 = grid_point(*p1, precision);
+    const IntVec2 origin2 = grid_point(*p2, precision);
+    for (uint64_t i = polygon1->point_array.count; i > 0; i--) {
+        if (!(grid_point(*p1++, precision) - origin1 == grid_point(*p2++, precision) - origin2))
+            return false;
+    }
+    return true;
+}
+
+static bool repetition_candidate(const Reference* reference, double precision,
+                                 RepetitionCandidate& candidate) {
+    if (reference->repetition.type != RepetitionType::None || reference->properties) return false;
+    uint64_t signature = hash((uint64_t)reference->type);
+    switch (reference->type) {
+        case ReferenceType::Cell:
+            signature = hash_combine(signature, hash(reference->cell));
+            break;
+        case ReferenceType::RawCell:
+            signature = hash_combine(signature, hash(reference->rawcell));
+            break;
+        case ReferenceType::Name:
+            signature = hash_combine(signature, hash(reference->name));
+    }
+    signature = hash_combine(signature, hash(reference->rotation));
+    signature = hash_combine(signature, hash(reference->magnification));
+    candidate.signature = hash_combine(signature, reference->x_reflection ? 1 : 0);
+    candidate.origin = grid_point(reference->origin, precision);
+    return true;
+}
+
+static bool repetition_match(const Reference* reference1, const Reference* reference2, double) {
+    if (reference1->type != reference2->type || reference1->rotation != reference2->rotation ||
+        reference1->magnification != reference2->magnification ||
+        reference1->x_reflection != reference2->x_reflection)
+        return false;
+    switch (reference1->type) {
+        case ReferenceType::Cell:
+            return reference1->cell == reference2->cell;
+        case ReferenceType::RawCell:
+            return reference1->rawcell == reference2->rawcell;
+        case ReferenceType::Name:
+            return strcmp(reference1->name, reference2->name) == 0;
+    }
+    return false;
+}
+
+// Fold a group of identical elements into repetitions.  The group is sorted by
+// position, rows of evenly spaced elements are found and stacked into
+// rectangular arrays, and the remaining elements are joined in a single
+// regular or explicit repetition.  Elements at repeated positions are left
+// untouched.  Repetitions are set in the first element of each block and the
+// other elements in the block are marked in folded.
+template <class T>
+static void fold_repetitions(Array<T*>& elements, Array<RepetitionCandidate>& group,
+                             double precision, bool* folded) {
+    sort(group, repetition_origin_less);
+
+    Array<RepetitionRun> runs = {};
+    Array<uint64_t> singles = {};
+    uint64_t i = 0;
+    while (i < group.count) {
+        const IntVec2 origin = group[i].origin;
+        uint64_t j = i + 1;
+        while (j < group.count && group[j].origin == origin) j++;
+        if (j < group.count && group[j].origin.y == origin.y) {
+            RepetitionRun run = {origin, group[j].origin.x - origin.x, 2, i, j};
+            uint64_t k = j;
+            while (k + 1 < group.count && group[k + 1].origin.y == origin.y &&
+                   group[k + 1].origin.x - group[k].origin.x == run.step) {
+                k++;
+                run.count++;
+            }
+            runs.append(run);
+            i = k + 1;
+        } else {
+            singles.append(i);
+            i = j;
+        }
+    }
+
+    sort(runs, repetition_run_less);
+    i = 0;
+    while (i < runs.count) {
+        const RepetitionRun& run = runs[i];
+        uint64_t j = i + 1;
+        int64_t step_y = 0;
+        if (j < runs.count && runs[j].start.x == run.start.x && runs[j].step == run.step &&
+            runs[j].count == run.count) {
+            step_y = runs[j].start.y - run.start.y;
+            if (step_y > 0) {
+                while (j < runs.count && runs[j].start.x == run.start.x &&
+                       runs[j].step == run.step && runs[j].count == run.count &&
+                       runs[j].start.y - runs[j - 1].start.y == step_y)
+                    j++;
+            } else {
+                step_y = 0;
+            }
+        }
+
+        T* element = elements[group[run.first].index];
+        Repetition* repetition = &element->repetition;
+        repetition->type = RepetitionType::Rectangular;
+        repetition->columns = run.count;
+        repetition->rows = j - i;
+        repetition->spacing = Vec2{run.step * precision, step_y * precision};
+
+        for (; i < j; i++) {
+            const RepetitionRun& r = runs[i];
+            if (r.first != run.first) folded[group[r.first].index] = true;
+            for (uint64_t k = r.next; k < r.next + r.count - 1; k++) folded[group[k].index] = true;
+        }
+    }
+    runs.clear();
+
+    if (singles.count > 1) {
+        const IntVec2 origin = group[singles[0]].origin;
+        const IntVec2 step = group[singles[1]].origin - origin;
+        bool regular = true;
+        bool same_x = true;
+        bool same_y = true;
+        for (i = 1; i < singles.count; i++) {
+            const IntVec2 delta = group[singles[i]].origin - group[singles[i - 1]].origin;
+            if (!(delta == step)) regular = false;
+            if (delta.x != 0) same_x = false;
+            if (delta.y != 0) same_y = false;
+        }
+
+        Repetition* repetition = &elements[group[singles[0]].index]->repetition;
+        if (regular) {
+            repetition->type = RepetitionType::Regular;
+            repetition->columns = singles.count;
+            repetition->rows = 1;
+            repetition->v1 = Vec2{step.x * precision, step.y * precision};
+            repetition->v2 = Vec2{0, 0};
+        } else if (same_x || same_y) {
+            repetition->type = same_y ? RepetitionType::ExplicitX : RepetitionType::ExplicitY;
+            repetition->coords = {};
+            repetition->coords.ensure_slots(singles.count - 1);
+            for (i = 1; i < singles.count; i++) {
+                const IntVec2 delta = group[singles[i]].origin - origin;
+                repetition->coords.append_unsafe((same_y ? delta.x : delta.y) * precision);
+            }
+        } else {
+            repetition->type = RepetitionType::Explicit;
+            repetition->offsets = {};
+            repetition->offsets.ensure_slots(singles.count - 1);
+            for (i = 1; i < singles.count; i++) {
+                const IntVec2 delta = group[singles[i]].origin - origin;
+                repetition->offsets.append_unsafe(Vec2{delta.x * precision, delta.y * precision});
+            }
+        }
+        for (i = 1; i < singles.count; i++) folded[group[singles[i]].index] = true;
+    }
+    singles.clear();
+}
+
+template <class T>
+static void extract_element_repetitions(Array<T*>& elements, double precision,
+                                        Array<T*>& removed) {
+    Array<RepetitionCandidate> candidates = {};
+    candidates.ensure_slots(elements.count);
+    for (uint64_t i = 0; i < elements.count; i++) {
+        RepetitionCandidate candidate = {};
+        candidate.index = i;
+        if (repetition_candidate(elements[i], precision, candidate))
+            candidates.append_unsafe(candidate);
+    }
+    if (candidates.count < 2) {
+        candidates.clear();
+        return;
+    }
+    sort(candidates, repetition_signature_less);
+
+    bool* folded = (bool*)allocate_clear(elements.count * sizeof(bool));
+    bool* grouped = (bool*)allocate_clear(candidates.count * sizeof(bool));
+    Array<RepetitionCandidate> group = {};
+    uint64_t start = 0;
+    while (start < candidates.count) {
+        uint64_t end = start + 1;
+        while (end < candidates.count && candidates[end].signature == candidates[start].signature)
+            end++;
+        // Equal signatures are verified, so hash collisions only split groups
+        for (uint64_t i = start; i < end; i++) {
+            if (grouped[i]) continue;
+            const T* element = elements[candidates[i].index];
+            group.count = 0;
+            group.append(candidates[i]);
+            for (uint64_t j = i + 1; j < end; j++) {
+                if (!grouped[j] &&
+                    repetition_match(element, elements[candidates[j].index], precision)) {
+                    grouped[j] = true;
+                    group.append(candidates[j]);
+                }
+            }
+            if (group.count > 1) fold_repetitions(elements, group, precision, folded);
+        }
+        start = end;
+    }
+    group.clear();
+    free_allocation(grouped);
+    candidates.clear();
+
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < elements.count; i++) {
+        if (folded[i]) {
+            removed.append(elements[i]);
+        } else {
+            elements[count++] = elements[i];
+        }
+    }
+    elements.count = count;
+    free_allocation(folded);
+}
+
+void Cell::extract_repetitions(double precision, Array<Polygon*>& removed_polygons,
+                               Array<Reference*>& removed_references) {
+    load();
+    mark_modified();
+    extract_element_repetitions(polygon_array, precision, removed_polygons);
+    extract_element_repetitions(reference_array, precision, removed_references);
 }
 
 void Cell::remap_tags(const TagMap& map) {
+    load();
     for (uint64_t i = 0; i < polygon_array.count; i++) {
         Polygon* polygon = polygon_array[i];
         polygon->tag = map.get(polygon->tag);
@@ -621,6 +1929,22 @@ void Cell::remap_tags(const TagMap& map) {
 }
 
 void Cell::get_dependencies(bool recursive, Map<Cell*>& result) const {
+    if (!is_loaded()) {
+        // References are known from the file index without loading the cell
+        Array<Cell*> dependencies = {};
+        if (gdsii_get_lazy_dependencies(*this, dependencies)) {
+            for (uint64_t i = 0; i < dependencies.count; i++) {
+                Cell* cell = dependencies[i];
+                if (recursive && result.get(cell->name) != cell) {
+                    cell->get_dependencies(true, result);
+                }
+                result.set(cell->name, cell);
+            }
+            dependencies.clear();
+            return;
+        }
+    }
+    load();
     Reference** reference = reference_array.items;
     for (uint64_t i = 0; i < reference_array.count; i++, reference++) {
         if ((*reference)->type == ReferenceType::Cell) {
@@ -634,6 +1958,18 @@ void Cell::get_dependencies(bool recursive, Map<Cell*>& result) const {
 }
 
 void Cell::get_raw_dependencies(bool recursive, Map<RawCell*>& result) const {
+    if (!is_loaded()) {
+        // Lazy cells only reference other cells from the same file
+        if (!recursive) return;
+        Array<Cell*> dependencies = {};
+        const bool indexed = gdsii_get_lazy_dependencies(*this, dependencies);
+        for (uint64_t i = 0; i < dependencies.count; i++) {
+            dependencies[i]->get_raw_dependencies(true, result);
+        }
+        dependencies.clear();
+        if (indexed) return;
+    }
+    load();
     Reference** reference = reference_array.items;
     for (uint64_t i = 0; i < reference_array.count; i++, reference++) {
         Reference* ref = *reference;
@@ -650,6 +1986,7 @@ void Cell::get_raw_dependencies(bool recursive, Map<RawCell*>& result) const {
 }
 
 void Cell::get_shape_tags(Set<Tag>& result) const {
+    load();
     for (uint64_t i = 0; i < polygon_array.count; i++) {
         result.add(polygon_array[i]->tag);
     }
@@ -670,6 +2007,7 @@ void Cell::get_shape_tags(Set<Tag>& result) const {
 }
 
 void Cell::get_label_tags(Set<Tag>& result) const {
+    load();
     for (uint64_t i = 0; i < label_array.count; i++) {
         result.add(label_array[i]->tag);
     }
@@ -677,6 +2015,7 @@ void Cell::get_label_tags(Set<Tag>& result) const {
 
 ErrorCode Cell::to_gds(FILE* out, double scaling, uint64_t max_points, double precision,
                        const tm* timestamp) const {
+    load();
     ErrorCode error_code = ErrorCode::NoError;
     uint64_t len = strlen(name);
     if (len % 2) len++;
@@ -814,6 +2153,7 @@ ErrorCode Cell::to_gds(FILE* out, double scaling, uint64_t max_points, double pr
 
 ErrorCode Cell::to_svg(FILE* out, double scaling, uint32_t precision, const char* attributes,
                        PolygonComparisonFunction comparison) const {
+    load();
     ErrorCode error_code = ErrorCode::NoError;
     char* buffer = (char*)allocate(strlen(name) + 1);
     // NOTE: Here be dragons if name is not ASCII.  The GDSII specification imposes ASCII-only
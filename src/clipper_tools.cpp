@@ -11,12 +11,18 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <new>
 
 #include <gdstk/allocator.hpp>
 #include <gdstk/array.hpp>
 #include <gdstk/clipper_tools.hpp>
 #include <gdstk/polygon.hpp>
+#include <gdstk/simd.hpp>
 #include <gdstk/sort.hpp>
+#include <gdstk/spatialindex.hpp>
 #include <gdstk/utils.hpp>
 #include <gdstk/vec.hpp>
 
@@ -88,41 +94,17 @@ static inline bool path_less(const SortingPath& p1, const SortingPath& p2) {
     return point_less(*p1.min_point, *p2.min_point);
 }
 
-static void link_holes(ClipperLib::PolyNode* node, ErrorCode& error_code) {
-    /*
-    static int dbg_counter = 0;
-    char dbg_name[16];
-    snprintf(dbg_name, COUNT(dbg_name), "d%d.gds", dbg_counter++);
-    Library dbg_library = {.name = dbg_name, .unit = 1e-6, .precision = 1e-9};
-    Cell dbg_cell = {.name = dbg_name};
-    dbg_library.cell_array.append(&dbg_cell);
-    Polygon* dbg_poly = (Polygon*)allocate_clear(sizeof(Polygon));
-    dbg_cell.polygon_array.append(dbg_poly);
-    dbg_poly->tag = make_tag(1, 0);
-    ClipperLib::Path dbg_path = node->Contour;
-    for (ClipperLib::Path::iterator pt = dbg_path.begin(); pt != dbg_path.end(); pt++)
-        dbg_poly->point_array.append(Vec2{(double)pt->X, (double)pt->Y});
-    for (ClipperLib::PolyNodes::iterator child = node->Childs.begin(); child != node->Childs.end();
-         child++) {
-        dbg_poly = (Polygon*)allocate_clear(sizeof(Polygon));
-        dbg_cell.polygon_array.append(dbg_poly);
-        dbg_path = (*child)->Contour;
-        for (ClipperLib::Path::iterator pt = dbg_path.begin(); pt != dbg_path.end(); pt++)
-            dbg_poly->point_array.append(Vec2{(double)pt->X, (double)pt->Y});
-    }
-    printf("Debug library %s written with %ld polygons\n", dbg_name, dbg_cell.polygon_array.count);
-    dbg_library.write_gds(dbg_name, 0, NULL);
-    */
-
+// Holes are linked to the contour (in place) through bridges from their
+// minimal points.  They must be oriented opposite to the contour.
+static void link_hole_paths(ClipperLib::Path* contour, const Array<ClipperLib::Path*>& paths,
+                            ErrorCode& error_code) {
     Array<SortingPath> holes = {};
-    holes.ensure_slots(node->ChildCount());
+    holes.ensure_slots(paths.count);
 
-    ClipperLib::Path* contour = &node->Contour;
     uint64_t count = contour->size();
-    for (ClipperLib::PolyNodes::iterator child = node->Childs.begin(); child != node->Childs.end();
-         child++) {
-        count += (*child)->Contour.size() + 3;
-        SortingPath sp = {&(*child)->Contour};
+    for (uint64_t i = 0; i < paths.count; i++) {
+        count += paths[i]->size() + 3;
+        SortingPath sp = {paths[i]};
         sp.min_point = sp.path->begin();
         for (ClipperLib::Path::iterator point = sp.path->begin(); point != sp.path->end();
              point++) {
@@ -180,6 +162,42 @@ static void link_holes(ClipperLib::PolyNode* node, ErrorCode& error_code) {
     holes.clear();
 }
 
+static void link_holes(ClipperLib::PolyNode* node, ErrorCode& error_code) {
+    /*
+    static int dbg_counter = 0;
+    char dbg_name[16];
+    snprintf(dbg_name, COUNT(dbg_name), "d%d.gds", dbg_counter++);
+    Library dbg_library = {.name = dbg_name, .unit = 1e-6, .precision = 1e-9};
+    Cell dbg_cell = {.name = dbg_name};
+    dbg_library.cell_array.append(&dbg_cell);
+    Polygon* dbg_poly = (Polygon*)allocate_clear(sizeof(Polygon));
+    dbg_cell.polygon_array.append(dbg_poly);
+    dbg_poly->tag = make_tag(1, 0);
+    ClipperLib::Path dbg_path = node->Contour;
+    for (ClipperLib::Path::iterator pt = dbg_path.begin(); pt != dbg_path.end(); pt++)
+        dbg_poly->point_array.append(Vec2{(double)pt->X, (double)pt->Y});
+    for (ClipperLib::PolyNodes::iterator child = node->Childs.begin(); child != node->Childs.end();
+         child++) {
+        dbg_poly = (Polygon*)allocate_clear(sizeof(Polygon));
+        dbg_cell.polygon_array.append(dbg_poly);
+        dbg_path = (*child)->Contour;
+        for (ClipperLib::Path::iterator pt = dbg_path.begin(); pt != dbg_path.end(); pt++)
+            dbg_poly->point_array.append(Vec2{(double)pt->X, (double)pt->Y});
+    }
+    printf("Debug library %s written with %ld polygons\n", dbg_name, dbg_cell.polygon_array.count);
+    dbg_library.write_gds(dbg_name, 0, NULL);
+    */
+
+    Array<ClipperLib::Path*> holes = {};
+    holes.ensure_slots(node->ChildCount());
+    for (ClipperLib::PolyNodes::iterator child = node->Childs.begin(); child != node->Childs.end();
+         child++) {
+        holes.append_unsafe(&(*child)->Contour);
+    }
+    link_hole_paths(&node->Contour, holes, error_code);
+    holes.clear();
+}
+
 static void tree_to_polygons(const ClipperLib::PolyTree& tree, double scaling,
                              Array<Polygon*>& polygon_array, ErrorCode& error_code) {
     ClipperLib::PolyNode* node = tree.GetFirst();
@@ -240,8 +258,511 @@ extern "C" {
 #endif
 ///////////////////////////////////////////////////////////////
 
-ErrorCode boolean(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2, Operation operation,
-                  double scaling, Array<Polygon*>& result) {
+static ClipperLib::ClipType clip_type(Operation operation) {
+    switch (operation) {
+        case Operation::Or:
+            return ClipperLib::ctUnion;
+        case Operation::And:
+            return ClipperLib::ctIntersection;
+        case Operation::Xor:
+            return ClipperLib::ctXor;
+        case Operation::Not:
+            return ClipperLib::ctDifference;
+    }
+    return ClipperLib::ctUnion;
+}
+
+// Rectilinear boolean engine.  When all input polygons are rectilinear in the
+// integer grid used by Clipper, the operation is computed by a sweep line over
+// their vertical edges, in exact integer arithmetic.  The result boundaries
+// are assembled in the same form as the contours of Clipper's PolyTree: outer
+// boundaries are counter-clockwise and holes clockwise, without repeated or
+// collinear vertices.  Holes are then linked exactly as in tree_to_polygons.
+// The resulting region is the same as Clipper's, but the polygons are not:
+// their order and starting vertices follow the sweep, and boundaries Clipper
+// keeps apart along shared edges are merged, so the engine is only used when
+// requested (boolean_rectilinear, offset_rectilinear).
+//
+// Where result boundaries touch at a single vertex, Clipper might either keep
+// them in one contour or split them depending on the order of its internal
+// events, so those cases are left to Clipper.
+
+// Vertical edge of an input polygon at x, from y0 to y1 > y0.  Crossing it in
+// the positive x direction adds wa to the winding number of the first operand
+// and wb to the winding number of the second.
+struct ManhattanEdge {
+    int64_t x;
+    int64_t y0;
+    int64_t y1;
+    int32_t wa;
+    int32_t wb;
+};
+
+static bool manhattan_edge_less(const ManhattanEdge& a, const ManhattanEdge& b) {
+    return a.x < b.x || (a.x == b.x && a.y0 < b.y0);
+}
+
+// Winding numbers in the sweep line, from y up to the next span.  Also used
+// for the changes in winding numbers at a given position.
+struct ManhattanSpan {
+    int64_t y;
+    int32_t wa;
+    int32_t wb;
+};
+
+static bool manhattan_span_less(const ManhattanSpan& a, const ManhattanSpan& b) {
+    return a.y < b.y;
+}
+
+// Vertical side of a result boundary, at x, from y0 to y1.  Boundaries are
+// oriented with the result on their left, so sides going down have the result
+// on their right.  The sides of each boundary are linked through next and
+// prev.  The result boundary immediately below (x, y0) to the right of x is at
+// height below (if has_below).
+struct ManhattanSide {
+    int64_t x;
+    int64_t y0;
+    int64_t y1;
+    int64_t below;
+    bool has_below;
+    bool down;
+    uint64_t next;
+    uint64_t prev;
+    uint64_t contour;
+};
+
+// Endpoint of a side, used to find the horizontal boundary segments
+struct ManhattanEnd {
+    int64_t y;
+    int64_t x;
+    uint64_t side;
+    bool top;
+};
+
+static bool manhattan_end_less(const ManhattanEnd& a, const ManhattanEnd& b) {
+    if (a.y != b.y) return a.y < b.y;
+    if (a.x != b.x) return a.x < b.x;
+    return a.top && !b.top;
+}
+
+// Vertical edges of the polygons, with the same rounding and orientation used
+// in polygon_to_path.  Returns false if any polygon is not rectilinear.
+static bool manhattan_edges(const Array<Polygon*>& polygons, double scaling, bool clip,
+                            Array<ManhattanEdge>& edges) {
+    for (uint64_t i = 0; i < polygons.count; i++) {
+        const Array<Vec2>& point_array = polygons[i]->point_array;
+        const uint64_t count = point_array.count;
+        if (count == 0) continue;
+        const int32_t w = polygons[i]->signed_area() < 0 ? -1 : 1;
+        const Vec2* p = point_array.items;
+        int64_t x0 = llround(scaling * p[count - 1].x);
+        int64_t y0 = llround(scaling * p[count - 1].y);
+        for (uint64_t j = 0; j < count; j++) {
+            const int64_t x1 = llround(scaling * p[j].x);
+            const int64_t y1 = llround(scaling * p[j].y);
+            if (x0 == x1) {
+                if (y0 != y1) {
+                    // Edges going down increase the winding number to their right
+                    const int32_t delta = y1 < y0 ? w : -w;
+                    ManhattanEdge edge = {x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, 0, 0};
+                    if (clip) {
+                        edge.wb = delta;
+                    } else {
+                        edge.wa = delta;
+                    }
+                    edges.append(edge);
+                }
+            } else if (y0 != y1) {
+                return false;
+            }
+            x0 = x1;
+            y0 = y1;
+        }
+    }
+    return true;
+}
+
+// Same fill rule (non-zero or positive) for both operands
+static inline bool manhattan_inside(Operation operation, ClipperLib::PolyFillType fill, int32_t wa,
+                                    int32_t wb) {
+    const bool a = fill == ClipperLib::pftPositive ? wa > 0 : wa != 0;
+    const bool b = fill == ClipperLib::pftPositive ? wb > 0 : wb != 0;
+    switch (operation) {
+        case Operation::Or:
+            return a || b;
+        case Operation::And:
+            return a && b;
+        case Operation::Xor:
+            return a != b;
+        case Operation::Not:
+            return a && !b;
+    }
+    return false;
+}
+
+// Index of the first span in the sweep line at or above y
+static uint64_t manhattan_lower_bound(const Array<ManhattanSpan>& spans, int64_t y) {
+    uint64_t lo = 0;
+    uint64_t hi = spans.count;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        if (spans[mid].y < y) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Sweep the edges (sorted by manhattan_edge_less) from left to right, keeping
+// the winding numbers along the sweep line.  At each edge position, the
+// result sides are the maximal vertical segments where the result changes.
+// Only the part of the sweep line between the lowest and highest edge
+// endpoints at that position is updated.  Returns false if 2 sides meet at a
+// vertex of an input polygon.
+static bool manhattan_sweep(const Array<ManhattanEdge>& edges, Operation operation,
+                            ClipperLib::PolyFillType fill, Array<ManhattanSide>& sides) {
+    bool success = true;
+    Array<ManhattanSpan> active = {};
+    Array<ManhattanSpan> updated = {};
+    Array<ManhattanSpan> changes = {};
+    uint64_t e = 0;
+    while (success && e < edges.count) {
+        const int64_t x = edges[e].x;
+        changes.count = 0;
+        for (; e < edges.count && edges[e].x == x; e++) {
+            const ManhattanEdge& edge = edges[e];
+            changes.append(ManhattanSpan{edge.y0, edge.wa, edge.wb});
+            changes.append(ManhattanSpan{edge.y1, -edge.wa, -edge.wb});
+        }
+        sort(changes, manhattan_span_less);
+
+        const uint64_t first = manhattan_lower_bound(active, changes[0].y);
+        uint64_t i = first;
+        // Winding numbers before x, accumulated changes at x, and the last
+        // span in the updated sweep line
+        int32_t wa = 0, wb = 0, da = 0, db = 0;
+        if (first > 0) {
+            wa = active[first - 1].wa;
+            wb = active[first - 1].wb;
+        }
+        int32_t ua = wa, ub = wb;
+        bool inside = manhattan_inside(operation, fill, wa, wb);
+        // The result boundary below the first side is only searched for if
+        // needed
+        int64_t below = 0;
+        bool has_below = false;
+        bool below_known = false;
+        // 0: no side, 1: side going down, 2: side going up
+        int side_type = 0;
+        uint64_t side = 0;
+        uint64_t j = 0;
+        updated.count = 0;
+        while (j < changes.count) {
+            const int64_t y = i < active.count && active[i].y < changes[j].y ? active[i].y
+                                                                             : changes[j].y;
+            if (i < active.count && active[i].y == y) {
+                wa = active[i].wa;
+                wb = active[i].wb;
+                i++;
+            }
+            const bool vertex = changes[j].y == y;
+            for (; j < changes.count && changes[j].y == y; j++) {
+                da += changes[j].wa;
+                db += changes[j].wb;
+            }
+            if (wa + da != ua || wb + db != ub) {
+                ua = wa + da;
+                ub = wb + db;
+                updated.append(ManhattanSpan{y, ua, ub});
+            }
+
+            const bool before = manhattan_inside(operation, fill, wa, wb);
+            const bool after = manhattan_inside(operation, fill, ua, ub);
+            const int type = before == after ? 0 : (after ? 1 : 2);
+            if (type != side_type) {
+                if (side_type != 0) sides[side].y1 = y;
+                if (type != 0) {
+                    if (side_type != 0 && vertex) success = false;
+                    if (!below_known) {
+                        below_known = true;
+                        for (uint64_t k = first; k > 0 && !has_below; k--) {
+                            const ManhattanSpan& span = active[k - 1];
+                            const ManhattanSpan& lower = active[k > 1 ? k - 2 : 0];
+                            const bool span_inside =
+                                manhattan_inside(operation, fill, span.wa, span.wb);
+                            const bool lower_inside =
+                                k > 1 && manhattan_inside(operation, fill, lower.wa, lower.wb);
+                            if (span_inside != lower_inside) {
+                                below = span.y;
+                                has_below = true;
+                            }
+                        }
+                    }
+                    side = sides.count;
+                    sides.append(ManhattanSide{x, y, y, below, has_below, type == 1, 0, 0, 0});
+                }
+                side_type = type;
+            }
+            if (after != inside) {
+                inside = after;
+                below = y;
+                has_below = true;
+                below_known = true;
+            }
+        }
+
+        // The changes cancel out above the last one, so the remaining spans
+        // are unchanged, except for the first one, which might now be
+        // redundant.
+        if (i < active.count && active[i].wa == ua && active[i].wb == ub) i++;
+        const uint64_t removed = i - first;
+        if (updated.count != removed) {
+            active.ensure_slots(updated.count);
+            memmove(active.items + first + updated.count, active.items + i,
+                    (active.count - i) * sizeof(ManhattanSpan));
+            active.count = active.count + updated.count - removed;
+        }
+        if (updated.count > 0) {
+            memcpy(active.items + first, updated.items, updated.count * sizeof(ManhattanSpan));
+        }
+    }
+    active.clear();
+    updated.clear();
+    changes.clear();
+    return success;
+}
+
+// Boundary sides are linked through the horizontal segments between them,
+// which are found between consecutive side endpoints along each horizontal
+// line.  Returns false if the sides are not consistent.
+static bool manhattan_link(Array<ManhattanSide>& sides, Array<ManhattanEnd>& ends) {
+    ends.ensure_slots(2 * sides.count);
+    for (uint64_t i = 0; i < sides.count; i++) {
+        const ManhattanSide& side = sides[i];
+        ends.append_unsafe(ManhattanEnd{side.y0, side.x, i, false});
+        ends.append_unsafe(ManhattanEnd{side.y1, side.x, i, true});
+    }
+    sort(ends, manhattan_end_less);
+    for (uint64_t i = 0; i < ends.count; i += 2) {
+        const ManhattanEnd& a = ends[i];
+        const ManhattanEnd& b = ends[i + 1];
+        // Sides going up end at their top, sides going down at their bottom
+        const bool a_ends = a.top != sides[a.side].down;
+        const bool b_ends = b.top != sides[b.side].down;
+        if (a.y != b.y || a_ends == b_ends) return false;
+        const uint64_t from = a_ends ? a.side : b.side;
+        const uint64_t to = a_ends ? b.side : a.side;
+        sides[from].next = to;
+        sides[to].prev = from;
+    }
+    return true;
+}
+
+static void manhattan_label(Array<ManhattanSide>& sides, uint64_t start, uint64_t contour) {
+    uint64_t i = start;
+    do {
+        sides[i].contour = contour;
+        i = sides[i].next;
+    } while (i != start);
+}
+
+// Result boundaries of the operation over the given edges, with their
+// vertices in Clipper's integer grid.  For each contour, parent is the index
+// of the outer contour of a hole, or UINT64_MAX for outer contours.  Returns
+// false, without changing contours, if the result boundary touches itself (or
+// the sweep fails, see manhattan_sweep).  Edges are sorted in place.
+static bool manhattan_edge_contours(Array<ManhattanEdge>& edges, Operation operation,
+                                    ClipperLib::PolyFillType fill, ClipperLib::Paths& contours,
+                                    Array<uint64_t>& parent) {
+    sort(edges, manhattan_edge_less);
+
+    Array<ManhattanSide> sides = {};
+    Array<ManhattanEnd> ends = {};
+    if (!manhattan_sweep(edges, operation, fill, sides) ||
+        !manhattan_link(sides, ends)) {
+        sides.clear();
+        ends.clear();
+        return false;
+    }
+
+    uint64_t contour_count = 0;
+    for (uint64_t i = 0; i < sides.count; i++) sides[i].contour = UINT64_MAX;
+    for (uint64_t i = 0; i < sides.count; i++) {
+        if (sides[i].contour == UINT64_MAX) manhattan_label(sides, i, contour_count++);
+    }
+
+    // Leftmost side (its direction tells if the contour is a hole), and the
+    // sides with the lowest and highest vertices of each contour
+    uint64_t* left = (uint64_t*)allocate(3 * contour_count * sizeof(uint64_t));
+    uint64_t* lowest = left + contour_count;
+    uint64_t* highest = lowest + contour_count;
+    for (uint64_t i = 0; i < contour_count; i++) left[i] = UINT64_MAX;
+    for (uint64_t i = 0; i < sides.count; i++) {
+        const ManhattanSide& side = sides[i];
+        const uint64_t c = side.contour;
+        if (left[c] == UINT64_MAX) {
+            left[c] = lowest[c] = highest[c] = i;
+            continue;
+        }
+        if (side.x < sides[left[c]].x) left[c] = i;
+        const ManhattanSide& low = sides[lowest[c]];
+        if (side.y0 < low.y0 || (side.y0 == low.y0 && side.x < low.x)) lowest[c] = i;
+        const ManhattanSide& high = sides[highest[c]];
+        if (side.y1 > high.y1 || (side.y1 == high.y1 && side.x > high.x)) highest[c] = i;
+    }
+
+    // The parent of a hole is found through the boundary immediately below its
+    // lowest vertex.  If that is another hole, they share the same parent.
+    bool success = true;
+    const uint64_t first = parent.count;
+    parent.ensure_slots(contour_count);
+    for (uint64_t c = 0; c < contour_count; c++) {
+        uint64_t p = UINT64_MAX;
+        if (!sides[left[c]].down) {
+            const ManhattanSide& side = sides[lowest[c]];
+            uint64_t lo = 0;
+            uint64_t hi = ends.count;
+            while (lo < hi) {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                const ManhattanEnd& end = ends[mid];
+                if (end.y < side.below || (end.y == side.below && end.x <= side.x)) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            if (!side.has_below || lo % 2 == 0 || lo == ends.count || ends[lo].y != side.below) {
+                success = false;
+                break;
+            }
+            p = sides[ends[lo].side].contour;
+        }
+        parent.append_unsafe(p);
+    }
+    ends.clear();
+
+    if (success) {
+        for (uint64_t c = 0; c < contour_count; c++) {
+            uint64_t p = parent[first + c];
+            while (p != UINT64_MAX && parent[first + p] != UINT64_MAX) p = parent[first + p];
+            parent[first + c] = p;
+        }
+
+        // Outer contours start at their highest vertex and holes at their
+        // lowest, as they often do in Clipper
+        const size_t offset = contours.size();
+        contours.resize(offset + contour_count);
+        for (uint64_t c = 0; c < contour_count; c++) {
+            ClipperLib::Path& path = contours[offset + c];
+            const bool hole = parent[first + c] != UINT64_MAX;
+            if (hole) parent[first + c] += offset;
+            const uint64_t start = hole ? lowest[c] : highest[c];
+            uint64_t i = start;
+            do {
+                const ManhattanSide& side = sides[i];
+                path.push_back(ClipperLib::IntPoint(side.x, side.down ? side.y1 : side.y0));
+                path.push_back(ClipperLib::IntPoint(side.x, side.down ? side.y0 : side.y1));
+                i = side.next;
+            } while (i != start);
+            // Starting vertex at the end of the first side
+            if (sides[start].down == hole) {
+                path.push_back(path[0]);
+                path.erase(path.begin());
+            }
+        }
+    } else {
+        parent.count = first;
+    }
+
+    free_allocation(left);
+    sides.clear();
+    return success;
+}
+
+// Same as manhattan_edge_contours for the polygons of both operands.  Also
+// returns false if any polygon is not rectilinear.
+static bool manhattan_contours(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                               Operation operation, double scaling, ClipperLib::Paths& contours,
+                               Array<uint64_t>& parent) {
+    Array<ManhattanEdge> edges = {};
+    const bool success =
+        manhattan_edges(polys1, scaling, false, edges) &&
+        manhattan_edges(polys2, scaling, true, edges) &&
+        manhattan_edge_contours(edges, operation, ClipperLib::pftNonZero, contours, parent);
+    edges.clear();
+    return success;
+}
+
+static bool is_manhattan(const Polygon& polygon, double scaling) {
+    const uint64_t count = polygon.point_array.count;
+    if (count == 0) return true;
+    const Vec2* p = polygon.point_array.items;
+    int64_t x0 = llround(scaling * p[count - 1].x);
+    int64_t y0 = llround(scaling * p[count - 1].y);
+    for (uint64_t i = 0; i < count; i++) {
+        const int64_t x1 = llround(scaling * p[i].x);
+        const int64_t y1 = llround(scaling * p[i].y);
+        if (x0 != x1 && y0 != y1) return false;
+        x0 = x1;
+        y0 = y1;
+    }
+    return true;
+}
+
+// Holes are linked to their outer contours as in tree_to_polygons
+static void manhattan_polygons(ClipperLib::Paths& contours, const Array<uint64_t>& parent,
+                               double scaling, Array<Polygon*>& result, ErrorCode& error_code) {
+    // Holes grouped by parent with a counting sort
+    const uint64_t count = parent.count;
+    uint64_t* offsets = (uint64_t*)allocate_clear((count + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++) {
+        if (parent[i] != UINT64_MAX) offsets[parent[i] + 1]++;
+    }
+    for (uint64_t i = 0; i < count; i++) offsets[i + 1] += offsets[i];
+    Array<ClipperLib::Path*> holes = {};
+    holes.ensure_slots(offsets[count]);
+    holes.count = offsets[count];
+    for (uint64_t i = 0; i < count; i++) {
+        if (parent[i] != UINT64_MAX) holes[offsets[parent[i]]++] = &contours[i];
+    }
+
+    uint64_t start = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (parent[i] != UINT64_MAX) continue;
+        Array<ClipperLib::Path*> children = {};
+        children.items = holes.items + start;
+        children.count = offsets[i] - start;
+        start = offsets[i];
+        if (children.count > 0) link_hole_paths(&contours[i], children, error_code);
+        result.append(path_to_polygon(contours[i], scaling));
+    }
+
+    holes.clear();
+    free_allocation(offsets);
+}
+
+// Returns false, without changing result, if any polygon is not rectilinear
+// or the result boundary touches itself at a vertex of an input polygon
+static bool manhattan_boolean(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                              Operation operation, double scaling, Array<Polygon*>& result,
+                              ErrorCode& error_code) {
+    ClipperLib::Paths contours;
+    Array<uint64_t> parent = {};
+    if (!manhattan_contours(polys1, polys2, operation, scaling, contours, parent)) {
+        parent.clear();
+        return false;
+    }
+    manhattan_polygons(contours, parent, scaling, result, error_code);
+    parent.clear();
+    return true;
+}
+
+// Implementation of boolean and boolean_rectilinear
+static ErrorCode boolean_engine(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                                Operation operation, double scaling, bool rectilinear,
+                                Array<Polygon*>& result) {
     ////////////////// CAESAREALABS EDIT //////////////////////
     //////// REASON: boolean() causes a memory error when attaching an lldb windows debugger, so we don't allow it
     if (IsDebuggerPresent()) {
@@ -249,21 +770,14 @@ ErrorCode boolean(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
         return ErrorCode::BooleanError;
     }
     /////////////////////////////////////////////////////////////
-    ClipperLib::ClipType ct_operation = ClipperLib::ctUnion;
-    switch (operation) {
-        case Operation::Or:
-            ct_operation = ClipperLib::ctUnion;
-            break;
-        case Operation::And:
-            ct_operation = ClipperLib::ctIntersection;
-            break;
-        case Operation::Xor:
-            ct_operation = ClipperLib::ctXor;
-            break;
-        case Operation::Not:
-            ct_operation = ClipperLib::ctDifference;
+    ErrorCode error_code = ErrorCode::NoError;
+    if (rectilinear &&
+        manhattan_boolean(polys1, polys2, operation, scaling, result, error_code)) {
+        return error_code;
     }
 
+    ClipperLib::ClipType ct_operation = clip_type(operation);
+
     ClipperLib::Paths paths1 = polygons_to_paths(polys1, scaling);
     ClipperLib::Paths paths2 = polygons_to_paths(polys2, scaling);
 
@@ -276,50 +790,819 @@ ErrorCode boolean(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
     ClipperLib::PolyTree solution;
     clpr.Execute(ct_operation, solution, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
 
-    ErrorCode error_code = ErrorCode::NoError;
     tree_to_polygons(solution, scaling, result, error_code);
     return error_code;
 }
 
-ErrorCode offset(const Array<Polygon*>& polygons, double distance, OffsetJoin join,
-                 double tolerance, double scaling, bool use_union, Array<Polygon*>& result) {
-    ClipperLib::JoinType jt_join = ClipperLib::jtSquare;
-    ClipperLib::ClipperOffset clprof;
+ErrorCode boolean(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2, Operation operation,
+                  double scaling, Array<Polygon*>& result) {
+    return boolean_engine(polys1, polys2, operation, scaling, false, result);
+}
+
+ErrorCode boolean_rectilinear(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                              Operation operation, double scaling, Array<Polygon*>& result) {
+    return boolean_engine(polys1, polys2, operation, scaling, true, result);
+}
+
+// Union-find over polygon indices shared among threads.  Roots are always
+// linked under the smaller index, and path halving only replaces parents by
+// their ancestors, so concurrent updates never break a tree.
+static uint64_t cluster_find(std::atomic<uint64_t>* parent, uint64_t i) {
+    while (true) {
+        const uint64_t p = parent[i].load(std::memory_order_relaxed);
+        if (p == i) return i;
+        const uint64_t grandparent = parent[p].load(std::memory_order_relaxed);
+        if (grandparent != p) parent[i].store(grandparent, std::memory_order_relaxed);
+        i = grandparent;
+    }
+}
+
+static void cluster_union(std::atomic<uint64_t>* parent, uint64_t a, uint64_t b) {
+    while (true) {
+        a = cluster_find(parent, a);
+        b = cluster_find(parent, b);
+        if (a == b) return;
+        if (a < b) {
+            const uint64_t t = a;
+            a = b;
+            b = t;
+        }
+        uint64_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b)) return;
+    }
+}
+
+// Polygons from both operands of boolean_parallel (only polys1 in
+// offset_parallel) grouped in clusters that can be processed independently,
+// which are then distributed in bands.
+struct PolygonBands {
+    const Array<Polygon*>* polys1;
+    const Array<Polygon*>* polys2;
+    double scaling;
+    Operation operation;
+    ClipperLib::ClipType clip_type;
+    // The rectilinear engine was requested and all polygons are rectilinear,
+    // so bands are first tried with it
+    bool manhattan;
+    uint64_t polygon_count;
+    // Polygon bounding boxes in the integer grid used by Clipper, expanded by
+    // the clustering margin.  Indices below polys1->count refer to polys1, the
+    // remaining to polys2.  After clustering, the bounding box of each cluster
+    // is stored in its root.
+    Vec2* bb_min;
+    Vec2* bb_max;
+    SpatialIndex spatial_index;
+    std::atomic<uint64_t>* parent;
+    // Polygons in clusters that cannot contribute to the result.  They are
+    // still needed for their scanbeams.
+    bool* skip;
+    // Band b holds the clusters with roots cluster_roots[band_clusters[b]] up
+    // to cluster_roots[band_clusters[b + 1] - 1] and their polygons,
+    // band_polygons[band_offsets[b]] up to band_polygons[band_offsets[b + 1] -
+    // 1], in input order.
+    uint64_t band_count;
+    uint64_t* cluster_roots;
+    uint64_t* band_clusters;
+    uint64_t* band_offsets;
+    uint64_t* band_polygons;
+    // Sorted scanbeams (without repetitions) from all paths in each band
+    Array<ClipperLib::cInt>* band_scanbeams;
+    Array<Polygon*>* band_results;
+    ErrorCode* band_errors;
+    bool* band_declined;
+};
+
+// Number of polygons in each task of the clustering stage
+#define GDSTK_BOOLEAN_CLUSTER_CHUNK 4096
+
+struct ClusterQuery {
+    std::atomic<uint64_t>* parent;
+    uint64_t index;
+};
+
+static bool cluster_overlap(const SpatialItem& item, void* data) {
+    ClusterQuery* query = (ClusterQuery*)data;
+    if (item.index > query->index) cluster_union(query->parent, query->index, item.index);
+    return true;
+}
+
+static void cluster_chunk(uint64_t chunk, void* data) {
+    PolygonBands* bands = (PolygonBands*)data;
+    const uint64_t start = chunk * GDSTK_BOOLEAN_CLUSTER_CHUNK;
+    uint64_t end = start + GDSTK_BOOLEAN_CLUSTER_CHUNK;
+    if (end > bands->polygon_count) end = bands->polygon_count;
+    ClusterQuery query = {bands->parent, 0};
+    for (uint64_t i = start; i < end; i++) {
+        query.index = i;
+        bands->spatial_index.query(bands->bb_min[i], bands->bb_max[i], cluster_overlap, &query);
+    }
+}
+
+struct ClusterCenter {
+    double y;
+    uint64_t root;
+};
+
+static bool cluster_center_less(const ClusterCenter& a, const ClusterCenter& b) {
+    return a.y < b.y || (a.y == b.y && a.root < b.root);
+}
+
+// Groups the polygons with overlapping bounding boxes, expanded by margin, in
+// clusters and splits them in bands.  Clusters without the required operands
+// (bit 0 for polys1, bit 1 for polys2) are marked in skip.  Operands, scaling
+// and manhattan (true if the rectilinear engine is requested) must be set in
+// bands.
+static void build_bands(PolygonBands& bands, double margin, uint8_t required,
+                        uint32_t num_threads) {
+    const Array<Polygon*>& polys1 = *bands.polys1;
+    const Array<Polygon*>& polys2 = *bands.polys2;
+    const double scaling = bands.scaling;
+    const uint64_t n1 = polys1.count;
+    const uint64_t count = n1 + polys2.count;
+    bands.polygon_count = count;
+    bands.bb_min = (Vec2*)allocate(2 * count * sizeof(Vec2));
+    bands.bb_max = bands.bb_min + count;
+
+    // Empty polygons are not indexed, so they end up in clusters of their own,
+    // which are ignored.
+    Array<SpatialItem> items = {};
+    items.ensure_slots(count);
+    for (uint64_t i = 0; i < count; i++) {
+        const Polygon* polygon = i < n1 ? polys1[i] : polys2[i - n1];
+        if (bands.manhattan) bands.manhattan = is_manhattan(*polygon, scaling);
+        Vec2 min, max;
+        simd_bounding_box(polygon->point_array.items, polygon->point_array.count, min, max);
+        if (polygon->point_array.count > 0) {
+            min.x = (double)llround(scaling * min.x) - margin;
+            min.y = (double)llround(scaling * min.y) - margin;
+            max.x = (double)llround(scaling * max.x) + margin;
+            max.y = (double)llround(scaling * max.y) + margin;
+            items.append_unsafe(SpatialItem{min, max, i, SpatialItemType::Polygon});
+        }
+        bands.bb_min[i] = min;
+        bands.bb_max[i] = max;
+    }
+    bands.spatial_index.build(items);
+    items.clear();
+
+    bands.parent = (std::atomic<uint64_t>*)allocate(count * sizeof(std::atomic<uint64_t>));
+    for (uint64_t i = 0; i < count; i++) new (bands.parent + i) std::atomic<uint64_t>(i);
+    parallel_for((count + GDSTK_BOOLEAN_CLUSTER_CHUNK - 1) / GDSTK_BOOLEAN_CLUSTER_CHUNK,
+                 num_threads, cluster_chunk, &bands);
+    bands.spatial_index.clear();
+
+    // Roots have the smallest index in their clusters.  Operands present in
+    // each cluster, their sizes and bounding boxes are accumulated in the root.
+    uint64_t* root = (uint64_t*)allocate(count * sizeof(uint64_t));
+    uint64_t* size = (uint64_t*)allocate_clear(count * sizeof(uint64_t));
+    uint8_t* operands = (uint8_t*)allocate_clear(count * sizeof(uint8_t));
+    uint64_t cluster_count = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        const uint64_t r = cluster_find(bands.parent, i);
+        root[i] = r;
+        if (bands.bb_min[i].x > bands.bb_max[i].x) continue;
+        if (r == i) cluster_count++;
+        size[r]++;
+        operands[r] |= i < n1 ? 1 : 2;
+        if (r == i) continue;
+        Vec2& min = bands.bb_min[r];
+        Vec2& max = bands.bb_max[r];
+        if (bands.bb_min[i].x < min.x) min.x = bands.bb_min[i].x;
+        if (bands.bb_min[i].y < min.y) min.y = bands.bb_min[i].y;
+        if (bands.bb_max[i].x > max.x) max.x = bands.bb_max[i].x;
+        if (bands.bb_max[i].y > max.y) max.y = bands.bb_max[i].y;
+    }
+    free_allocation(bands.parent);
+
+    bands.skip = (bool*)allocate(count * sizeof(bool));
+    for (uint64_t i = 0; i < count; i++) {
+        bands.skip[i] = (operands[root[i]] & required) != required;
+    }
+
+    // Clusters are sorted by the vertical position of their centers and split
+    // in bands with similar numbers of polygons.
+    Array<ClusterCenter> centers = {};
+    centers.ensure_slots(cluster_count);
+    for (uint64_t i = 0; i < count; i++) {
+        if (root[i] == i && operands[i] != 0) {
+            centers.append_unsafe(
+                ClusterCenter{0.5 * (bands.bb_min[i].y + bands.bb_max[i].y), i});
+        }
+    }
+    free_allocation(operands);
+    sort(centers, cluster_center_less);
+
+    uint64_t* band_of = (uint64_t*)allocate(count * sizeof(uint64_t));
+    bands.cluster_roots = (uint64_t*)allocate(cluster_count * sizeof(uint64_t));
+    bands.band_clusters = (uint64_t*)allocate((cluster_count + 1) * sizeof(uint64_t));
+    bands.band_clusters[0] = 0;
+    uint64_t band_size = 0;
+    for (uint64_t i = 0; i < cluster_count; i++) {
+        const uint64_t r = centers[i].root;
+        bands.cluster_roots[i] = r;
+        band_of[r] = bands.band_count;
+        band_size += size[r];
+        if (band_size >= GDSTK_BOOLEAN_BAND_POLYGONS || i == cluster_count - 1) {
+            bands.band_clusters[++bands.band_count] = i + 1;
+            band_size = 0;
+        }
+    }
+    centers.clear();
+    free_allocation(size);
+
+    // Counting sort of the polygons by band, keeping the input order
+    const uint64_t band_count = bands.band_count;
+    bands.band_offsets = (uint64_t*)allocate_clear((band_count + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++) {
+        if (bands.bb_min[i].x > bands.bb_max[i].x) continue;
+        bands.band_offsets[band_of[root[i]] + 1]++;
+    }
+    for (uint64_t b = 0; b < band_count; b++) bands.band_offsets[b + 1] += bands.band_offsets[b];
+    bands.band_polygons = (uint64_t*)allocate(bands.band_offsets[band_count] * sizeof(uint64_t));
+    uint64_t* cursor = (uint64_t*)allocate(band_count * sizeof(uint64_t));
+    memcpy(cursor, bands.band_offsets, band_count * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++) {
+        if (bands.bb_min[i].x > bands.bb_max[i].x) continue;
+        bands.band_polygons[cursor[band_of[root[i]]]++] = i;
+    }
+    free_allocation(cursor);
+    free_allocation(band_of);
+    free_allocation(root);
+
+    bands.band_scanbeams =
+        (Array<ClipperLib::cInt>*)allocate_clear(band_count * sizeof(Array<ClipperLib::cInt>));
+    bands.band_results = (Array<Polygon*>*)allocate_clear(band_count * sizeof(Array<Polygon*>));
+    bands.band_errors = (ErrorCode*)allocate(band_count * sizeof(ErrorCode));
+    bands.band_declined = (bool*)allocate(band_count * sizeof(bool));
+}
+
+// Returns true if the rectilinear engine declined any band.  In that case,
+// the results from all bands are discarded, so that all of them can be redone
+// with Clipper, as in the serial functions.
+static bool bands_declined(PolygonBands& bands) {
+    bool declined = false;
+    for (uint64_t b = 0; b < bands.band_count; b++) {
+        if (bands.band_declined[b]) declined = true;
+    }
+    if (!declined) return false;
+    for (uint64_t b = 0; b < bands.band_count; b++) {
+        Array<Polygon*>& band_result = bands.band_results[b];
+        for (uint64_t i = 0; i < band_result.count; i++) {
+            band_result[i]->clear();
+            free_allocation(band_result[i]);
+        }
+        band_result.count = 0;
+    }
+    return true;
+}
+
+// Moves the results from all bands to result, in band order, and frees the
+// bands.  Returns the last error from the bands.
+static ErrorCode finish_bands(PolygonBands& bands, Array<Polygon*>& result) {
+    ErrorCode error_code = ErrorCode::NoError;
+    for (uint64_t b = 0; b < bands.band_count; b++) {
+        result.extend(bands.band_results[b]);
+        bands.band_results[b].clear();
+        bands.band_scanbeams[b].clear();
+        if (bands.band_errors[b] != ErrorCode::NoError) error_code = bands.band_errors[b];
+    }
+    free_allocation(bands.band_declined);
+    free_allocation(bands.band_errors);
+    free_allocation(bands.band_results);
+    free_allocation(bands.band_scanbeams);
+    free_allocation(bands.band_polygons);
+    free_allocation(bands.band_offsets);
+    free_allocation(bands.band_clusters);
+    free_allocation(bands.cluster_roots);
+    free_allocation(bands.skip);
+    free_allocation(bands.bb_min);
+    return error_code;
+}
+
+// Paths are added in input order, subjects first, as in boolean
+static void add_band_paths(const PolygonBands* bands, uint64_t band, bool skip,
+                           ClipperLib::Clipper& clpr) {
+    const uint64_t n1 = bands->polys1->count;
+    ClipperLib::Paths paths1;
+    ClipperLib::Paths paths2;
+    for (uint64_t i = bands->band_offsets[band]; i < bands->band_offsets[band + 1]; i++) {
+        const uint64_t j = bands->band_polygons[i];
+        if (skip && bands->skip[j]) continue;
+        if (j < n1) {
+            paths1.push_back(polygon_to_path(*(*bands->polys1)[j], bands->scaling));
+        } else {
+            paths2.push_back(polygon_to_path(*(*bands->polys2)[j - n1], bands->scaling));
+        }
+    }
+    clpr.AddPaths(paths1, ClipperLib::ptSubject, true);
+    clpr.AddPaths(paths2, ClipperLib::ptClip, true);
+}
+
+static void store_scanbeams(const ClipperLib::Clipper& clpr, Array<ClipperLib::cInt>& scanbeams) {
+    std::vector<ClipperLib::cInt> ys;
+    clpr.GetScanbeams(ys);
+    scanbeams.count = 0;
+    scanbeams.ensure_slots(ys.size());
+    for (size_t i = 0; i < ys.size(); i++) scanbeams.append_unsafe(ys[i]);
+    sort(scanbeams);
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < scanbeams.count; i++) {
+        if (count == 0 || scanbeams[i] != scanbeams[count - 1]) scanbeams[count++] = scanbeams[i];
+    }
+    scanbeams.count = count;
+}
+
+static void band_scanbeams(uint64_t band, void* data) {
+    PolygonBands* bands = (PolygonBands*)data;
+    ClipperLib::Clipper clpr;
+    add_band_paths(bands, band, false, clpr);
+    store_scanbeams(clpr, bands->band_scanbeams[band]);
+}
+
+// Index of the first item in the sorted array that is not less than value
+static uint64_t scanbeam_lower_bound(const Array<ClipperLib::cInt>& scanbeams,
+                                     ClipperLib::cInt value) {
+    uint64_t lo = 0;
+    uint64_t hi = scanbeams.count;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        if (scanbeams[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool interval_less(const Vec2& a, const Vec2& b) { return a.x < b.x; }
+
+// A single Clipper run over all bands would also sweep the scanbeams from
+// every other band (including the skipped polygons) in the vertical range of
+// the clusters in this band.  They affect the rounding of intersections, so
+// they are appended to result to be added to the band run.  Returns false if
+// all clusters in the band are skipped.
+static bool crossing_scanbeams(const PolygonBands* bands, uint64_t band,
+                               Array<ClipperLib::cInt>& result) {
+    // Vertical extents of the clusters in this band, merged
+    Array<Vec2> intervals = {};
+    for (uint64_t i = bands->band_clusters[band]; i < bands->band_clusters[band + 1]; i++) {
+        const uint64_t root = bands->cluster_roots[i];
+        if (bands->skip[root]) continue;
+        intervals.append(Vec2{bands->bb_min[root].y, bands->bb_max[root].y});
+    }
+    if (intervals.count == 0) return false;
+    sort(intervals, interval_less);
+    uint64_t count = 1;
+    for (uint64_t i = 1; i < intervals.count; i++) {
+        Vec2& last = intervals[count - 1];
+        if (intervals[i].x <= last.y) {
+            if (intervals[i].y > last.y) last.y = intervals[i].y;
+        } else {
+            intervals[count++] = intervals[i];
+        }
+    }
+    intervals.count = count;
+
+    for (uint64_t b = 0; b < bands->band_count; b++) {
+        const Array<ClipperLib::cInt>& scanbeams = bands->band_scanbeams[b];
+        if (scanbeams.count == 0) continue;
+        for (uint64_t i = 0; i < intervals.count; i++) {
+            const ClipperLib::cInt y0 = (ClipperLib::cInt)intervals[i].x;
+            const ClipperLib::cInt y1 = (ClipperLib::cInt)intervals[i].y;
+            if (y1 < scanbeams[0] || y0 > scanbeams[scanbeams.count - 1]) continue;
+            const uint64_t start = scanbeam_lower_bound(scanbeams, y0);
+            const uint64_t end = scanbeam_lower_bound(scanbeams, y1 + 1);
+            if (end > start) {
+                result.ensure_slots(end - start);
+                for (uint64_t j = start; j < end; j++) result.append_unsafe(scanbeams[j]);
+            }
+        }
+    }
+    intervals.clear();
+    return true;
+}
+
+static void boolean_band(uint64_t band, void* data) {
+    PolygonBands* bands = (PolygonBands*)data;
+    bands->band_errors[band] = ErrorCode::NoError;
+    Array<ClipperLib::cInt> scanbeams = {};
+    if (crossing_scanbeams(bands, band, scanbeams)) {
+        ClipperLib::Clipper clpr;
+        add_band_paths(bands, band, true, clpr);
+        clpr.AddScanbeams(scanbeams.items, scanbeams.count);
+        ClipperLib::PolyTree solution;
+        clpr.Execute(bands->clip_type, solution, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+        tree_to_polygons(solution, bands->scaling, bands->band_results[band],
+                         bands->band_errors[band]);
+    }
+    scanbeams.clear();
+}
+
+static void boolean_band_manhattan(uint64_t band, void* data) {
+    PolygonBands* bands = (PolygonBands*)data;
+    bands->band_errors[band] = ErrorCode::NoError;
+    const uint64_t n1 = bands->polys1->count;
+    Array<Polygon*> polys1 = {};
+    Array<Polygon*> polys2 = {};
+    for (uint64_t i = bands->band_offsets[band]; i < bands->band_offsets[band + 1]; i++) {
+        const uint64_t j = bands->band_polygons[i];
+        if (bands->skip[j]) continue;
+        if (j < n1) {
+            polys1.append((*bands->polys1)[j]);
+        } else {
+            polys2.append((*bands->polys2)[j - n1]);
+        }
+    }
+    bands->band_declined[band] =
+        !manhattan_boolean(polys1, polys2, bands->operation, bands->scaling,
+                           bands->band_results[band], bands->band_errors[band]);
+    polys1.clear();
+    polys2.clear();
+}
+
+ErrorCode boolean_parallel(const Array<Polygon*>& polys1, const Array<Polygon*>& polys2,
+                           Operation operation, double scaling, bool rectilinear,
+                           uint32_t num_threads, Array<Polygon*>& result) {
+    if (polys1.count + polys2.count < 2 * GDSTK_BOOLEAN_BAND_POLYGONS) {
+        return boolean_engine(polys1, polys2, operation, scaling, rectilinear, result);
+    }
+    ////////////////// CAESAREALABS EDIT //////////////////////
+    //////// REASON: See boolean()
+    if (IsDebuggerPresent()) {
+        printf("boolean() doesn't work in debug mode, will fail");
+        return ErrorCode::BooleanError;
+    }
+    /////////////////////////////////////////////////////////////
+
+    PolygonBands bands = {};
+    bands.polys1 = &polys1;
+    bands.polys2 = &polys2;
+    bands.scaling = scaling;
+    bands.operation = operation;
+    bands.clip_type = clip_type(operation);
+    bands.manhattan = rectilinear;
+    // Clusters without the required operands do not contribute to the result
+    const uint8_t required = operation == Operation::And ? 3 : (operation == Operation::Not ? 1 : 0);
+    build_bands(bands, 0, required, num_threads);
+
+    // As in boolean_rectilinear, Clipper is used for all bands if the
+    // rectilinear engine declines any of them.
+    bool use_clipper = true;
+    if (bands.manhattan) {
+        parallel_for(bands.band_count, num_threads, boolean_band_manhattan, &bands);
+        use_clipper = bands_declined(bands);
+    }
+    if (use_clipper) {
+        parallel_for(bands.band_count, num_threads, band_scanbeams, &bands);
+        parallel_for(bands.band_count, num_threads, boolean_band, &bands);
+    }
+
+    return finish_bands(bands, result);
+}
+
+// Vertical edges of the paths (first operand), keeping their orientation.
+// Returns false if any path is not rectilinear.
+static bool manhattan_path_edges(const ClipperLib::Paths& paths, Array<ManhattanEdge>& edges) {
+    for (size_t i = 0; i < paths.size(); i++) {
+        const ClipperLib::Path& path = paths[i];
+        if (path.empty()) continue;
+        ClipperLib::IntPoint p0 = path.back();
+        for (size_t j = 0; j < path.size(); j++) {
+            const ClipperLib::IntPoint p1 = path[j];
+            if (p0.X == p1.X) {
+                if (p1.Y < p0.Y) {
+                    edges.append(ManhattanEdge{p0.X, p1.Y, p0.Y, 1, 0});
+                } else if (p1.Y > p0.Y) {
+                    edges.append(ManhattanEdge{p0.X, p0.Y, p1.Y, -1, 0});
+                }
+            } else if (p0.Y != p1.Y) {
+                return false;
+            }
+            p0 = p1;
+        }
+    }
+    return true;
+}
+
+// Joins offset paths as ClipperOffset::JoinOffsetPaths, which keeps the
+// regions with positive winding numbers, using the rectilinear engine.
+// Miter joins at right angles are rectilinear, so that is usually the case
+// for rectilinear polygons.  Returns false, without changing result, if any
+// path is not rectilinear or the result touches itself at a path vertex.
+static bool manhattan_join_offset_paths(const ClipperLib::Paths& paths, double scaling,
+                                        Array<Polygon*>& result, ErrorCode& error_code) {
+    Array<ManhattanEdge> edges = {};
+    ClipperLib::Paths contours;
+    Array<uint64_t> parent = {};
+    const bool success =
+        manhattan_path_edges(paths, edges) &&
+        manhattan_edge_contours(edges, Operation::Or, ClipperLib::pftPositive, contours, parent);
+    edges.clear();
+    if (success) manhattan_polygons(contours, parent, scaling, result, error_code);
+    parent.clear();
+    return success;
+}
+
+static ClipperLib::JoinType offset_join_type(OffsetJoin join, double distance, double tolerance,
+                                             double scaling, ClipperLib::ClipperOffset& clprof) {
     switch (join) {
         case OffsetJoin::Bevel:
-            jt_join = ClipperLib::jtSquare;
-            break;
+            return ClipperLib::jtSquare;
         case OffsetJoin::Miter:
-            jt_join = ClipperLib::jtMiter;
             clprof.MiterLimit = tolerance;
-            break;
+            return ClipperLib::jtMiter;
         case OffsetJoin::Round:
-            jt_join = ClipperLib::jtRound;
             clprof.ArcTolerance = distance * scaling * (1.0 - cos(M_PI / tolerance));
+            return ClipperLib::jtRound;
+    }
+    return ClipperLib::jtSquare;
+}
+
+// Contours of the union of the polygons (outer boundaries and holes), as
+// from ClipperLib::PolyTreeToPaths
+static void union_contours(const Array<Polygon*>& polygons, double scaling, bool rectilinear,
+                           ClipperLib::Paths& contours) {
+    if (rectilinear) {
+        const Array<Polygon*> empty = {};
+        Array<uint64_t> parent = {};
+        const bool manhattan =
+            manhattan_contours(polygons, empty, Operation::Or, scaling, contours, parent);
+        parent.clear();
+        if (manhattan) return;
     }
 
-    ClipperLib::Paths original_polys = polygons_to_paths(polygons, scaling);
+    ClipperLib::Clipper clpr;
+    clpr.AddPaths(polygons_to_paths(polygons, scaling), ClipperLib::ptSubject, true);
+    ClipperLib::PolyTree joined_tree;
+    clpr.Execute(ClipperLib::ctUnion, joined_tree, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+    ClipperLib::PolyTreeToPaths(joined_tree, contours);
+}
+
+// Implementation of offset and offset_rectilinear
+static ErrorCode offset_engine(const Array<Polygon*>& polygons, double distance, OffsetJoin join,
+                               double tolerance, double scaling, bool use_union, bool rectilinear,
+                               Array<Polygon*>& result) {
+    ClipperLib::ClipperOffset clprof;
+    const ClipperLib::JoinType jt_join =
+        offset_join_type(join, distance, tolerance, scaling, clprof);
+
     if (use_union) {
-        ClipperLib::Clipper clpr;
-        clpr.AddPaths(original_polys, ClipperLib::ptSubject, true);
-        ClipperLib::PolyTree joined_tree;
-        clpr.Execute(ClipperLib::ctUnion, joined_tree, ClipperLib::pftNonZero,
-                     ClipperLib::pftNonZero);
         ClipperLib::Paths joined_polys;
-        ClipperLib::PolyTreeToPaths(joined_tree, joined_polys);
+        union_contours(polygons, scaling, rectilinear, joined_polys);
         clprof.AddPaths(joined_polys, jt_join, ClipperLib::etClosedPolygon);
     } else {
-        clprof.AddPaths(original_polys, jt_join, ClipperLib::etClosedPolygon);
+        clprof.AddPaths(polygons_to_paths(polygons, scaling), jt_join,
+                        ClipperLib::etClosedPolygon);
     }
 
-    ClipperLib::PolyTree solution;
-    clprof.Execute(solution, distance * scaling);
+    ClipperLib::Paths offset_polys;
+    clprof.GetOffsetPaths(offset_polys, distance * scaling);
 
     ErrorCode error_code = ErrorCode::NoError;
-    tree_to_polygons(solution, scaling, result, error_code);
+    if (!rectilinear || !manhattan_join_offset_paths(offset_polys, scaling, result, error_code)) {
+        ClipperLib::PolyTree solution;
+        ClipperLib::ClipperOffset::JoinOffsetPaths(offset_polys, distance * scaling, solution,
+                                                   NULL, 0);
+        tree_to_polygons(solution, scaling, result, error_code);
+    }
     return error_code;
 }
 
+ErrorCode offset(const Array<Polygon*>& polygons, double distance, OffsetJoin join,
+                 double tolerance, double scaling, bool use_union, Array<Polygon*>& result) {
+    return offset_engine(polygons, distance, join, tolerance, scaling, use_union, false, result);
+}
+
+ErrorCode offset_rectilinear(const Array<Polygon*>& polygons, double distance, OffsetJoin join,
+                             double tolerance, double scaling, bool use_union,
+                             Array<Polygon*>& result) {
+    return offset_engine(polygons, distance, join, tolerance, scaling, use_union, true, result);
+}
+
+// Orientation of the path with the lowest vertex (in Clipper's sense: largest
+// Y, then smallest X), which ClipperOffset uses to decide whether all paths
+// are reversed: 1 for positive, -1 for negative, 0 if there are no valid paths
+// and 2 if paths with both orientations share the lowest vertex (the choice
+// would depend on their order).
+static int8_t lowest_path_orientation(const ClipperLib::Paths& paths,
+                                      ClipperLib::IntPoint& lowest) {
+    int8_t result = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        const ClipperLib::Path& path = paths[i];
+        if (path.empty()) continue;
+        size_t high = path.size() - 1;
+        while (high > 0 && path[0] == path[high]) high--;
+        uint64_t distinct = 1;
+        ClipperLib::IntPoint low = path[0];
+        for (size_t j = 1; j <= high; j++) {
+            if (path[j] != path[j - 1]) distinct++;
+            if (path[j].Y > low.Y || (path[j].Y == low.Y && path[j].X < low.X)) low = path[j];
+        }
+        if (distinct < 3) continue;
+        const int8_t orientation = ClipperLib::Orientation(path) ? 1 : -1;
+        if (result == 0 || low.Y > lowest.Y || (low.Y == lowest.Y && low.X < lowest.X)) {
+            result = orientation;
+            lowest = low;
+        } else if (low == lowest && orientation != result) {
+            result = 2;
+        }
+    }
+    return result;
+}
+
+struct OffsetBands {
+    PolygonBands bands;
+    double distance;
+    OffsetJoin join;
+    double tolerance;
+    bool use_union;
+    // Orientation for the paths of all bands, from lowest_path_orientation
+    int8_t orientation;
+    // Union contours (if use_union) and then offset paths of each band
+    ClipperLib::Paths* band_paths;
+    ClipperLib::IntPoint* band_lowest;
+    int8_t* band_orientations;
+};
+
+static void offset_band_union_manhattan(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    const PolygonBands* bands = &offset_bands->bands;
+    Array<Polygon*> polygons = {};
+    for (uint64_t i = bands->band_offsets[band]; i < bands->band_offsets[band + 1]; i++) {
+        polygons.append((*bands->polys1)[bands->band_polygons[i]]);
+    }
+    const Array<Polygon*> empty = {};
+    Array<uint64_t> parent = {};
+    offset_bands->bands.band_declined[band] =
+        !manhattan_contours(polygons, empty, Operation::Or, bands->scaling,
+                            offset_bands->band_paths[band], parent);
+    parent.clear();
+    polygons.clear();
+}
+
+static void offset_band_union(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    const PolygonBands* bands = &offset_bands->bands;
+    Array<ClipperLib::cInt> scanbeams = {};
+    crossing_scanbeams(bands, band, scanbeams);
+    ClipperLib::Clipper clpr;
+    add_band_paths(bands, band, false, clpr);
+    clpr.AddScanbeams(scanbeams.items, scanbeams.count);
+    scanbeams.clear();
+    ClipperLib::PolyTree joined_tree;
+    clpr.Execute(ClipperLib::ctUnion, joined_tree, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+    ClipperLib::PolyTreeToPaths(joined_tree, offset_bands->band_paths[band]);
+}
+
+static void offset_band_orientation(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    const PolygonBands* bands = &offset_bands->bands;
+    ClipperLib::Paths& paths = offset_bands->band_paths[band];
+    if (!offset_bands->use_union) {
+        for (uint64_t i = bands->band_offsets[band]; i < bands->band_offsets[band + 1]; i++) {
+            const Polygon* polygon = (*bands->polys1)[bands->band_polygons[i]];
+            paths.push_back(polygon_to_path(*polygon, bands->scaling));
+        }
+    }
+    offset_bands->band_orientations[band] =
+        lowest_path_orientation(paths, offset_bands->band_lowest[band]);
+}
+
+static void offset_band_paths(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    const PolygonBands* bands = &offset_bands->bands;
+    ClipperLib::Paths& paths = offset_bands->band_paths[band];
+    ClipperLib::ClipperOffset clprof;
+    const ClipperLib::JoinType jt_join =
+        offset_join_type(offset_bands->join, offset_bands->distance, offset_bands->tolerance,
+                         bands->scaling, clprof);
+    clprof.AddPaths(paths, jt_join, ClipperLib::etClosedPolygon);
+    clprof.GetOffsetPaths(paths, offset_bands->distance * bands->scaling,
+                          offset_bands->orientation);
+}
+
+static void offset_band_join_manhattan(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    PolygonBands* bands = &offset_bands->bands;
+    bands->band_errors[band] = ErrorCode::NoError;
+    bands->band_declined[band] =
+        !manhattan_join_offset_paths(offset_bands->band_paths[band], bands->scaling,
+                                     bands->band_results[band], bands->band_errors[band]);
+}
+
+static void offset_band_scanbeams(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    ClipperLib::Clipper clpr;
+    clpr.AddPaths(offset_bands->band_paths[band], ClipperLib::ptSubject, true);
+    store_scanbeams(clpr, offset_bands->bands.band_scanbeams[band]);
+}
+
+static void offset_band_join(uint64_t band, void* data) {
+    OffsetBands* offset_bands = (OffsetBands*)data;
+    PolygonBands* bands = &offset_bands->bands;
+    bands->band_errors[band] = ErrorCode::NoError;
+    Array<ClipperLib::cInt> scanbeams = {};
+    crossing_scanbeams(bands, band, scanbeams);
+    ClipperLib::PolyTree solution;
+    ClipperLib::ClipperOffset::JoinOffsetPaths(offset_bands->band_paths[band],
+                                               offset_bands->distance * bands->scaling,
+                                               solution, scanbeams.items, scanbeams.count);
+    scanbeams.clear();
+    tree_to_polygons(solution, bands->scaling, bands->band_results[band],
+                     bands->band_errors[band]);
+}
+
+ErrorCode offset_parallel(const Array<Polygon*>& polygons, double distance, OffsetJoin join,
+                          double tolerance, double scaling, bool use_union, bool rectilinear,
+                          uint32_t num_threads, Array<Polygon*>& result) {
+    if (polygons.count < 2 * GDSTK_BOOLEAN_BAND_POLYGONS) {
+        return offset_engine(polygons, distance, join, tolerance, scaling, use_union, rectilinear,
+                             result);
+    }
+
+    const Array<Polygon*> empty = {};
+    OffsetBands offset_bands = {};
+    offset_bands.distance = distance;
+    offset_bands.join = join;
+    offset_bands.tolerance = tolerance;
+    offset_bands.use_union = use_union;
+    PolygonBands& bands = offset_bands.bands;
+    bands.polys1 = &polygons;
+    bands.polys2 = &empty;
+    bands.scaling = scaling;
+    bands.operation = Operation::Or;
+    bands.clip_type = ClipperLib::ctUnion;
+    bands.manhattan = rectilinear;
+
+    // Offset paths from a polygon stay within its bounding box expanded by the
+    // miter limit (at least 2) times the distance, so polygons farther apart
+    // than that are offset independently.
+    const double limit = join == OffsetJoin::Miter && tolerance > 2 ? tolerance : 2;
+    build_bands(bands, fabs(distance * scaling) * limit + 1, 0, num_threads);
+    const uint64_t band_count = bands.band_count;
+
+    std::vector<ClipperLib::Paths> band_paths(band_count);
+    offset_bands.band_paths = band_paths.data();
+    offset_bands.band_lowest =
+        (ClipperLib::IntPoint*)allocate(band_count * sizeof(ClipperLib::IntPoint));
+    offset_bands.band_orientations = (int8_t*)allocate(band_count * sizeof(int8_t));
+
+    if (use_union) {
+        bool use_clipper = true;
+        if (bands.manhattan) {
+            parallel_for(band_count, num_threads, offset_band_union_manhattan, &offset_bands);
+            use_clipper = bands_declined(bands);
+        }
+        if (use_clipper) {
+            for (uint64_t b = 0; b < band_count; b++) band_paths[b].clear();
+            parallel_for(band_count, num_threads, band_scanbeams, &bands);
+            parallel_for(band_count, num_threads, offset_band_union, &offset_bands);
+        }
+    }
+
+    // ClipperOffset orients all paths by the one with the lowest vertex, so
+    // that orientation is found among all bands and imposed on each of them.
+    // Ties between paths with different orientations are resolved by their
+    // order, which is not kept among bands, so offset is used in that case.
+    parallel_for(band_count, num_threads, offset_band_orientation, &offset_bands);
+    uint64_t lowest_band = band_count;
+    for (uint64_t b = 0; b < band_count; b++) {
+        if (offset_bands.band_orientations[b] == 0) continue;
+        const ClipperLib::IntPoint& lowest = offset_bands.band_lowest[b];
+        if (lowest_band == band_count || lowest.Y > offset_bands.band_lowest[lowest_band].Y ||
+            (lowest.Y == offset_bands.band_lowest[lowest_band].Y &&
+             lowest.X < offset_bands.band_lowest[lowest_band].X)) {
+            lowest_band = b;
+        }
+    }
+    if (lowest_band < band_count) {
+        offset_bands.orientation = offset_bands.band_orientations[lowest_band];
+    }
+    free_allocation(offset_bands.band_orientations);
+    free_allocation(offset_bands.band_lowest);
+    if (offset_bands.orientation == 2) {
+        finish_bands(bands, result);
+        return offset_engine(polygons, distance, join, tolerance, scaling, use_union, rectilinear,
+                             result);
+    }
+    parallel_for(band_count, num_threads, offset_band_paths, &offset_bands);
+
+    // As in offset_rectilinear, offset paths are joined by Clipper in all
+    // bands if the rectilinear engine declines any of them.
+    bool use_clipper = true;
+    if (rectilinear) {
+        parallel_for(band_count, num_threads, offset_band_join_manhattan, &offset_bands);
+        use_clipper = bands_declined(bands);
+    }
+    if (use_clipper) {
+        parallel_for(band_count, num_threads, offset_band_scanbeams, &offset_bands);
+        parallel_for(band_count, num_threads, offset_band_join, &offset_bands);
+    }
+
+    return finish_bands(bands, result);
+}
+
 ErrorCode slice(const Polygon& polygon, const Array<double>& positions, bool x_axis, double scaling,
                 Array<Polygon*>* result) {
     ErrorCode error_code = ErrorCode::NoError;
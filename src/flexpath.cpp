@@ -203,15 +203,8 @@ void FlexPath::apply_repetition(Array<FlexPath*>& result) {
 
 void FlexPath::transform(double magnification, bool x_reflection, double rotation,
                          const Vec2 origin) {
-    double ca = cos(rotation);
-    double sa = sin(rotation);
-    Vec2* p = spine.point_array.items;
-    for (uint64_t num = spine.point_array.count; num > 0; num--, p++) {
-        Vec2 q = *p * magnification;
-        if (x_reflection) q.y = -q.y;
-        p->x = q.x * ca - q.y * sa + origin.x;
-        p->y = q.x * sa + q.y * ca + origin.y;
-    }
+    transform_points(spine.point_array.items, spine.point_array.count, magnification,
+                     x_reflection, rotation, origin);
     Vec2 wo_scale = {1, magnification};
     if (scale_width) wo_scale.x = magnification;
     FlexPathElement* el = elements;
@@ -238,6 +231,14 @@ void FlexPath::remove_overlapping_points() {
 }
 
 ErrorCode FlexPath::to_polygons(bool filter, Tag tag, Array<Polygon*>& result) {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    ErrorCode error_code = to_polygons(filter ? &tags : NULL, result);
+    tags.clear();
+    return error_code;
+}
+
+ErrorCode FlexPath::to_polygons(const Set<Tag>* tags, Array<Polygon*>& result) {
     remove_overlapping_points();
     if (spine.point_array.count < 2) return ErrorCode::EmptyPath;
 
@@ -246,7 +247,7 @@ ErrorCode FlexPath::to_polygons(bool filter, Tag tag, Array<Polygon*>& result) {
 
     FlexPathElement* el = elements;
     for (uint64_t ne = 0; ne < num_elements; ne++, el++) {
-        if (filter && el->tag != tag) continue;
+        if (tags && !tags->has_value(el->tag)) continue;
 
         const double* half_widths = (double*)el->half_width_and_offset.items;
         const double* offsets = half_widths + 1;
@@ -920,61 +921,27 @@ ErrorCode FlexPath::to_oas(OasisStream& out, OasisState& state) {
 
     if (spine.point_array.count < 2) return ErrorCode::EmptyPath;
 
-    bool has_repetition = repetition.get_count() > 1;
-
     Array<Vec2> point_array = {};
     point_array.ensure_slots(spine.point_array.count);
 
     FlexPathElement* el = elements;
     for (uint64_t ne = 0; ne < num_elements; ne++, el++) {
-        uint8_t info = 0xFB;
-        if (has_repetition) info |= 0x04;
-
-        oasis_putc((int)OasisRecord::PATH, out);
-        oasis_putc(info, out);
-        oasis_write_unsigned_integer(out, get_layer(el->tag));
-        oasis_write_unsigned_integer(out, get_type(el->tag));
         uint64_t half_width = (uint64_t)llround(el->half_width_and_offset[0].u * state.scaling);
-        oasis_write_unsigned_integer(out, half_width);
-
-        switch (el->end_type) {
-            case EndType::Extended: {
-                uint8_t extension_scheme = 0;
-                int64_t start_extension = (int64_t)llround(el->end_extensions.u * state.scaling);
-                int64_t end_extension = (int64_t)llround(el->end_extensions.v * state.scaling);
-                if (start_extension == 0) {
-                    extension_scheme |= 0x04;
-                } else if (start_extension > 0 && (uint64_t)start_extension == half_width) {
-                    extension_scheme |= 0x08;
-                    start_extension = 0;
-                } else {
-                    extension_scheme |= 0x0C;
-                }
-                if (end_extension == 0) {
-                    extension_scheme |= 0x01;
-                } else if (end_extension > 0 && (uint64_t)end_extension == half_width) {
-                    extension_scheme |= 0x02;
-                    end_extension = 0;
-                } else {
-                    extension_scheme |= 0x03;
-                }
-                oasis_putc(extension_scheme, out);
-                if (start_extension != 0) oasis_write_integer(out, start_extension);
-                if (end_extension != 0) oasis_write_integer(out, end_extension);
-            } break;
-            case EndType::HalfWidth:
-                oasis_putc(0x0A, out);
-                break;
-            default:  // Flush
-                oasis_putc(0x05, out);
+        int64_t start_extension = 0;
+        int64_t end_extension = 0;
+        if (el->end_type == EndType::Extended) {
+            start_extension = (int64_t)llround(el->end_extensions.u * state.scaling);
+            end_extension = (int64_t)llround(el->end_extensions.v * state.scaling);
+        } else if (el->end_type == EndType::HalfWidth) {
+            start_extension = (int64_t)half_width;
+            end_extension = (int64_t)half_width;
         }
 
         ErrorCode err = element_center(el, point_array);
         if (err != ErrorCode::NoError) error_code = err;
-        oasis_write_point_list(out, point_array, state.scaling, false);
-        oasis_write_integer(out, (int64_t)llround(point_array[0].x * state.scaling));
-        oasis_write_integer(out, (int64_t)llround(point_array[0].y * state.scaling));
-        if (has_repetition) oasis_write_repetition(out, repetition, state.scaling);
+
+        oasis_write_path(out, state, el->tag, half_width, start_extension, end_extension,
+                         point_array, repetition);
         err = properties_to_oas(properties, out, state);
         if (err != ErrorCode::NoError) error_code = err;
 
@@ -12,6 +12,16 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <stdint.h>
 #include <stdio.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include <gdstk/gdsii.hpp>
 #include <gdstk/utils.hpp>
 
@@ -95,4 +105,89 @@ ErrorCode gdsii_read_record(FILE* in, uint8_t* buffer, uint64_t& buffer_count) {
     return ErrorCode::NoError;
 }
 
+bool GdsiiMemoryMap::map(FILE* file) {
+    data = NULL;
+    size = 0;
+#ifdef _WIN32
+    mapping = NULL;
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK) return false;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart <= 0) return false;
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) return false;
+    data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        mapping = NULL;
+        return false;
+    }
+    size = (uint64_t)file_size.QuadPart;
+#else
+    struct stat file_stat;
+    int fd = fileno(file);
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0)
+        return false;
+    void* address = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) return false;
+#ifdef MADV_SEQUENTIAL
+    madvise(address, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+#endif
+    data = (const uint8_t*)address;
+    size = (uint64_t)file_stat.st_size;
+#endif
+    return true;
+}
+
+void GdsiiMemoryMap::unmap() {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = NULL;
+#else
+        munmap((void*)data, (size_t)size);
+#endif
+    }
+    data = NULL;
+    size = 0;
+}
+
+ErrorCode gdsii_next_record(const uint8_t* data, uint64_t size, uint64_t& position,
+                            const uint8_t*& record, uint64_t& record_length) {
+    if (position + 4 > size) {
+        if (error_logger)
+            fputs("[GDSTK] Unable to read input file. End of file reached unexpectedly.\n",
+                  error_logger);
+        record_length = size > position ? size - position : 0;
+        return ErrorCode::InputFileError;
+    }
+    record = data + position;
+    record_length = ((uint32_t)record[0] << 8) | (uint32_t)record[1];
+    if (record_length < 4) {
+        DEBUG_PRINT("Record length should be at least 4. Found %" PRIu64 "\n", record_length);
+        if (error_logger) fputs("[GDSTK] Invalid or corrupted GDSII file.\n", error_logger);
+        record_length = 4;
+        return ErrorCode::InvalidFile;
+    }
+    if (position + record_length > size) {
+        if (error_logger)
+            fputs("[GDSTK] Unable to read input file. End of file reached unexpectedly.\n",
+                  error_logger);
+        record_length = size - position;
+        return ErrorCode::InputFileError;
+    }
+    position += record_length;
+    return ErrorCode::NoError;
+}
+
+void gdsii_read_points(const uint8_t* bytes, uint64_t count, double factor, Vec2* result) {
+    double* d = (double*)result;
+    for (uint64_t i = 2 * count; i > 0; i--, bytes += 4) {
+        const int32_t value = (int32_t)(((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+                                        ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3]);
+        *d++ = factor * value;
+    }
+}
+
 }  // namespace gdstk
@@ -69,8 +69,8 @@ void Label::bounding_box(Vec2& min, Vec2& max) const {
 
 void Label::transform(double mag, bool x_refl, double rot, const Vec2 orig) {
     const int r1 = x_refl ? -1 : 1;
-    const double crot = cos(rot);
-    const double srot = sin(rot);
+    double crot, srot;
+    cos_sin(rot, crot, srot);
     const double x = origin.x;
     const double y = origin.y;
     origin.x = orig.x + mag * (x * crot - r1 * y * srot);
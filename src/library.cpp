@@ -30,6 +30,7 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <gdstk/polygon.hpp>
 #include <gdstk/rawcell.hpp>
 #include <gdstk/reference.hpp>
+#include <gdstk/sort.hpp>
 #include <gdstk/utils.hpp>
 #include <gdstk/vec.hpp>
 
@@ -129,15 +130,171 @@ void Library::top_level(Array<Cell*>& top_cells, Array<RawCell*>& top_rawcells)
     rawcell_deps.clear();
 }
 
+// Node of the cell dependency graph used by Library::geometry_info
+struct GeometryNode {
+    const Cell* cell;
+    uint64_t height;           // Distance to the deepest dependency
+    Array<uint64_t> children;  // Node for each reference (UINT64_MAX if not a cell reference)
+    bool needs_convex_hull;
+    bool modified;  // Cache entry outdated for the cell or any dependency
+};
+
+struct GeometryGraph {
+    Array<GeometryNode> node_array;
+    Map<uint64_t> node_map;  // Node index for each cell name + 1
+};
+
+// Cells in one level of the graph and the shared cache
+struct GeometryLevel {
+    GeometryNode** nodes;
+    Map<GeometryInfo>* cache;
+};
+
+static bool geometry_node_lower(GeometryNode* const& a, GeometryNode* const& b) {
+    return a->height < b->height;
+}
+
+static uint64_t add_geometry_node(GeometryGraph& graph, const Cell* cell) {
+    uint64_t index = graph.node_map.get(cell->name);
+    if (index > 0) return index - 1;
+
+    // Cells are loaded here, before any parallel work.  Cells that were never
+    // marked get a generation now, so that their entries can be tracked.
+    cell->load();
+    if (cell->generation == 0) ((Cell*)cell)->mark_modified();
+    index = graph.node_array.count;
+    graph.node_array.append(GeometryNode{cell});
+    graph.node_map.set(cell->name, index + 1);
+
+    Array<uint64_t> children = {};
+    uint64_t height = 0;
+    children.ensure_slots(cell->reference_array.count);
+    for (uint64_t i = 0; i < cell->reference_array.count; i++) {
+        const Reference* reference = cell->reference_array[i];
+        if (reference->type != ReferenceType::Cell) {
+            children.append_unsafe(UINT64_MAX);
+            continue;
+        }
+        uint64_t child = add_geometry_node(graph, reference->cell);
+        children.append_unsafe(child);
+        if (graph.node_array[child].height + 1 > height) {
+            height = graph.node_array[child].height + 1;
+        }
+    }
+    graph.node_array[index].children = children;
+    graph.node_array[index].height = height;
+    return index;
+}
+
+static void compute_geometry_node(uint64_t index, void* data) {
+    const GeometryLevel* level = (GeometryLevel*)data;
+    const GeometryNode* node = level->nodes[index];
+    const char* name = node->cell->name;
+    GeometryInfo info = level->cache->get(name);
+    if (node->needs_convex_hull && !info.convex_hull_valid) {
+        info = node->cell->convex_hull(*level->cache);
+    }
+    if (!info.bounding_box_valid) info = node->cell->bounding_box(*level->cache);
+    info.generation = node->cell->generation;
+    level->cache->set(name, info);
+}
+
+void Library::geometry_info(bool convex_hulls, uint32_t num_threads,
+                            Map<GeometryInfo>& cache) const {
+    GeometryGraph graph = {};
+    for (uint64_t i = 0; i < cell_array.count; i++) add_geometry_node(graph, cell_array[i]);
+    const uint64_t count = graph.node_array.count;
+    if (count == 0) return;
+
+    // Children are always in lower levels than their parents
+    Array<GeometryNode*> order = {};
+    order.ensure_slots(count);
+    for (uint64_t i = 0; i < count; i++) order.append_unsafe(graph.node_array.items + i);
+    sort(order, geometry_node_lower);
+
+    // Discard the entries computed for other generations of the cells.  Going
+    // from the bottom level up, the changes propagate to all ancestors.
+    for (uint64_t i = 0; i < count; i++) {
+        GeometryNode* node = order[i];
+        GeometryInfo info = cache.get(node->cell->name);
+        node->modified = info.generation != node->cell->generation;
+        for (uint64_t j = 0; j < node->children.count && !node->modified; j++) {
+            const uint64_t child = node->children[j];
+            if (child != UINT64_MAX && graph.node_array[child].modified) node->modified = true;
+        }
+        if (node->modified && (info.bounding_box_valid || info.convex_hull_valid)) {
+            info.clear();
+            cache.set(node->cell->name, info);
+        }
+    }
+
+    // References with rotations that are not multiples of π/2 use the convex
+    // hull of the referenced cell, which in turn requires the convex hulls of
+    // all its dependencies.  Going from the top level down, all parents of a
+    // node are visited before the node itself.
+    for (uint64_t i = count; i > 0; i--) {
+        GeometryNode* node = order[i - 1];
+        if (convex_hulls) node->needs_convex_hull = true;
+        if (cache.get(node->cell->name).convex_hull_valid) continue;
+        const Array<Reference*>& references = node->cell->reference_array;
+        for (uint64_t j = 0; j < references.count; j++) {
+            if (node->children[j] == UINT64_MAX) continue;
+            int64_t m;
+            if (node->needs_convex_hull || !is_multiple_of_pi_over_2(references[j]->rotation, m)) {
+                graph.node_array[node->children[j]].needs_convex_hull = true;
+            }
+        }
+    }
+
+    // Insert all entries beforehand (with room to spare) so that the cache is
+    // never resized by the concurrent updates below.  Each thread only
+    // modifies the entry of its own cell and reads the entries of cells from
+    // lower levels.
+    for (uint64_t i = 0; i < count; i++) {
+        const char* cell_name = graph.node_array[i].cell->name;
+        cache.set(cell_name, cache.get(cell_name));
+    }
+    if (cache.count * 10 >= cache.capacity * GDSTK_MAP_CAPACITY_THRESHOLD) {
+        cache.resize(cache.capacity * GDSTK_MAP_GROWTH_FACTOR);
+    }
+
+    GeometryLevel level = {NULL, &cache};
+    for (uint64_t start = 0; start < count;) {
+        uint64_t end = start + 1;
+        while (end < count && order[end]->height == order[start]->height) end++;
+        level.nodes = order.items + start;
+        parallel_for(end - start, num_threads, compute_geometry_node, &level);
+        start = end;
+    }
+
+    order.clear();
+    for (uint64_t i = 0; i < count; i++) graph.node_array[i].children.clear();
+    graph.node_array.clear();
+    graph.node_map.clear();
+}
+
 Cell* Library::get_cell(const char* cell_name) const {
     Cell** p = cell_array.items;
     for (uint64_t i = cell_array.count; i > 0; i--) {
         Cell* cell = *p++;
-        if (strcmp(cell->name, cell_name) == 0) return cell;
+        if (strcmp(cell->name, cell_name) == 0) {
+            cell->load();
+            return cell;
+        }
     }
     return NULL;
 }
 
+ErrorCode Library::load_all() const {
+    ErrorCode error_code = ErrorCode::NoError;
+    Cell** p = cell_array.items;
+    for (uint64_t i = cell_array.count; i > 0; i--) {
+        ErrorCode err = (*p++)->load();
+        if (err != ErrorCode::NoError) error_code = err;
+    }
+    return error_code;
+}
+
 RawCell* Library::get_rawcell(const char* rawcell_name) const {
     RawCell** p = rawcell_array.items;
     for (uint64_t i = rawcell_array.count; i > 0; i--) {
@@ -172,6 +329,8 @@ void Library::rename_cell(Cell* cell, const char* new_name) {
 }
 
 void Library::replace_cell(Cell* old_cell, Cell* new_cell) {
+    // Lazy cells would still resolve their references to old_cell
+    load_all();
     uint64_t index = cell_array.index(old_cell);
     if (index < cell_array.count) {
         cell_array.items[index] = new_cell;
@@ -183,18 +342,21 @@ void Library::replace_cell(Cell* old_cell, Cell* new_cell) {
     bool rename = strcmp(old_name, new_name) != 0;
     for (uint64_t i = 0; i < cell_array.count; ++i) {
         Array<Reference*> ref_array = cell_array[i]->reference_array;
+        bool modified = false;
         for (uint64_t j = 0; j < ref_array.count; ++j) {
             Reference* ref = ref_array[j];
             switch (ref->type) {
                 case ReferenceType::Cell:
                     if (ref->cell == old_cell) {
                         ref->cell = new_cell;
+                        modified = true;
                     }
                     break;
                 case ReferenceType::RawCell:
                     if (strcmp(ref->rawcell->name, old_name) == 0) {
                         ref->type = ReferenceType::Cell;
                         ref->cell = new_cell;
+                        modified = true;
                     }
                     break;
                 case ReferenceType::Name:
@@ -205,6 +367,7 @@ void Library::replace_cell(Cell* old_cell, Cell* new_cell) {
                     break;
             }
         }
+        if (modified) cell_array[i]->mark_modified();
     }
 }
 
@@ -221,18 +384,21 @@ void Library::replace_cell(RawCell* old_cell, Cell* new_cell) {
     bool rename = strcmp(old_name, new_name) != 0;
     for (uint64_t i = 0; i < cell_array.count; ++i) {
         Array<Reference*> ref_array = cell_array[i]->reference_array;
+        bool modified = false;
         for (uint64_t j = 0; j < ref_array.count; ++j) {
             Reference* ref = ref_array[j];
             switch (ref->type) {
                 case ReferenceType::Cell:
                     if (strcmp(ref->cell->name, old_name) == 0) {
                         ref->cell = new_cell;
+                        modified = true;
                     }
                     break;
                 case ReferenceType::RawCell:
                     if (ref->rawcell == old_cell) {
                         ref->type = ReferenceType::Cell;
                         ref->cell = new_cell;
+                        modified = true;
                     }
                     break;
                 case ReferenceType::Name:
@@ -243,10 +409,13 @@ void Library::replace_cell(RawCell* old_cell, Cell* new_cell) {
                     break;
             }
         }
+        if (modified) cell_array[i]->mark_modified();
     }
 }
 
 void Library::replace_cell(Cell* old_cell, RawCell* new_cell) {
+    // Lazy cells would still resolve their references to old_cell
+    load_all();
     uint64_t index = cell_array.index(old_cell);
     if (index < cell_array.count) {
         cell_array.remove_unordered(index);
@@ -259,6 +428,7 @@ void Library::replace_cell(Cell* old_cell, RawCell* new_cell) {
     bool rename = strcmp(old_name, new_name) != 0;
     for (uint64_t i = 0; i < cell_array.count; ++i) {
         Array<Reference*> ref_array = cell_array[i]->reference_array;
+        bool modified = false;
         for (uint64_t j = 0; j < ref_array.count; ++j) {
             Reference* ref = ref_array[j];
             switch (ref->type) {
@@ -266,6 +436,7 @@ void Library::replace_cell(Cell* old_cell, RawCell* new_cell) {
                     if (ref->cell == old_cell) {
                         ref->type = ReferenceType::RawCell;
                         ref->rawcell = new_cell;
+                        modified = true;
                     }
                     break;
                 case ReferenceType::RawCell:
@@ -281,6 +452,7 @@ void Library::replace_cell(Cell* old_cell, RawCell* new_cell) {
                     break;
             }
         }
+        if (modified) cell_array[i]->mark_modified();
     }
 }
 
@@ -321,7 +493,68 @@ void Library::replace_cell(RawCell* old_cell, RawCell* new_cell) {
     }
 }
 
+// Prepare a shallow copy of cell (view) for output, in which the references
+// (and polygons, if include_polygons) without repetition or properties are
+// replaced by copies folded with Cell::extract_repetitions.  The copies are
+// owned by extracted, which must be freed with free_all after use.  Only the
+// polygon and reference arrays of view must be cleared.
+static void extract_repetitions_view(const Cell* cell, double precision, bool include_polygons,
+                                     Cell& view, Cell& extracted) {
+    view = *cell;
+    view.polygon_array = {};
+    view.reference_array = {};
+    extracted = {};
+
+    if (include_polygons) {
+        for (uint64_t i = 0; i < cell->polygon_array.count; i++) {
+            Polygon* polygon = cell->polygon_array[i];
+            if (polygon->repetition.type == RepetitionType::None && polygon->properties == NULL) {
+                Polygon* copy = (Polygon*)allocate_clear(sizeof(Polygon));
+                copy->copy_from(*polygon);
+                extracted.polygon_array.append(copy);
+            } else {
+                view.polygon_array.append(polygon);
+            }
+        }
+    } else {
+        view.polygon_array.copy_from(cell->polygon_array);
+    }
+
+    for (uint64_t i = 0; i < cell->reference_array.count; i++) {
+        Reference* reference = cell->reference_array[i];
+        if (reference->repetition.type == RepetitionType::None && reference->properties == NULL) {
+            Reference* copy = (Reference*)allocate_clear(sizeof(Reference));
+            copy->copy_from(*reference);
+            extracted.reference_array.append(copy);
+        } else {
+            view.reference_array.append(reference);
+        }
+    }
+
+    Array<Polygon*> removed_polygons = {};
+    Array<Reference*> removed_references = {};
+    extracted.extract_repetitions(precision, removed_polygons, removed_references);
+    for (uint64_t i = 0; i < removed_polygons.count; i++) {
+        removed_polygons[i]->clear();
+        free_allocation(removed_polygons[i]);
+    }
+    for (uint64_t i = 0; i < removed_references.count; i++) {
+        removed_references[i]->clear();
+        free_allocation(removed_references[i]);
+    }
+    removed_polygons.clear();
+    removed_references.clear();
+
+    view.polygon_array.extend(extracted.polygon_array);
+    view.reference_array.extend(extracted.reference_array);
+}
+
 ErrorCode Library::write_gds(const char* filename, uint64_t max_points, tm* timestamp) const {
+    return write_gds(filename, max_points, timestamp, 0);
+}
+
+ErrorCode Library::write_gds(const char* filename, uint64_t max_points, tm* timestamp,
+                             uint16_t config_flags) const {
     ErrorCode error_code = ErrorCode::NoError;
     FILE* out = fopen(filename, "wb");
     if (out == NULL) {
@@ -369,7 +602,21 @@ ErrorCode Library::write_gds(const char* filename, uint64_t max_points, tm* time
     double scaling = unit / precision;
     Cell** cell = cell_array.items;
     for (uint64_t i = 0; i < cell_array.count; i++, cell++) {
-        ErrorCode err = (*cell)->to_gds(out, scaling, max_points, precision, timestamp);
+        ErrorCode err;
+        if (config_flags & GDSII_CONFIG_EXTRACT_REPETITIONS) {
+            // Polygon repetitions are expanded in GDSII, so only references
+            // benefit from the extraction (as AREF records)
+            Cell view;
+            Cell extracted;
+            (*cell)->load();
+            extract_repetitions_view(*cell, 1 / scaling, false, view, extracted);
+            err = view.to_gds(out, scaling, max_points, precision, timestamp);
+            view.polygon_array.clear();
+            view.reference_array.clear();
+            extracted.free_all();
+        } else {
+            err = (*cell)->to_gds(out, scaling, max_points, precision, timestamp);
+        }
         if (err != ErrorCode::NoError) error_code = err;
     }
 
@@ -410,9 +657,372 @@ static void* zalloc(void*, uInt count, uInt size) { return allocate(count * size
 
 static void zfree(void*, void* ptr) { free_allocation(ptr); }
 
+// Compress size bytes from data into a newly allocated result buffer.
+static ErrorCode oasis_deflate(const uint8_t* data, uint64_t size, uint8_t compression_level,
+                               uint8_t*& result, uint64_t& result_size) {
+    ErrorCode error_code = ErrorCode::NoError;
+    z_stream s = {};
+    s.zalloc = zalloc;
+    s.zfree = zfree;
+    if (deflateInit2(&s, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        if (error_logger) fputs("[GDSTK] Unable to initialize zlib.\n", error_logger);
+        error_code = ErrorCode::ZlibError;
+    }
+    s.avail_out = deflateBound(&s, (uLong)size);
+    result = (uint8_t*)allocate(s.avail_out);
+    s.next_out = result;
+    s.avail_in = (uInt)size;
+    s.next_in = (Bytef*)data;
+    int ret = deflate(&s, Z_FINISH);
+    if (ret != Z_STREAM_END) {
+        if (error_logger) fputs("[GDSTK] Unable to compress CBLOCK.\n", error_logger);
+        error_code = ErrorCode::ZlibError;
+    }
+    result_size = s.total_out;
+    deflateEnd(&s);
+    return error_code;
+}
+
+static void oasis_write_cblock(OasisStream& out, uint64_t uncompressed_size,
+                               const uint8_t* compressed, uint64_t compressed_size) {
+    oasis_putc((int)OasisRecord::CBLOCK, out);
+    oasis_putc(0, out);
+    oasis_write_unsigned_integer(out, uncompressed_size);
+    oasis_write_unsigned_integer(out, compressed_size);
+    oasis_write(compressed, 1, compressed_size, out);
+}
+
+struct OasisTagOrder {
+    Tag tag;
+    uint64_t index;
+};
+
+static bool oasis_tag_order_less(const OasisTagOrder& a, const OasisTagOrder& b) {
+    return a.tag < b.tag || (a.tag == b.tag && a.index < b.index);
+}
+
+// Append items to result in a stable order by tag
+template <class T>
+static void oasis_sort_by_tag(const Array<T*>& items, Array<T*>& result) {
+    Array<OasisTagOrder> order = {};
+    order.ensure_slots(items.count);
+    for (uint64_t i = 0; i < items.count; i++) order.append_unsafe({items[i]->tag, i});
+    sort(order, oasis_tag_order_less);
+    result.ensure_slots(items.count);
+    for (uint64_t i = 0; i < order.count; i++) result.append_unsafe(items[order[i].index]);
+    order.clear();
+}
+
+// Polygons and labels from cell in the order they are written to the OASIS
+// file.  With OASIS_CONFIG_SORT_BY_TAG they are grouped by tag, so that
+// layer and datatype are reused from the modal variables as much as possible.
+// In that case, the arrays must be cleared by the caller.
+static void oasis_cell_shapes(const Cell* cell, uint16_t config_flags, Array<Polygon*>& polygons,
+                              Array<Label*>& labels) {
+    if (config_flags & OASIS_CONFIG_SORT_BY_TAG) {
+        polygons = {};
+        labels = {};
+        oasis_sort_by_tag(cell->polygon_array, polygons);
+        oasis_sort_by_tag(cell->label_array, labels);
+    } else {
+        polygons = cell->polygon_array;
+        labels = cell->label_array;
+    }
+}
+
+static ErrorCode oasis_write_cell_elements(Cell* cell, OasisStream& out, OasisState& state,
+                                           const Map<uint64_t>& cell_name_map,
+                                           Map<uint64_t>& text_string_map) {
+    ErrorCode error_code = ErrorCode::NoError;
+    ErrorCode err;
+
+    // Modal variables are reset by the CELL record
+    state.modal.reset();
+
+    Array<Polygon*> polygons;
+    Array<Label*> labels;
+    oasis_cell_shapes(cell, state.config_flags, polygons, labels);
+
+    Polygon** poly_p = polygons.items;
+    for (uint64_t j = polygons.count; j > 0; j--) {
+        err = (*poly_p++)->to_oas(out, state);
+        if (err != ErrorCode::NoError) error_code = err;
+    }
+
+    FlexPath** flexpath_p = cell->flexpath_array.items;
+    for (uint64_t j = cell->flexpath_array.count; j > 0; j--) {
+        FlexPath* path = *flexpath_p++;
+        if (path->simple_path) {
+            err = path->to_oas(out, state);
+            if (err != ErrorCode::NoError) error_code = err;
+        } else {
+            Array<Polygon*> array = {};
+            err = path->to_polygons(false, 0, array);
+            if (err != ErrorCode::NoError) error_code = err;
+            poly_p = array.items;
+            for (uint64_t k = array.count; k > 0; k--) {
+                Polygon* poly = *poly_p++;
+                err = poly->to_oas(out, state);
+                if (err != ErrorCode::NoError) error_code = err;
+                poly->clear();
+                free_allocation(poly);
+            }
+            array.clear();
+        }
+    }
+
+    RobustPath** robustpath_p = cell->robustpath_array.items;
+    for (uint64_t j = cell->robustpath_array.count; j > 0; j--) {
+        RobustPath* path = *robustpath_p++;
+        if (path->simple_path) {
+            err = path->to_oas(out, state);
+            if (err != ErrorCode::NoError) error_code = err;
+        } else {
+            Array<Polygon*> array = {};
+            err = path->to_polygons(false, 0, array);
+            if (err != ErrorCode::NoError) error_code = err;
+            poly_p = array.items;
+            for (uint64_t k = array.count; k > 0; k--) {
+                Polygon* poly = *poly_p++;
+                err = poly->to_oas(out, state);
+                if (err != ErrorCode::NoError) error_code = err;
+                poly->clear();
+                free_allocation(poly);
+            }
+            array.clear();
+        }
+    }
+
+    OasisModal& modal = state.modal;
+    Reference** ref_p = cell->reference_array.items;
+    for (uint64_t j = cell->reference_array.count; j > 0; j--) {
+        Reference* ref = *ref_p++;
+        if (ref->type == ReferenceType::RawCell) {
+            if (error_logger)
+                fputs("[GDSTK] Reference to a RawCell cannot be used in an OASIS file.\n",
+                      error_logger);
+            error_code = ErrorCode::MissingReference;
+            continue;
+        }
+        // Info: 'CNXYRAAF' or 'CNXYRMAF'
+        const char* name_ = (ref->type == ReferenceType::Cell) ? ref->cell->name : ref->name;
+        bool reference_exists = cell_name_map.has_key(name_);
+        uint64_t index = 0;
+        uint8_t info = 0;
+        if (reference_exists) {
+            index = cell_name_map.get(name_);
+            if (oasis_modal_update(modal.placement_cell_defined, modal.placement_cell, index))
+                info |= 0xC0;
+        } else {
+            info |= 0x80;
+            modal.placement_cell_defined = false;
+        }
+        IntVec2 origin = {(int64_t)llround(ref->origin.x * state.scaling),
+                          (int64_t)llround(ref->origin.y * state.scaling)};
+        if (origin.x != modal.placement_position.x) info |= 0x20;
+        if (origin.y != modal.placement_position.y) info |= 0x10;
+        modal.placement_position = origin;
+        bool has_repetition = ref->repetition.get_count() > 1;
+        if (has_repetition) info |= 0x08;
+        if (ref->x_reflection) info |= 0x01;
+        int64_t m;
+        bool transform = !(ref->magnification == 1.0 && is_multiple_of_pi_over_2(ref->rotation, m));
+        if (transform) {
+            if (ref->magnification != 1) info |= 0x04;
+            if (ref->rotation != 0) info |= 0x02;
+            oasis_putc((int)OasisRecord::PLACEMENT_TRANSFORM, out);
+        } else {
+            if (m < 0) {
+                info |= ((uint8_t)(0x03 & ((m % 4) + 4))) << 1;
+            } else {
+                info |= ((uint8_t)(0x03 & (m % 4))) << 1;
+            }
+            oasis_putc((int)OasisRecord::PLACEMENT, out);
+        }
+        oasis_putc(info, out);
+        if (info & 0x80) {
+            if (reference_exists) {
+                oasis_write_unsigned_integer(out, index);
+            } else {
+                uint64_t len = strlen(name_);
+                oasis_write_unsigned_integer(out, len);
+                oasis_write(name_, 1, len, out);
+            }
+        }
+        if (transform) {
+            if (ref->magnification != 1) {
+                oasis_write_real(out, ref->magnification);
+            }
+            if (ref->rotation != 0) {
+                oasis_write_real(out, ref->rotation * (180.0 / M_PI));
+            }
+        }
+        if (info & 0x20) oasis_write_integer(out, origin.x);
+        if (info & 0x10) oasis_write_integer(out, origin.y);
+        if (has_repetition) oasis_write_repetition(out, ref->repetition, state.scaling, modal);
+        err = properties_to_oas(ref->properties, out, state);
+        if (err != ErrorCode::NoError) error_code = err;
+    }
+
+    Label** label_p = labels.items;
+    for (uint64_t j = labels.count; j > 0; j--) {
+        Label* label = *label_p++;
+        uint64_t index;
+        if (text_string_map.has_key(label->text)) {
+            index = text_string_map.get(label->text);
+        } else {
+            index = text_string_map.count;
+            text_string_map.set(label->text, index);
+        }
+        // Info: '0CNXYRTL'
+        bool has_repetition = label->repetition.get_count() > 1;
+        uint8_t info = has_repetition ? 0x04 : 0;
+        if (oasis_modal_update(modal.text_string_defined, modal.text_string, index)) info |= 0x60;
+        if (oasis_modal_update(modal.textlayer_defined, modal.textlayer, get_layer(label->tag)))
+            info |= 0x01;
+        if (oasis_modal_update(modal.texttype_defined, modal.texttype, get_type(label->tag)))
+            info |= 0x02;
+        IntVec2 origin = {(int64_t)llround(label->origin.x * state.scaling),
+                          (int64_t)llround(label->origin.y * state.scaling)};
+        info |= oasis_position_info(modal.text_position, origin);
+        modal.text_position = origin;
+        oasis_putc((int)OasisRecord::TEXT, out);
+        oasis_putc(info, out);
+        if (info & 0x40) oasis_write_unsigned_integer(out, index);
+        if (info & 0x01) oasis_write_unsigned_integer(out, modal.textlayer);
+        if (info & 0x02) oasis_write_unsigned_integer(out, modal.texttype);
+        if (info & 0x10) oasis_write_integer(out, origin.x);
+        if (info & 0x08) oasis_write_integer(out, origin.y);
+        if (has_repetition) oasis_write_repetition(out, label->repetition, state.scaling, modal);
+        err = properties_to_oas(label->properties, out, state);
+        if (err != ErrorCode::NoError) error_code = err;
+    }
+
+    if (state.config_flags & OASIS_CONFIG_SORT_BY_TAG) {
+        polygons.clear();
+        labels.clear();
+    }
+    return error_code;
+}
+
+// Write the contents of cell (excluding the CELL record itself) to out.  New
+// text strings are added to text_string_map.
+static ErrorCode oasis_write_cell_contents(Cell* cell, OasisStream& out, OasisState& state,
+                                           const Map<uint64_t>& cell_name_map,
+                                           Map<uint64_t>& text_string_map) {
+    if (!(state.config_flags & OASIS_CONFIG_EXTRACT_REPETITIONS))
+        return oasis_write_cell_elements(cell, out, state, cell_name_map, text_string_map);
+    // Folded elements have no properties, so the strings registered from the
+    // original cell contents are still valid
+    Cell view;
+    Cell extracted;
+    extract_repetitions_view(cell, 1 / state.scaling, true, view, extracted);
+    ErrorCode error_code =
+        oasis_write_cell_elements(&view, out, state, cell_name_map, text_string_map);
+    view.polygon_array.clear();
+    view.reference_array.clear();
+    extracted.free_all();
+    return error_code;
+}
+
+// Add the strings used by oasis_write_cell_contents for cell to the OASIS
+// tables, in the same order.
+static void oasis_register_cell_strings(Cell* cell, OasisState& state,
+                                        Map<uint64_t>& text_string_map) {
+    Array<Polygon*> polygons;
+    Array<Label*> labels;
+    oasis_cell_shapes(cell, state.config_flags, polygons, labels);
+
+    Polygon** poly_p = polygons.items;
+    for (uint64_t j = polygons.count; j > 0; j--) {
+        properties_register_oas((*poly_p++)->properties, state);
+    }
+
+    // Empty paths are not written
+    FlexPath** flexpath_p = cell->flexpath_array.items;
+    for (uint64_t j = cell->flexpath_array.count; j > 0; j--) {
+        FlexPath* path = *flexpath_p++;
+        path->remove_overlapping_points();
+        if (path->spine.point_array.count > 1 && path->num_elements > 0) {
+            properties_register_oas(path->properties, state);
+        }
+    }
+
+    RobustPath** robustpath_p = cell->robustpath_array.items;
+    for (uint64_t j = cell->robustpath_array.count; j > 0; j--) {
+        RobustPath* path = *robustpath_p++;
+        if (path->subpath_array.count > 0 && path->num_elements > 0) {
+            properties_register_oas(path->properties, state);
+        }
+    }
+
+    Reference** ref_p = cell->reference_array.items;
+    for (uint64_t j = cell->reference_array.count; j > 0; j--) {
+        Reference* ref = *ref_p++;
+        if (ref->type != ReferenceType::RawCell) properties_register_oas(ref->properties, state);
+    }
+
+    Label** label_p = labels.items;
+    for (uint64_t j = labels.count; j > 0; j--) {
+        Label* label = *label_p++;
+        if (!text_string_map.has_key(label->text)) {
+            text_string_map.set(label->text, text_string_map.count);
+        }
+        properties_register_oas(label->properties, state);
+    }
+
+    if (state.config_flags & OASIS_CONFIG_SORT_BY_TAG) {
+        polygons.clear();
+        labels.clear();
+    }
+}
+
+// Encoded (and possibly compressed) cell contents for the parallel writer
+struct OasisCellBuffer {
+    uint8_t* data;
+    uint64_t size;  // uncompressed
+    uint8_t* compressed;
+    uint64_t compressed_size;
+    ErrorCode error_code;
+};
+
+struct OasisEncodeData {
+    Cell** cells;
+    OasisCellBuffer* buffers;
+    const OasisState* state;
+    Map<uint64_t>* cell_name_map;
+    Map<uint64_t>* text_string_map;
+    uint8_t compression_level;
+};
+
+static void oasis_encode_cell(uint64_t index, void* data) {
+    OasisEncodeData* encode_data = (OasisEncodeData*)data;
+    OasisCellBuffer* buffer = encode_data->buffers + index;
+    // Shallow copy: the tables are complete, so they are only read from
+    OasisState state = *encode_data->state;
+    state.modal = {};
+    OasisStream out = {};
+    out.data_size = 64 * 1024;
+    out.data = (uint8_t*)allocate(out.data_size);
+    out.cursor = out.data;
+    buffer->error_code =
+        oasis_write_cell_contents(encode_data->cells[index], out, state,
+                                  *encode_data->cell_name_map, *encode_data->text_string_map);
+    state.modal.clear();
+    buffer->size = out.cursor - out.data;
+    if (encode_data->compression_level > 0 && buffer->size > 0) {
+        ErrorCode err = oasis_deflate(out.data, buffer->size, encode_data->compression_level,
+                                      buffer->compressed, buffer->compressed_size);
+        if (err != ErrorCode::NoError) buffer->error_code = err;
+        free_allocation(out.data);
+    } else {
+        buffer->data = out.data;
+    }
+}
+
 ErrorCode Library::write_oas(const char* filename, double circle_tolerance,
                              uint8_t compression_level, uint16_t config_flags) {
-    ErrorCode error_code = ErrorCode::NoError;
+    ErrorCode error_code = load_all();
     const uint64_t c_size = cell_array.count;
     OasisState state = {};
     state.circle_tolerance = circle_tolerance;
@@ -607,190 +1217,82 @@ ErrorCode Library::write_oas(const char* filename, double circle_tolerance,
         cell_name_map.set(cell->name, i);
     }
 
-    cell_p = cell_array.items;
-    for (uint64_t i = 0; i < c_size; i++) {
-        Cell* cell = *cell_p++;
-        if (write_cell_offsets) {
-            cell_offset_map.set(cell->name, ftell(out.file));
-        }
-        oasis_putc((int)OasisRecord::CELL_REF_NUM, out);
-        oasis_write_unsigned_integer(out, cell_name_map.get(cell->name));
-
-        assert(cell_name_map.get(cell->name) == i);
-
-        if (compression_level > 0) {
-            out.cursor = out.data;
-        }
-
-        // TODO: Use modal variables
-        // Cell contents
-        Polygon** poly_p = cell->polygon_array.items;
-        for (uint64_t j = cell->polygon_array.count; j > 0; j--) {
-            err = (*poly_p++)->to_oas(out, state);
-            if (err != ErrorCode::NoError) error_code = err;
-        }
-
-        FlexPath** flexpath_p = cell->flexpath_array.items;
-        for (uint64_t j = cell->flexpath_array.count; j > 0; j--) {
-            FlexPath* path = *flexpath_p++;
-            if (path->simple_path) {
-                err = path->to_oas(out, state);
-                if (err != ErrorCode::NoError) error_code = err;
-            } else {
-                Array<Polygon*> array = {};
-                err = path->to_polygons(false, 0, array);
-                if (err != ErrorCode::NoError) error_code = err;
-                poly_p = array.items;
-                for (uint64_t k = array.count; k > 0; k--) {
-                    Polygon* poly = *poly_p++;
-                    err = poly->to_oas(out, state);
-                    if (err != ErrorCode::NoError) error_code = err;
-                    poly->clear();
-                    free_allocation(poly);
-                }
-                array.clear();
-            }
-        }
-
-        RobustPath** robustpath_p = cell->robustpath_array.items;
-        for (uint64_t j = cell->robustpath_array.count; j > 0; j--) {
-            RobustPath* path = *robustpath_p++;
-            if (path->simple_path) {
-                err = path->to_oas(out, state);
-                if (err != ErrorCode::NoError) error_code = err;
-            } else {
-                Array<Polygon*> array = {};
-                err = path->to_polygons(false, 0, array);
-                if (err != ErrorCode::NoError) error_code = err;
-                poly_p = array.items;
-                for (uint64_t k = array.count; k > 0; k--) {
-                    Polygon* poly = *poly_p++;
-                    err = poly->to_oas(out, state);
-                    if (err != ErrorCode::NoError) error_code = err;
-                    poly->clear();
-                    free_allocation(poly);
-                }
-                array.clear();
-            }
+    if ((state.config_flags & OASIS_CONFIG_PARALLEL) && c_size > 1) {
+        // Workers only read from the name tables, so all strings are
+        // registered beforehand, in the same order as the sequential writer.
+        cell_p = cell_array.items;
+        for (uint64_t i = 0; i < c_size; i++) {
+            oasis_register_cell_strings(*cell_p++, state, text_string_map);
         }
 
-        Reference** ref_p = cell->reference_array.items;
-        for (uint64_t j = cell->reference_array.count; j > 0; j--) {
-            Reference* ref = *ref_p++;
-            if (ref->type == ReferenceType::RawCell) {
-                if (error_logger)
-                    fputs("[GDSTK] Reference to a RawCell cannot be used in an OASIS file.\n",
-                          error_logger);
-                error_code = ErrorCode::MissingReference;
-                continue;
-            }
-            const char* name_ = (ref->type == ReferenceType::Cell) ? ref->cell->name : ref->name;
-            bool reference_exists = cell_name_map.has_key(name_);
-            uint8_t info = reference_exists ? 0xF0 : 0xB0;
-            bool has_repetition = ref->repetition.get_count() > 1;
-            if (has_repetition) info |= 0x08;
-            if (ref->x_reflection) info |= 0x01;
-            int64_t m;
-            if (ref->magnification == 1.0 && is_multiple_of_pi_over_2(ref->rotation, m)) {
-                if (m < 0) {
-                    info |= ((uint8_t)(0x03 & ((m % 4) + 4))) << 1;
-                } else {
-                    info |= ((uint8_t)(0x03 & (m % 4))) << 1;
+        // Cells are encoded in batches to limit the memory used by buffers
+        // waiting to be written.
+        const uint64_t batch_size = 4 * (uint64_t)hardware_thread_count();
+        OasisCellBuffer* buffers =
+            (OasisCellBuffer*)allocate_clear(batch_size * sizeof(OasisCellBuffer));
+        OasisEncodeData data = {NULL,           buffers,         &state,
+                                &cell_name_map, &text_string_map, compression_level};
+        for (uint64_t i = 0; i < c_size; i += batch_size) {
+            const uint64_t count = c_size - i < batch_size ? c_size - i : batch_size;
+            data.cells = cell_array.items + i;
+            parallel_for(count, 0, oasis_encode_cell, &data);
+
+            OasisCellBuffer* buffer = buffers;
+            for (uint64_t j = 0; j < count; j++, buffer++) {
+                Cell* cell = cell_array[i + j];
+                if (write_cell_offsets) {
+                    cell_offset_map.set(cell->name, ftell(out.file));
                 }
-                oasis_putc((int)OasisRecord::PLACEMENT, out);
-                oasis_putc(info, out);
-                if (reference_exists) {
-                    uint64_t index = cell_name_map.get(name_);
-                    oasis_write_unsigned_integer(out, index);
-                } else {
-                    uint64_t len = strlen(name_);
-                    oasis_write_unsigned_integer(out, len);
-                    oasis_write(ref->name, 1, len, out);
-                }
-            } else {
-                if (ref->magnification != 1) info |= 0x04;
-                if (ref->rotation != 0) info |= 0x02;
-                oasis_putc((int)OasisRecord::PLACEMENT_TRANSFORM, out);
-                oasis_putc(info, out);
-                if (reference_exists) {
-                    uint64_t index = cell_name_map.get(name_);
-                    oasis_write_unsigned_integer(out, index);
+                oasis_putc((int)OasisRecord::CELL_REF_NUM, out);
+                oasis_write_unsigned_integer(out, i + j);
+                if (buffer->error_code != ErrorCode::NoError) error_code = buffer->error_code;
+                if (compression_level > 0) {
+                    if (buffer->size > 0) {
+                        oasis_write_cblock(out, buffer->size, buffer->compressed,
+                                           buffer->compressed_size);
+                    }
                 } else {
-                    uint64_t len = strlen(name_);
-                    oasis_write_unsigned_integer(out, len);
-                    oasis_write(ref->name, 1, len, out);
-                }
-                if (ref->magnification != 1) {
-                    oasis_write_real(out, ref->magnification);
-                }
-                if (ref->rotation != 0) {
-                    oasis_write_real(out, ref->rotation * (180.0 / M_PI));
+                    oasis_write(buffer->data, 1, buffer->size, out);
                 }
+                if (buffer->data) free_allocation(buffer->data);
+                if (buffer->compressed) free_allocation(buffer->compressed);
+                *buffer = {};
             }
-            oasis_write_integer(out, (int64_t)llround(ref->origin.x * state.scaling));
-            oasis_write_integer(out, (int64_t)llround(ref->origin.y * state.scaling));
-            if (has_repetition) oasis_write_repetition(out, ref->repetition, state.scaling);
-            err = properties_to_oas(ref->properties, out, state);
-            if (err != ErrorCode::NoError) error_code = err;
         }
+        free_allocation(buffers);
+    } else {
+        cell_p = cell_array.items;
+        for (uint64_t i = 0; i < c_size; i++) {
+            Cell* cell = *cell_p++;
+            if (write_cell_offsets) {
+                cell_offset_map.set(cell->name, ftell(out.file));
+            }
+            oasis_putc((int)OasisRecord::CELL_REF_NUM, out);
+            oasis_write_unsigned_integer(out, cell_name_map.get(cell->name));
 
-        Label** label_p = cell->label_array.items;
-        for (uint64_t j = cell->label_array.count; j > 0; j--) {
-            Label* label = *label_p++;
-            uint8_t info = 0x7B;
-            bool has_repetition = label->repetition.get_count() > 1;
-            if (has_repetition) info |= 0x04;
-            oasis_putc((int)OasisRecord::TEXT, out);
-            oasis_putc(info, out);
-            uint64_t index;
-            if (text_string_map.has_key(label->text)) {
-                index = text_string_map.get(label->text);
-            } else {
-                index = text_string_map.count;
-                text_string_map.set(label->text, index);
+            assert(cell_name_map.get(cell->name) == i);
+
+            if (compression_level > 0) {
+                out.cursor = out.data;
             }
-            oasis_write_unsigned_integer(out, index);
-            oasis_write_unsigned_integer(out, get_layer(label->tag));
-            oasis_write_unsigned_integer(out, get_type(label->tag));
-            oasis_write_integer(out, (int64_t)llround(label->origin.x * state.scaling));
-            oasis_write_integer(out, (int64_t)llround(label->origin.y * state.scaling));
-            if (has_repetition) oasis_write_repetition(out, label->repetition, state.scaling);
-            err = properties_to_oas(label->properties, out, state);
+
+            err = oasis_write_cell_contents(cell, out, state, cell_name_map, text_string_map);
             if (err != ErrorCode::NoError) error_code = err;
-        }
 
-        if (compression_level > 0) {
-            uint64_t uncompressed_size = out.cursor - out.data;
-            out.cursor = NULL;
-
-            // Skip empty cells
-            if (uncompressed_size > 0) {
-                z_stream s = {};
-                s.zalloc = zalloc;
-                s.zfree = zfree;
-                if (deflateInit2(&s, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
-                    Z_OK) {
-                    if (error_logger) fputs("[GDSTK] Unable to initialize zlib.\n", error_logger);
-                    error_code = ErrorCode::ZlibError;
-                }
-                s.avail_out = deflateBound(&s, (uLong)uncompressed_size);
-                uint8_t* buffer = (uint8_t*)allocate(s.avail_out);
-                s.next_out = buffer;
-                s.avail_in = (uInt)uncompressed_size;
-                s.next_in = out.data;
-                int ret = deflate(&s, Z_FINISH);
-                if (ret != Z_STREAM_END) {
-                    if (error_logger) fputs("[GDSTK] Unable to compress CBLOCK.\n", error_logger);
-                    error_code = ErrorCode::ZlibError;
-                }
-
-                oasis_putc((int)OasisRecord::CBLOCK, out);
-                oasis_putc(0, out);
-                oasis_write_unsigned_integer(out, uncompressed_size);
-                oasis_write_unsigned_integer(out, s.total_out);
-                oasis_write(buffer, 1, s.total_out, out);
-                free_allocation(buffer);
-                deflateEnd(&s);
+            if (compression_level > 0) {
+                uint64_t uncompressed_size = out.cursor - out.data;
+                out.cursor = NULL;
+
+                // Skip empty cells
+                if (uncompressed_size > 0) {
+                    uint8_t* buffer;
+                    uint64_t compressed_size;
+                    err = oasis_deflate(out.data, uncompressed_size, compression_level, buffer,
+                                        compressed_size);
+                    if (err != ErrorCode::NoError) error_code = err;
+                    oasis_write_cblock(out, uncompressed_size, buffer, compressed_size);
+                    free_allocation(buffer);
+                }
             }
         }
     }
@@ -827,8 +1329,9 @@ ErrorCode Library::write_oas(const char* filename, double circle_tolerance,
             set_property(cell->properties, s_bounding_box_property_name, xmin, false);
             set_property(cell->properties, s_bounding_box_property_name, (uint64_t)0, false);
         }
+        // Offsets from a previously read or written file are never valid here
+        remove_property(cell->properties, s_cell_offset_property_name, true);
         if (write_cell_offsets) {
-            remove_property(cell->properties, s_cell_offset_property_name, true);
             set_property(cell->properties, s_cell_offset_property_name,
                          cell_offset_map.get(cell->name), true);
         }
@@ -913,59 +1416,82 @@ ErrorCode Library::write_oas(const char* filename, double circle_tolerance,
     text_string_map.clear();
     state.property_name_map.clear();
     state.property_value_array.clear();
+    state.modal.clear();
     return error_code;
 }
 
-Library read_gds(const char* filename, double unit, double tolerance, const Set<Tag>* shape_tags,
-                 ErrorCode* error_code) {
-    const char* gdsii_record_names[] = {
-        "HEADER",    "BGNLIB",   "LIBNAME",   "UNITS",      "ENDLIB",      "BGNSTR",
-        "STRNAME",   "ENDSTR",   "BOUNDARY",  "PATH",       "SREF",        "AREF",
-        "TEXT",      "LAYER",    "DATATYPE",  "WIDTH",      "XY",          "ENDEL",
-        "SNAME",     "COLROW",   "TEXTNODE",  "NODE",       "TEXTTYPE",    "PRESENTATION",
-        "SPACING",   "STRING",   "STRANS",    "MAG",        "ANGLE",       "UINTEGER",
-        "USTRING",   "REFLIBS",  "FONTS",     "PATHTYPE",   "GENERATIONS", "ATTRTABLE",
-        "STYPTABLE", "STRTYPE",  "ELFLAGS",   "ELKEY",      "LINKTYPE",    "LINKKEYS",
-        "NODETYPE",  "PROPATTR", "PROPVALUE", "BOX",        "BOXTYPE",     "PLEX",
-        "BGNEXTN",   "ENDEXTN",  "TAPENUM",   "TAPECODE",   "STRCLASS",    "RESERVED",
-        "FORMAT",    "MASK",     "ENDMASKS",  "LIBDIRSIZE", "SRFNAME",     "LIBSECUR"};
-
-    Library library = {};
-    // One extra char in case we need a 0-terminated string with max count (should never happen, but
-    // it doesn't hurt to be prepared).
-    uint8_t buffer[65537];
-    int16_t* data16 = (int16_t*)(buffer + 4);
-    int32_t* data32 = (int32_t*)(buffer + 4);
-    uint64_t* data64 = (uint64_t*)(buffer + 4);
-    char* str = (char*)(buffer + 4);
-
-    Cell* cell = NULL;
-    Polygon* polygon = NULL;
-    FlexPath* path = NULL;
-    Reference* reference = NULL;
-    Label* label = NULL;
-
-    double factor = 1;
-    double width = 0;
-    int16_t key = 0;
-
-    FILE* in = fopen(filename, "rb");
-    if (in == NULL) {
-        ////////////////// CAESAREALABS EDIT //////////////////////
-        //////// REASON: Print WHERE gds tried to look for the file, and failed to find it.
-        fprintf(stderr, "[GDSTK] Unable to open GDSII file at %ls%ls%s for input.\n",  std::filesystem::current_path().c_str(),&std::filesystem::path::preferred_separator, filename);
-        ///////////////////////////////////////////////////////////
-        if (error_code) *error_code = ErrorCode::InputFileOpenError;
-        return library;
+// Remove from the library all cells that are not in cell_names or in their dependency trees.
+static void keep_cell_hierarchy(Library& library, const Array<const char*>& cell_names,
+                                ErrorCode* error_code) {
+    Map<Cell*> keep = {};
+    for (uint64_t i = 0; i < cell_names.count; i++) {
+        Cell* cell = library.get_cell(cell_names[i]);
+        if (cell) {
+            keep.set(cell->name, cell);
+            cell->get_dependencies(true, keep);
+        } else {
+            if (error_code) *error_code = ErrorCode::MissingReference;
+            if (error_logger)
+                fprintf(error_logger, "[GDSTK] Cell %s not found in library.\n", cell_names[i]);
+        }
     }
 
-    while (true) {
-        uint64_t record_length = COUNT(buffer);
-        ErrorCode err = gdsii_read_record(in, buffer, record_length);
-        if (err != ErrorCode::NoError) {
-            if (error_code) *error_code = err;
-            break;
+    Cell** src = library.cell_array.items;
+    Cell** dst = library.cell_array.items;
+    for (uint64_t i = library.cell_array.count; i > 0; i--) {
+        Cell* cell = *src++;
+        if (keep.get(cell->name) == cell) {
+            *dst++ = cell;
+        } else {
+            cell->free_all();
+            free_allocation(cell);
         }
+    }
+    library.cell_array.count = dst - library.cell_array.items;
+    keep.clear();
+}
+
+static const char* gdsii_record_names[] = {
+    "HEADER",    "BGNLIB",   "LIBNAME",   "UNITS",      "ENDLIB",      "BGNSTR",
+    "STRNAME",   "ENDSTR",   "BOUNDARY",  "PATH",       "SREF",        "AREF",
+    "TEXT",      "LAYER",    "DATATYPE",  "WIDTH",      "XY",          "ENDEL",
+    "SNAME",     "COLROW",   "TEXTNODE",  "NODE",       "TEXTTYPE",    "PRESENTATION",
+    "SPACING",   "STRING",   "STRANS",    "MAG",        "ANGLE",       "UINTEGER",
+    "USTRING",   "REFLIBS",  "FONTS",     "PATHTYPE",   "GENERATIONS", "ATTRTABLE",
+    "STYPTABLE", "STRTYPE",  "ELFLAGS",   "ELKEY",      "LINKTYPE",    "LINKKEYS",
+    "NODETYPE",  "PROPATTR", "PROPVALUE", "BOX",        "BOXTYPE",     "PLEX",
+    "BGNEXTN",   "ENDEXTN",  "TAPENUM",   "TAPECODE",   "STRCLASS",    "RESERVED",
+    "FORMAT",    "MASK",     "ENDMASKS",  "LIBDIRSIZE", "SRFNAME",     "LIBSECUR"};
+
+// Parsing state for GDSII records.  The whole stream can be parsed by a single
+// reader, or each structure can be parsed by its own reader (in parallel),
+// provided that the library-level records (UNITS, in particular) have been
+// processed before.
+struct GdsiiReader {
+    Library* library;  // LIBNAME, UNITS and new cells go here
+    const Set<Tag>* shape_tags;
+    ErrorCode* error_code;
+
+    double unit;
+    double tolerance;
+    double factor;
+    double width;
+    int16_t key;
+
+    Cell* cell;
+    Polygon* polygon;
+    FlexPath* path;
+    Reference* reference;
+    Label* label;
+
+    // Process the record in buffer (including header).  Its contents are
+    // byte-swapped in place.  The buffer must have room for at least one extra
+    // byte after the record.
+    void process_record(uint8_t* buffer, uint64_t record_length) {
+        int16_t* data16 = (int16_t*)(buffer + 4);
+        int32_t* data32 = (int32_t*)(buffer + 4);
+        uint64_t* data64 = (uint64_t*)(buffer + 4);
+        char* str = (char*)(buffer + 4);
 
         // printf("0x%02X %s (%" PRIu64 " bytes)", buffer[2],
         //        buffer[2] < COUNT(gdsii_record_names) ? gdsii_record_names[buffer[2]] : "",
@@ -1002,57 +1528,29 @@ Library read_gds(const char* filename, double unit, double tolerance, const Set<
             case GdsiiRecord::HEADER:
             case GdsiiRecord::BGNLIB:
             case GdsiiRecord::ENDSTR:
+            case GdsiiRecord::ENDLIB:
                 break;
             case GdsiiRecord::LIBNAME:
                 if (str[data_length - 1] == 0) data_length--;
-                library.name = (char*)allocate(data_length + 1);
-                memcpy(library.name, str, data_length);
-                library.name[data_length] = 0;
+                library->name = (char*)allocate(data_length + 1);
+                memcpy(library->name, str, data_length);
+                library->name[data_length] = 0;
                 break;
             case GdsiiRecord::UNITS: {
                 const double db_in_user = gdsii_real_to_double(data64[0]);
                 const double db_in_meters = gdsii_real_to_double(data64[1]);
                 if (unit > 0) {
                     factor = db_in_meters / unit;
-                    library.unit = unit;
+                    library->unit = unit;
                 } else {
                     factor = db_in_user;
-                    library.unit = db_in_meters / db_in_user;
+                    library->unit = db_in_meters / db_in_user;
                 }
-                library.precision = db_in_meters;
+                library->precision = db_in_meters;
                 if (tolerance <= 0) {
-                    tolerance = library.precision / library.unit;
+                    tolerance = library->precision / library->unit;
                 }
             } break;
-            case GdsiiRecord::ENDLIB: {
-                Map<Cell*> map = {};
-                uint64_t c_size = library.cell_array.count;
-                map.resize((uint64_t)(2.0 + 10.0 / GDSTK_MAP_CAPACITY_THRESHOLD * c_size));
-                Cell** c_item = library.cell_array.items;
-                for (uint64_t i = c_size; i > 0; i--, c_item++) map.set((*c_item)->name, *c_item);
-                c_item = library.cell_array.items;
-                for (uint64_t i = c_size; i > 0; i--) {
-                    cell = *c_item++;
-                    Reference** ref = cell->reference_array.items;
-                    for (uint64_t j = cell->reference_array.count; j > 0; j--) {
-                        reference = *ref++;
-                        Cell* cp = map.get(reference->name);
-                        if (cp) {
-                            free_allocation(reference->name);
-                            reference->type = ReferenceType::Cell;
-                            reference->cell = cp;
-                        } else {
-                            if (error_code) *error_code = ErrorCode::MissingReference;
-                            if (error_logger)
-                                fprintf(error_logger, "[GDSTK] Missing referenced cell %s\n",
-                                        reference->name);
-                        }
-                    }
-                }
-                map.clear();
-                fclose(in);
-                return library;
-            } break;
             case GdsiiRecord::BGNSTR:
                 cell = (Cell*)allocate_clear(sizeof(Cell));
                 break;
@@ -1062,7 +1560,7 @@ Library read_gds(const char* filename, double unit, double tolerance, const Set<
                     cell->name = (char*)allocate(data_length + 1);
                     memcpy(cell->name, str, data_length);
                     cell->name[data_length] = 0;
-                    library.cell_array.append(cell);
+                    library->cell_array.append(cell);
                 }
                 break;
             case GdsiiRecord::BOUNDARY:
@@ -1299,60 +1797,917 @@ Library read_gds(const char* filename, double unit, double tolerance, const Set<
                     set_gds_property(label->properties, key, str, data_length);
                 }
                 break;
-            case GdsiiRecord::BGNEXTN:
-                if (path) path->elements[0].end_extensions.u = factor * data32[0];
+            case GdsiiRecord::BGNEXTN:
+                if (path) path->elements[0].end_extensions.u = factor * data32[0];
+                break;
+            case GdsiiRecord::ENDEXTN:
+                if (path) path->elements[0].end_extensions.v = factor * data32[0];
+                break;
+            // TODO: Consider NODE support (even though it is not available for OASIS)
+            // case GdsiiRecord::TEXTNODE:
+            // case GdsiiRecord::NODE:
+            // case GdsiiRecord::SPACING:
+            // case GdsiiRecord::UINTEGER:
+            // case GdsiiRecord::USTRING:
+            // case GdsiiRecord::REFLIBS:
+            // case GdsiiRecord::FONTS:
+            // case GdsiiRecord::GENERATIONS:
+            // case GdsiiRecord::ATTRTABLE:
+            // case GdsiiRecord::STYPTABLE:
+            // case GdsiiRecord::STRTYPE:
+            // case GdsiiRecord::ELFLAGS:
+            // case GdsiiRecord::ELKEY:
+            // case GdsiiRecord::LINKTYPE:
+            // case GdsiiRecord::LINKKEYS:
+            // case GdsiiRecord::NODETYPE:
+            // case GdsiiRecord::PLEX:
+            // case GdsiiRecord::TAPENUM:
+            // case GdsiiRecord::TAPECODE:
+            // case GdsiiRecord::STRCLASS:
+            // case GdsiiRecord::RESERVED:
+            // case GdsiiRecord::FORMAT:
+            // case GdsiiRecord::MASK:
+            // case GdsiiRecord::ENDMASKS:
+            // case GdsiiRecord::LIBDIRSIZE:
+            // case GdsiiRecord::SRFNAME:
+            // case GdsiiRecord::LIBSECUR:
+            default:
+                if (buffer[2] < COUNT(gdsii_record_names)) {
+                    if (error_logger)
+                        fprintf(error_logger, "[GDSTK] Record type %s (0x%02X) is not supported.\n",
+                                gdsii_record_names[buffer[2]], buffer[2]);
+                } else {
+                    if (error_logger)
+                        fprintf(error_logger, "[GDSTK] Unknown record type 0x%02X.\n", buffer[2]);
+                }
+                if (error_code) *error_code = ErrorCode::UnsupportedRecord;
+        }
+    }
+
+    // Process a record in memory that cannot be modified (from a memory-mapped
+    // file), using buffer as scratch space if necessary.
+    void process_mapped_record(const uint8_t* record, uint64_t record_length, uint8_t* buffer) {
+        // Polygon coordinates are the bulk of most files: convert them straight from the mapped
+        // memory.  All other records go through the buffer as usual.
+        if (polygon && (GdsiiRecord)record[2] == GdsiiRecord::XY) {
+            const uint64_t count = (record_length - 4) / 8;
+            Array<Vec2>& point_array = polygon->point_array;
+            point_array.ensure_slots(count);
+            gdsii_read_points(record + 4, count, factor, point_array.items + point_array.count);
+            point_array.count += count;
+            return;
+        }
+        memcpy(buffer, record, record_length);
+        process_record(buffer, record_length);
+    }
+};
+
+static void gdsii_resolve_cell_references(Cell* cell, const Map<Cell*>& map,
+                                          ErrorCode* error_code) {
+    Reference** ref = cell->reference_array.items;
+    for (uint64_t j = cell->reference_array.count; j > 0; j--) {
+        Reference* reference = *ref++;
+        Cell* cp = map.get(reference->name);
+        if (cp) {
+            free_allocation(reference->name);
+            reference->type = ReferenceType::Cell;
+            reference->cell = cp;
+        } else {
+            if (error_code) *error_code = ErrorCode::MissingReference;
+            if (error_logger)
+                fprintf(error_logger, "[GDSTK] Missing referenced cell %s\n", reference->name);
+        }
+    }
+}
+
+static void gdsii_build_cell_map(const Library& library, Map<Cell*>& map) {
+    uint64_t c_size = library.cell_array.count;
+    map.resize((uint64_t)(2.0 + 10.0 / GDSTK_MAP_CAPACITY_THRESHOLD * c_size));
+    Cell** c_item = library.cell_array.items;
+    for (uint64_t i = c_size; i > 0; i--, c_item++) map.set((*c_item)->name, *c_item);
+}
+
+static void gdsii_clear_names(Array<char*>& names) {
+    for (uint64_t i = 0; i < names.count; i++) free_allocation(names[i]);
+    names.clear();
+}
+
+static void gdsii_remove_reference_names(GdsiiLazySource& source, const char* key) {
+    Array<char*> names = source.reference_names.get(key);
+    if (source.reference_names.del(key)) gdsii_clear_names(names);
+}
+
+// Key of a lazy cell in the cell map of its source: its original name, as it
+// might have been renamed since it was read.  NULL if the cell is not found.
+static const char* gdsii_lazy_cell_key(const Cell& cell) {
+    const Map<Cell*>& map = cell.lazy_source->cell_map;
+    if (cell.name && map.get(cell.name) == &cell) return cell.name;
+    for (MapItem<Cell*>* item = map.next(NULL); item; item = map.next(item)) {
+        if (item->value == &cell) return item->key;
+    }
+    return NULL;
+}
+
+static void gdsii_resolve_references(Library& library, ErrorCode* error_code) {
+    Map<Cell*> map = {};
+    gdsii_build_cell_map(library, map);
+    Cell** c_item = library.cell_array.items;
+    for (uint64_t i = library.cell_array.count; i > 0; i--) {
+        gdsii_resolve_cell_references(*c_item++, map, error_code);
+    }
+    map.clear();
+}
+
+ErrorCode gdsii_load_lazy_cell(Cell& cell) {
+    GdsiiLazySource* source = cell.lazy_source;
+    ErrorCode error_code = ErrorCode::NoError;
+
+    uint8_t* file_data = NULL;
+    const uint8_t* data;
+    if (source->memory_map.data) {
+        data = source->memory_map.data + cell.lazy_offset;
+    } else {
+        file_data = (uint8_t*)allocate(cell.lazy_size);
+        const RawSource file_source = {source->file, 0};
+        if (file_source.offset_read(file_data, cell.lazy_size, cell.lazy_offset) !=
+            (int64_t)cell.lazy_size) {
+            if (error_logger)
+                fprintf(error_logger, "[GDSTK] Unable to read contents of cell %s.\n", cell.name);
+            free_allocation(file_data);
+            return ErrorCode::InputFileError;
+        }
+        data = file_data;
+    }
+
+    Library library = {};
+    GdsiiReader reader = {};
+    reader.library = &library;
+    reader.shape_tags = source->filter ? &source->shape_tags : NULL;
+    reader.error_code = &error_code;
+    reader.tolerance = source->tolerance;
+    reader.factor = source->factor;
+    reader.cell = &cell;
+
+    uint8_t buffer[65537];
+    uint64_t position = 0;
+    while (position < cell.lazy_size) {
+        const uint8_t* record;
+        uint64_t record_length;
+        // Records have already been validated when the file was indexed.
+        gdsii_next_record(data, cell.lazy_size, position, record, record_length);
+        reader.process_mapped_record(record, record_length, buffer);
+    }
+    cell.lazy_size = 0;
+    if (file_data) free_allocation(file_data);
+
+    // The loaded references are used from now on
+    const char* key = gdsii_lazy_cell_key(cell);
+    if (key) gdsii_remove_reference_names(*source, key);
+
+    gdsii_resolve_cell_references(&cell, source->cell_map, &error_code);
+    return error_code;
+}
+
+void gdsii_release_lazy_cell(Cell& cell) {
+    GdsiiLazySource* source = cell.lazy_source;
+    if (source->uses <= 1) {
+        cell.lazy_source = NULL;
+        cell.lazy_size = 0;
+        if (source->memory_map.data) source->memory_map.unmap();
+        fclose(source->file);
+        source->shape_tags.clear();
+        source->cell_map.clear();
+        Map<Array<char*>>& names = source->reference_names;
+        for (MapItem<Array<char*>>* item = names.next(NULL); item; item = names.next(item)) {
+            gdsii_clear_names(item->value);
+        }
+        names.clear();
+        free_allocation(source);
+        return;
+    }
+    source->uses--;
+
+    // Make sure this cell cannot be used to resolve references anymore
+    const char* key = gdsii_lazy_cell_key(cell);
+    if (key) {
+        gdsii_remove_reference_names(*source, key);
+        source->cell_map.del(key);
+    }
+    cell.lazy_source = NULL;
+    cell.lazy_size = 0;
+}
+
+bool gdsii_get_lazy_dependencies(const Cell& cell, Array<Cell*>& result) {
+    const GdsiiLazySource* source = cell.lazy_source;
+    const char* key = gdsii_lazy_cell_key(cell);
+    if (!key || !source->reference_names.has_key(key)) return false;
+    const Array<char*> names = source->reference_names.get(key);
+    result.ensure_slots(names.count);
+    for (uint64_t i = 0; i < names.count; i++) {
+        // Missing cells are not dependencies, as in gdsii_resolve_cell_references
+        Cell* dependency = source->cell_map.get(names[i]);
+        if (dependency) result.append_unsafe(dependency);
+    }
+    return true;
+}
+
+// Byte range of a structure (from BGNSTR to ENDSTR, inclusive) in a
+// memory-mapped GDSII file and the cells parsed from it.
+struct GdsiiStructure {
+    uint64_t begin;
+    uint64_t end;
+    Array<Cell*> cell_array;
+    ErrorCode error_code;
+};
+
+struct GdsiiParallelData {
+    const uint8_t* data;
+    const GdsiiReader* reader;
+    GdsiiStructure* structures;
+};
+
+static void gdsii_parse_structure(uint64_t index, void* data) {
+    GdsiiParallelData* parallel_data = (GdsiiParallelData*)data;
+    GdsiiStructure* structure = parallel_data->structures + index;
+
+    Library library = {};
+    GdsiiReader reader = *parallel_data->reader;
+    reader.library = &library;
+    reader.error_code = &structure->error_code;
+    reader.width = 0;
+    reader.key = 0;
+
+    uint8_t buffer[65537];
+    uint64_t position = structure->begin;
+    while (position < structure->end) {
+        const uint8_t* record;
+        uint64_t record_length;
+        // Records have already been validated during the structure scan.
+        gdsii_next_record(parallel_data->data, structure->end, position, record, record_length);
+        reader.process_mapped_record(record, record_length, buffer);
+    }
+
+    structure->cell_array = library.cell_array;
+}
+
+Library read_gds(const char* filename, double unit, double tolerance, const Set<Tag>* shape_tags,
+                 const Array<const char*>* cell_names, uint16_t config_flags,
+                 ErrorCode* error_code) {
+    if (cell_names) {
+        // Index the file and load only the cells that are needed, so that they can all be
+        // detached from the file afterwards.
+        Library library = read_gds(filename, unit, tolerance, shape_tags, NULL,
+                                   config_flags | GDSII_READ_CONFIG_LAZY, error_code);
+        if (library.cell_array.count > 0) keep_cell_hierarchy(library, *cell_names, error_code);
+        Cell** c_item = library.cell_array.items;
+        for (uint64_t i = library.cell_array.count; i > 0; i--, c_item++) {
+            ErrorCode err = (*c_item)->load();
+            if (err != ErrorCode::NoError && error_code) *error_code = err;
+            if ((*c_item)->lazy_source) gdsii_release_lazy_cell(**c_item);
+        }
+        return library;
+    }
+
+    Library library = {};
+    // One extra char in case we need a 0-terminated string with max count (should never happen, but
+    // it doesn't hurt to be prepared).
+    uint8_t buffer[65537];
+
+    GdsiiReader reader = {};
+    reader.library = &library;
+    reader.shape_tags = shape_tags;
+    reader.error_code = error_code;
+    reader.unit = unit;
+    reader.tolerance = tolerance;
+    reader.factor = 1;
+
+    FILE* in = fopen(filename, "rb");
+    if (in == NULL) {
+        ////////////////// CAESAREALABS EDIT //////////////////////
+        //////// REASON: Print WHERE gds tried to look for the file, and failed to find it.
+        fprintf(stderr, "[GDSTK] Unable to open GDSII file at %ls%ls%s for input.\n",  std::filesystem::current_path().c_str(),&std::filesystem::path::preferred_separator, filename);
+        ///////////////////////////////////////////////////////////
+        if (error_code) *error_code = ErrorCode::InputFileOpenError;
+        return library;
+    }
+
+    // Non-regular files (pipes, for example) cannot be mapped, so we fall back to reading the
+    // stream record by record in that case.
+    GdsiiMemoryMap memory_map = {};
+    const bool mapped =
+        (config_flags & (GDSII_READ_CONFIG_MEMORY_MAP | GDSII_READ_CONFIG_PARALLEL)) &&
+        memory_map.map(in);
+    uint64_t position = 0;
+
+    // Lazy cells need random access to the file, so pipes, for example, are read eagerly.
+    if ((config_flags & GDSII_READ_CONFIG_LAZY) && (mapped || FSEEK64(in, 0, SEEK_SET) == 0)) {
+        // Index pass: process library-level records and find the contents of each cell.
+        Cell* cell = NULL;
+        bool success = false;
+        // Cells referenced by the current structure and by all structures
+        bool in_reference = false;
+        Map<bool> structure_references = {};
+        Map<Array<char*>> reference_names = {};
+        while (true) {
+            const uint8_t* record;
+            uint64_t record_length = COUNT(buffer);
+            ErrorCode err;
+            if (mapped) {
+                err = gdsii_next_record(memory_map.data, memory_map.size, position, record,
+                                        record_length);
+            } else {
+                err = gdsii_read_record(in, buffer, record_length);
+                position += record_length;
+                record = buffer;
+            }
+            if (err != ErrorCode::NoError) {
+                if (error_code) *error_code = err;
+                break;
+            }
+            const GdsiiRecord record_type = (GdsiiRecord)record[2];
+            if (cell) {
+                if (record_type == GdsiiRecord::STRNAME && cell->name == NULL) {
+                    uint64_t data_length = record_length - 4;
+                    if (data_length > 0 && record[4 + data_length - 1] == 0) data_length--;
+                    cell->name = (char*)allocate(data_length + 1);
+                    memcpy(cell->name, record + 4, data_length);
+                    cell->name[data_length] = 0;
+                    cell->lazy_offset = position;
+                    library.cell_array.append(cell);
+                } else if (record_type == GdsiiRecord::SREF || record_type == GdsiiRecord::AREF) {
+                    in_reference = true;
+                } else if (record_type == GdsiiRecord::ENDEL) {
+                    in_reference = false;
+                } else if (record_type == GdsiiRecord::SNAME && in_reference) {
+                    uint64_t data_length = record_length - 4;
+                    if (data_length > 0 && record[4 + data_length - 1] == 0) data_length--;
+                    char name[65537];
+                    memcpy(name, record + 4, data_length);
+                    name[data_length] = 0;
+                    structure_references.set(name, true);
+                } else if (record_type == GdsiiRecord::ENDSTR) {
+                    if (cell->name) {
+                        cell->lazy_size = position - cell->lazy_offset;
+                        Array<char*> names = reference_names.get(cell->name);
+                        gdsii_clear_names(names);
+                        Map<bool>& map = structure_references;
+                        names.ensure_slots(map.count);
+                        for (MapItem<bool>* item = map.next(NULL); item; item = map.next(item)) {
+                            names.append_unsafe(copy_string(item->key, NULL));
+                        }
+                        reference_names.set(cell->name, names);
+                    } else {
+                        free_allocation(cell);
+                    }
+                    structure_references.clear();
+                    cell = NULL;
+                }
+            } else if (record_type == GdsiiRecord::BGNSTR) {
+                cell = (Cell*)allocate_clear(sizeof(Cell));
+            } else if (record_type == GdsiiRecord::ENDLIB) {
+                success = true;
+                break;
+            } else if (mapped) {
+                reader.process_mapped_record(record, record_length, buffer);
+            } else {
+                reader.process_record(buffer, record_length);
+            }
+        }
+        if (cell && cell->name == NULL) free_allocation(cell);
+        structure_references.clear();
+
+        if (!success || library.cell_array.count == 0) {
+            for (MapItem<Array<char*>>* item = reference_names.next(NULL); item;
+                 item = reference_names.next(item)) {
+                gdsii_clear_names(item->value);
+            }
+            reference_names.clear();
+            if (mapped) memory_map.unmap();
+            fclose(in);
+            if (!success) {
+                library.free_all();
+                return Library{};
+            }
+            return library;
+        }
+
+        // The file is kept open (or mapped) in the source until all cells are cleared.
+        GdsiiLazySource* source = (GdsiiLazySource*)allocate_clear(sizeof(GdsiiLazySource));
+        source->file = in;
+        if (mapped) source->memory_map = memory_map;
+        source->uses = library.cell_array.count;
+        source->tolerance = reader.tolerance;
+        source->factor = reader.factor;
+        if (shape_tags) {
+            source->filter = true;
+            source->shape_tags.copy_from(*shape_tags);
+        }
+        gdsii_build_cell_map(library, source->cell_map);
+        source->reference_names = reference_names;
+        Cell** c_item = library.cell_array.items;
+        for (uint64_t i = library.cell_array.count; i > 0; i--) (*c_item++)->lazy_source = source;
+        return library;
+    }
+
+    if (mapped && (config_flags & GDSII_READ_CONFIG_PARALLEL)) {
+        // First pass: process library-level records and find the structure ranges.
+        Array<GdsiiStructure> structures = {};
+        GdsiiStructure structure = {};
+        bool in_structure = false;
+        bool success = false;
+        while (true) {
+            const uint8_t* record;
+            uint64_t record_length;
+            ErrorCode err = gdsii_next_record(memory_map.data, memory_map.size, position, record,
+                                              record_length);
+            if (err != ErrorCode::NoError) {
+                if (error_code) *error_code = err;
+                break;
+            }
+            const GdsiiRecord record_type = (GdsiiRecord)record[2];
+            if (in_structure) {
+                if (record_type == GdsiiRecord::ENDSTR) {
+                    structure.end = position;
+                    structures.append(structure);
+                    in_structure = false;
+                }
+            } else if (record_type == GdsiiRecord::BGNSTR) {
+                structure.begin = position - record_length;
+                in_structure = true;
+            } else if (record_type == GdsiiRecord::ENDLIB) {
+                success = true;
+                break;
+            } else {
+                reader.process_mapped_record(record, record_length, buffer);
+            }
+        }
+
+        // Second pass: parse structures in parallel.  Cells are kept in file order.
+        if (success) {
+            GdsiiParallelData parallel_data = {memory_map.data, &reader, structures.items};
+            parallel_for(structures.count, 0, gdsii_parse_structure, &parallel_data);
+        }
+
+        GdsiiStructure* s = structures.items;
+        for (uint64_t i = structures.count; i > 0; i--, s++) {
+            library.cell_array.extend(s->cell_array);
+            s->cell_array.clear();
+            if (s->error_code != ErrorCode::NoError && error_code) *error_code = s->error_code;
+        }
+        structures.clear();
+        memory_map.unmap();
+        fclose(in);
+
+        if (!success) {
+            library.free_all();
+            return Library{};
+        }
+        gdsii_resolve_references(library, error_code);
+        return library;
+    }
+
+    bool success = false;
+    while (true) {
+        uint64_t record_length = COUNT(buffer);
+        if (mapped) {
+            const uint8_t* record;
+            ErrorCode err = gdsii_next_record(memory_map.data, memory_map.size, position, record,
+                                              record_length);
+            if (err != ErrorCode::NoError) {
+                if (error_code) *error_code = err;
+                break;
+            }
+            if ((GdsiiRecord)record[2] == GdsiiRecord::ENDLIB) {
+                success = true;
+                break;
+            }
+            reader.process_mapped_record(record, record_length, buffer);
+        } else {
+            ErrorCode err = gdsii_read_record(in, buffer, record_length);
+            if (err != ErrorCode::NoError) {
+                if (error_code) *error_code = err;
+                break;
+            }
+            if ((GdsiiRecord)buffer[2] == GdsiiRecord::ENDLIB) {
+                success = true;
+                break;
+            }
+            reader.process_record(buffer, record_length);
+        }
+    }
+
+    if (mapped) memory_map.unmap();
+    fclose(in);
+
+    if (!success) {
+        library.free_all();
+        return Library{};
+    }
+    gdsii_resolve_references(library, error_code);
+    return library;
+}
+
+static void oasis_clear_name_table(Array<ByteArray>& table) {
+    ByteArray* ba = table.items;
+    for (uint64_t i = table.count; i > 0; i--, ba++) {
+        if (ba->bytes) free_allocation(ba->bytes);
+        properties_clear(ba->properties);
+    }
+    table.clear();
+}
+
+// Read the table-offsets from a START or END record and store the offsets of
+// the cell name, text string, property name and property string tables.
+// Return false if any of these tables is present but not strict, i.e., if
+// name records can be found outside of the tables.
+static bool oasis_read_table_offsets(OasisStream& in, uint64_t* table_offsets) {
+    bool strict = true;
+    for (uint8_t i = 0; i < 6; i++) {
+        uint64_t flag = oasis_read_unsigned_integer(in);
+        uint64_t offset = oasis_read_unsigned_integer(in);
+        if (i < 4) {
+            table_offsets[i] = offset;
+            if (offset > 0 && flag == 0) strict = false;
+        }
+    }
+    return strict && in.error_code == ErrorCode::NoError;
+}
+
+// Compressed block found ahead of the parser by OasisPrefetch
+struct OasisCblock {
+    uint64_t offset;      // position of the CBLOCK record in the file
+    uint64_t end_offset;  // position right after the compressed data
+    uint64_t uncompressed_size;
+    uint64_t compressed_size;
+    uint8_t* compressed;
+    uint8_t* data;
+    ErrorCode error_code;
+};
+
+static void oasis_inflate_cblock(uint64_t index, void* data) {
+    OasisCblock* cblock = (OasisCblock*)data + index;
+    cblock->data = (uint8_t*)allocate(cblock->uncompressed_size);
+    z_stream s = {};
+    s.zalloc = zalloc;
+    s.zfree = zfree;
+    s.next_in = (Bytef*)cblock->compressed;
+    s.avail_in = (uInt)cblock->compressed_size;
+    s.next_out = cblock->data;
+    s.avail_out = (uInt)cblock->uncompressed_size;
+    if (inflateInit2(&s, -15) != Z_OK) {
+        cblock->error_code = ErrorCode::ZlibError;
+    } else {
+        if (inflate(&s, Z_FINISH) != Z_STREAM_END) cblock->error_code = ErrorCode::ZlibError;
+        inflateEnd(&s);
+    }
+    free_allocation(cblock->compressed);
+    cblock->compressed = NULL;
+}
+
+// Skip a PROPERTY record (after the record type).
+static void oasis_skip_property(OasisStream& in) {
+    uint8_t info;
+    if (oasis_read(&info, 1, 1, in) != ErrorCode::NoError) return;
+    uint64_t len;
+    if (info & 0x04) {
+        if (info & 0x02) {
+            oasis_read_unsigned_integer(in);
+        } else {
+            free_allocation(oasis_read_string(in, false, len));
+        }
+    }
+    if (info & 0x08) return;
+    uint64_t num_values = info >> 4;
+    if (num_values == 15) num_values = oasis_read_unsigned_integer(in);
+    for (; num_values > 0 && in.error_code == ErrorCode::NoError; num_values--) {
+        OasisDataType data_type;
+        oasis_read(&data_type, 1, 1, in);
+        switch (data_type) {
+            case OasisDataType::UnsignedInteger:
+            case OasisDataType::ReferenceA:
+            case OasisDataType::ReferenceB:
+            case OasisDataType::ReferenceN:
+                oasis_read_unsigned_integer(in);
+                break;
+            case OasisDataType::SignedInteger:
+                oasis_read_integer(in);
                 break;
-            case GdsiiRecord::ENDEXTN:
-                if (path) path->elements[0].end_extensions.v = factor * data32[0];
+            case OasisDataType::AString:
+            case OasisDataType::BString:
+            case OasisDataType::NString:
+                free_allocation(oasis_read_string(in, false, len));
                 break;
-            // TODO: Consider NODE support (even though it is not available for OASIS)
-            // case GdsiiRecord::TEXTNODE:
-            // case GdsiiRecord::NODE:
-            // case GdsiiRecord::SPACING:
-            // case GdsiiRecord::UINTEGER:
-            // case GdsiiRecord::USTRING:
-            // case GdsiiRecord::REFLIBS:
-            // case GdsiiRecord::FONTS:
-            // case GdsiiRecord::GENERATIONS:
-            // case GdsiiRecord::ATTRTABLE:
-            // case GdsiiRecord::STYPTABLE:
-            // case GdsiiRecord::STRTYPE:
-            // case GdsiiRecord::ELFLAGS:
-            // case GdsiiRecord::ELKEY:
-            // case GdsiiRecord::LINKTYPE:
-            // case GdsiiRecord::LINKKEYS:
-            // case GdsiiRecord::NODETYPE:
-            // case GdsiiRecord::PLEX:
-            // case GdsiiRecord::TAPENUM:
-            // case GdsiiRecord::TAPECODE:
-            // case GdsiiRecord::STRCLASS:
-            // case GdsiiRecord::RESERVED:
-            // case GdsiiRecord::FORMAT:
-            // case GdsiiRecord::MASK:
-            // case GdsiiRecord::ENDMASKS:
-            // case GdsiiRecord::LIBDIRSIZE:
-            // case GdsiiRecord::SRFNAME:
-            // case GdsiiRecord::LIBSECUR:
             default:
-                if (buffer[2] < COUNT(gdsii_record_names)) {
-                    if (error_logger)
-                        fprintf(error_logger, "[GDSTK] Record type %s (0x%02X) is not supported.\n",
-                                gdsii_record_names[buffer[2]], buffer[2]);
-                } else {
-                    if (error_logger)
-                        fprintf(error_logger, "[GDSTK] Unknown record type 0x%02X.\n", buffer[2]);
-                }
-                if (error_code) *error_code = ErrorCode::UnsupportedRecord;
+                oasis_read_real_by_type(in, data_type);
         }
     }
+}
 
-    library.free_all();
-    fclose(in);
-    return Library{};
+// Parallel decompression for read_oas.  Starting at a CBLOCK record, the
+// file is scanned ahead for more CBLOCKs, skipping the few record types that
+// usually separate them (CELL, PROPERTY, PAD, etc.).  The blocks found are
+// inflated concurrently and handed over to the parser as it reaches them.
+// Scanning stops at any other record type, at the latest when
+// GDSTK_OASIS_PREFETCH_SIZE bytes are to be inflated; it restarts at the next
+// CBLOCK the parser finds.
+struct OasisPrefetch {
+    Array<OasisCblock> cblocks;
+    uint64_t next;  // next cblock to be consumed
+
+    void fill(FILE* file, uint64_t offset) {
+        clear();
+        int64_t position = ftell(file);
+        FSEEK64(file, offset, SEEK_SET);
+        OasisStream scan = {file};
+        uint64_t total = 0;
+        uint64_t len;
+        OasisRecord record;
+        while (total < GDSTK_OASIS_PREFETCH_SIZE &&
+               oasis_read(&record, 1, 1, scan) == ErrorCode::NoError) {
+            bool stop = false;
+            switch (record) {
+                case OasisRecord::PAD:
+                case OasisRecord::XYABSOLUTE:
+                case OasisRecord::XYRELATIVE:
+                case OasisRecord::LAST_PROPERTY:
+                    break;
+                case OasisRecord::CELL_REF_NUM:
+                    oasis_read_unsigned_integer(scan);
+                    break;
+                case OasisRecord::CELL:
+                    free_allocation(oasis_read_string(scan, false, len));
+                    break;
+                case OasisRecord::PROPERTY:
+                    oasis_skip_property(scan);
+                    break;
+                case OasisRecord::CBLOCK: {
+                    OasisCblock cblock = {};
+                    cblock.offset = ftell(file) - 1;
+                    if (oasis_read_unsigned_integer(scan) != 0) {
+                        stop = true;
+                        break;
+                    }
+                    cblock.uncompressed_size = oasis_read_unsigned_integer(scan);
+                    cblock.compressed_size = oasis_read_unsigned_integer(scan);
+                    if (scan.error_code != ErrorCode::NoError) break;
+                    cblock.compressed = (uint8_t*)allocate(cblock.compressed_size);
+                    if (fread(cblock.compressed, 1, cblock.compressed_size, file) !=
+                        cblock.compressed_size) {
+                        free_allocation(cblock.compressed);
+                        stop = true;
+                        break;
+                    }
+                    cblock.end_offset = ftell(file);
+                    cblocks.append(cblock);
+                    total += cblock.uncompressed_size;
+                } break;
+                default:
+                    stop = true;
+            }
+            if (stop || scan.error_code != ErrorCode::NoError) break;
+        }
+        FSEEK64(file, position, SEEK_SET);
+        parallel_for(cblocks.count, 0, oasis_inflate_cblock, cblocks.items);
+    }
+
+    // If the CBLOCK record at offset has been inflated, pass its data to in,
+    // skip its contents in the file and return true.  Otherwise, discard any
+    // blocks left (the parser is out of sync with the scan) and return false.
+    bool take(OasisStream& in, uint64_t offset, ErrorCode* error_code) {
+        if (next == cblocks.count || cblocks[next].offset != offset) {
+            clear();
+            return false;
+        }
+        OasisCblock* cblock = cblocks.items + next++;
+        if (cblock->error_code != ErrorCode::NoError) {
+            if (error_logger) fputs("[GDSTK] Unable to decompress CBLOCK.\n", error_logger);
+            if (error_code) *error_code = cblock->error_code;
+        }
+        FSEEK64(in.file, cblock->end_offset, SEEK_SET);
+        if (cblock->uncompressed_size > 0) {
+            in.data = cblock->data;
+            in.cursor = in.data;
+            in.data_size = cblock->uncompressed_size;
+        } else {
+            free_allocation(cblock->data);
+        }
+        cblock->data = NULL;
+        return true;
+    }
+
+    void clear() {
+        OasisCblock* cblock = cblocks.items;
+        for (uint64_t i = cblocks.count; i > 0; i--, cblock++) {
+            if (cblock->compressed) free_allocation(cblock->compressed);
+            if (cblock->data) free_allocation(cblock->data);
+        }
+        cblocks.count = 0;
+        next = 0;
+    }
+};
+
+struct OasisCellOffset {
+    uint64_t offset;
+    Cell* cell;
+};
+
+static bool oasis_cell_offset_less(const OasisCellOffset& a, const OasisCellOffset& b) {
+    return a.offset < b.offset;
+}
+
+// Segments of an OASIS file visited by random access reading, in order.
+enum struct OasisSegment {
+    Header,  // library properties after START
+    CellNameTable,
+    TextStringTable,
+    PropNameTable,
+    PropStringTable,
+    Cells,
+};
+
+// State for random access reading in read_oas.  Instead of parsing the whole
+// file, only the library properties, the name tables and the requested cells
+// (with their dependencies) are read.  Cells are located by the S_CELL_OFFSET
+// properties in the cell name table.
+struct OasisRandomAccess {
+    bool active;
+    OasisSegment segment;
+    bool cell_started;
+    uint64_t start_position;    // first record after START
+    uint64_t table_offsets[4];  // in OasisSegment order
+    // Offsets indexed by cell reference number (zeroed once a cell is queued)
+    Array<uint64_t> cell_offsets;
+    Map<uint64_t> cell_numbers;  // cell reference numbers by name
+    Array<uint64_t> queue;       // offsets of the cells to be read
+    uint64_t queue_position;
+
+    // Check whether record belongs to the current segment
+    bool accepts(OasisRecord record) {
+        switch (record) {
+            case OasisRecord::PAD:
+            case OasisRecord::PROPERTY:
+            case OasisRecord::LAST_PROPERTY:
+                return true;
+            case OasisRecord::CBLOCK:
+                return segment != OasisSegment::Header;
+            case OasisRecord::CELLNAME_IMPLICIT:
+            case OasisRecord::CELLNAME:
+                return segment == OasisSegment::CellNameTable;
+            case OasisRecord::TEXTSTRING_IMPLICIT:
+            case OasisRecord::TEXTSTRING:
+                return segment == OasisSegment::TextStringTable;
+            case OasisRecord::PROPNAME_IMPLICIT:
+            case OasisRecord::PROPNAME:
+                return segment == OasisSegment::PropNameTable;
+            case OasisRecord::PROPSTRING_IMPLICIT:
+            case OasisRecord::PROPSTRING:
+                return segment == OasisSegment::PropStringTable;
+            case OasisRecord::CELL_REF_NUM:
+            case OasisRecord::CELL:
+                if (segment != OasisSegment::Cells || cell_started) return false;
+                cell_started = true;
+                return true;
+            case OasisRecord::START:
+            case OasisRecord::END:
+            case OasisRecord::LAYERNAME_DATA:
+            case OasisRecord::LAYERNAME_TEXT:
+            case OasisRecord::XNAME_IMPLICIT:
+            case OasisRecord::XNAME:
+                return false;
+            default:
+                return segment == OasisSegment::Cells && cell_started;
+        }
+    }
+
+    // Seek to the next name table.  Return false if there are no more tables.
+    bool next_table(OasisStream& in) {
+        while (segment < OasisSegment::PropStringTable) {
+            segment = (OasisSegment)((int)segment + 1);
+            uint64_t offset = table_offsets[(int)segment - 1];
+            if (offset > 0) {
+                FSEEK64(in.file, offset, SEEK_SET);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void enqueue(uint64_t number) {
+        if (number < cell_offsets.count && cell_offsets[number] > 0) {
+            queue.append(cell_offsets[number]);
+            cell_offsets[number] = 0;
+        }
+    }
+
+    // Called after all name tables are read.  Property names are resolved
+    // (they might be needed before the END record) and the requested cells
+    // are queued.  Return false if the cell offsets are not available.
+    bool start_cells(const Array<ByteArray>& cell_name_table,
+                     const Array<ByteArray>& property_name_table,
+                     Array<Property*>& unfinished_property_name,
+                     const Array<const char*>& cell_names) {
+        Property** prop_p = unfinished_property_name.items;
+        for (uint64_t i = unfinished_property_name.count; i > 0; i--) {
+            uint64_t index = (uint64_t)(*prop_p++)->name;
+            if (index >= property_name_table.count || !property_name_table[index].bytes)
+                return false;
+        }
+        prop_p = unfinished_property_name.items;
+        for (uint64_t i = unfinished_property_name.count; i > 0; i--) {
+            Property* property = *prop_p++;
+            ByteArray* prop_name = property_name_table.items + (uint64_t)property->name;
+            property->name = copy_string((char*)prop_name->bytes, NULL);
+        }
+        unfinished_property_name.count = 0;
+
+        cell_offsets.ensure_slots(cell_name_table.count);
+        cell_offsets.count = cell_name_table.count;
+        cell_numbers.resize(
+            (uint64_t)(2.0 + 10.0 / GDSTK_MAP_CAPACITY_THRESHOLD * cell_name_table.count));
+        for (uint64_t i = 0; i < cell_name_table.count; i++) {
+            ByteArray* cell_name = cell_name_table.items + i;
+            PropertyValue* value = cell_name->bytes ? get_property(cell_name->properties,
+                                                                   s_cell_offset_property_name)
+                                                    : NULL;
+            if (!value || value->type != PropertyType::UnsignedInteger ||
+                value->unsigned_integer == 0)
+                return false;
+            cell_offsets[i] = value->unsigned_integer;
+            cell_numbers.set((char*)cell_name->bytes, i);
+        }
+
+        for (uint64_t i = 0; i < cell_names.count; i++) {
+            if (cell_numbers.has_key(cell_names[i])) enqueue(cell_numbers.get(cell_names[i]));
+        }
+        segment = OasisSegment::Cells;
+        return true;
+    }
+
+    // Queue the cells referenced by cell (with unresolved references, as
+    // created by read_oas).
+    void enqueue_references(const Cell& cell) {
+        Reference** ref_p = cell.reference_array.items;
+        for (uint64_t i = cell.reference_array.count; i > 0; i--) {
+            Reference* ref = *ref_p++;
+            if (ref->type == ReferenceType::Cell) {
+                enqueue((uint64_t)ref->cell);
+            } else if (cell_numbers.has_key(ref->name)) {
+                enqueue(cell_numbers.get(ref->name));
+            }
+        }
+    }
+
+    // Seek to the next queued cell.  Return false if the queue is empty.
+    bool next_cell(OasisStream& in) {
+        if (queue_position == queue.count) return false;
+        FSEEK64(in.file, queue[queue_position++], SEEK_SET);
+        cell_started = false;
+        return true;
+    }
+
+    // Cells are read in queue order; put them back in file order.
+    void sort_cells(Array<Cell*>& cell_array) const {
+        if (cell_array.count != queue.count) return;
+        Array<OasisCellOffset> cells = {};
+        cells.ensure_slots(queue.count);
+        for (uint64_t i = 0; i < queue.count; i++) {
+            cells.append_unsafe(OasisCellOffset{queue[i], cell_array[i]});
+        }
+        sort(cells, oasis_cell_offset_less);
+        for (uint64_t i = 0; i < queue.count; i++) cell_array[i] = cells[i].cell;
+        cells.clear();
+    }
+
+    void clear() {
+        cell_offsets.clear();
+        cell_numbers.clear();
+        queue.clear();
+    }
+};
+
+// Properties following an element filtered out by read_oas are redirected to
+// the end of the list of skipped properties.
+static void oasis_redirect_skipped_properties(Property**& skipped_properties_tail,
+                                              Property**& next_property) {
+    while (*skipped_properties_tail)
+        skipped_properties_tail = &(*skipped_properties_tail)->next;
+    next_property = skipped_properties_tail;
+}
+
+// Skip the rest of an element filtered out by read_oas, with the given info
+// byte.  Its repetition must still be read, because it becomes the modal one.
+static void oasis_skip_element(OasisStream& in, double factor, uint8_t info,
+                               Repetition& modal_repetition,
+                               Property**& skipped_properties_tail,
+                               Property**& next_property) {
+    if (info & 0x04) oasis_read_repetition(in, factor, modal_repetition);
+    oasis_redirect_skipped_properties(skipped_properties_tail, next_property);
 }
 
 // TODO: verify modal variables are correctly updated
-Library read_oas(const char* filename, double unit, double tolerance, ErrorCode* error_code) {
+Library read_oas(const char* filename, double unit, double tolerance, const Set<Tag>* shape_tags,
+                 const Set<Tag>* label_tags, const Array<const char*>* cell_names,
+                 uint16_t config_flags, ErrorCode* error_code) {
     Library library = {};
 
     OasisStream in = {};
@@ -1398,11 +2753,31 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
         tolerance = library.precision / library.unit;
     }
 
+    // Random access is only used when specific cells are requested and the
+    // name tables can be found through the table-offsets.
+    OasisRandomAccess random_access = {};
     uint64_t offset_table_flag = oasis_read_unsigned_integer(in);
     if (offset_table_flag == 0) {
-        // Skip offset table
-        for (uint8_t i = 12; i > 0; i--) oasis_read_unsigned_integer(in);
+        random_access.active = oasis_read_table_offsets(in, random_access.table_offsets);
     }
+    random_access.start_position = ftell(in.file);
+    if (offset_table_flag != 0 && cell_names) {
+        // The END record has a fixed length of 256 bytes
+        OasisRecord end_record;
+        random_access.active =
+            FSEEK64(in.file, -256, SEEK_END) == 0 &&
+            oasis_read(&end_record, 1, 1, in) == ErrorCode::NoError &&
+            end_record == OasisRecord::END &&
+            oasis_read_table_offsets(in, random_access.table_offsets);
+        in.error_code = ErrorCode::NoError;
+        FSEEK64(in.file, random_access.start_position, SEEK_SET);
+    }
+    random_access.active =
+        random_access.active && cell_names && random_access.table_offsets[0] > 0;
+
+    // Random access reads only a few cells, so blocks are not inflated ahead of time
+    OasisPrefetch prefetch = {};
+    bool use_prefetch = (config_flags & OASIS_READ_CONFIG_PARALLEL) && !random_access.active;
 
     // State variables
     bool modal_absolute_pos = true;
@@ -1430,6 +2805,12 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
 
     Property** next_property = &library.properties;
 
+    // Filtered out elements are not created, but their properties and labels
+    // must be parsed anyway because they might be used as modal variables.
+    Property* skipped_properties = NULL;
+    Property** skipped_properties_tail = &skipped_properties;
+    Array<Label*> skipped_labels = {};
+
     Array<Property*> unfinished_property_name = {};
     Array<PropertyValue*> unfinished_property_value = {};
     bool modal_property_unfinished = false;
@@ -1486,6 +2867,58 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
         //             (uint8_t)record < COUNT(oasis_record_names)
         //                 ? oasis_record_names[(uint8_t)record]
         //                 : "---");
+        if (random_access.active && !random_access.accepts(record)) {
+            // End of the current segment: move to the next one
+            if (in.data) {
+                free_allocation(in.data);
+                in.data = NULL;
+            }
+            bool found;
+            if (random_access.segment == OasisSegment::Cells) {
+                random_access.enqueue_references(*cell);
+                found = random_access.next_cell(in);
+            } else {
+                found = random_access.next_table(in);
+                if (!found) {
+                    if (random_access.start_cells(cell_name_table, property_name_table,
+                                                  unfinished_property_name, *cell_names)) {
+                        modal_property_unfinished = false;
+                        found = random_access.next_cell(in);
+                    } else {
+                        // Cell offsets not available: restart with a linear read
+                        Property** prop_p = unfinished_property_name.items;
+                        for (uint64_t i = unfinished_property_name.count; i > 0; i--) {
+                            (*prop_p++)->name = NULL;
+                        }
+                        unfinished_property_name.count = 0;
+                        unfinished_property_value.count = 0;
+                        oasis_clear_name_table(cell_name_table);
+                        oasis_clear_name_table(label_text_table);
+                        oasis_clear_name_table(property_name_table);
+                        oasis_clear_name_table(property_value_table);
+                        properties_clear(library.properties);
+                        next_property = &library.properties;
+                        modal_property = NULL;
+                        modal_property_value_list = NULL;
+                        modal_property_unfinished = false;
+                        random_access.active = false;
+                        FSEEK64(in.file, random_access.start_position, SEEK_SET);
+                        continue;
+                    }
+                }
+            }
+            if (!found) {
+                record = OasisRecord::END;
+            } else if (oasis_read(&record, 1, 1, in) != ErrorCode::NoError) {
+                break;
+            } else if (!random_access.accepts(record)) {
+                if (error_logger)
+                    fputs("[GDSTK] Invalid table or cell offset in OASIS file.\n",
+                          error_logger);
+                if (error_code) *error_code = ErrorCode::InvalidFile;
+                break;
+            }
+        }
         switch (record) {
             case OasisRecord::PAD:
                 break;
@@ -1595,6 +3028,9 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                     property_value->bytes = (uint8_t*)allocate(prop_string->count);
                     memcpy(property_value->bytes, prop_string->bytes, prop_string->count);
                 }
+
+                if (random_access.active) random_access.sort_cells(library.cell_array);
+                if (cell_names) keep_cell_hierarchy(library, *cell_names, error_code);
                 goto CLEANUP;
             } break;
             case OasisRecord::CELLNAME_IMPLICIT: {
@@ -1831,11 +3267,18 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                     oasis_read_repetition(in, factor, modal_repetition);
                     label->repetition.copy_from(modal_repetition);
                 }
+                if (label_tags && !label_tags->has_value(label->tag)) {
+                    cell->label_array.count--;
+                    if (modal_text_string == label) {
+                        skipped_labels.append(label);
+                    } else {
+                        label->clear();
+                        free_allocation(label);
+                    }
+                    oasis_redirect_skipped_properties(skipped_properties_tail, next_property);
+                }
             } break;
             case OasisRecord::RECTANGLE: {
-                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
-                cell->polygon_array.append(polygon);
-                next_property = &polygon->properties;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
@@ -1868,32 +3311,34 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
-                *polygon = rectangle(modal_geom_pos, modal_geom_pos + modal_geom_dim,
-                                     make_tag(modal_layer, modal_datatype));
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+                cell->polygon_array.append(polygon);
+                next_property = &polygon->properties;
+                *polygon = rectangle(modal_geom_pos, modal_geom_pos + modal_geom_dim, tag);
                 if (info & 0x04) {
                     oasis_read_repetition(in, factor, modal_repetition);
                     polygon->repetition.copy_from(modal_repetition);
                 }
             } break;
             case OasisRecord::POLYGON: {
-                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
-                cell->polygon_array.append(polygon);
-                next_property = &polygon->properties;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
                     modal_layer = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_layer(polygon->tag, modal_layer);
                 if (info & 0x02) {
                     modal_datatype = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_type(polygon->tag, modal_datatype);
                 if (info & 0x20) {
                     modal_polygon_points.count = 1;
                     oasis_read_point_list(in, factor, true, modal_polygon_points);
                 }
-                polygon->point_array.copy_from(modal_polygon_points);
                 if (info & 0x10) {
                     double x = factor * oasis_read_integer(in);
                     if (modal_absolute_pos) {
@@ -1910,6 +3355,17 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+                cell->polygon_array.append(polygon);
+                next_property = &polygon->properties;
+                polygon->tag = tag;
+                polygon->point_array.copy_from(modal_polygon_points);
                 Vec2* v = polygon->point_array.items;
                 for (uint64_t i = polygon->point_array.count; i > 0; i--) {
                     *v++ += modal_geom_pos;
@@ -1920,30 +3376,17 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                 }
             } break;
             case OasisRecord::PATH: {
-                FlexPath* path = (FlexPath*)allocate_clear(sizeof(FlexPath));
-                FlexPathElement* element =
-                    (FlexPathElement*)allocate_clear(sizeof(FlexPathElement));
-                cell->flexpath_array.append(path);
-                next_property = &path->properties;
-                path->spine.tolerance = tolerance;
-                path->elements = element;
-                path->num_elements = 1;
-                path->simple_path = true;
-                path->scale_width = true;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
                     modal_layer = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_layer(element->tag, modal_layer);
                 if (info & 0x02) {
                     modal_datatype = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_type(element->tag, modal_datatype);
                 if (info & 0x40) {
                     modal_path_halfwidth = factor * oasis_read_unsigned_integer(in);
                 }
-                element->half_width_and_offset.append(Vec2{modal_path_halfwidth, 0});
                 if (info & 0x80) {
                     uint8_t extension_scheme;
                     oasis_read(&extension_scheme, 1, 1, in);
@@ -1968,15 +3411,6 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                             modal_path_extensions.v = factor * oasis_read_integer(in);
                     }
                 }
-                if (modal_path_extensions.u == 0 && modal_path_extensions.v == 0) {
-                    element->end_type = EndType::Flush;
-                } else if (modal_path_extensions.u == modal_path_halfwidth &&
-                           modal_path_extensions.v == modal_path_halfwidth) {
-                    element->end_type = EndType::HalfWidth;
-                } else {
-                    element->end_type = EndType::Extended;
-                    element->end_extensions = modal_path_extensions;
-                }
                 if (info & 0x20) {
                     modal_path_points.count = 1;
                     oasis_read_point_list(in, factor, false, modal_path_points);
@@ -1997,6 +3431,33 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                FlexPath* path = (FlexPath*)allocate_clear(sizeof(FlexPath));
+                FlexPathElement* element =
+                    (FlexPathElement*)allocate_clear(sizeof(FlexPathElement));
+                cell->flexpath_array.append(path);
+                next_property = &path->properties;
+                path->spine.tolerance = tolerance;
+                path->elements = element;
+                path->num_elements = 1;
+                path->simple_path = true;
+                path->scale_width = true;
+                element->tag = tag;
+                element->half_width_and_offset.append(Vec2{modal_path_halfwidth, 0});
+                if (modal_path_extensions.u == 0 && modal_path_extensions.v == 0) {
+                    element->end_type = EndType::Flush;
+                } else if (modal_path_extensions.u == modal_path_halfwidth &&
+                           modal_path_extensions.v == modal_path_halfwidth) {
+                    element->end_type = EndType::HalfWidth;
+                } else {
+                    element->end_type = EndType::Extended;
+                    element->end_extensions = modal_path_extensions;
+                }
                 path->spine.append(modal_geom_pos);
                 const Array<Vec2> skip_first = {0, modal_path_points.count - 1,
                                                 modal_path_points.items + 1};
@@ -2009,19 +3470,14 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
             case OasisRecord::TRAPEZOID_AB:
             case OasisRecord::TRAPEZOID_A:
             case OasisRecord::TRAPEZOID_B: {
-                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
-                cell->polygon_array.append(polygon);
-                next_property = &polygon->properties;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
                     modal_layer = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_layer(polygon->tag, modal_layer);
                 if (info & 0x02) {
                     modal_datatype = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_type(polygon->tag, modal_datatype);
                 if (info & 0x40) {
                     modal_geom_dim.x = factor * oasis_read_unsigned_integer(in);
                 }
@@ -2055,6 +3511,16 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+                cell->polygon_array.append(polygon);
+                next_property = &polygon->properties;
+                polygon->tag = tag;
                 Array<Vec2>* point_array = &polygon->point_array;
                 point_array->ensure_slots(4);
                 point_array->count = 4;
@@ -2103,19 +3569,14 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                 }
             } break;
             case OasisRecord::CTRAPEZOID: {
-                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
-                cell->polygon_array.append(polygon);
-                next_property = &polygon->properties;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
                     modal_layer = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_layer(polygon->tag, modal_layer);
                 if (info & 0x02) {
                     modal_datatype = (uint32_t)oasis_read_unsigned_integer(in);
                 }
-                set_type(polygon->tag, modal_datatype);
                 if (info & 0x80) {
                     oasis_read(&modal_ctrapezoid_type, 1, 1, in);
                 }
@@ -2141,19 +3602,17 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
-                Array<Vec2>* point_array = &polygon->point_array;
-                Vec2* v;
+                // The trapezoid type can update modal_geom_dim, so the
+                // vertices are calculated even if the shape is filtered out.
+                Vec2 v[4];
+                uint64_t num_vertices;
                 if (modal_ctrapezoid_type > 15 && modal_ctrapezoid_type < 24) {
-                    point_array->ensure_slots(3);
-                    point_array->count = 3;
-                    v = point_array->items;
+                    num_vertices = 3;
                     v[0] = modal_geom_pos;
                     v[1] = modal_geom_pos;
                     v[2] = modal_geom_pos;
                 } else {
-                    point_array->ensure_slots(4);
-                    point_array->count = 4;
-                    v = point_array->items;
+                    num_vertices = 4;
                     v[0] = modal_geom_pos;
                     v[1] = modal_geom_pos + Vec2{modal_geom_dim.x, 0};
                     v[2] = modal_geom_pos + modal_geom_dim;
@@ -2265,15 +3724,24 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         v[2].y = v[3].y = modal_geom_pos.y + modal_geom_dim.x;
                         break;
                 }
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+                cell->polygon_array.append(polygon);
+                next_property = &polygon->properties;
+                polygon->tag = tag;
+                const Array<Vec2> vertices = {0, num_vertices, v};
+                polygon->point_array.copy_from(vertices);
                 if (info & 0x04) {
                     oasis_read_repetition(in, factor, modal_repetition);
                     polygon->repetition.copy_from(modal_repetition);
                 }
             } break;
             case OasisRecord::CIRCLE: {
-                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
-                cell->polygon_array.append(polygon);
-                next_property = &polygon->properties;
                 uint8_t info;
                 oasis_read(&info, 1, 1, in);
                 if (info & 0x01) {
@@ -2301,8 +3769,17 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                         modal_geom_pos.y += y;
                     }
                 }
+                Tag tag = make_tag(modal_layer, modal_datatype);
+                if (shape_tags && !shape_tags->has_value(tag)) {
+                    oasis_skip_element(in, factor, info, modal_repetition,
+                                       skipped_properties_tail, next_property);
+                    break;
+                }
+                Polygon* polygon = (Polygon*)allocate_clear(sizeof(Polygon));
+                cell->polygon_array.append(polygon);
+                next_property = &polygon->properties;
                 *polygon = ellipse(modal_geom_pos, modal_circle_radius, modal_circle_radius, 0, 0,
-                                   0, 0, tolerance, make_tag(modal_layer, modal_datatype));
+                                   0, 0, tolerance, tag);
                 if (info & 0x04) {
                     oasis_read_repetition(in, factor, modal_repetition);
                     polygon->repetition.copy_from(modal_repetition);
@@ -2459,6 +3936,12 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
                 if (error_code) *error_code = ErrorCode::UnsupportedRecord;
             } break;
             case OasisRecord::CBLOCK: {
+                if (use_prefetch && !in.data) {
+                    uint64_t offset = ftell(in.file) - 1;
+                    if (prefetch.take(in, offset, error_code)) break;
+                    prefetch.fill(in.file, offset);
+                    if (prefetch.take(in, offset, error_code)) break;
+                }
                 if (oasis_read_unsigned_integer(in) != 0) {
                     if (error_logger)
                         fputs("[GDSTK] CBLOCK compression method not supported.\n", error_logger);
@@ -2516,38 +3999,26 @@ Library read_oas(const char* filename, double unit, double tolerance, ErrorCode*
 CLEANUP:
     fclose(in.file);
 
-    ByteArray* ba = cell_name_table.items;
-    for (uint64_t i = cell_name_table.count; i > 0; i--, ba++) {
-        if (ba->bytes) free_allocation(ba->bytes);
-        properties_clear(ba->properties);
-    }
-    cell_name_table.clear();
-
-    ba = label_text_table.items;
-    for (uint64_t i = label_text_table.count; i > 0; i--, ba++) {
-        if (ba->bytes) free_allocation(ba->bytes);
-        properties_clear(ba->properties);
-    }
-    label_text_table.clear();
-
-    ba = property_name_table.items;
-    for (uint64_t i = property_name_table.count; i > 0; i--, ba++) {
-        if (ba->bytes) free_allocation(ba->bytes);
-        properties_clear(ba->properties);
-    }
-    property_name_table.clear();
-
-    ba = property_value_table.items;
-    for (uint64_t i = property_value_table.count; i > 0; i--, ba++) {
-        if (ba->bytes) free_allocation(ba->bytes);
-        properties_clear(ba->properties);
-    }
-    property_value_table.clear();
+    oasis_clear_name_table(cell_name_table);
+    oasis_clear_name_table(label_text_table);
+    oasis_clear_name_table(property_name_table);
+    oasis_clear_name_table(property_value_table);
+    random_access.clear();
+    prefetch.clear();
+    prefetch.cblocks.clear();
 
     modal_repetition.clear();
     modal_polygon_points.clear();
     modal_path_points.clear();
 
+    properties_clear(skipped_properties);
+    Label** label_p = skipped_labels.items;
+    for (uint64_t i = skipped_labels.count; i > 0; i--, label_p++) {
+        (*label_p)->clear();
+        free_allocation(*label_p);
+    }
+    skipped_labels.clear();
+
     unfinished_property_name.clear();
     unfinished_property_value.clear();
 
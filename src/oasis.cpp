@@ -985,4 +985,119 @@ void oasis_write_repetition(OasisStream& out, const Repetition repetition, doubl
     }
 }
 
+// Stream that writes into buffer (see oasis_buffer_stream_end)
+static OasisStream oasis_buffer_stream(Array<uint8_t>& buffer) {
+    if (buffer.capacity == 0) buffer.ensure_slots(64);
+    OasisStream result = {};
+    result.data = buffer.items;
+    result.data_size = buffer.capacity;
+    result.cursor = buffer.items;
+    return result;
+}
+
+static void oasis_buffer_stream_end(OasisStream& stream, Array<uint8_t>& buffer) {
+    buffer.items = stream.data;
+    buffer.capacity = stream.data_size;
+    buffer.count = stream.cursor - stream.data;
+}
+
+// If buffer is equal to modal_value, return false.  Otherwise, swap them and
+// return true.
+static bool oasis_update_encoded(Array<uint8_t>& modal_value, Array<uint8_t>& buffer) {
+    if (modal_value.count == buffer.count &&
+        memcmp(modal_value.items, buffer.items, buffer.count) == 0)
+        return false;
+    Array<uint8_t> temp = modal_value;
+    modal_value = buffer;
+    buffer = temp;
+    return true;
+}
+
+void oasis_write_repetition(OasisStream& out, const Repetition repetition, double scaling,
+                            OasisModal& modal) {
+    OasisStream stream = oasis_buffer_stream(modal.buffer);
+    oasis_write_repetition(stream, repetition, scaling);
+    oasis_buffer_stream_end(stream, modal.buffer);
+    if (oasis_update_encoded(modal.repetition, modal.buffer)) {
+        oasis_write(modal.repetition.items, 1, modal.repetition.count, out);
+    } else {
+        oasis_putc(0, out);
+    }
+}
+
+bool oasis_update_point_list(OasisModal& modal, Array<IntVec2>& points, bool closed) {
+    OasisStream stream = oasis_buffer_stream(modal.buffer);
+    oasis_write_point_list(stream, points, closed);
+    oasis_buffer_stream_end(stream, modal.buffer);
+    return oasis_update_encoded(closed ? modal.polygon_point_list : modal.path_point_list,
+                                modal.buffer);
+}
+
+void oasis_write_path(OasisStream& out, OasisState& state, Tag tag, uint64_t half_width,
+                      int64_t start_extension, int64_t end_extension, const Array<Vec2> points,
+                      const Repetition& repetition) {
+    OasisModal& modal = state.modal;
+    uint8_t info = 0;
+    if (oasis_modal_update(modal.layer_defined, modal.layer, get_layer(tag))) info |= 0x01;
+    if (oasis_modal_update(modal.datatype_defined, modal.datatype, get_type(tag))) info |= 0x02;
+    if (oasis_modal_update(modal.path_halfwidth_defined, modal.path_halfwidth, half_width))
+        info |= 0x40;
+
+    uint8_t extension_scheme = 0;
+    if (!modal.path_extensions_defined || start_extension != modal.path_start_extension) {
+        if (start_extension == 0) {
+            extension_scheme |= 0x04;
+        } else if (start_extension > 0 && (uint64_t)start_extension == half_width) {
+            extension_scheme |= 0x08;
+        } else {
+            extension_scheme |= 0x0C;
+        }
+    }
+    if (!modal.path_extensions_defined || end_extension != modal.path_end_extension) {
+        if (end_extension == 0) {
+            extension_scheme |= 0x01;
+        } else if (end_extension > 0 && (uint64_t)end_extension == half_width) {
+            extension_scheme |= 0x02;
+        } else {
+            extension_scheme |= 0x03;
+        }
+    }
+    if (extension_scheme) {
+        info |= 0x80;
+        modal.path_extensions_defined = true;
+        modal.path_start_extension = start_extension;
+        modal.path_end_extension = end_extension;
+    }
+
+    Array<IntVec2> scaled_points = {};
+    scale_and_round_array(points, state.scaling, scaled_points);
+    const IntVec2 position = scaled_points[0];
+    if (oasis_update_point_list(modal, scaled_points, false)) info |= 0x20;
+    scaled_points.clear();
+
+    if (position.x != modal.geometry_position.x) info |= 0x10;
+    if (position.y != modal.geometry_position.y) info |= 0x08;
+    modal.geometry_position = position;
+
+    bool has_repetition = repetition.get_count() > 1;
+    if (has_repetition) info |= 0x04;
+
+    oasis_putc((int)OasisRecord::PATH, out);
+    oasis_putc(info, out);
+    if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+    if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+    if (info & 0x40) oasis_write_unsigned_integer(out, half_width);
+    if (info & 0x80) {
+        oasis_putc(extension_scheme, out);
+        if ((extension_scheme & 0x0C) == 0x0C) oasis_write_integer(out, start_extension);
+        if ((extension_scheme & 0x03) == 0x03) oasis_write_integer(out, end_extension);
+    }
+    if (info & 0x20) {
+        oasis_write(modal.path_point_list.items, 1, modal.path_point_list.count, out);
+    }
+    if (info & 0x10) oasis_write_integer(out, position.x);
+    if (info & 0x08) oasis_write_integer(out, position.y);
+    if (has_repetition) oasis_write_repetition(out, repetition, state.scaling, modal);
+}
+
 }  // namespace gdstk
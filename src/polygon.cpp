@@ -20,6 +20,7 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <gdstk/font.hpp>
 #include <gdstk/polygon.hpp>
 #include <gdstk/repetition.hpp>
+#include <gdstk/simd.hpp>
 #include <gdstk/sort.hpp>
 #include <gdstk/utils.hpp>
 #include <gdstk/vec.hpp>
@@ -52,100 +53,24 @@ void Polygon::copy_from(const Polygon& polygon) {
 }
 
 double Polygon::area() const {
-    if (point_array.count < 3) return 0;
-    double result = 0;
-    Vec2* p = point_array.items;
-    Vec2 v0 = *p++;
-    Vec2 v1 = *p++ - v0;
-    for (uint64_t num = point_array.count - 2; num > 0; num--) {
-        Vec2 v2 = *p++ - v0;
-        result += v1.cross(v2);
-        v1 = v2;
-    }
+    double result = fabs(simd_signed_area(point_array.items, point_array.count));
     if (repetition.type != RepetitionType::None) result *= repetition.get_count();
-    return 0.5 * fabs(result);
+    return result;
 }
 
 double Polygon::signed_area() const {
-    if (point_array.count < 3) return 0;
-    double result = 0;
-    Vec2* p = point_array.items;
-    Vec2 v0 = *p++;
-    Vec2 v1 = *p++ - v0;
-    for (uint64_t num = point_array.count - 2; num > 0; num--) {
-        Vec2 v2 = *p++ - v0;
-        result += v1.cross(v2);
-        v1 = v2;
-    }
-    return 0.5 * result;
+    return simd_signed_area(point_array.items, point_array.count);
 }
 
 double Polygon::perimeter() const {
     if (point_array.count < 3) return 0;
-    double result = 0;
-    Vec2* p = point_array.items;
-    Vec2 v0 = *p++;
-
-    for (uint64_t num = point_array.count - 1; num > 0; num--) {
-        Vec2 v1 = *p++ - v0;
-        result += v1.length();
-        v0 += v1;
-    }
-    result += (point_array.items[0] - point_array.items[point_array.count-1]).length();
+    double result = simd_perimeter(point_array.items, point_array.count);
     if (repetition.type != RepetitionType::None) result *= repetition.get_count();
     return result;
 }
 
-
-
-// Based on algorithm 7 from: Kai Hormann, Alexander Agathos, “The point in
-// polygon problem for arbitrary polygons,” Computational Geometry, Volume 20,
-// Issue 3, 2001, Pages 131-144, ISSN 0925-7721.
-// https://doi.org/10.1016/S0925-7721(01)00012-8
 bool Polygon::contain(const Vec2 point) const {
-    if (point_array.count == 0) {
-        return false;
-    }
-
-    Vec2 p0 = point_array[point_array.count - 1];
-    if (point == p0) {
-        return true;
-    }
-
-    int64_t winding = 0;
-    Vec2* v = point_array.items;
-    for (uint64_t i = point_array.count; i > 0; i--, v++) {
-        Vec2 p1 = *v;
-        if (p1.y == point.y &&
-            (p1.x == point.x || (p0.y == point.y && (p1.x > point.x) == (p0.x < point.x)))) {
-            return true;
-        }
-        if ((p0.y < point.y) != (p1.y < point.y)) {
-            if (p0.x >= point.x) {
-                if (p1.x > point.x) {
-                    winding += p1.y > p0.y ? 1 : -1;
-                } else {
-                    double det = (p0 - point).cross(p1 - point);
-                    if (det == 0) {
-                        return true;
-                    }
-                    if ((det > 0) == (p1.y > p0.y)) {
-                        winding += p1.y > p0.y ? 1 : -1;
-                    }
-                }
-            } else if (p1.x > point.x) {
-                double det = (p0 - point).cross(p1 - point);
-                if (det == 0) {
-                    return true;
-                }
-                if ((det > 0) == (p1.y > p0.y)) {
-                    winding += p1.y > p0.y ? 1 : -1;
-                }
-            }
-        }
-        p0 = p1;
-    }
-    return winding != 0;
+    return simd_contain(point_array.items, point_array.count, point);
 }
 
 bool Polygon::contain_all(const Array<Vec2>& points) const {
@@ -153,7 +78,7 @@ bool Polygon::contain_all(const Array<Vec2>& points) const {
     bounding_box(min, max);
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
-        if (point.x < min.x || point.x > max.x || point.y < min.y || point.x > max.x) return false;
+        if (point.x < min.x || point.x > max.x || point.y < min.y || point.y > max.y) return false;
     }
     for (uint64_t i = 0; i < points.count; i++) {
         if (!contain(points[i])) return false;
@@ -166,7 +91,7 @@ bool Polygon::contain_any(const Array<Vec2>& points) const {
     bounding_box(min, max);
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
-        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.x <= max.x &&
+        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y &&
             contain(point))
             return true;
     }
@@ -174,15 +99,7 @@ bool Polygon::contain_any(const Array<Vec2>& points) const {
 }
 
 void Polygon::bounding_box(Vec2& min, Vec2& max) const {
-    min.x = min.y = DBL_MAX;
-    max.x = max.y = -DBL_MAX;
-    Vec2* p = point_array.items;
-    for (uint64_t num = point_array.count; num > 0; num--, p++) {
-        if (p->x < min.x) min.x = p->x;
-        if (p->x > max.x) max.x = p->x;
-        if (p->y < min.y) min.y = p->y;
-        if (p->y > max.y) max.y = p->y;
-    }
+    simd_bounding_box(point_array.items, point_array.count, min, max);
     if (repetition.type != RepetitionType::None) {
         Array<Vec2> offsets = {};
         repetition.get_extrema(offsets);
@@ -234,15 +151,8 @@ void Polygon::rotate(double angle, const Vec2 center) {
 
 void Polygon::transform(double magnification, bool x_reflection, double rotation,
                         const Vec2 origin) {
-    double ca = cos(rotation);
-    double sa = sin(rotation);
-    Vec2* p = point_array.items;
-    for (uint64_t num = point_array.count; num > 0; num--, p++) {
-        Vec2 q = *p * magnification;
-        if (x_reflection) q.y = -q.y;
-        p->x = q.x * ca - q.y * sa + origin.x;
-        p->y = q.x * sa + q.y * ca + origin.y;
-    }
+    transform_points(point_array.items, point_array.count, magnification, x_reflection, rotation,
+                     origin);
 }
 
 void Polygon::fillet(const Array<double> radii, double tolerance) {
@@ -842,6 +752,7 @@ static bool is_circle(const Array<Vec2> point_array, double tolerance, Vec2& cen
 
 ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
     ErrorCode error_code = ErrorCode::NoError;
+    OasisModal& modal = state.modal;
     Vec2 center;
     double radius;
     IntVec2 corner, size;
@@ -851,24 +762,32 @@ ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
     Array<IntVec2> points = {};
     scale_and_round_array(point_array, state.scaling, points);
 
+    // Bits for layer, datatype, repetition and position are the same for all
+    // records written here: '.....XYRDL'
+    uint8_t info = has_repetition ? 0x04 : 0;
+    if (oasis_modal_update(modal.layer_defined, modal.layer, get_layer(tag))) info |= 0x01;
+    if (oasis_modal_update(modal.datatype_defined, modal.datatype, get_type(tag))) info |= 0x02;
+
     if ((state.config_flags & OASIS_CONFIG_DETECT_RECTANGLES) &&
         is_rectangle(points, corner, size)) {
+        // Info: 'SWHXYRDL'
         bool is_square = size.x == size.y;
-        uint8_t info;
+        if (is_square) info |= 0x80;
+        if (oasis_modal_update(modal.geometry_w_defined, modal.geometry_w, (uint64_t)size.x))
+            info |= 0x40;
         if (is_square) {
-            info = 0xDB;
-        } else {
-            info = 0x7B;
+            modal.geometry_h_defined = true;
+            modal.geometry_h = modal.geometry_w;
+        } else if (oasis_modal_update(modal.geometry_h_defined, modal.geometry_h,
+                                      (uint64_t)size.y)) {
+            info |= 0x20;
         }
-        if (has_repetition) info |= 0x04;
         oasis_putc((int)OasisRecord::RECTANGLE, out);
-        oasis_putc(info, out);
-        oasis_write_unsigned_integer(out, get_layer(tag));
-        oasis_write_unsigned_integer(out, get_type(tag));
-        oasis_write_unsigned_integer(out, size.x);
-        if (!is_square) oasis_write_unsigned_integer(out, size.y);
-        oasis_write_integer(out, corner.x);
-        oasis_write_integer(out, corner.y);
+        oasis_putc(info | oasis_position_info(modal.geometry_position, corner), out);
+        if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+        if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+        if (info & 0x40) oasis_write_unsigned_integer(out, size.x);
+        if (info & 0x20) oasis_write_unsigned_integer(out, size.y);
         // if (is_square)
         //     printf("SQUARE @ (%ld, %ld) w %ld\n", corner.x, corner.y, size.x);
         // else
@@ -877,8 +796,12 @@ ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
     } else if ((state.config_flags & OASIS_CONFIG_DETECT_TRAPEZOIDS) &&
                is_trapezoid(points, type, corner, size, delta_a, delta_b)) {
         if (type > 25) {
-            uint8_t info = type == 26 ? 0x7B : 0xFB;
-            if (has_repetition) info |= 0x04;
+            // Info: 'OWHXYRDL'
+            if (type != 26) info |= 0x80;
+            if (oasis_modal_update(modal.geometry_w_defined, modal.geometry_w, (uint64_t)size.x))
+                info |= 0x40;
+            if (oasis_modal_update(modal.geometry_h_defined, modal.geometry_h, (uint64_t)size.y))
+                info |= 0x20;
             if (delta_a == 0) {
                 oasis_putc((int)OasisRecord::TRAPEZOID_B, out);
             } else if (delta_b == 0) {
@@ -886,11 +809,11 @@ ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
             } else {
                 oasis_putc((int)OasisRecord::TRAPEZOID_AB, out);
             }
-            oasis_putc(info, out);
-            oasis_write_unsigned_integer(out, get_layer(tag));
-            oasis_write_unsigned_integer(out, get_type(tag));
-            oasis_write_unsigned_integer(out, size.x);
-            oasis_write_unsigned_integer(out, size.y);
+            oasis_putc(info | oasis_position_info(modal.geometry_position, corner), out);
+            if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+            if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+            if (info & 0x40) oasis_write_unsigned_integer(out, size.x);
+            if (info & 0x20) oasis_write_unsigned_integer(out, size.y);
             if (delta_a == 0) {
                 oasis_write_1delta(out, delta_b);
                 // printf("TRAPEZOID_B %s @ (%ld, %ld) w %ld, h %ld, db %ld\n",
@@ -909,19 +832,37 @@ ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
                 //        delta_a, delta_b);
             }
         } else {
-            uint8_t info = 0x9B;
+            // Info: 'TWHXYRDL'
             bool use_h = type < 16 || type == 20 || type == 21 || type == 24;
             bool use_w = type != 20 && type != 21;
-            if (use_h) info |= 0x20;
-            if (use_w) info |= 0x40;
-            if (has_repetition) info |= 0x04;
+            if (oasis_modal_update(modal.ctrapezoid_type_defined, modal.ctrapezoid_type, type))
+                info |= 0x80;
+            if (use_w &&
+                oasis_modal_update(modal.geometry_w_defined, modal.geometry_w, (uint64_t)size.x))
+                info |= 0x40;
+            if (use_h &&
+                oasis_modal_update(modal.geometry_h_defined, modal.geometry_h, (uint64_t)size.y))
+                info |= 0x20;
+            // Implicit dimensions also update the modal variables
+            if (type >= 16 && type <= 19) {
+                modal.geometry_h_defined = true;
+                modal.geometry_h = modal.geometry_w;
+            } else if (type == 20 || type == 21) {
+                modal.geometry_w_defined = true;
+                modal.geometry_w = 2 * modal.geometry_h;
+            } else if (type == 22 || type == 23) {
+                modal.geometry_h_defined = true;
+                modal.geometry_h = 2 * modal.geometry_w;
+            } else if (type == 25) {
+                modal.geometry_h_defined = false;
+            }
             oasis_putc((int)OasisRecord::CTRAPEZOID, out);
-            oasis_putc(info, out);
-            oasis_write_unsigned_integer(out, get_layer(tag));
-            oasis_write_unsigned_integer(out, get_type(tag));
-            oasis_putc(type, out);
-            if (use_w) oasis_write_unsigned_integer(out, size.x);
-            if (use_h) oasis_write_unsigned_integer(out, size.y);
+            oasis_putc(info | oasis_position_info(modal.geometry_position, corner), out);
+            if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+            if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+            if (info & 0x80) oasis_putc(type, out);
+            if (info & 0x40) oasis_write_unsigned_integer(out, size.x);
+            if (info & 0x20) oasis_write_unsigned_integer(out, size.y);
             // if (use_w && use_h)
             //     printf("CTRAPEZOID %hu @ (%ld, %ld) w  %ld, h %ld\n", type, corner.x,
             //     corner.y,
@@ -933,33 +874,36 @@ ErrorCode Polygon::to_oas(OasisStream& out, OasisState& state) const {
             //     printf("CTRAPEZOID %hu @ (%ld, %ld) h %ld\n", type, corner.x, corner.y,
             //     size.y);
         }
-        oasis_write_integer(out, corner.x);
-        oasis_write_integer(out, corner.y);
     } else if (state.circle_tolerance > 0 &&
                is_circle(point_array, state.circle_tolerance, center, radius)) {
-        uint8_t info = 0x3B;
-        if (has_repetition) info |= 0x04;
+        // Info: '00rXYRDL'
+        uint64_t r = (uint64_t)llround(radius * state.scaling);
+        if (oasis_modal_update(modal.circle_radius_defined, modal.circle_radius, r)) info |= 0x20;
+        corner.x = (int64_t)llround(center.x * state.scaling);
+        corner.y = (int64_t)llround(center.y * state.scaling);
         oasis_putc((int)OasisRecord::CIRCLE, out);
-        oasis_putc(info, out);
-        oasis_write_unsigned_integer(out, get_layer(tag));
-        oasis_write_unsigned_integer(out, get_type(tag));
-        oasis_write_unsigned_integer(out, (uint64_t)llround(radius * state.scaling));
-        oasis_write_integer(out, (int64_t)llround(center.x * state.scaling));
-        oasis_write_integer(out, (int64_t)llround(center.y * state.scaling));
+        oasis_putc(info | oasis_position_info(modal.geometry_position, corner), out);
+        if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+        if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+        if (info & 0x20) oasis_write_unsigned_integer(out, r);
         // printf("CIRCLE @ (%lf, %lf) r %lf\n", center.x, center.y, radius);
     } else {
-        uint8_t info = 0x3B;
-        if (has_repetition) info |= 0x04;
+        // Info: '00PXYRDL'
+        corner = points[0];
+        if (oasis_update_point_list(modal, points, true)) info |= 0x20;
         oasis_putc((int)OasisRecord::POLYGON, out);
-        oasis_putc(info, out);
-        oasis_write_unsigned_integer(out, get_layer(tag));
-        oasis_write_unsigned_integer(out, get_type(tag));
-        oasis_write_point_list(out, points, true);
-        oasis_write_integer(out, points[0].x);
-        oasis_write_integer(out, points[0].y);
+        oasis_putc(info | oasis_position_info(modal.geometry_position, corner), out);
+        if (info & 0x01) oasis_write_unsigned_integer(out, modal.layer);
+        if (info & 0x02) oasis_write_unsigned_integer(out, modal.datatype);
+        if (info & 0x20) {
+            oasis_write(modal.polygon_point_list.items, 1, modal.polygon_point_list.count, out);
+        }
         // printf("POLYGON @ (%ld, %ld)\n", points[0].x, points[0].y);
     }
-    if (has_repetition) oasis_write_repetition(out, repetition, state.scaling);
+    if (corner.x != modal.geometry_position.x) oasis_write_integer(out, corner.x);
+    if (corner.y != modal.geometry_position.y) oasis_write_integer(out, corner.y);
+    modal.geometry_position = corner;
+    if (has_repetition) oasis_write_repetition(out, repetition, state.scaling, modal);
     ErrorCode err = properties_to_oas(properties, out, state);
     if (err != ErrorCode::NoError) error_code = err;
 
@@ -1664,7 +1608,195 @@ ErrorCode contour(const double* data, uint64_t rows, uint64_t cols, double level
     return error_code;
 }
 
+// Maximal average number of slabs each edge is added to in
+// PolygonEdgeBuckets before the number of slabs is reduced
+#define GDSTK_POLYGON_INDEX_MAX_SLABS_PER_EDGE 8
+
+static uint64_t slab_index(double y, double y0, double inv_height, uint64_t slab_count) {
+    const double s = (y - y0) * inv_height;
+    if (s <= 0) return 0;
+    const uint64_t slab = (uint64_t)s;
+    return slab < slab_count ? slab : slab_count - 1;
+}
+
+static void build_edge_buckets(const Array<Vec2>& point_array, const Vec2 min, const Vec2 max,
+                               PolygonEdgeBuckets& buckets) {
+    const uint64_t count = point_array.count;
+    const double height = max.y - min.y;
+    uint64_t slab_count = height > 0 ? count / 4 : 1;
+    buckets.y0 = min.y;
+
+    // Long edges are added to many slabs: reduce the number of slabs until
+    // the total number of bucket entries is proportional to the edge count.
+    uint64_t total;
+    do {
+        buckets.inv_height = height > 0 ? slab_count / height : 0;
+        total = 0;
+        Vec2 p0 = point_array[count - 1];
+        const Vec2* p1 = point_array.items;
+        for (uint64_t i = count; i > 0; i--, p1++) {
+            const double lo = p0.y < p1->y ? p0.y : p1->y;
+            const double hi = p0.y < p1->y ? p1->y : p0.y;
+            total += slab_index(hi, buckets.y0, buckets.inv_height, slab_count) -
+                     slab_index(lo, buckets.y0, buckets.inv_height, slab_count) + 1;
+            p0 = *p1;
+        }
+        if (total <= GDSTK_POLYGON_INDEX_MAX_SLABS_PER_EDGE * count || slab_count == 1) break;
+        slab_count /= 2;
+    } while (true);
+
+    buckets.offset_array.ensure_slots(slab_count + 1);
+    buckets.offset_array.count = slab_count + 1;
+    memset(buckets.offset_array.items, 0, (slab_count + 1) * sizeof(uint64_t));
+    uint64_t* offsets = buckets.offset_array.items;
+    Vec2 p0 = point_array[count - 1];
+    for (uint64_t i = 0; i < count; i++) {
+        const Vec2 p1 = point_array[i];
+        const uint64_t first = slab_index(p0.y < p1.y ? p0.y : p1.y, buckets.y0,
+                                          buckets.inv_height, slab_count);
+        const uint64_t last = slab_index(p0.y < p1.y ? p1.y : p0.y, buckets.y0,
+                                         buckets.inv_height, slab_count);
+        for (uint64_t slab = first; slab <= last; slab++) offsets[slab + 1]++;
+        p0 = p1;
+    }
+    for (uint64_t slab = 0; slab < slab_count; slab++) offsets[slab + 1] += offsets[slab];
+
+    // Fill the buckets using offsets[slab] as insertion cursor, then shift the
+    // offsets back into place.
+    buckets.edge_array.ensure_slots(total);
+    buckets.edge_array.count = total;
+    p0 = point_array[count - 1];
+    for (uint64_t i = 0; i < count; i++) {
+        const Vec2 p1 = point_array[i];
+        const uint64_t first = slab_index(p0.y < p1.y ? p0.y : p1.y, buckets.y0,
+                                          buckets.inv_height, slab_count);
+        const uint64_t last = slab_index(p0.y < p1.y ? p1.y : p0.y, buckets.y0,
+                                         buckets.inv_height, slab_count);
+        for (uint64_t slab = first; slab <= last; slab++) {
+            buckets.edge_array[offsets[slab]++] = i;
+        }
+        p0 = p1;
+    }
+    for (uint64_t slab = slab_count; slab > 0; slab--) offsets[slab] = offsets[slab - 1];
+    offsets[0] = 0;
+}
+
+void PolygonIndex::clear() {
+    polygon_array.clear();
+    for (uint64_t i = 0; i < bucket_array.count; i++) bucket_array[i].clear();
+    bucket_array.clear();
+    spatial_index.clear();
+}
+
+void PolygonIndex::build(const Array<Polygon*>& polygons) {
+    clear();
+    polygon_array.copy_from(polygons);
+    bucket_array.ensure_slots(polygons.count);
+    bucket_array.count = polygons.count;
+    memset(bucket_array.items, 0, polygons.count * sizeof(PolygonEdgeBuckets));
+
+    Array<SpatialItem> items = {};
+    items.ensure_slots(polygons.count);
+    for (uint64_t i = 0; i < polygons.count; i++) {
+        const Array<Vec2>& point_array = polygons[i]->point_array;
+        if (point_array.count == 0) continue;
+        // Repetitions are not considered by Polygon::contain, so we cannot use
+        // Polygon::bounding_box here.
+        Vec2 min, max;
+        simd_bounding_box(point_array.items, point_array.count, min, max);
+        if (point_array.count >= GDSTK_POLYGON_INDEX_BUCKET_THRESHOLD) {
+            build_edge_buckets(point_array, min, max, bucket_array[i]);
+        }
+        items.append_unsafe(SpatialItem{min, max, i, SpatialItemType::Polygon});
+    }
+    spatial_index.build(items);
+    items.clear();
+}
+
+static bool bucketed_contain(const Polygon* polygon, const PolygonEdgeBuckets& buckets,
+                             const Vec2 point) {
+    const uint64_t slab_count = buckets.offset_array.count - 1;
+    const uint64_t slab = slab_index(point.y, buckets.y0, buckets.inv_height, slab_count);
+    const uint64_t* edge = buckets.edge_array.items + buckets.offset_array[slab];
+    const uint64_t* end = buckets.edge_array.items + buckets.offset_array[slab + 1];
+    const Vec2* points = polygon->point_array.items;
+    const uint64_t last = polygon->point_array.count - 1;
+    // Edges outside the slab never cross the horizontal line through point, so
+    // their winding contribution is zero.
+    int64_t winding = 0;
+    for (; edge < end; edge++) {
+        const uint64_t i = *edge;
+        if (!edge_winding(points[i == 0 ? last : i - 1], points[i], point, winding)) {
+            return true;
+        }
+    }
+    return winding != 0;
+}
+
+struct PolygonIndexQuery {
+    const PolygonIndex* index;
+    Vec2 point;
+    bool found;
+};
+
+static bool polygon_index_query(const SpatialItem& item, void* data) {
+    PolygonIndexQuery* query = (PolygonIndexQuery*)data;
+    const Polygon* polygon = query->index->polygon_array[item.index];
+    const PolygonEdgeBuckets& buckets = query->index->bucket_array[item.index];
+    if (buckets.offset_array.count > 0 ? bucketed_contain(polygon, buckets, query->point)
+                                       : polygon->contain(query->point)) {
+        query->found = true;
+        return false;
+    }
+    return true;
+}
+
+bool PolygonIndex::contain(const Vec2 point) const {
+    PolygonIndexQuery query = {this, point, false};
+    spatial_index.query(point, point, polygon_index_query, &query);
+    return query.found;
+}
+
+// Number of points tested by each task in PolygonIndex::contain
+#define GDSTK_POLYGON_INDEX_CHUNK_SIZE 1024
+
+struct PolygonIndexBatch {
+    const PolygonIndex* index;
+    const Array<Vec2>* points;
+    bool* result;
+};
+
+static void polygon_index_batch_chunk(uint64_t chunk, void* data) {
+    PolygonIndexBatch* batch = (PolygonIndexBatch*)data;
+    const uint64_t start = chunk * GDSTK_POLYGON_INDEX_CHUNK_SIZE;
+    uint64_t end = start + GDSTK_POLYGON_INDEX_CHUNK_SIZE;
+    if (end > batch->points->count) end = batch->points->count;
+    for (uint64_t i = start; i < end; i++) {
+        batch->result[i] = batch->index->contain((*batch->points)[i]);
+    }
+}
+
+void PolygonIndex::contain(const Array<Vec2>& points, uint32_t num_threads, bool* result) const {
+    PolygonIndexBatch batch = {this, &points, result};
+    const uint64_t chunks =
+        (points.count + GDSTK_POLYGON_INDEX_CHUNK_SIZE - 1) / GDSTK_POLYGON_INDEX_CHUNK_SIZE;
+    parallel_for(chunks, num_threads, polygon_index_batch_chunk, &batch);
+}
+
 void inside(const Array<Vec2>& points, const Array<Polygon*>& polygons, bool* result) {
+    inside(points, polygons, 1, result);
+}
+
+void inside(const Array<Vec2>& points, const Array<Polygon*>& polygons, uint32_t num_threads,
+            bool* result) {
+    if (points.count >= GDSTK_POLYGON_INDEX_MIN_POINTS) {
+        PolygonIndex index = {};
+        index.build(polygons);
+        index.contain(points, num_threads, result);
+        index.clear();
+        return;
+    }
+
     Vec2 min = {DBL_MAX, DBL_MAX};
     Vec2 max = {-DBL_MAX, -DBL_MAX};
     for (uint64_t j = 0; j < polygons.count; j++) {
@@ -1678,7 +1810,7 @@ void inside(const Array<Vec2>& points, const Array<Polygon*>& polygons, bool* re
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
         result[i] = false;
-        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.x <= max.x) {
+        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y) {
             for (uint64_t j = 0; j < polygons.count; j++) {
                 if (polygons[j]->contain(point)) {
                     result[i] = true;
@@ -1702,7 +1834,15 @@ bool all_inside(const Array<Vec2>& points, const Array<Polygon*>& polygons) {
     }
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
-        if (point.x < min.x || point.x > max.x || point.y < min.y || point.x > max.x) return false;
+        if (point.x < min.x || point.x > max.x || point.y < min.y || point.y > max.y) return false;
+    }
+    if (points.count >= GDSTK_POLYGON_INDEX_MIN_POINTS) {
+        PolygonIndex index = {};
+        index.build(polygons);
+        bool result = true;
+        for (uint64_t i = 0; i < points.count && result; i++) result = index.contain(points[i]);
+        index.clear();
+        return result;
     }
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
@@ -1729,9 +1869,17 @@ bool any_inside(const Array<Vec2>& points, const Array<Polygon*>& polygons) {
         if (b.x > max.x) max.x = b.x;
         if (b.y > max.y) max.y = b.y;
     }
+    if (points.count >= GDSTK_POLYGON_INDEX_MIN_POINTS) {
+        PolygonIndex index = {};
+        index.build(polygons);
+        bool result = false;
+        for (uint64_t i = 0; i < points.count && !result; i++) result = index.contain(points[i]);
+        index.clear();
+        return result;
+    }
     for (uint64_t i = 0; i < points.count; i++) {
         Vec2 point = points[i];
-        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.x <= max.x) {
+        if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y) {
             for (uint64_t j = 0; j < polygons.count; j++) {
                 if (polygons[j]->contain(point)) return true;
             }
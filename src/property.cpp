@@ -248,7 +248,7 @@ uint64_t remove_property(Property*& properties, const char* name, bool all_occur
         free_allocation(properties);
         properties = next;
         removed++;
-        if (!all_occurences) return removed;
+        if (!all_occurences || properties == NULL) return removed;
     }
     Property* property = properties;
     while (true) {
@@ -345,6 +345,33 @@ ErrorCode properties_to_gds(const Property* properties, FILE* out) {
     return ErrorCode::NoError;
 }
 
+static uint64_t oasis_property_name_index(const char* name, OasisState& state) {
+    if (state.property_name_map.has_key(name)) return state.property_name_map.get(name);
+    uint64_t index = state.property_name_map.count;
+    state.property_name_map.set(name, index);
+    return index;
+}
+
+static uint64_t oasis_property_value_index(PropertyValue* value, OasisState& state) {
+    uint64_t index;
+    for (index = 0; index < state.property_value_array.count; index++) {
+        PropertyValue* it = state.property_value_array[index];
+        if (it->count == value->count && memcmp(it->bytes, value->bytes, it->count) == 0)
+            return index;
+    }
+    state.property_value_array.append(value);
+    return index;
+}
+
+void properties_register_oas(const Property* properties, OasisState& state) {
+    for (; properties; properties = properties->next) {
+        oasis_property_name_index(properties->name, state);
+        for (PropertyValue* value = properties->value; value; value = value->next) {
+            if (value->type == PropertyType::String) oasis_property_value_index(value, state);
+        }
+    }
+}
+
 ErrorCode properties_to_oas(const Property* properties, OasisStream& out, OasisState& state) {
     while (properties) {
         uint8_t info = 0x06;
@@ -361,14 +388,7 @@ ErrorCode properties_to_oas(const Property* properties, OasisStream& out, OasisS
         oasis_putc((int)OasisRecord::PROPERTY, out);
         oasis_putc(info, out);
 
-        uint64_t index;
-        if (state.property_name_map.has_key(properties->name)) {
-            index = state.property_name_map.get(properties->name);
-        } else {
-            index = state.property_name_map.count;
-            state.property_name_map.set(properties->name, index);
-        }
-        oasis_write_unsigned_integer(out, index);
+        oasis_write_unsigned_integer(out, oasis_property_name_index(properties->name, state));
 
         if (value_count > 14) {
             oasis_write_unsigned_integer(out, value_count);
@@ -406,15 +426,7 @@ ErrorCode properties_to_oas(const Property* properties, OasisStream& out, OasisS
                     } else {
                         oasis_putc(15, out);
                     }
-                    for (index = 0; index < state.property_value_array.count; index++) {
-                        PropertyValue* it = state.property_value_array[index];
-                        if (it->count == value->count &&
-                            memcmp(it->bytes, value->bytes, it->count) == 0)
-                            break;
-                    }
-                    if (index == state.property_value_array.count)
-                        state.property_value_array.append(value);
-                    oasis_write_unsigned_integer(out, index);
+                    oasis_write_unsigned_integer(out, oasis_property_value_index(value, state));
                 }
             }
         }
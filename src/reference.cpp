@@ -81,24 +81,13 @@ void Reference::repeat_and_transform(Array<Vec2>& point_array) const {
         offsets.items = &zero;
     }
 
-    double ca = cos(rotation);
-    double sa = sin(rotation);
-
     Vec2* dst = point_array.items + point_array.count - num_points;
     Vec2* off = offsets.items;
     for (uint64_t offset_count = offsets.count; offset_count > 0; offset_count--) {
         if (offset_count != 1) {
             memcpy(dst, point_array.items, num_points * sizeof(Vec2));
         }
-
-        Vec2* p = dst;
-        for (uint64_t num = num_points; num > 0; num--, p++) {
-            Vec2 q = *p * magnification;
-            if (x_reflection) q.y = -q.y;
-            p->x = q.x * ca - q.y * sa + origin.x + off->x;
-            p->y = q.x * sa + q.y * ca + origin.y + off->y;
-        }
-
+        transform_points(dst, num_points, magnification, x_reflection, rotation, origin + *off);
         off++;
         dst -= num_points;
     }
@@ -182,8 +171,8 @@ void Reference::convex_hull(Array<Vec2>& result, Map<GeometryInfo>& cache) const
 
 void Reference::transform(double mag, bool x_refl, double rot, const Vec2 orig) {
     const int r1 = x_refl ? -1 : 1;
-    const double crot = cos(rot);
-    const double srot = sin(rot);
+    double crot, srot;
+    cos_sin(rot, crot, srot);
     const double x = origin.x;
     const double y = origin.y;
     origin.x = orig.x + mag * (x * crot - r1 * y * srot);
@@ -218,10 +207,97 @@ void Reference::apply_repetition(Array<Reference*>& result) {
 // Depth is passed as-is to Cell::get_polygons, where it is inspected and applied.
 void Reference::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
                              Tag tag, Array<Polygon*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_polygons(apply_repetitions, include_paths, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+// Get the flattened polygons of the cell from cache, if present for depth.
+// The last counted use (see FlattenInfo::remaining) takes ownership of the
+// array and drops it from cache; earlier uses must copy the polygons.
+static bool take_flattened(Map<FlattenInfo>& cache, const char* name, int64_t depth,
+                           Array<Polygon*>& array, bool& owned) {
+    FlattenInfo info = cache.get(name);
+    if (!info.valid || info.depth != depth) return false;
+    array = info.polygon_array;
+    owned = info.remaining == 1;
+    if (owned) {
+        info.polygon_array = {};
+        info.valid = false;
+    } else if (info.remaining > 1) {
+        info.remaining--;
+    }
+    cache.set(name, info);
+    return true;
+}
+
+// Store the polygons just flattened for their first use, unless they are not
+// needed again.  A cell reached again with a different depth limit is
+// flattened without replacing the cache entry.  Returns whether the array now
+// belongs to the cache.
+static bool store_flattened(Map<FlattenInfo>& cache, const char* name, int64_t depth,
+                            const Array<Polygon*>& array) {
+    FlattenInfo info = cache.get(name);
+    if (info.valid) return false;
+    if (info.remaining > 0 && (info.remaining == 1 || info.depth != depth)) return false;
+    info.polygon_array = array;
+    info.depth = depth;
+    info.valid = true;
+    if (info.remaining > 1) info.remaining--;
+    cache.set(name, info);
+    return true;
+}
+
+void Reference::count_flatten_uses(int64_t depth, Map<FlattenInfo>& cache) const {
     if (type != ReferenceType::Cell) return;
+    FlattenInfo info = cache.get(cell->name);
+    if (info.remaining > 0 && info.depth == depth) {
+        // Taken from cache: the cell is not traversed again
+        info.remaining++;
+        cache.set(cell->name, info);
+        return;
+    }
+    if (info.remaining == 0) {
+        info.depth = depth;
+        info.remaining = 1;
+        cache.set(cell->name, info);
+    }
+    cell->count_flatten_uses(depth, cache);
+}
+
+void Reference::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                             const Set<Tag>* tags, Array<Polygon*>& result) const {
+    Map<FlattenInfo> cache = {};
+    count_flatten_uses(depth, cache);
+    get_polygons(apply_repetitions, include_paths, depth, tags, cache, result);
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
 
+void Reference::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth, bool filter,
+                             Tag tag, Map<FlattenInfo>& cache, Array<Polygon*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_polygons(apply_repetitions, include_paths, depth, filter ? &tags : NULL, cache, result);
+    tags.clear();
+}
+
+void Reference::get_polygons(bool apply_repetitions, bool include_paths, int64_t depth,
+                             const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                             Array<Polygon*>& result) const {
+    if (type != ReferenceType::Cell) return;
+
+    // The polygons in array are moved into result only if owned; otherwise
+    // they belong to the cache and are copied.
     Array<Polygon*> array = {};
-    cell->get_polygons(apply_repetitions, include_paths, depth, filter, tag, array);
+    bool owned;
+    if (!take_flattened(cache, cell->name, depth, array, owned)) {
+        cell->get_polygons(apply_repetitions, include_paths, depth, tags, cache, array);
+        owned = !store_flattened(cache, cell->name, depth, array);
+    }
 
     Vec2 zero = {0, 0};
     Array<Vec2> offsets = {};
@@ -240,26 +316,35 @@ void Reference::get_polygons(bool apply_repetitions, bool include_paths, int64_t
         for (uint64_t offset_count = offsets.count; offset_count > 0; offset_count--) {
             Polygon* dst;
             // Avoid an extra allocation by moving the last polygon.
-            if (offset_count == 1) {
+            if (offset_count == 1 && owned) {
                 dst = src;
             } else {
                 dst = (Polygon*)allocate_clear(sizeof(Polygon));
                 dst->copy_from(*src);
             }
             dst->transform(magnification, x_reflection, rotation, origin + *offset_p++);
+            dst->repetition.transform(magnification, x_reflection, rotation);
             result.append_unsafe(dst);
         }
     }
-    array.clear();
+    if (owned) array.clear();
     if (repetition.type != RepetitionType::None) offsets.clear();
 }
 
 void Reference::get_flexpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                               Array<FlexPath*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_flexpaths(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Reference::get_flexpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                              Array<FlexPath*>& result) const {
     if (type != ReferenceType::Cell) return;
 
     Array<FlexPath*> array = {};
-    cell->get_flexpaths(apply_repetitions, depth, filter, tag, array);
+    cell->get_flexpaths(apply_repetitions, depth, tags, array);
 
     Vec2 zero = {0, 0};
     Array<Vec2> offsets = {};
@@ -284,6 +369,7 @@ void Reference::get_flexpaths(bool apply_repetitions, int64_t depth, bool filter
                 dst->copy_from(*src);
             }
             dst->transform(magnification, x_reflection, rotation, origin + *offset_p++);
+            dst->repetition.transform(magnification, x_reflection, rotation);
             result.append_unsafe(dst);
         }
     }
@@ -293,10 +379,18 @@ void Reference::get_flexpaths(bool apply_repetitions, int64_t depth, bool filter
 
 void Reference::get_robustpaths(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                                 Array<RobustPath*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_robustpaths(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Reference::get_robustpaths(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                                Array<RobustPath*>& result) const {
     if (type != ReferenceType::Cell) return;
 
     Array<RobustPath*> array = {};
-    cell->get_robustpaths(apply_repetitions, depth, filter, tag, array);
+    cell->get_robustpaths(apply_repetitions, depth, tags, array);
 
     Vec2 zero = {0, 0};
     Array<Vec2> offsets = {};
@@ -321,6 +415,7 @@ void Reference::get_robustpaths(bool apply_repetitions, int64_t depth, bool filt
                 dst->copy_from(*src);
             }
             dst->transform(magnification, x_reflection, rotation, origin + *offset_p++);
+            dst->repetition.transform(magnification, x_reflection, rotation);
             result.append_unsafe(dst);
         }
     }
@@ -330,10 +425,18 @@ void Reference::get_robustpaths(bool apply_repetitions, int64_t depth, bool filt
 
 void Reference::get_labels(bool apply_repetitions, int64_t depth, bool filter, Tag tag,
                            Array<Label*>& result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    get_labels(apply_repetitions, depth, filter ? &tags : NULL, result);
+    tags.clear();
+}
+
+void Reference::get_labels(bool apply_repetitions, int64_t depth, const Set<Tag>* tags,
+                           Array<Label*>& result) const {
     if (type != ReferenceType::Cell) return;
 
     Array<Label*> array = {};
-    cell->get_labels(apply_repetitions, depth, filter, tag, array);
+    cell->get_labels(apply_repetitions, depth, tags, array);
 
     Vec2 zero = {0, 0};
     Array<Vec2> offsets = {};
@@ -358,6 +461,7 @@ void Reference::get_labels(bool apply_repetitions, int64_t depth, bool filter, T
                 dst->copy_from(*src);
             }
             dst->transform(magnification, x_reflection, rotation, origin + *offset_p++);
+            dst->repetition.transform(magnification, x_reflection, rotation);
             result.append_unsafe(dst);
         }
     }
@@ -365,6 +469,117 @@ void Reference::get_labels(bool apply_repetitions, int64_t depth, bool filter, T
     if (repetition.type != RepetitionType::None) offsets.clear();
 }
 
+// Append to result the copies of src (an element in the coordinate system of
+// the referenced cell) placed by reference, without expanding all
+// repetitions: from the element repetition (transformed) and the reference
+// repetition, only the one with fewer copies is expanded, and the other is
+// kept in the copies.  If owned is true, src is used for the last copy.
+template <class T>
+static void place_with_repetitions(const Reference& reference, T* src, bool owned,
+                                   Array<T*>& result) {
+    Repetition element_repetition = {};
+    element_repetition.copy_from(src->repetition);
+    element_repetition.transform(reference.magnification, reference.x_reflection,
+                                 reference.rotation);
+
+    const Repetition* kept;
+    Array<Vec2> offsets = {};
+    if (element_repetition.type == RepetitionType::None) {
+        kept = &reference.repetition;
+        offsets.append(Vec2{0, 0});
+    } else if (reference.repetition.type == RepetitionType::None) {
+        kept = &element_repetition;
+        offsets.append(Vec2{0, 0});
+    } else if (reference.repetition.get_count() >= element_repetition.get_count()) {
+        kept = &reference.repetition;
+        element_repetition.get_offsets(offsets);
+    } else {
+        kept = &element_repetition;
+        reference.repetition.get_offsets(offsets);
+    }
+
+    result.ensure_slots(offsets.count);
+    for (uint64_t i = 0; i < offsets.count; i++) {
+        T* dst;
+        if (owned && i == offsets.count - 1) {
+            dst = src;
+        } else {
+            dst = (T*)allocate_clear(sizeof(T));
+            dst->copy_from(*src);
+        }
+        dst->repetition.clear();
+        dst->transform(reference.magnification, reference.x_reflection, reference.rotation,
+                       reference.origin + offsets[i]);
+        dst->repetition.copy_from(*kept);
+        result.append_unsafe(dst);
+    }
+    offsets.clear();
+    element_repetition.clear();
+}
+
+void Reference::get_polygons_with_repetitions(bool include_paths, int64_t depth,
+                                              const Set<Tag>* tags,
+                                              Array<Polygon*>& result) const {
+    Map<FlattenInfo> cache = {};
+    count_flatten_uses(depth, cache);
+    get_polygons_with_repetitions(include_paths, depth, tags, cache, result);
+    for (MapItem<FlattenInfo>* item = cache.next(NULL); item; item = cache.next(item)) {
+        item->value.clear();
+    }
+    cache.clear();
+}
+
+void Reference::get_polygons_with_repetitions(bool include_paths, int64_t depth,
+                                              const Set<Tag>* tags, Map<FlattenInfo>& cache,
+                                              Array<Polygon*>& result) const {
+    if (type != ReferenceType::Cell) return;
+
+    Array<Polygon*> array = {};
+    bool owned;
+    if (!take_flattened(cache, cell->name, depth, array, owned)) {
+        cell->get_polygons_with_repetitions(include_paths, depth, tags, cache, array);
+        owned = !store_flattened(cache, cell->name, depth, array);
+    }
+
+    for (uint64_t i = 0; i < array.count; i++) {
+        place_with_repetitions(*this, array[i], owned, result);
+    }
+    if (owned) array.clear();
+}
+
+void Reference::get_flexpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                               Array<FlexPath*>& result) const {
+    if (type != ReferenceType::Cell) return;
+    Array<FlexPath*> array = {};
+    cell->get_flexpaths_with_repetitions(depth, tags, array);
+    for (uint64_t i = 0; i < array.count; i++) {
+        place_with_repetitions(*this, array[i], true, result);
+    }
+    array.clear();
+}
+
+void Reference::get_robustpaths_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                                 Array<RobustPath*>& result) const {
+    if (type != ReferenceType::Cell) return;
+    Array<RobustPath*> array = {};
+    cell->get_robustpaths_with_repetitions(depth, tags, array);
+    for (uint64_t i = 0; i < array.count; i++) {
+        place_with_repetitions(*this, array[i], true, result);
+    }
+    array.clear();
+}
+
+void Reference::get_labels_with_repetitions(int64_t depth, const Set<Tag>* tags,
+                                            Array<Label*>& result) const {
+    if (type != ReferenceType::Cell) return;
+    Array<Label*> array = {};
+    cell->get_labels_with_repetitions(depth, tags, array);
+    for (uint64_t i = 0; i < array.count; i++) {
+        place_with_repetitions(*this, array[i], true, result);
+    }
+    array.clear();
+}
+
 #define GDSTK_REFERENCE_REPETITION_TOLERANCE 1e-12
 ErrorCode Reference::to_gds(FILE* out, double scaling) const {
     ErrorCode error_code = ErrorCode::NoError;
@@ -401,8 +616,8 @@ ErrorCode Reference::to_gds(FILE* out, double scaling) const {
             Vec2 u2 = v2;
             double len1 = u1.normalize();
             double len2 = u2.normalize();
-            double sa = sin(rotation);
-            double ca = cos(rotation);
+            double ca, sa;
+            cos_sin(rotation, ca, sa);
             double p1 = u1.inner(Vec2{ca, sa});
             double p2 = u2.inner(Vec2{-sa, ca});
             double p3 = u1.inner(Vec2{-sa, ca});
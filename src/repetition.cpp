@@ -13,6 +13,7 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 
 #include <gdstk/array.hpp>
 #include <gdstk/repetition.hpp>
+#include <gdstk/utils.hpp>
 #include <gdstk/vec.hpp>
 
 namespace gdstk {
@@ -280,8 +281,8 @@ void Repetition::transform(double magnification, bool x_reflection, double rotat
             if (x_reflection || rotation != 0) {
                 Vec2 v = spacing;
                 if (x_reflection) v.y = -v.y;
-                double ca = cos(rotation);
-                double sa = sin(rotation);
+                double ca, sa;
+                cos_sin(rotation, ca, sa);
                 type = RepetitionType::Regular;
                 v1.x = v.x * ca;
                 v1.y = v.x * sa;
@@ -299,15 +300,18 @@ void Repetition::transform(double magnification, bool x_reflection, double rotat
                 v2.y = -v2.y;
             }
             if (rotation != 0) {
-                Vec2 r = {cos(rotation), sin(rotation)};
+                Vec2 r;
+                cos_sin(rotation, r.x, r.y);
                 v1 = cplx_mul(v1, r);
                 v2 = cplx_mul(v2, r);
             }
         } break;
         case RepetitionType::ExplicitX: {
             if (rotation != 0) {
-                double ca = magnification * cos(rotation);
-                double sa = magnification * sin(rotation);
+                double ca, sa;
+                cos_sin(rotation, ca, sa);
+                ca *= magnification;
+                sa *= magnification;
                 Array<Vec2> temp = {};
                 temp.ensure_slots(coords.count);
                 temp.count = coords.count;
@@ -329,8 +333,10 @@ void Repetition::transform(double magnification, bool x_reflection, double rotat
         } break;
         case RepetitionType::ExplicitY: {
             if (rotation != 0) {
-                double ca = magnification * cos(rotation);
-                double sa = -magnification * sin(rotation);
+                double ca, sa;
+                cos_sin(rotation, ca, sa);
+                ca *= magnification;
+                sa *= -magnification;
                 if (x_reflection) {
                     ca = -ca;
                     sa = -sa;
@@ -358,7 +364,9 @@ void Repetition::transform(double magnification, bool x_reflection, double rotat
         case RepetitionType::Explicit: {
             Vec2* v = offsets.items;
             if (rotation != 0) {
-                Vec2 r = {magnification * cos(rotation), magnification * sin(rotation)};
+                Vec2 r;
+                cos_sin(rotation, r.x, r.y);
+                r *= magnification;
                 if (x_reflection) {
                     for (uint64_t i = offsets.count; i > 0; i--, v++) {
                         *v = cplx_mul(cplx_conj(*v), r);
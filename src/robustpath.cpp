@@ -610,8 +610,8 @@ void RobustPath::mirror(const Vec2 p0, const Vec2 p1) {
 }
 
 void RobustPath::simple_rotate(double angle) {
-    const double c = cos(angle);
-    const double s = sin(angle);
+    double c, s;
+    cos_sin(angle, c, s);
     const double tr0 = trafo[0];
     const double tr1 = trafo[1];
     const double tr2 = trafo[2];
@@ -1270,13 +1270,21 @@ ErrorCode RobustPath::spine(Array<Vec2> &result) const {
 }
 
 ErrorCode RobustPath::to_polygons(bool filter, Tag tag, Array<Polygon *> &result) const {
+    Set<Tag> tags = {};
+    if (filter) tags.add(tag);
+    ErrorCode error_code = to_polygons(filter ? &tags : NULL, result);
+    tags.clear();
+    return error_code;
+}
+
+ErrorCode RobustPath::to_polygons(const Set<Tag> *tags, Array<Polygon *> &result) const {
     ErrorCode error_code = ErrorCode::NoError;
     if (num_elements == 0 || subpath_array.count == 0) return error_code;
 
     const double tolerance_sq = tolerance * tolerance;
     RobustPathElement *el = elements;
     for (uint64_t ne = 0; ne < num_elements; ne++, el++) {
-        if (filter && el->tag != tag) continue;
+        if (tags && !tags->has_value(el->tag)) continue;
 
         Array<Vec2> left_side = {};
         Array<Vec2> right_side = {};
@@ -1622,63 +1630,28 @@ ErrorCode RobustPath::to_oas(OasisStream &out, OasisState &state) const {
     ErrorCode error_code = ErrorCode::NoError;
     if (num_elements == 0 || subpath_array.count == 0) return error_code;
 
-    bool has_repetition = repetition.get_count() > 1;
-
     Array<Vec2> point_array = {};
     point_array.ensure_slots(subpath_array.count * GDSTK_MIN_POINTS);
 
     RobustPathElement *el = elements;
     for (uint64_t ne = 0; ne < num_elements; ne++, el++) {
-        uint8_t info = 0xFB;
-        if (has_repetition) info |= 0x04;
-
-        oasis_putc((int)OasisRecord::PATH, out);
-        oasis_putc(info, out);
-        oasis_write_unsigned_integer(out, get_layer(el->tag));
-        oasis_write_unsigned_integer(out, get_type(el->tag));
         uint64_t half_width =
             (uint64_t)llround(interp(el->width_array[0], 0) * width_scale * state.scaling);
-        oasis_write_unsigned_integer(out, half_width);
-
-        switch (el->end_type) {
-            case EndType::Extended: {
-                uint8_t extension_scheme = 0;
-                int64_t start_extension = (int64_t)llround(el->end_extensions.u * state.scaling);
-                int64_t end_extension = (int64_t)llround(el->end_extensions.v * state.scaling);
-                if (start_extension == 0) {
-                    extension_scheme |= 0x04;
-                } else if (start_extension > 0 && (uint64_t)start_extension == half_width) {
-                    extension_scheme |= 0x08;
-                    start_extension = 0;
-                } else {
-                    extension_scheme |= 0x0C;
-                }
-                if (end_extension == 0) {
-                    extension_scheme |= 0x01;
-                } else if (end_extension > 0 && (uint64_t)end_extension == half_width) {
-                    extension_scheme |= 0x02;
-                    end_extension = 0;
-                } else {
-                    extension_scheme |= 0x03;
-                }
-                oasis_putc(extension_scheme, out);
-                if (start_extension != 0) oasis_write_integer(out, start_extension);
-                if (end_extension != 0) oasis_write_integer(out, end_extension);
-            } break;
-            case EndType::HalfWidth:
-                oasis_putc(0x0A, out);
-                break;
-            default:  // Flush
-                oasis_putc(0x05, out);
+        int64_t start_extension = 0;
+        int64_t end_extension = 0;
+        if (el->end_type == EndType::Extended) {
+            start_extension = (int64_t)llround(el->end_extensions.u * state.scaling);
+            end_extension = (int64_t)llround(el->end_extensions.v * state.scaling);
+        } else if (el->end_type == EndType::HalfWidth) {
+            start_extension = (int64_t)half_width;
+            end_extension = (int64_t)half_width;
         }
 
         ErrorCode err = element_center(el, point_array);
         if (err != ErrorCode::NoError) error_code = err;
 
-        oasis_write_point_list(out, point_array, state.scaling, false);
-        oasis_write_integer(out, (int64_t)llround(point_array[0].x * state.scaling));
-        oasis_write_integer(out, (int64_t)llround(point_array[0].y * state.scaling));
-        if (has_repetition) oasis_write_repetition(out, repetition, state.scaling);
+        oasis_write_path(out, state, el->tag, half_width, start_extension, end_extension,
+                         point_array, repetition);
         err = properties_to_oas(properties, out, state);
         if (err != ErrorCode::NoError) error_code = err;
 
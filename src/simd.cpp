@@ -0,0 +1,488 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+#define __STDC_FORMAT_MACROS 1
+#define _USE_MATH_DEFINES
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <gdstk/simd.hpp>
+#include <gdstk/vec.hpp>
+
+// Vectorized kernels are compiled with function-level target attributes (or,
+// with MSVC, directly, since its intrinsics do not depend on compiler flags)
+// and only called after checking the processor features at runtime.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GDSTK_SIMD_X86 1
+#define GDSTK_TARGET_AVX2 __attribute__((target("avx2")))
+#define GDSTK_TARGET_AVX512 __attribute__((target("avx512f")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define GDSTK_SIMD_X86 1
+#define GDSTK_TARGET_AVX2
+#define GDSTK_TARGET_AVX512
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// Smaller polygons always use the scalar kernels: they would not fill enough
+// vector blocks to pay for the dispatch.
+#define GDSTK_SIMD_MIN_POINTS 16
+
+// Keeps edge_determinant out of the vectorized kernels (where GCC would fuse
+// its products with FMA instructions) and disables contraction in its body.
+#if defined(__clang__)
+#define GDSTK_NO_FP_CONTRACT __attribute__((noinline))
+#elif defined(__GNUC__)
+#define GDSTK_NO_FP_CONTRACT __attribute__((noinline, optimize("fp-contract=off")))
+#elif defined(_MSC_VER)
+#define GDSTK_NO_FP_CONTRACT __declspec(noinline)
+#else
+#define GDSTK_NO_FP_CONTRACT
+#endif
+
+namespace gdstk {
+
+GDSTK_NO_FP_CONTRACT double edge_determinant(const Vec2 p0, const Vec2 p1, const Vec2 point) {
+#ifdef __clang__
+#pragma clang fp contract(off)
+#endif
+    const Vec2 v0 = p0 - point;
+    const Vec2 v1 = p1 - point;
+    const double a = v0.x * v1.y;
+    const double b = v0.y * v1.x;
+    return a - b;
+}
+
+static uint32_t bit_count(uint32_t bits) {
+    uint32_t result = 0;
+    for (; bits; bits &= bits - 1) result++;
+    return result;
+}
+
+#ifdef GDSTK_SIMD_X86
+
+#ifdef _MSC_VER
+// Check CPUID leaf 7 (EBX) for the feature bit and the OS support for the
+// register state in XCR0.
+static bool cpu_supports(uint32_t leaf7_ebx_bit, uint64_t xcr0_mask) {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0) return false;  // OSXSAVE
+    if ((_xgetbv(0) & xcr0_mask) != xcr0_mask) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << leaf7_ebx_bit)) != 0;
+}
+#endif
+
+static SimdLevel detect_simd_level() {
+#ifdef _MSC_VER
+    if (cpu_supports(16, 0xE6)) return SimdLevel::AVX512;
+    if (cpu_supports(5, 0x06)) return SimdLevel::AVX2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+#else
+
+static SimdLevel detect_simd_level() { return SimdLevel::Scalar; }
+
+#endif
+
+SimdLevel simd_supported_level() {
+    static const SimdLevel supported = detect_simd_level();
+    return supported;
+}
+
+// Negative until the first use
+static std::atomic<int> selected_simd_level{-1};
+
+SimdLevel simd_level() {
+    int level = selected_simd_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = (int)simd_supported_level();
+        selected_simd_level.store(level, std::memory_order_relaxed);
+    }
+    return (SimdLevel)level;
+}
+
+void set_simd_level(SimdLevel level) {
+    const SimdLevel supported = simd_supported_level();
+    if ((int)level > (int)supported) level = supported;
+    selected_simd_level.store((int)level, std::memory_order_relaxed);
+}
+
+// Scalar kernels.  The vectorized versions process blocks of edges
+// (p[i], p[i + 1]) and leave the remaining edges, including the closing one,
+// to these.
+
+// Edges from points[start] up to the closing edge
+static bool scalar_contain(const Vec2* points, uint64_t count, uint64_t start, const Vec2 point,
+                           int64_t& winding) {
+    Vec2 p0 = points[start];
+    for (uint64_t i = start + 1; i < count; i++) {
+        const Vec2 p1 = points[i];
+        if (!edge_winding(p0, p1, point, winding)) return true;
+        p0 = p1;
+    }
+    if (!edge_winding(p0, points[0], point, winding)) return true;
+    return winding != 0;
+}
+
+// Triangles (points[0], points[i], points[i + 1]) for i ≥ start
+static double scalar_signed_area(const Vec2* points, uint64_t count, uint64_t start) {
+    double result = 0;
+    const Vec2 v0 = points[0];
+    Vec2 v1 = points[start] - v0;
+    for (uint64_t i = start + 1; i < count; i++) {
+        const Vec2 v2 = points[i] - v0;
+        result += v1.cross(v2);
+        v1 = v2;
+    }
+    return result;
+}
+
+// Edges from points[start] up to the closing edge
+static double scalar_perimeter(const Vec2* points, uint64_t count, uint64_t start) {
+    double result = 0;
+    for (uint64_t i = start + 1; i < count; i++) {
+        result += (points[i] - points[i - 1]).length();
+    }
+    result += (points[0] - points[count - 1]).length();
+    return result;
+}
+
+static void scalar_bounding_box(const Vec2* points, uint64_t count, Vec2& min, Vec2& max) {
+    for (; count > 0; count--, points++) {
+        if (points->x < min.x) min.x = points->x;
+        if (points->x > max.x) max.x = points->x;
+        if (points->y < min.y) min.y = points->y;
+        if (points->y > max.y) max.y = points->y;
+    }
+}
+
+#ifdef GDSTK_SIMD_X86
+
+// AVX2 kernels: 4 edges per iteration.  All vectorized kernels clear the
+// upper register state before calling the scalar kernels, which avoids the
+// penalty of mixing VEX and legacy SSE instructions.
+
+// Load 4 consecutive points as separate x and y vectors
+GDSTK_TARGET_AVX2 static inline void load4(const Vec2* p, __m256d& x, __m256d& y) {
+    const __m256d a = _mm256_loadu_pd((const double*)p);
+    const __m256d b = _mm256_loadu_pd((const double*)(p + 2));
+    x = _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), 0xD8);
+    y = _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), 0xD8);
+}
+
+// Lanes are only classified here.  Edges with one end on each side of the
+// point that cross its horizontal line (at most a few per polygon) need the
+// sign of the determinant, which is left to edge_winding, so the results are
+// the same as with the scalar kernel.
+GDSTK_TARGET_AVX2 static bool avx2_contain(const Vec2* points, uint64_t count, const Vec2 point) {
+    const __m256d px = _mm256_set1_pd(point.x);
+    const __m256d py = _mm256_set1_pd(point.y);
+    int64_t winding = 0;
+    uint64_t i = 0;
+    for (; i + 4 < count; i += 4) {
+        __m256d x0, y0, x1, y1;
+        load4(points + i, x0, y0);
+        load4(points + i + 1, x1, y1);
+        const uint32_t ey1 = _mm256_movemask_pd(_mm256_cmp_pd(y1, py, _CMP_EQ_OQ));
+        const uint32_t gt1 = _mm256_movemask_pd(_mm256_cmp_pd(x1, px, _CMP_GT_OQ));
+        if (ey1) {
+            const uint32_t ex1 = _mm256_movemask_pd(_mm256_cmp_pd(x1, px, _CMP_EQ_OQ));
+            const uint32_t ey0 = _mm256_movemask_pd(_mm256_cmp_pd(y0, py, _CMP_EQ_OQ));
+            const uint32_t lt0 = _mm256_movemask_pd(_mm256_cmp_pd(x0, px, _CMP_LT_OQ));
+            if (ey1 & (ex1 | (ey0 & ~(gt1 ^ lt0)))) return true;
+        }
+        const uint32_t crossing = _mm256_movemask_pd(_mm256_cmp_pd(y0, py, _CMP_LT_OQ)) ^
+                                  _mm256_movemask_pd(_mm256_cmp_pd(y1, py, _CMP_LT_OQ));
+        if (crossing == 0) continue;
+        const uint32_t ge0 = _mm256_movemask_pd(_mm256_cmp_pd(x0, px, _CMP_GE_OQ));
+        const uint32_t up = _mm256_movemask_pd(_mm256_cmp_pd(y1, y0, _CMP_GT_OQ));
+        const uint32_t right = crossing & ge0 & gt1;
+        winding += (int64_t)bit_count(right & up) - (int64_t)bit_count(right & ~up);
+        for (uint32_t mixed = crossing & (ge0 ^ gt1); mixed; mixed &= mixed - 1) {
+            uint32_t lane = 0;
+            while (((mixed >> lane) & 1) == 0) lane++;
+            if (!edge_winding(points[i + lane], points[i + lane + 1], point, winding)) {
+                return true;
+            }
+        }
+    }
+    _mm256_zeroupper();
+    return scalar_contain(points, count, i, point, winding);
+}
+
+GDSTK_TARGET_AVX2 static double avx2_signed_area(const Vec2* points, uint64_t count) {
+    const __m256d v0 = _mm256_broadcast_pd((const __m128d*)points);
+    __m256d sum = _mm256_setzero_pd();
+    uint64_t i = 1;
+    for (; i + 4 < count; i += 4) {
+        const __m256d a1 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i)), v0);
+        const __m256d a2 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i + 2)), v0);
+        const __m256d b1 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i + 1)), v0);
+        const __m256d b2 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i + 3)), v0);
+        // (a.x * b.y, a.y * b.x) pairs, subtracted horizontally
+        const __m256d c1 = _mm256_mul_pd(a1, _mm256_permute_pd(b1, 0x5));
+        const __m256d c2 = _mm256_mul_pd(a2, _mm256_permute_pd(b2, 0x5));
+        sum = _mm256_add_pd(sum, _mm256_hsub_pd(c1, c2));
+    }
+    double partial[4];
+    _mm256_storeu_pd(partial, sum);
+    _mm256_zeroupper();
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]) +
+           scalar_signed_area(points, count, i);
+}
+
+GDSTK_TARGET_AVX2 static double avx2_perimeter(const Vec2* points, uint64_t count) {
+    __m256d sum = _mm256_setzero_pd();
+    uint64_t i = 0;
+    for (; i + 4 < count; i += 4) {
+        const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i + 1)),
+                                         _mm256_loadu_pd((const double*)(points + i)));
+        const __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd((const double*)(points + i + 3)),
+                                         _mm256_loadu_pd((const double*)(points + i + 2)));
+        const __m256d sq1 = _mm256_mul_pd(d1, d1);
+        const __m256d sq2 = _mm256_mul_pd(d2, d2);
+        // dx² + dy² for the 4 edges
+        const __m256d sq =
+            _mm256_add_pd(_mm256_unpacklo_pd(sq1, sq2), _mm256_unpackhi_pd(sq1, sq2));
+        sum = _mm256_add_pd(sum, _mm256_sqrt_pd(sq));
+    }
+    double partial[4];
+    _mm256_storeu_pd(partial, sum);
+    _mm256_zeroupper();
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]) +
+           scalar_perimeter(points, count, i);
+}
+
+GDSTK_TARGET_AVX2 static void avx2_bounding_box(const Vec2* points, uint64_t count, Vec2& min,
+                                                Vec2& max) {
+    __m256d lo = _mm256_set1_pd(DBL_MAX);
+    __m256d hi = _mm256_set1_pd(-DBL_MAX);
+    uint64_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d a = _mm256_loadu_pd((const double*)(points + i));
+        const __m256d b = _mm256_loadu_pd((const double*)(points + i + 2));
+        lo = _mm256_min_pd(_mm256_min_pd(a, b), lo);
+        hi = _mm256_max_pd(_mm256_max_pd(a, b), hi);
+    }
+    const __m128d lo2 = _mm_min_pd(_mm256_castpd256_pd128(lo), _mm256_extractf128_pd(lo, 1));
+    const __m128d hi2 = _mm_max_pd(_mm256_castpd256_pd128(hi), _mm256_extractf128_pd(hi, 1));
+    _mm_storeu_pd((double*)&min, lo2);
+    _mm_storeu_pd((double*)&max, hi2);
+    _mm256_zeroupper();
+    scalar_bounding_box(points + i, count - i, min, max);
+}
+
+// AVX-512 kernels: 8 edges per iteration
+
+// GCC 12 warns about the intentionally undefined registers used inside its
+// own AVX-512 intrinsics (GCC bug 105593).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+GDSTK_TARGET_AVX512 static inline void load8(const Vec2* p, __m512d& x, __m512d& y) {
+    const __m512i even = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m512i odd = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+    const __m512d a = _mm512_loadu_pd((const double*)p);
+    const __m512d b = _mm512_loadu_pd((const double*)(p + 4));
+    x = _mm512_permutex2var_pd(a, even, b);
+    y = _mm512_permutex2var_pd(a, odd, b);
+}
+
+// Same classification as avx2_contain
+GDSTK_TARGET_AVX512 static bool avx512_contain(const Vec2* points, uint64_t count,
+                                               const Vec2 point) {
+    const __m512d px = _mm512_set1_pd(point.x);
+    const __m512d py = _mm512_set1_pd(point.y);
+    int64_t winding = 0;
+    uint64_t i = 0;
+    for (; i + 8 < count; i += 8) {
+        __m512d x0, y0, x1, y1;
+        load8(points + i, x0, y0);
+        load8(points + i + 1, x1, y1);
+        const uint32_t ey1 = _mm512_cmp_pd_mask(y1, py, _CMP_EQ_OQ);
+        const uint32_t gt1 = _mm512_cmp_pd_mask(x1, px, _CMP_GT_OQ);
+        if (ey1) {
+            const uint32_t ex1 = _mm512_cmp_pd_mask(x1, px, _CMP_EQ_OQ);
+            const uint32_t ey0 = _mm512_cmp_pd_mask(y0, py, _CMP_EQ_OQ);
+            const uint32_t lt0 = _mm512_cmp_pd_mask(x0, px, _CMP_LT_OQ);
+            if (ey1 & (ex1 | (ey0 & ~(gt1 ^ lt0)))) return true;
+        }
+        const uint32_t crossing =
+            _mm512_cmp_pd_mask(y0, py, _CMP_LT_OQ) ^ _mm512_cmp_pd_mask(y1, py, _CMP_LT_OQ);
+        if (crossing == 0) continue;
+        const uint32_t ge0 = _mm512_cmp_pd_mask(x0, px, _CMP_GE_OQ);
+        const uint32_t up = _mm512_cmp_pd_mask(y1, y0, _CMP_GT_OQ);
+        const uint32_t right = crossing & ge0 & gt1;
+        winding += (int64_t)bit_count(right & up) - (int64_t)bit_count(right & ~up);
+        for (uint32_t mixed = crossing & (ge0 ^ gt1); mixed; mixed &= mixed - 1) {
+            uint32_t lane = 0;
+            while (((mixed >> lane) & 1) == 0) lane++;
+            if (!edge_winding(points[i + lane], points[i + lane + 1], point, winding)) {
+                return true;
+            }
+        }
+    }
+    _mm256_zeroupper();
+    return scalar_contain(points, count, i, point, winding);
+}
+
+GDSTK_TARGET_AVX512 static double avx512_signed_area(const Vec2* points, uint64_t count) {
+    const __m512d v0 = _mm512_broadcast_f64x4(_mm256_broadcast_pd((const __m128d*)points));
+    __m512d sum = _mm512_setzero_pd();
+    uint64_t i = 1;
+    for (; i + 4 < count; i += 4) {
+        const __m512d a = _mm512_sub_pd(_mm512_loadu_pd((const double*)(points + i)), v0);
+        const __m512d b = _mm512_sub_pd(_mm512_loadu_pd((const double*)(points + i + 1)), v0);
+        // (a.x * b.y, a.y * b.x) pairs: the cross products end up in the
+        // even lanes
+        const __m512d c = _mm512_mul_pd(a, _mm512_permute_pd(b, 0x55));
+        sum = _mm512_mask_add_pd(sum, 0x55, sum, _mm512_sub_pd(c, _mm512_permute_pd(c, 0x55)));
+    }
+    const double result = _mm512_reduce_add_pd(sum);
+    _mm256_zeroupper();
+    return result + scalar_signed_area(points, count, i);
+}
+
+GDSTK_TARGET_AVX512 static double avx512_perimeter(const Vec2* points, uint64_t count) {
+    __m512d sum = _mm512_setzero_pd();
+    uint64_t i = 0;
+    for (; i + 8 < count; i += 8) {
+        const __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd((const double*)(points + i + 1)),
+                                         _mm512_loadu_pd((const double*)(points + i)));
+        const __m512d d2 = _mm512_sub_pd(_mm512_loadu_pd((const double*)(points + i + 5)),
+                                         _mm512_loadu_pd((const double*)(points + i + 4)));
+        const __m512d sq1 = _mm512_mul_pd(d1, d1);
+        const __m512d sq2 = _mm512_mul_pd(d2, d2);
+        // dx² + dy² for the 8 edges
+        const __m512d sq =
+            _mm512_add_pd(_mm512_unpacklo_pd(sq1, sq2), _mm512_unpackhi_pd(sq1, sq2));
+        sum = _mm512_add_pd(sum, _mm512_sqrt_pd(sq));
+    }
+    const double result = _mm512_reduce_add_pd(sum);
+    _mm256_zeroupper();
+    return result + scalar_perimeter(points, count, i);
+}
+
+GDSTK_TARGET_AVX512 static void avx512_bounding_box(const Vec2* points, uint64_t count, Vec2& min,
+                                                    Vec2& max) {
+    __m512d lo = _mm512_set1_pd(DBL_MAX);
+    __m512d hi = _mm512_set1_pd(-DBL_MAX);
+    uint64_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m512d a = _mm512_loadu_pd((const double*)(points + i));
+        const __m512d b = _mm512_loadu_pd((const double*)(points + i + 4));
+        lo = _mm512_min_pd(_mm512_min_pd(a, b), lo);
+        hi = _mm512_max_pd(_mm512_max_pd(a, b), hi);
+    }
+    const __m256d lo4 = _mm256_min_pd(_mm512_castpd512_pd256(lo), _mm512_extractf64x4_pd(lo, 1));
+    const __m256d hi4 = _mm256_max_pd(_mm512_castpd512_pd256(hi), _mm512_extractf64x4_pd(hi, 1));
+    const __m128d lo2 = _mm_min_pd(_mm256_castpd256_pd128(lo4), _mm256_extractf128_pd(lo4, 1));
+    const __m128d hi2 = _mm_max_pd(_mm256_castpd256_pd128(hi4), _mm256_extractf128_pd(hi4, 1));
+    _mm_storeu_pd((double*)&min, lo2);
+    _mm_storeu_pd((double*)&max, hi2);
+    _mm256_zeroupper();
+    scalar_bounding_box(points + i, count - i, min, max);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+bool simd_contain(const Vec2* points, uint64_t count, const Vec2 point) {
+    if (count == 0) return false;
+    if (point == points[count - 1]) return true;
+#ifdef GDSTK_SIMD_X86
+    if (count >= GDSTK_SIMD_MIN_POINTS) {
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                return avx512_contain(points, count, point);
+            case SimdLevel::AVX2:
+                return avx2_contain(points, count, point);
+            default:
+                break;
+        }
+    }
+#endif
+    int64_t winding = 0;
+    return scalar_contain(points, count, 0, point, winding);
+}
+
+double simd_signed_area(const Vec2* points, uint64_t count) {
+    if (count < 3) return 0;
+#ifdef GDSTK_SIMD_X86
+    if (count >= GDSTK_SIMD_MIN_POINTS) {
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                return 0.5 * avx512_signed_area(points, count);
+            case SimdLevel::AVX2:
+                return 0.5 * avx2_signed_area(points, count);
+            default:
+                break;
+        }
+    }
+#endif
+    return 0.5 * scalar_signed_area(points, count, 1);
+}
+
+double simd_perimeter(const Vec2* points, uint64_t count) {
+    if (count == 0) return 0;
+#ifdef GDSTK_SIMD_X86
+    if (count >= GDSTK_SIMD_MIN_POINTS) {
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                return avx512_perimeter(points, count);
+            case SimdLevel::AVX2:
+                return avx2_perimeter(points, count);
+            default:
+                break;
+        }
+    }
+#endif
+    return scalar_perimeter(points, count, 0);
+}
+
+void simd_bounding_box(const Vec2* points, uint64_t count, Vec2& min, Vec2& max) {
+#ifdef GDSTK_SIMD_X86
+    if (count >= GDSTK_SIMD_MIN_POINTS) {
+        switch (simd_level()) {
+            case SimdLevel::AVX512:
+                avx512_bounding_box(points, count, min, max);
+                return;
+            case SimdLevel::AVX2:
+                avx2_bounding_box(points, count, min, max);
+                return;
+            default:
+                break;
+        }
+    }
+#endif
+    min.x = min.y = DBL_MAX;
+    max.x = max.y = -DBL_MAX;
+    scalar_bounding_box(points, count, min, max);
+}
+
+}  // namespace gdstk
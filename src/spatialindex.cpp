@@ -0,0 +1,213 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+#define __STDC_FORMAT_MACROS 1
+#define _USE_MATH_DEFINES
+
+#include <float.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <gdstk/sort.hpp>
+#include <gdstk/spatialindex.hpp>
+
+namespace gdstk {
+
+struct HilbertEntry {
+    uint64_t key;
+    uint64_t index;
+};
+
+static bool hilbert_entry_sorted(const HilbertEntry& a, const HilbertEntry& b) {
+    return a.key < b.key;
+}
+
+// Position of (x, y) along the Hilbert curve that fills a 2¹⁶ × 2¹⁶ grid.
+static uint64_t hilbert_key(uint32_t x, uint32_t y) {
+    uint64_t key = 0;
+    for (uint32_t s = 1 << 15; s > 0; s >>= 1) {
+        const uint32_t rx = (x & s) > 0 ? 1 : 0;
+        const uint32_t ry = (y & s) > 0 ? 1 : 0;
+        key += (uint64_t)s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            const uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+    return key;
+}
+
+void SpatialIndex::print(bool all) const {
+    printf("SpatialIndex <%p>, %" PRIu64 " items, %" PRIu64 " nodes, %svalid\n", this,
+           item_array.count, node_min.count, valid ? "" : "in");
+    if (all) {
+        const SpatialItem* item = item_array.items;
+        for (uint64_t i = 0; i < item_array.count; i++, item++) {
+            printf("Item[%" PRIu64 "] type %d, index %" PRIu64 ", (%lg, %lg) - (%lg, %lg)\n", i,
+                   (int)item->type, item->index, item->min.x, item->min.y, item->max.x,
+                   item->max.y);
+        }
+    }
+}
+
+void SpatialIndex::build(Array<SpatialItem>& items) {
+    clear();
+    item_array = items;
+    items.count = 0;
+    items.capacity = 0;
+    items.items = NULL;
+
+    const uint64_t count = item_array.count;
+    level_offsets.append(0);
+    valid = true;
+    if (count == 0) return;
+
+    Vec2 min = {DBL_MAX, DBL_MAX};
+    Vec2 max = {-DBL_MAX, -DBL_MAX};
+    SpatialItem* item = item_array.items;
+    for (uint64_t i = count; i > 0; i--, item++) {
+        const Vec2 center = 0.5 * (item->min + item->max);
+        if (center.x < min.x) min.x = center.x;
+        if (center.y < min.y) min.y = center.y;
+        if (center.x > max.x) max.x = center.x;
+        if (center.y > max.y) max.y = center.y;
+    }
+    const double sx = max.x > min.x ? 65535 / (max.x - min.x) : 0;
+    const double sy = max.y > min.y ? 65535 / (max.y - min.y) : 0;
+
+    Array<HilbertEntry> entries = {};
+    entries.ensure_slots(count);
+    item = item_array.items;
+    for (uint64_t i = 0; i < count; i++, item++) {
+        const Vec2 center = 0.5 * (item->min + item->max);
+        const uint32_t x = (uint32_t)((center.x - min.x) * sx);
+        const uint32_t y = (uint32_t)((center.y - min.y) * sy);
+        entries.append_unsafe(HilbertEntry{hilbert_key(x, y), i});
+    }
+    sort(entries, hilbert_entry_sorted);
+
+    Array<SpatialItem> sorted_items = {};
+    sorted_items.ensure_slots(count);
+    for (uint64_t i = 0; i < count; i++) {
+        sorted_items.append_unsafe(item_array[entries[i].index]);
+    }
+    entries.clear();
+    item_array.clear();
+    item_array = sorted_items;
+
+    // First level: nodes over the items
+    const uint64_t n = GDSTK_SPATIAL_INDEX_NODE_SIZE;
+    uint64_t parents = (count + n - 1) / n;
+    node_min.ensure_slots(parents + parents / (n - 1) + 1);
+    node_max.ensure_slots(parents + parents / (n - 1) + 1);
+    for (uint64_t i = 0; i < parents; i++) {
+        const uint64_t end = (i + 1) * n < count ? (i + 1) * n : count;
+        item = item_array.items + i * n;
+        Vec2 node_lo = item->min;
+        Vec2 node_hi = item->max;
+        for (uint64_t j = i * n + 1; j < end; j++) {
+            item++;
+            if (item->min.x < node_lo.x) node_lo.x = item->min.x;
+            if (item->min.y < node_lo.y) node_lo.y = item->min.y;
+            if (item->max.x > node_hi.x) node_hi.x = item->max.x;
+            if (item->max.y > node_hi.y) node_hi.y = item->max.y;
+        }
+        node_min.append(node_lo);
+        node_max.append(node_hi);
+    }
+    level_offsets.append(node_min.count);
+
+    // Upper levels until a single root remains
+    while (parents > 1) {
+        const uint64_t start = level_offsets[level_offsets.count - 2];
+        const uint64_t children = parents;
+        parents = (children + n - 1) / n;
+        for (uint64_t i = 0; i < parents; i++) {
+            const uint64_t end = (i + 1) * n < children ? (i + 1) * n : children;
+            Vec2 node_lo = node_min[start + i * n];
+            Vec2 node_hi = node_max[start + i * n];
+            for (uint64_t j = i * n + 1; j < end; j++) {
+                const Vec2 child_lo = node_min[start + j];
+                const Vec2 child_hi = node_max[start + j];
+                if (child_lo.x < node_lo.x) node_lo.x = child_lo.x;
+                if (child_lo.y < node_lo.y) node_lo.y = child_lo.y;
+                if (child_hi.x > node_hi.x) node_hi.x = child_hi.x;
+                if (child_hi.y > node_hi.y) node_hi.y = child_hi.y;
+            }
+            node_min.append(node_lo);
+            node_max.append(node_hi);
+        }
+        level_offsets.append(node_min.count);
+    }
+}
+
+void SpatialIndex::bounding_box(Vec2& min, Vec2& max) const {
+    if (node_min.count == 0) {
+        min.x = min.y = DBL_MAX;
+        max.x = max.y = -DBL_MAX;
+        return;
+    }
+    min = node_min[node_min.count - 1];
+    max = node_max[node_max.count - 1];
+}
+
+static bool boxes_intersect(const Vec2 min1, const Vec2 max1, const Vec2 min2, const Vec2 max2) {
+    return min1.x <= max2.x && min2.x <= max1.x && min1.y <= max2.y && min2.y <= max1.y;
+}
+
+// Visit the children of node (level, i), where level indexes level_offsets.
+// Returns false if the search was stopped by the callback.
+static bool query_node(const SpatialIndex& index, uint64_t level, uint64_t i, const Vec2 min,
+                       const Vec2 max, bool (*callback)(const SpatialItem&, void*), void* data) {
+    const uint64_t n = GDSTK_SPATIAL_INDEX_NODE_SIZE;
+    if (level == 0) {
+        const uint64_t count = index.item_array.count;
+        const uint64_t end = (i + 1) * n < count ? (i + 1) * n : count;
+        const SpatialItem* item = index.item_array.items + i * n;
+        for (uint64_t j = i * n; j < end; j++, item++) {
+            if (boxes_intersect(item->min, item->max, min, max) && !callback(*item, data)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    const uint64_t start = index.level_offsets[level - 1];
+    const uint64_t count = index.level_offsets[level] - start;
+    const uint64_t end = (i + 1) * n < count ? (i + 1) * n : count;
+    for (uint64_t j = i * n; j < end; j++) {
+        if (boxes_intersect(index.node_min[start + j], index.node_max[start + j], min, max) &&
+            !query_node(index, level - 1, j, min, max, callback, data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SpatialIndex::query(const Vec2 min, const Vec2 max,
+                         bool (*callback)(const SpatialItem& item, void* data), void* data) const {
+    if (node_min.count == 0) return;
+    const uint64_t root = node_min.count - 1;
+    if (!boxes_intersect(node_min[root], node_max[root], min, max)) return;
+    query_node(*this, level_offsets.count - 2, 0, min, max, callback, data);
+}
+
+static bool append_item(const SpatialItem& item, void* data) {
+    ((Array<SpatialItem>*)data)->append(item);
+    return true;
+}
+
+void SpatialIndex::query(const Vec2 min, const Vec2 max, Array<SpatialItem>& result) const {
+    query(min, max, append_item, &result);
+}
+
+}  // namespace gdstk
@@ -14,6 +14,9 @@ LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 #include <string.h>
 #include <time.h>
 
+#include <atomic>
+#include <thread>
+
 #include <gdstk/allocator.hpp>
 #include <gdstk/utils.hpp>
 #include <gdstk/vec.hpp>
@@ -69,6 +72,103 @@ bool is_multiple_of_pi_over_2(double angle, int64_t& m) {
     return false;
 }
 
+void cos_sin(double angle, double& c, double& s) {
+    int64_t m;
+    if (is_multiple_of_pi_over_2(angle, m)) {
+        switch (m & 3) {
+            case 0:
+                c = 1;
+                s = 0;
+                break;
+            case 1:
+                c = 0;
+                s = 1;
+                break;
+            case 2:
+                c = -1;
+                s = 0;
+                break;
+            case 3:
+                c = 0;
+                s = -1;
+        }
+        return;
+    }
+    c = cos(angle);
+    s = sin(angle);
+}
+
+// Kernel for rotations by quarter * π/2.  The orientation is fixed at compile
+// time so that the loop body has no branches.
+template <int quarter, bool x_reflection>
+static void transform_points_manhattan(Vec2* points, uint64_t count, double magnification,
+                                       const Vec2 translation) {
+    Vec2* p = points;
+    for (; count > 0; count--, p++) {
+        const double x = p->x * magnification;
+        const double y = x_reflection ? -p->y * magnification : p->y * magnification;
+        switch (quarter) {
+            case 0:
+                p->x = x + translation.x;
+                p->y = y + translation.y;
+                break;
+            case 1:
+                p->x = translation.x - y;
+                p->y = x + translation.y;
+                break;
+            case 2:
+                p->x = translation.x - x;
+                p->y = translation.y - y;
+                break;
+            case 3:
+                p->x = y + translation.x;
+                p->y = translation.y - x;
+        }
+    }
+}
+
+void transform_points(Vec2* points, uint64_t count, double magnification, bool x_reflection,
+                      double rotation, const Vec2 translation) {
+    int64_t m;
+    if (is_multiple_of_pi_over_2(rotation, m)) {
+        switch ((m & 3) * 2 + (x_reflection ? 1 : 0)) {
+            case 0:
+                transform_points_manhattan<0, false>(points, count, magnification, translation);
+                break;
+            case 1:
+                transform_points_manhattan<0, true>(points, count, magnification, translation);
+                break;
+            case 2:
+                transform_points_manhattan<1, false>(points, count, magnification, translation);
+                break;
+            case 3:
+                transform_points_manhattan<1, true>(points, count, magnification, translation);
+                break;
+            case 4:
+                transform_points_manhattan<2, false>(points, count, magnification, translation);
+                break;
+            case 5:
+                transform_points_manhattan<2, true>(points, count, magnification, translation);
+                break;
+            case 6:
+                transform_points_manhattan<3, false>(points, count, magnification, translation);
+                break;
+            case 7:
+                transform_points_manhattan<3, true>(points, count, magnification, translation);
+        }
+        return;
+    }
+    const double ca = cos(rotation);
+    const double sa = sin(rotation);
+    Vec2* p = points;
+    for (; count > 0; count--, p++) {
+        Vec2 q = *p * magnification;
+        if (x_reflection) q.y = -q.y;
+        p->x = q.x * ca - q.y * sa + translation.x;
+        p->y = q.x * sa + q.y * ca + translation.y;
+    }
+}
+
 uint64_t arc_num_points(double angle, double radius, double tolerance) {
     assert(radius > 0);
     assert(tolerance > 0);
@@ -651,6 +751,55 @@ tm* get_now(tm& result) {
     return &result;
 }
 
+uint32_t hardware_thread_count() {
+    uint32_t count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+struct ParallelForData {
+    std::atomic<uint64_t> next;
+    uint64_t count;
+    void (*function)(uint64_t, void*);
+    void* data;
+};
+
+static void parallel_for_worker(ParallelForData* pfd) {
+    for (uint64_t i = pfd->next++; i < pfd->count; i = pfd->next++) pfd->function(i, pfd->data);
+}
+
+void parallel_for(uint64_t count, uint32_t num_threads, void (*function)(uint64_t, void*),
+                  void* data) {
+    if (num_threads == 0) num_threads = hardware_thread_count();
+    if (num_threads > count) num_threads = (uint32_t)count;
+    if (num_threads <= 1) {
+        for (uint64_t i = 0; i < count; i++) function(i, data);
+        return;
+    }
+
+    ParallelForData pfd;
+    pfd.next = 0;
+    pfd.count = count;
+    pfd.function = function;
+    pfd.data = data;
+
+    Array<std::thread*> threads = {};
+    threads.ensure_slots(num_threads - 1);
+    for (uint32_t i = num_threads - 1; i > 0; i--) {
+        // If the system refuses to create more threads, we just use the ones we already have.
+        try {
+            threads.append_unsafe(new std::thread(parallel_for_worker, &pfd));
+        } catch (...) {
+            break;
+        }
+    }
+    parallel_for_worker(&pfd);
+    for (uint64_t i = 0; i < threads.count; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+    threads.clear();
+}
+
 // Kenneth Kelly's 22 colors of maximum contrast (minus B/W: "F2F3F4", "222222")
 const char* colors[] = {"F3C300", "875692", "F38400", "A1CAF1", "BE0032", "C2B280", "848482",
                         "008856", "E68FAC", "0067A5", "F99379", "604E97", "F6A600", "B3446C",
@@ -5,6 +5,9 @@
 # Boost Software License - Version 1.0.  See the accompanying
 # LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 
+import subprocess
+import sys
+
 import pytest
 import numpy
 import gdstk
@@ -192,6 +195,91 @@ def test_flatten(tree):
     assert len(c3.labels) == 12
 
 
+def test_flatten_transform_repetitions():
+    leaf = gdstk.Cell("LEAF")
+    rect = gdstk.rectangle((0, 0), (1, 2))
+    rect.repetition = gdstk.Repetition(columns=3, rows=1, spacing=(2, 0))
+    leaf.add(rect)
+    label = gdstk.Label("A", (0, 0))
+    label.repetition = gdstk.Repetition(2, 2, v1=(1, 1), v2=(0, 3))
+    leaf.add(label)
+    top = gdstk.Cell("TOP")
+    top.add(gdstk.Reference(leaf, (10, 0), rotation=numpy.pi / 2, magnification=2))
+
+    expected = sorted(tuple(p.bounding_box()) for p in top.get_polygons())
+    (polygon,) = top.get_polygons(apply_repetitions=False)
+    assert_close(polygon.repetition.v1, (0, 4))
+    result = [polygon] + polygon.apply_repetition()
+    assert_close(sorted(tuple(p.bounding_box()) for p in result), expected)
+
+    (label,) = top.get_labels(apply_repetitions=False)
+    assert_close(label.repetition.v1, (-2, 2))
+    assert_close(label.repetition.v2, (-6, 0))
+
+    parallel = top.copy("PARALLEL")
+    parallel.flatten(apply_repetitions=False, parallel=True)
+    assert_close(parallel.polygons[0].repetition.v1, (0, 4))
+    top.flatten(apply_repetitions=False)
+    assert_close(top.polygons[0].repetition.v1, (0, 4))
+    assert_close(top.labels[0].repetition.v1, (-2, 2))
+
+
+def test_flatten_keep_repetitions():
+    leaf = gdstk.Cell("LEAF")
+    leaf.add(gdstk.rectangle((0, 0), (1, 2)))
+    rect = gdstk.rectangle((2, 0), (3, 1), layer=1)
+    rect.repetition = gdstk.Repetition(columns=3, rows=1, spacing=(2, 0))
+    leaf.add(rect)
+    top = gdstk.Cell("TOP")
+    top.add(
+        gdstk.Reference(leaf, (10, 0), rotation=numpy.pi / 2, columns=10, rows=20, spacing=(20, 20))
+    )
+
+    expected = sorted(tuple(p.bounding_box()) for p in top.get_polygons())
+    polys = top.get_polygons(keep_repetitions=True)
+    assert len(polys) == 4
+    assert all(p.repetition.size == 200 for p in polys)
+    result = []
+    for p in polys:
+        result.extend(p.apply_repetition())
+        result.append(p)
+    assert len(result) == len(expected)
+    assert_close(sorted(tuple(p.bounding_box()) for p in result), expected)
+
+    with pytest.raises(ValueError):
+        top.flatten(parallel=True, keep_repetitions=True)
+    top.flatten(keep_repetitions=True)
+    assert len(top.references) == 0
+    assert len(top.polygons) == 4
+
+
+def test_extract_repetitions():
+    ref_cell = gdstk.Cell("REF")
+    cell = gdstk.Cell("CELL")
+    for i in range(4):
+        for j in range(3):
+            cell.add(gdstk.rectangle((2 * i, 3 * j), (2 * i + 1, 3 * j + 1)))
+            cell.add(gdstk.Reference(ref_cell, (10 + 5 * i, 4 * j)))
+    cell.add(gdstk.rectangle((0, 20), (1, 21), layer=1))
+    cell.add(gdstk.rectangle((3, 25), (4, 26), layer=1))
+    cell.add(gdstk.rectangle((7, 24), (8, 25), layer=1))
+    cell.add(gdstk.rectangle((0, 0), (1, 1), layer=2))
+    before = sorted(p.area() for p in cell.get_polygons())
+    bb = cell.bounding_box()
+
+    cell.extract_repetitions()
+    assert len(cell.polygons) == 3
+    assert len(cell.references) == 1
+    assert cell.polygons[0].repetition.size == 12
+    assert cell.polygons[0].repetition.spacing == pytest.approx((2, 3))
+    assert cell.polygons[1].repetition.size == 3
+    assert cell.polygons[2].repetition.size == 0
+    assert cell.references[0].repetition.size == 12
+    assert cell.references[0].repetition.spacing == pytest.approx((5, 4))
+    assert sorted(p.area() for p in cell.get_polygons()) == before
+    assert_close(cell.bounding_box(), bb)
+
+
 def test_bb(tree):
     c3, c2, c1 = tree
     assert_close(c3.bounding_box(), ((0, 0), (8, 4)))
@@ -277,6 +365,110 @@ def test_bb_robustpath_repetition():
     assert_close(c_ref.bounding_box(), ((a.real, b.imag - 4), (c.real, d.imag + 2)))
 
 
+def test_get_polygons_shared_cell():
+    leaf = gdstk.Cell("LEAF")
+    leaf.add(gdstk.rectangle((0, 0), (1, 2)))
+    leaf.add(gdstk.FlexPath([(0, 0), (3, 0), (3, 3)], 0.2, layer=1))
+    mid = gdstk.Cell("MID")
+    for i in range(5):
+        mid.add(gdstk.Reference(leaf, (5 * i, 0), rotation=i * 0.3, x_reflection=i % 2 == 1))
+    top = gdstk.Cell("TOP")
+    top.add(
+        gdstk.Reference(mid, magnification=2, columns=2, rows=1, spacing=(40, 0)),
+        gdstk.Reference(leaf, (-10, -10)),
+        gdstk.Reference(mid, (0, 20)),
+    )
+    for depth in (None, 1, 2):
+        polys = top.get_polygons(depth=depth)
+        expected = []
+        for ref in top.references:
+            expected.extend(ref.get_polygons(depth=None if depth is None else depth - 1))
+        assert len(polys) == len(expected)
+        for p1, p2 in zip(polys, expected):
+            assert p1.layer == p2.layer
+            assert_close(p1.points, p2.points)
+    assert len(top.get_polygons()) == 2 * 5 * 2 + 2 + 2 * 5
+
+
+def test_get_polygons_reference_chain():
+    leaf = gdstk.Cell("LEAF")
+    leaf.add(*[gdstk.rectangle((i, 0), (i + 0.5, 1), layer=i % 3) for i in range(10)])
+    top = leaf
+    for i in range(8):
+        cell = gdstk.Cell(f"CHAIN{i}")
+        cell.add(gdstk.Reference(top, (1, 1), rotation=0.1))
+        top = cell
+    polys = top.get_polygons()
+    expected = leaf.get_polygons()
+    for _ in range(8):
+        expected = [p.rotate(0.1).translate(1, 1) for p in expected]
+    assert len(polys) == len(expected)
+    for p1, p2 in zip(polys, expected):
+        assert p1.layer == p2.layer
+        assert_close(p1.points, p2.points)
+
+
+# Cells referenced only once must not be kept flattened until the end of the
+# call: flattening a chain of single references must take about as much
+# memory as flattening the leaf once.
+def test_flatten_reference_chain_memory():
+    pytest.importorskip("resource")
+    script = """
+import resource, gdstk
+leaf = gdstk.Cell("LEAF")
+leaf.add(*[gdstk.rectangle((i, 0), (i + 0.5, 1)) for i in range(100000)])
+top = leaf
+for i in range(8):
+    cell = gdstk.Cell(f"CHAIN{i}")
+    cell.add(gdstk.Reference(top, (1, 1), rotation=0.1))
+    top = cell
+m0 = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+top.flatten()
+m1 = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+single = gdstk.Cell("SINGLE")
+single.add(gdstk.Reference(leaf))
+single.flatten()
+m2 = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+print(m1 - m0, m2 - m1)
+"""
+    out = subprocess.run(
+        [sys.executable, "-c", script], capture_output=True, check=True, text=True
+    ).stdout
+    chain, single = (int(x) for x in out.split())
+    assert chain < 3 * max(single, 1)
+
+
+def test_get_polygons_parallel():
+    leaf = gdstk.Cell("LEAF")
+    leaf.add(gdstk.rectangle((0, 0), (1, 2), layer=1))
+    leaf.add(gdstk.FlexPath([(0, 0), (3, 0), (3, 3)], 0.2, layer=2))
+    mid = gdstk.Cell("MID")
+    mid.add(gdstk.regular_polygon((0, 0), 1, 6, layer=3))
+    for i in range(5):
+        mid.add(gdstk.Reference(leaf, (5 * i, 0), rotation=i * 0.3, x_reflection=i % 2 == 1))
+    top = gdstk.Cell("TOP")
+    top.add(
+        gdstk.rectangle((0, 0), (1, 1)),
+        gdstk.Reference(mid, magnification=2, columns=30, rows=20, spacing=(40, 40)),
+        gdstk.Reference(leaf, (-10, -10)),
+    )
+    for kwargs in ({}, {"depth": 1}, {"tags": [(1, 0), (3, 0)]}, {"include_paths": False}):
+        polys = top.get_polygons(parallel=True, **kwargs)
+        expected = top.get_polygons(**kwargs)
+        assert len(polys) == len(expected)
+        for p1, p2 in zip(polys, expected):
+            assert (p1.layer, p1.datatype) == (p2.layer, p2.datatype)
+            assert_close(p1.points, p2.points)
+
+    expected = top.copy("EXPECTED").flatten()
+    top.flatten(parallel=True)
+    assert len(top.references) == 0
+    assert len(top.polygons) == len(expected.polygons)
+    for p1, p2 in zip(top.polygons, expected.polygons):
+        assert_close(p1.points, p2.points)
+    assert len(top.paths) == len(expected.paths)
+
+
 def test_get_polygons_depth(tree):
     c3, c2, c1 = tree
     polys = c3.get_polygons()
@@ -303,6 +495,64 @@ def test_get_polygons_filter(tree):
     assert len(polys) == 0
 
 
+def test_get_polygons_tags(tree):
+    c3, c2, c1 = tree
+    with pytest.raises(ValueError):
+        _ = c3.get_polygons(layer=0, datatype=0, tags=[(1, 1)])
+    polys = c3.get_polygons(tags=[(0, 0), (1, 1)])
+    assert len(polys) == 12
+    polys = c3.get_polygons(tags=[(1, 1), (5, 5)])
+    assert len(polys) == 6
+    assert all((p.layer, p.datatype) == (1, 1) for p in polys)
+    polys = c3.get_polygons(tags=[])
+    assert len(polys) == 0
+    c1.add(gdstk.FlexPath([(0, 0), (1, 1)], [0.1, 0.1], layer=[0, 1], datatype=[2, 3]))
+    polys = c3.get_polygons(depth=1, tags=[(0, 0), (1, 3)])
+    assert len(polys) == 0
+    polys = c3.get_polygons(tags=[(0, 0), (1, 3)])
+    assert len(polys) == 12
+    paths = c3.get_paths(tags=[(1, 3), (1, 1)])
+    assert len(paths) == 6
+    assert paths[0].num_paths == 1
+    labels = c3.get_labels(tags=[(11, 0), (12, 0)])
+    assert len(labels) == 12
+    labels = c3.get_labels(depth=1, tags=[(11, 0), (12, 0)])
+    assert len(labels) == 6
+
+
+def test_query_region(tree):
+    c3, c2, c1 = tree
+    polys = c3.query_region((0, 0), (0.5, 0.5))
+    assert len(polys) == 1
+    assert_same_shape(polys[0], gdstk.Polygon(((0, 0), (0, 1), (1, 0))))
+    polys = c3.query_region((4.5, 3.5), (1.5, 0.5))
+    assert len(polys) == 6
+    polys = c3.query_region((4.5, 3.5), (1.5, 0.5), tags=[(1, 1)])
+    assert len(polys) == 4
+    assert all((p.layer, p.datatype) == (1, 1) for p in polys)
+    polys = c3.query_region((-1, -1), (10, 10), depth=1)
+    assert len(polys) == 6
+    polys = c3.query_region((20, 20), (30, 30))
+    assert len(polys) == 0
+    polys = c3.query_region((0, 0), (0.5, 0.5), clip=True)
+    assert len(polys) == 1
+    assert_same_shape(polys[0], gdstk.rectangle((0, 0), (0.5, 0.5)))
+    assert (polys[0].layer, polys[0].datatype) == (0, 0)
+
+    ref = gdstk.Reference(c2, (10, 0), rotation=numpy.pi / 2, columns=2, rows=2, spacing=(5, 5))
+    c4 = gdstk.Cell("query")
+    c4.add(ref)
+    expected = [
+        p
+        for p in c4.get_polygons()
+        if numpy.all(numpy.array(p.bounding_box()[0]) <= (10.5, 9))
+        and numpy.all(numpy.array(p.bounding_box()[1]) >= (9, 5))
+    ]
+    polys = c4.query_region((9, 5), (10.5, 9))
+    assert len(polys) == len(expected) > 0
+    assert sum(p.area() for p in polys) == pytest.approx(sum(p.area() for p in expected))
+
+
 def test_get_paths(tree):
     c3, c2, c1 = tree
     c1.add(gdstk.FlexPath([(0, 0), (1, 1)], [0.1, 0.1], layer=[0, 1], datatype=[2, 3]))
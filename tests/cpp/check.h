@@ -0,0 +1,37 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Shared by the C and C++ tests in this directory, which are all built into
+// a single program (see main.cpp).
+
+#ifndef GDSTK_TESTS_CHECK_H
+#define GDSTK_TESTS_CHECK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Record a failure of the running test, printing message, unless condition
+// holds.  Tests continue after failed checks.
+void check(int condition, const char* message);
+
+void test_lazy_loading(void);
+void test_visit_shapes(void);
+void test_spatial_index(void);
+void test_geometry_cache(void);
+void test_geometry_cache_c(void);
+void test_simd_levels(void);
+
+// Write the library used by test_geometry_cache to a GDSII file, for the C
+// test, which cannot build it through the C API.
+void write_geometry_cache_library(const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
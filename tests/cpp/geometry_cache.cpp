@@ -0,0 +1,137 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Library::update_geometry_cache must only recompute the cells marked as
+// modified (Cell::mark_modified) and their ancestors.
+
+#include <stdio.h>
+
+#include <gdstk/gdstk.hpp>
+
+#include "check.h"
+
+using namespace gdstk;
+
+// TOP -> MIDDLE -> LEAF (references) and OTHER.  Everything is allocated, so
+// that it can be freed with Library::free_all.
+static void build_library(Library& lib) {
+    lib.init("library", 1e-6, 1e-9);
+
+    Cell* leaf = (Cell*)allocate_clear(sizeof(Cell));
+    leaf->init("LEAF");
+    Polygon* leaf_poly = (Polygon*)allocate_clear(sizeof(Polygon));
+    *leaf_poly = rectangle(Vec2{0, 0}, Vec2{1, 1}, 0);
+    leaf->polygon_array.append(leaf_poly);
+    lib.cell_array.append(leaf);
+
+    Cell* middle = (Cell*)allocate_clear(sizeof(Cell));
+    middle->init("MIDDLE");
+    Reference* leaf_ref = (Reference*)allocate_clear(sizeof(Reference));
+    leaf_ref->init(leaf);
+    leaf_ref->origin = Vec2{10, 0};
+    leaf_ref->rotation = 0.5;
+    middle->reference_array.append(leaf_ref);
+    lib.cell_array.append(middle);
+
+    Cell* top = (Cell*)allocate_clear(sizeof(Cell));
+    top->init("TOP");
+    Reference* middle_ref = (Reference*)allocate_clear(sizeof(Reference));
+    middle_ref->init(middle);
+    middle_ref->origin = Vec2{0, 10};
+    middle_ref->magnification = 2;
+    top->reference_array.append(middle_ref);
+    lib.cell_array.append(top);
+
+    Cell* other = (Cell*)allocate_clear(sizeof(Cell));
+    other->init("OTHER");
+    Polygon* other_poly = (Polygon*)allocate_clear(sizeof(Polygon));
+    *other_poly = rectangle(Vec2{-1, -1}, Vec2{0, 0}, 0);
+    other->polygon_array.append(other_poly);
+    lib.cell_array.append(other);
+}
+
+void write_geometry_cache_library(const char* filename) {
+    Library lib = {};
+    build_library(lib);
+    lib.write_gds(filename, 0, NULL);
+    lib.free_all();
+}
+
+// Cached bounding box equals the one computed from scratch
+static bool cache_matches(const Library& lib, const Cell& cell) {
+    const GeometryInfo info = lib.geometry_cache.get(cell.name);
+    Vec2 min, max;
+    cell.bounding_box(min, max);
+    return info.bounding_box_valid && info.generation == cell.generation &&
+           info.bounding_box_min == min && info.bounding_box_max == max;
+}
+
+void test_geometry_cache(void) {
+    Library lib = {};
+    build_library(lib);
+    Cell& leaf = *lib.get_cell("LEAF");
+    Cell& middle = *lib.get_cell("MIDDLE");
+    Cell& top = *lib.get_cell("TOP");
+    Cell& other = *lib.get_cell("OTHER");
+
+    // Generations are assigned to unmarked cells by the first update
+    check(leaf.generation == 0, "initial generation");
+    lib.update_geometry_cache(false, 1);
+    check(leaf.generation > 0 && middle.generation > 0 && top.generation > 0 &&
+              other.generation > 0,
+          "generations assigned");
+    check(cache_matches(lib, leaf) && cache_matches(lib, middle) && cache_matches(lib, top) &&
+              cache_matches(lib, other),
+          "initial cache");
+
+    // Each mark gives a new, larger generation
+    const uint64_t leaf_generation = leaf.generation;
+    const uint64_t middle_generation = middle.generation;
+    const uint64_t top_generation = top.generation;
+    const uint64_t other_generation = other.generation;
+    leaf.polygon_array[0]->translate(Vec2{5, 5});
+    leaf.mark_modified();
+    check(leaf.generation > leaf_generation && leaf.generation > top_generation &&
+              leaf.generation > other_generation,
+          "generation bump");
+    check(middle.generation == middle_generation && top.generation == top_generation,
+          "ancestor generations unchanged");
+
+    // Replace the cached value of the unrelated cell: it must not be
+    // recomputed, while the modified cell and its ancestors must be.
+    GeometryInfo other_info = lib.geometry_cache.get(other.name);
+    other_info.bounding_box_min = Vec2{-100, -100};
+    lib.geometry_cache.set(other.name, other_info);
+    lib.update_geometry_cache(false, 1);
+    check(cache_matches(lib, leaf), "modified cell recomputed");
+    check(cache_matches(lib, middle) && cache_matches(lib, top), "ancestors recomputed");
+    check(lib.geometry_cache.get(other.name).bounding_box_min == Vec2{-100, -100},
+          "unrelated cell kept");
+
+    // Convex hulls are computed on demand for cached cells as well
+    lib.update_geometry_cache(true, 0);
+    Array<Vec2> hull = {};
+    top.convex_hull(hull);
+    const GeometryInfo top_info = lib.geometry_cache.get(top.name);
+    check(top_info.convex_hull_valid && top_info.convex_hull.count == hull.count,
+          "convex hull cached");
+    hull.clear();
+
+    // Modifications of the cell structure (here by flattening) are marked too
+    Array<Reference*> removed = {};
+    top.flatten(true, removed);
+    check(top.generation > leaf.generation, "flatten marks the cell");
+    lib.update_geometry_cache(false, 1);
+    check(cache_matches(lib, top), "flattened cell recomputed");
+
+    for (uint64_t i = 0; i < removed.count; i++) {
+        removed[i]->clear();
+        free_allocation(removed[i]);
+    }
+    removed.clear();
+    lib.free_all();
+}
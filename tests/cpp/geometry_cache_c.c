@@ -0,0 +1,115 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Library geometry cache through the C API: gdstk_library_update_geometry_cache
+// must match the bounding boxes computed from scratch, and update the
+// ancestors of cells marked as modified.
+
+#include <cell_c.h>
+#include <library_c.h>
+#include <math.h>
+#include <polygon_c.h>
+#include <reference_c.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+
+// Cached bounding box equals the one computed from scratch
+static int cache_matches(const struct GDSTK_Library* lib, const GDSTK_Cell* cell) {
+    struct GDSTK_Vec2 cached_min, cached_max, min, max;
+    if (!gdstk_library_get_cached_bounding_box(lib, gdstk_cell_get_name(cell), &cached_min,
+                                               &cached_max))
+        return 0;
+    gdstk_cell_get_bounding_box(cell, &min, &max);
+    return cached_min.x == min.x && cached_min.y == min.y && cached_max.x == max.x &&
+           cached_max.y == max.y;
+}
+
+// Move the first reference in cell along x
+static void move_reference(GDSTK_Cell* cell, double dx) {
+    GDSTK_Reference* reference = gdstk_array_get(gdstk_cell_get_references(cell), 0);
+    struct GDSTK_Vec2 origin;
+    gdstk_reference_get_origin(reference, &origin);
+    origin.x += dx;
+    gdstk_reference_set_origin(reference, &origin);
+}
+
+void test_geometry_cache_c(void) {
+    // TOP -> MIDDLE -> LEAF (references) and OTHER
+    write_geometry_cache_library("geometry_cache_c.gds");
+    GDSTK_ErrorCode err = GDSTK_NoError;
+    struct GDSTK_Library* lib =
+        gdstk_read_gds("geometry_cache_c.gds", 0, 1e-2, NULL, NULL, 0, 0, &err);
+    check(lib && err == GDSTK_NoError, "read library");
+    if (!lib) return;
+
+    // Library cells (not copies) are reached from the top level
+    GDSTK_Cell* top = NULL;
+    GDSTK_Cell* other = NULL;
+    struct GDSTK_Array cells = gdstk_array_create(0);
+    struct GDSTK_Array raw_cells = gdstk_array_create(0);
+    gdstk_library_get_top_level(lib, cells, raw_cells);
+    for (uint64_t i = 0; i < gdstk_array_count(cells); i++) {
+        GDSTK_Cell* cell = gdstk_array_get(cells, i);
+        if (strcmp(gdstk_cell_get_name(cell), "TOP") == 0) top = cell;
+        if (strcmp(gdstk_cell_get_name(cell), "OTHER") == 0) other = cell;
+    }
+    gdstk_array_free(cells);
+    gdstk_array_free(raw_cells);
+    check(top && other, "top level cells");
+    if (!top || !other) {
+        gdstk_library_free(lib);
+        return;
+    }
+    GDSTK_Cell* middle =
+        gdstk_reference_get_cell(gdstk_array_get(gdstk_cell_get_references(top), 0));
+    GDSTK_Cell* leaf =
+        gdstk_reference_get_cell(gdstk_array_get(gdstk_cell_get_references(middle), 0));
+
+    struct GDSTK_Vec2 min, max;
+    check(!gdstk_library_get_cached_bounding_box(lib, "TOP", &min, &max), "empty cache");
+
+    gdstk_library_update_geometry_cache(lib, 1, 0);
+    check(cache_matches(lib, leaf) && cache_matches(lib, middle) && cache_matches(lib, top) &&
+              cache_matches(lib, other),
+          "initial cache");
+    check(!gdstk_library_get_cached_bounding_box(lib, "MISSING", &min, &max), "missing cell");
+
+    struct GDSTK_Vec2 top_min, top_max, other_min, other_max;
+    gdstk_library_get_cached_bounding_box(lib, "TOP", &top_min, &top_max);
+    gdstk_library_get_cached_bounding_box(lib, "OTHER", &other_min, &other_max);
+
+    // Modified in place: MIDDLE must be marked, and TOP is updated as its
+    // ancestor.
+    move_reference(middle, 5);
+    gdstk_library_update_geometry_cache(lib, 0, 1);
+    gdstk_library_get_cached_bounding_box(lib, "TOP", &min, &max);
+    check(min.x == top_min.x && max.x == top_max.x, "unmarked changes are not seen");
+
+    gdstk_cell_mark_modified(middle);
+    gdstk_library_update_geometry_cache(lib, 0, 1);
+    check(cache_matches(lib, middle) && cache_matches(lib, top), "ancestors updated");
+    gdstk_library_get_cached_bounding_box(lib, "TOP", &min, &max);
+    check(fabs(min.x - top_min.x - 10) < 1e-12 && fabs(max.x - top_max.x - 10) < 1e-12,
+          "ancestor moved");
+    gdstk_library_get_cached_bounding_box(lib, "OTHER", &min, &max);
+    check(min.x == other_min.x && min.y == other_min.y && max.x == other_max.x &&
+              max.y == other_max.y,
+          "unrelated cell unchanged");
+
+    // Marking by name
+    move_reference(middle, -5);
+    check(gdstk_library_mark_cell_modified(lib, "MIDDLE"), "mark by name");
+    check(!gdstk_library_mark_cell_modified(lib, "MISSING"), "mark missing cell");
+    gdstk_library_update_geometry_cache(lib, 0, 1);
+    check(cache_matches(lib, middle) && cache_matches(lib, top), "ancestors updated by name");
+    gdstk_library_get_cached_bounding_box(lib, "TOP", &min, &max);
+    check(fabs(min.x - top_min.x) < 1e-12 && fabs(max.x - top_max.x) < 1e-12, "ancestor restored");
+
+    gdstk_library_free(lib);
+}
@@ -0,0 +1,181 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Lazy GDSII loading (GDSII_READ_CONFIG_LAZY): cells are only parsed when
+// first used, and the result must match an eager read of the same file.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <gdstk/gdstk.hpp>
+
+#include "check.h"
+
+using namespace gdstk;
+
+static bool same_polygons(const Array<Polygon*>& a, const Array<Polygon*>& b) {
+    if (a.count != b.count) return false;
+    for (uint64_t i = 0; i < a.count; i++) {
+        if (a[i]->tag != b[i]->tag || a[i]->point_array.count != b[i]->point_array.count)
+            return false;
+        if (memcmp(a[i]->point_array.items, b[i]->point_array.items,
+                   a[i]->point_array.count * sizeof(Vec2)) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void clear_polygons(Array<Polygon*>& polygons) {
+    for (uint64_t i = 0; i < polygons.count; i++) {
+        polygons[i]->clear();
+        free_allocation(polygons[i]);
+    }
+    polygons.clear();
+}
+
+static bool same_files(const char* filename1, const char* filename2) {
+    FILE* in1 = fopen(filename1, "rb");
+    FILE* in2 = fopen(filename2, "rb");
+    bool result = in1 && in2;
+    while (result) {
+        int c1 = fgetc(in1);
+        int c2 = fgetc(in2);
+        if (c1 != c2) result = false;
+        if (c1 == EOF) break;
+    }
+    if (in1) fclose(in1);
+    if (in2) fclose(in2);
+    return result;
+}
+
+void test_lazy_loading(void) {
+    char lib_name[] = "library";
+    Library lib = {.name = lib_name, .unit = 1e-6, .precision = 1e-9};
+
+    char leaf_name[] = "LEAF";
+    Cell leaf = {.name = leaf_name};
+    lib.cell_array.append(&leaf);
+    Polygon leaf_poly[] = {rectangle(Vec2{0, 0}, Vec2{1, 2}, make_tag(1, 0)),
+                           regular_polygon(Vec2{3, 1}, 1, 6, 0, make_tag(2, 0))};
+    leaf.polygon_array.append(leaf_poly);
+    leaf.polygon_array.append(leaf_poly + 1);
+    char text[] = "LABEL";
+    Label label = {.tag = make_tag(3, 0), .text = text, .magnification = 1};
+    leaf.label_array.append(&label);
+
+    char middle_name[] = "MIDDLE";
+    Cell middle = {.name = middle_name};
+    lib.cell_array.append(&middle);
+    Reference leaf_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &leaf,
+        .origin = Vec2{10, 0},
+        .rotation = M_PI / 2,
+        .magnification = 1,
+        .repetition = {RepetitionType::Rectangular, 3, 2, Vec2{5, 7}},
+    };
+    middle.reference_array.append(&leaf_ref);
+    Polygon middle_poly = rectangle(Vec2{-1, -1}, Vec2{0, 0}, make_tag(1, 0));
+    middle.polygon_array.append(&middle_poly);
+
+    char top_name[] = "TOP";
+    Cell top = {.name = top_name};
+    lib.cell_array.append(&top);
+    Reference middle_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &middle,
+        .origin = Vec2{0, 50},
+        .magnification = 2,
+        .x_reflection = true,
+    };
+    top.reference_array.append(&middle_ref);
+
+    lib.write_gds("lazy_loading.gds", 0, NULL);
+
+    ErrorCode error_code = ErrorCode::NoError;
+    Library eager = read_gds("lazy_loading.gds", 0, 1e-2, NULL, NULL, 0, &error_code);
+    check(error_code == ErrorCode::NoError, "eager read");
+    Library lazy = read_gds("lazy_loading.gds", 0, 1e-2, NULL, NULL, GDSII_READ_CONFIG_LAZY,
+                           &error_code);
+    check(error_code == ErrorCode::NoError, "lazy read");
+
+    check(lazy.cell_array.count == eager.cell_array.count, "cell count");
+    for (uint64_t i = 0; i < lazy.cell_array.count; i++) {
+        check(strcmp(lazy.cell_array[i]->name, eager.cell_array[i]->name) == 0, "cell names");
+        check(!lazy.cell_array[i]->is_loaded(), "cells start unloaded");
+    }
+
+    // Flattening loads the whole hierarchy under the cell on access
+    Cell* lazy_middle = NULL;
+    Cell* lazy_leaf = NULL;
+    Cell* lazy_top = NULL;
+    for (uint64_t i = 0; i < lazy.cell_array.count; i++) {
+        Cell* cell = lazy.cell_array[i];
+        if (strcmp(cell->name, middle_name) == 0) lazy_middle = cell;
+        if (strcmp(cell->name, leaf_name) == 0) lazy_leaf = cell;
+        if (strcmp(cell->name, top_name) == 0) lazy_top = cell;
+    }
+    check(lazy_middle && lazy_leaf && lazy_top, "cells found");
+    if (!lazy_middle || !lazy_leaf || !lazy_top) return;
+
+    // The hierarchy is known from the file index, without loading any cells
+    Array<Cell*> top_cells = {};
+    Array<RawCell*> top_rawcells = {};
+    lazy.top_level(top_cells, top_rawcells);
+    check(top_cells.count == 1 && top_cells[0] == lazy_top && top_rawcells.count == 0,
+          "top level");
+    Map<Cell*> dependencies = {};
+    lazy_top->get_dependencies(true, dependencies);
+    check(dependencies.count == 2 && dependencies.get(middle_name) == lazy_middle &&
+              dependencies.get(leaf_name) == lazy_leaf,
+          "dependencies");
+    for (uint64_t i = 0; i < lazy.cell_array.count; i++) {
+        check(!lazy.cell_array[i]->is_loaded(), "top_level and dependencies do not load");
+    }
+    top_cells.clear();
+    top_rawcells.clear();
+    dependencies.clear();
+
+    Array<Polygon*> lazy_polygons = {};
+    Array<Polygon*> eager_polygons = {};
+    lazy_middle->get_polygons(true, true, -1, false, 0, lazy_polygons);
+    check(lazy_middle->is_loaded() && lazy_leaf->is_loaded(), "get_polygons loads dependencies");
+    check(!lazy_top->is_loaded(), "unrelated cells stay unloaded");
+    eager.get_cell(middle_name)->get_polygons(true, true, -1, false, 0, eager_polygons);
+    check(lazy_polygons.count == 13, "flattened polygon count");
+    check(same_polygons(lazy_polygons, eager_polygons), "flattened polygons");
+    clear_polygons(lazy_polygons);
+    clear_polygons(eager_polygons);
+
+    // get_cell loads the requested cell
+    check(lazy.get_cell(top_name) == lazy_top && lazy_top->is_loaded(), "get_cell loads");
+    check(lazy_top->reference_array.count == 1 &&
+              lazy_top->reference_array[0]->cell == lazy_middle,
+          "references resolved to lazy cells");
+    lazy_top->get_polygons(true, true, -1, false, 0, lazy_polygons);
+    eager.get_cell(top_name)->get_polygons(true, true, -1, false, 0, eager_polygons);
+    check(same_polygons(lazy_polygons, eager_polygons), "flattened top polygons");
+    clear_polygons(lazy_polygons);
+    clear_polygons(eager_polygons);
+
+    check(lazy.load_all() == ErrorCode::NoError, "load_all");
+    lazy.write_gds("lazy_loading-lazy.gds", 0, NULL);
+    eager.write_gds("lazy_loading-eager.gds", 0, NULL);
+    check(same_files("lazy_loading-lazy.gds", "lazy_loading-eager.gds"), "written files");
+
+    lazy.free_all();
+    eager.free_all();
+    leaf_poly[0].clear();
+    leaf_poly[1].clear();
+    middle_poly.clear();
+    leaf.polygon_array.clear();
+    leaf.label_array.clear();
+    middle.polygon_array.clear();
+    middle.reference_array.clear();
+    top.reference_array.clear();
+    lib.cell_array.clear();
+}
@@ -0,0 +1,58 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Runs the tests named in the command line, or all of them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+
+struct Test {
+    const char* name;
+    void (*function)(void);
+};
+
+static const Test tests[] = {
+    {"lazy_loading", test_lazy_loading},
+    {"visit_shapes", test_visit_shapes},
+    {"spatial_index", test_spatial_index},
+    {"geometry_cache", test_geometry_cache},
+    {"geometry_cache_c", test_geometry_cache_c},
+    {"simd_levels", test_simd_levels},
+};
+
+static const char* running = NULL;
+static int failures = 0;
+
+void check(int condition, const char* message) {
+    if (!condition) {
+        fprintf(stderr, "FAILED (%s): %s\n", running, message);
+        failures++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const int num_tests = sizeof(tests) / sizeof(tests[0]);
+    for (int i = 0; i < num_tests; i++) {
+        bool selected = argc < 2;
+        for (int j = 1; j < argc && !selected; j++) selected = strcmp(argv[j], tests[i].name) == 0;
+        if (!selected) continue;
+        running = tests[i].name;
+        tests[i].function();
+    }
+    for (int j = 1; j < argc; j++) {
+        bool found = false;
+        for (int i = 0; i < num_tests && !found; i++) found = strcmp(argv[j], tests[i].name) == 0;
+        if (!found) {
+            fprintf(stderr, "Unknown test %s.\n", argv[j]);
+            failures++;
+        }
+    }
+    return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Point containment must give exactly the same results at every SimdLevel,
+// including points within rounding distance of the polygon boundary.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <gdstk/gdstk.hpp>
+
+#include "check.h"
+
+using namespace gdstk;
+
+// Deterministic pseudo-random numbers in [0, 1)
+static double next_random(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(state >> 11) / 9007199254740992.0;
+}
+
+void test_simd_levels(void) {
+    uint64_t state = 1;
+    const uint64_t count = 97;
+    Array<Vec2> vertices = {};
+    vertices.ensure_slots(count);
+    for (uint64_t i = 0; i < count; i++) {
+        const double angle = 2 * M_PI * i / count;
+        const double radius = 10.3 + 3.7 * next_random(state);
+        vertices.append_unsafe(Vec2{0.1 + radius * cos(angle), -0.7 + radius * sin(angle)});
+    }
+
+    // Points on the edges and their closest neighbors in x and y
+    Array<Vec2> points = {};
+    for (uint64_t i = 0; i < count; i++) {
+        const Vec2 p0 = vertices[i];
+        const Vec2 p1 = vertices[i + 1 < count ? i + 1 : 0];
+        for (int j = 0; j < 8; j++) {
+            const Vec2 p = p0 + (p1 - p0) * next_random(state);
+            points.append(p);
+            points.append(Vec2{nextafter(p.x, -INFINITY), p.y});
+            points.append(Vec2{nextafter(p.x, INFINITY), p.y});
+            points.append(Vec2{p.x, nextafter(p.y, -INFINITY)});
+            points.append(Vec2{p.x, nextafter(p.y, INFINITY)});
+        }
+    }
+
+    const SimdLevel supported = simd_supported_level();
+    printf("Supported SIMD level: %d\n", (int)supported);
+
+    Array<bool> expected = {};
+    expected.ensure_slots(points.count);
+    set_simd_level(SimdLevel::Scalar);
+    for (uint64_t i = 0; i < points.count; i++) {
+        expected.append_unsafe(simd_contain(vertices.items, vertices.count, points[i]));
+    }
+
+    const SimdLevel levels[] = {SimdLevel::AVX2, SimdLevel::AVX512};
+    for (uint64_t l = 0; l < COUNT(levels); l++) {
+        if (levels[l] > supported) continue;
+        set_simd_level(levels[l]);
+        for (uint64_t i = 0; i < points.count; i++) {
+            if (simd_contain(vertices.items, vertices.count, points[i]) != expected[i]) {
+                char message[128];
+                snprintf(message, COUNT(message), "level %d, point (%.17g, %.17g)",
+                         (int)levels[l], points[i].x, points[i].y);
+                check(false, message);
+            }
+        }
+    }
+    set_simd_level(supported);
+
+    vertices.clear();
+    points.clear();
+    expected.clear();
+}
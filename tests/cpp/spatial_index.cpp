@@ -0,0 +1,124 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Cell spatial indexes must be found out of date after any marked
+// modification of the cell or of the cells it depends on, so that region
+// queries never use stale indexes.
+
+#include <stdio.h>
+
+#include <gdstk/gdstk.hpp>
+
+#include "check.h"
+
+using namespace gdstk;
+
+static uint64_t query_count(const Cell& cell, const Vec2 corner1, const Vec2 corner2) {
+    Array<Polygon*> result = {};
+    cell.query_region(corner1, corner2, false, -1, NULL, false, 1e-3, result);
+    const uint64_t count = result.count;
+    for (uint64_t i = 0; i < result.count; i++) {
+        result[i]->clear();
+        free_allocation(result[i]);
+    }
+    result.clear();
+    return count;
+}
+
+void test_spatial_index(void) {
+    char leaf_name[] = "LEAF";
+    Cell leaf = {.name = leaf_name};
+    Polygon leaf_poly[] = {rectangle(Vec2{0, 0}, Vec2{1, 1}, 0),
+                           rectangle(Vec2{50, 50}, Vec2{51, 51}, 0)};
+    leaf.polygon_array.append(leaf_poly);
+    leaf.mark_modified();
+
+    char middle_name[] = "MIDDLE";
+    Cell middle = {.name = middle_name};
+    Reference leaf_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &leaf,
+        .origin = Vec2{10, 0},
+        .magnification = 1,
+    };
+    middle.reference_array.append(&leaf_ref);
+    middle.mark_modified();
+
+    char top_name[] = "TOP";
+    Cell top = {.name = top_name};
+    Reference middle_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &middle,
+        .origin = Vec2{0, 10},
+        .magnification = 1,
+    };
+    top.reference_array.append(&middle_ref);
+    Polygon top_poly = rectangle(Vec2{-5, -5}, Vec2{-4, -4}, 0);
+    top.polygon_array.append(&top_poly);
+    top.mark_modified();
+
+    top.get_spatial_index();
+    middle.get_spatial_index();
+    check(top.has_spatial_index() && middle.has_spatial_index(), "indexes built");
+    check(query_count(top, Vec2{9, 9}, Vec2{12, 12}) == 1, "query with index");
+
+    // A marked modification of a dependency (with the same element counts)
+    // invalidates the indexes of all its ancestors.
+    leaf_poly[0].translate(Vec2{30, 30});
+    leaf.mark_modified();
+    check(!top.has_spatial_index() && !middle.has_spatial_index(), "dependency moved");
+    check(query_count(top, Vec2{9, 9}, Vec2{12, 12}) == 0, "moved polygon left the region");
+    check(query_count(top, Vec2{39, 39}, Vec2{42, 42}) == 1, "moved polygon found");
+
+    // New elements in a dependency grow the bounding boxes of the references
+    // to it, so a stale index would miss them.
+    top.get_spatial_index();
+    middle.get_spatial_index();
+    check(top.has_spatial_index() && middle.has_spatial_index(), "indexes rebuilt");
+    leaf.polygon_array.append(leaf_poly + 1);
+    leaf.mark_modified();
+    check(!top.has_spatial_index() && !middle.has_spatial_index(), "dependency grew");
+    check(query_count(top, Vec2{59, 59}, Vec2{62, 62}) == 1, "new polygon found");
+
+    // Changes in the number of elements are detected even when not marked
+    top.get_spatial_index();
+    check(top.has_spatial_index(), "index rebuilt");
+    top.polygon_array.count--;
+    check(!top.has_spatial_index(), "element count changed");
+    top.polygon_array.count++;
+
+    // The cell itself
+    top.get_spatial_index();
+    top_poly.translate(Vec2{100, 0});
+    top.mark_modified();
+    check(!top.has_spatial_index(), "cell modified");
+    check(query_count(top, Vec2{95, -5}, Vec2{96, -4}) == 1, "modified polygon found");
+
+    // Explicit invalidation
+    top.get_spatial_index();
+    top.invalidate_spatial_index();
+    check(!top.has_spatial_index(), "index invalidated");
+
+    // Indexed and linear queries agree
+    top.get_spatial_index();
+    middle.get_spatial_index();
+    leaf.get_spatial_index();
+    const uint64_t indexed = query_count(top, Vec2{0, 0}, Vec2{100, 100});
+    top.invalidate_spatial_index();
+    middle.invalidate_spatial_index();
+    leaf.invalidate_spatial_index();
+    check(indexed == query_count(top, Vec2{0, 0}, Vec2{100, 100}) && indexed == 2,
+          "indexed and linear queries");
+
+    leaf_poly[0].clear();
+    leaf_poly[1].clear();
+    top_poly.clear();
+    leaf.name = middle.name = top.name = NULL;
+    leaf.clear();
+    middle.clear();
+    top.clear();
+}
@@ -0,0 +1,243 @@
+/*
+Copyright 2020 Lucas Heitzmann Gabrielli.
+This file is part of gdstk, distributed under the terms of the
+Boost Software License - Version 1.0.  See the accompanying
+LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
+*/
+
+// Cell::visit_shapes must visit the same geometry that get_polygons and
+// get_labels copy, for any depth, filter, repetitions and transformations.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <gdstk/gdstk.hpp>
+
+#include "check.h"
+
+using namespace gdstk;
+
+// Check including the arguments of the calls in the message
+static void check_call(bool condition, const char* message, int64_t depth, bool filter) {
+    if (condition) return;
+    char buffer[256];
+    snprintf(buffer, COUNT(buffer), "%s (depth %" PRId64 ", filter %d)", message, depth, filter);
+    check(false, buffer);
+}
+
+struct Visited {
+    Array<Array<Vec2>> polygons;
+    Array<Tag> polygon_tags;
+    Array<Vec2> label_origins;
+    Array<Tag> label_tags;
+    bool transform_points;
+    bool consistent_points;
+};
+
+static void visit_polygon(const Polygon& polygon, const AffineTransform& transform,
+                          const Array<Vec2>& points, void* data) {
+    Visited* visited = (Visited*)data;
+    // Transformed points must be the original vertices mapped by transform;
+    // otherwise points must be the original vertices themselves.
+    Array<Vec2> copy = {};
+    copy.ensure_slots(polygon.point_array.count);
+    for (uint64_t i = 0; i < polygon.point_array.count; i++) {
+        copy.append_unsafe(transform.apply(polygon.point_array[i]));
+    }
+    if (visited->transform_points) {
+        if (points.count != copy.count) visited->consistent_points = false;
+        for (uint64_t i = 0; i < points.count && i < copy.count; i++) {
+            if ((points[i] - copy[i]).length_sq() > 1e-20) visited->consistent_points = false;
+        }
+    } else if (&points != &polygon.point_array) {
+        visited->consistent_points = false;
+    }
+    visited->polygons.append(copy);
+    visited->polygon_tags.append(polygon.tag);
+}
+
+static void visit_label(const Label& label, const AffineTransform& transform, void* data) {
+    Visited* visited = (Visited*)data;
+    visited->label_origins.append(transform.apply(label.origin));
+    visited->label_tags.append(label.tag);
+}
+
+static bool same_points(const Array<Vec2>& a, const Array<Vec2>& b) {
+    if (a.count != b.count) return false;
+    for (uint64_t i = 0; i < a.count; i++) {
+        if ((a[i] - b[i]).length_sq() > 1e-20) return false;
+    }
+    return true;
+}
+
+// Every visited polygon must match a distinct polygon from get_polygons
+static bool match_polygons(const Visited& visited, const Array<Polygon*>& polygons) {
+    if (visited.polygons.count != polygons.count) return false;
+    Array<bool> used = {};
+    used.ensure_slots(polygons.count);
+    for (uint64_t i = 0; i < polygons.count; i++) used.append_unsafe(false);
+    bool result = true;
+    for (uint64_t i = 0; i < visited.polygons.count && result; i++) {
+        result = false;
+        for (uint64_t j = 0; j < polygons.count; j++) {
+            if (!used[j] && polygons[j]->tag == visited.polygon_tags[i] &&
+                same_points(visited.polygons[i], polygons[j]->point_array)) {
+                used[j] = true;
+                result = true;
+                break;
+            }
+        }
+    }
+    used.clear();
+    return result;
+}
+
+static bool match_labels(const Visited& visited, const Array<Label*>& labels) {
+    if (visited.label_origins.count != labels.count) return false;
+    Array<bool> used = {};
+    used.ensure_slots(labels.count);
+    for (uint64_t i = 0; i < labels.count; i++) used.append_unsafe(false);
+    bool result = true;
+    for (uint64_t i = 0; i < visited.label_origins.count && result; i++) {
+        result = false;
+        for (uint64_t j = 0; j < labels.count; j++) {
+            if (!used[j] && labels[j]->tag == visited.label_tags[i] &&
+                (labels[j]->origin - visited.label_origins[i]).length_sq() <= 1e-20) {
+                used[j] = true;
+                result = true;
+                break;
+            }
+        }
+    }
+    used.clear();
+    return result;
+}
+
+static void free_polygons(Array<Polygon*>& polygons) {
+    for (uint64_t i = 0; i < polygons.count; i++) {
+        polygons[i]->clear();
+        free_allocation(polygons[i]);
+    }
+    polygons.clear();
+}
+
+static void clear_visited(Visited& visited) {
+    for (uint64_t i = 0; i < visited.polygons.count; i++) visited.polygons[i].clear();
+    visited.polygons.clear();
+    visited.polygon_tags.clear();
+    visited.label_origins.clear();
+    visited.label_tags.clear();
+}
+
+void test_visit_shapes(void) {
+    char leaf_name[] = "LEAF";
+    Cell leaf = {.name = leaf_name};
+    Polygon leaf_poly[] = {rectangle(Vec2{0, 0}, Vec2{1, 2}, make_tag(1, 0)),
+                           regular_polygon(Vec2{3, 1}, 0.5, 5, 0.1, make_tag(2, 0))};
+    leaf_poly[0].repetition = {RepetitionType::Rectangular, 2, 3, Vec2{1.5, 2.5}};
+    leaf.polygon_array.append(leaf_poly);
+    leaf.polygon_array.append(leaf_poly + 1);
+    char text[] = "LEAF";
+    Label leaf_label = {.tag = make_tag(1, 0), .text = text, .origin = Vec2{0.5, 0.5},
+                        .magnification = 1};
+    leaf_label.repetition.type = RepetitionType::Regular;
+    leaf_label.repetition.columns = 2;
+    leaf_label.repetition.rows = 2;
+    leaf_label.repetition.v1 = Vec2{1, 1};
+    leaf_label.repetition.v2 = Vec2{0, 3};
+    leaf.label_array.append(&leaf_label);
+
+    char middle_name[] = "MIDDLE";
+    Cell middle = {.name = middle_name};
+    Reference leaf_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &leaf,
+        .origin = Vec2{10.25, -3},
+        .rotation = M_PI / 3,
+        .magnification = 1.5,
+        .x_reflection = true,
+        .repetition = {RepetitionType::Rectangular, 2, 2, Vec2{7, 9}},
+    };
+    middle.reference_array.append(&leaf_ref);
+    Polygon middle_poly = rectangle(Vec2{-1, -1}, Vec2{0, 0}, make_tag(2, 0));
+    middle.polygon_array.append(&middle_poly);
+
+    char top_name[] = "TOP";
+    Cell top = {.name = top_name};
+    Reference middle_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &middle,
+        .origin = Vec2{0, 50},
+        .rotation = -0.3,
+        .magnification = 2,
+    };
+    Vec2 offsets[] = {{0, 0}, {-20, 5}, {13, 17}};
+    middle_ref.repetition.type = RepetitionType::Explicit;
+    middle_ref.repetition.offsets.extend(Array<Vec2>{.count = 3, .items = offsets});
+    top.reference_array.append(&middle_ref);
+    Reference leaf_direct_ref = {
+        .type = ReferenceType::Cell,
+        .cell = &leaf,
+        .origin = Vec2{-5, -5},
+        .rotation = M_PI,
+        .magnification = 1,
+    };
+    top.reference_array.append(&leaf_direct_ref);
+    Polygon top_poly = regular_polygon(Vec2{0, 0}, 2, 3, 0, make_tag(1, 0));
+    top.polygon_array.append(&top_poly);
+
+    ShapeVisitor visitor = {};
+    visitor.polygon = visit_polygon;
+    visitor.label = visit_label;
+
+    for (int64_t depth = -1; depth <= 2; depth++) {
+        for (int f = 0; f < 2; f++) {
+            bool filter = f == 1;
+            Tag tag = make_tag(1, 0);
+            for (int t = 0; t < 2; t++) {
+                Visited visited = {.transform_points = t == 0, .consistent_points = true};
+                visitor.transform_points = visited.transform_points;
+                visitor.data = &visited;
+                top.visit_shapes(true, depth, filter, tag, visitor);
+                check_call(visited.consistent_points, "visited points", depth, filter);
+
+                Array<Polygon*> polygons = {};
+                top.get_polygons(true, false, depth, filter, tag, polygons);
+                check_call(match_polygons(visited, polygons), "polygons", depth, filter);
+                free_polygons(polygons);
+
+                Array<Label*> labels = {};
+                top.get_labels(true, depth, filter, tag, labels);
+                check_call(match_labels(visited, labels), "labels", depth, filter);
+                for (uint64_t i = 0; i < labels.count; i++) {
+                    labels[i]->clear();
+                    free_allocation(labels[i]);
+                }
+                labels.clear();
+                clear_visited(visited);
+
+                // Without applying repetitions, elements are visited once
+                // each, and only reference repetitions are expanded.
+                top.visit_shapes(false, depth, filter, tag, visitor);
+                top.get_polygons(false, false, depth, filter, tag, polygons);
+                check_call(match_polygons(visited, polygons), "polygons without repetitions",
+                           depth, filter);
+                free_polygons(polygons);
+                clear_visited(visited);
+            }
+        }
+    }
+
+    leaf_poly[0].clear();
+    leaf_poly[1].clear();
+    leaf_label.repetition.clear();
+    middle_poly.clear();
+    top_poly.clear();
+    middle_ref.repetition.clear();
+    leaf.polygon_array.clear();
+    leaf.label_array.clear();
+    middle.polygon_array.clear();
+    middle.reference_array.clear();
+    top.polygon_array.clear();
+    top.reference_array.clear();
+}
@@ -5,10 +5,31 @@
 # Boost Software License - Version 1.0.  See the accompanying
 # LICENSE file or <http://www.boost.org/LICENSE_1_0.txt>
 
+import numpy
 import pytest
 import gdstk
 
 
+# Sorted polygon vertices, each polygon starting at its lowest vertex, to
+# compare results independently of polygon order and starting vertex.
+# Polygons starting beyond max_x are left out.
+def canonical(polygons, max_x=None):
+    result = []
+    for polygon in polygons:
+        points = [tuple(p) for p in polygon.points]
+        if max_x is not None and points[0][0] > max_x:
+            continue
+        first = min(points)
+        result.append(
+            min(
+                tuple(points[i:] + points[:i])
+                for i in range(len(points))
+                if points[i] == first
+            )
+        )
+    return sorted(result)
+
+
 def test_inside():
     ring = gdstk.ellipse((0, 0), 1, inner_radius=0.5, tolerance=1e-3)
     circle = gdstk.ellipse((0, 0), 0.5, tolerance=1e-3)
@@ -45,3 +66,168 @@ def test_inside():
     ):
         assert gdstk.any_inside(pts, polys) == _any
         assert gdstk.all_inside(pts, polys) == _all
+
+
+@pytest.mark.parametrize("parallel", [False, True])
+def test_inside_indexed(parallel):
+    ring = gdstk.ellipse((0, 0), 1, inner_radius=0.5, tolerance=1e-4)
+    star = gdstk.Polygon([(2, 0), (3, 2), (4, 0), (2, 1.5), (4, 1.5)])
+    polys = [ring, star] + [
+        gdstk.rectangle((i, -3), (i + 0.5, -2.5)) for i in range(-2, 5)
+    ]
+    points = [(0.01 * i - 2.5, 0.01 * j - 3.5) for i in range(700) for j in range(600)]
+    points.extend(ring.points)
+    points.extend(star.points)
+    points.extend([(0.25, -2.75), (0.25, 5), (3, 1.5), (2.5, 1.5)])
+    truth = tuple(any(p.contain(pt) for p in polys) for pt in points)
+    assert gdstk.inside(points, polys, parallel=parallel) == truth
+    assert gdstk.all_inside(points, polys) == all(truth)
+    assert gdstk.any_inside(points, polys) == any(truth)
+    outside = [pt for pt, t in zip(points, truth) if not t]
+    assert not gdstk.any_inside(outside, polys)
+    inner = [pt for pt, t in zip(points, truth) if t]
+    assert gdstk.all_inside(inner, polys)
+
+
+@pytest.mark.parametrize("operation", ["or", "and", "xor", "not"])
+def test_boolean_parallel(operation):
+    rng = numpy.random.default_rng(0)
+    operands = []
+    for _ in range(2):
+        polys = []
+        for i, (x, y) in enumerate(rng.uniform(0, 200, (3000, 2))):
+            if i % 3 == 0:
+                polys.append(gdstk.regular_polygon((x, y), 0.8, 3 + i % 5, i))
+            else:
+                w, h = rng.uniform(0.2, 2, 2)
+                polys.append(gdstk.rectangle((x, y), (x + w, y + h)))
+        operands.append(polys)
+
+    serial = gdstk.boolean(*operands, operation)
+    parallel = gdstk.boolean(*operands, operation, parallel=True)
+    assert len(serial) > 0
+    assert canonical(parallel) == canonical(serial)
+
+
+# Local minima and intersections at the same height are processed in input
+# order (with enough of them that std::sort would not keep that order), so
+# the serial output is pinned independently of the standard library.
+def test_boolean_same_height_order():
+    diamonds = [
+        gdstk.Polygon([(2 * i, -1), (2 * i + 1, 0), (2 * i, 1), (2 * i - 1, 0)])
+        for i in range(17)
+    ]
+    expected = [(33 - 2 * i, 0) for i in range(17)]
+    result = gdstk.boolean(diamonds, [], "or")
+    assert [tuple(p.points[0]) for p in result] == expected
+    assert result[0].points.tolist() == [[33, 0], [32, 1], [31, 0], [32, -1]]
+    result = gdstk.offset(diamonds, 0)
+    assert [tuple(p.points[0]) for p in result] == expected
+
+
+# Abutting and overlapping rectangles on a grid: by default, the exact
+# polygons (order and starting vertices included) come from Clipper, even if
+# all inputs are rectilinear.
+def test_boolean_grid_rectangles():
+    rects = [
+        gdstk.rectangle((0, 0), (2, 1)),
+        gdstk.rectangle((2, 0), (4, 1)),
+        gdstk.rectangle((1, 1), (3, 3)),
+        gdstk.rectangle((3, 2), (5, 4)),
+        gdstk.rectangle((6, 0), (8, 2)),
+        gdstk.rectangle((6, 2), (7, 3)),
+    ]
+    clip = [gdstk.rectangle((1, 0), (7, 1)), gdstk.rectangle((4, 3), (6, 5))]
+    expected = {
+        "and": [
+            [[5, 4], [4, 4], [4, 3], [5, 3]],
+            [[1, 0], [4, 0], [4, 1], [1, 1]],
+            [[7, 1], [6, 1], [6, 0], [7, 0]],
+        ],
+        "not": [
+            [[3, 2], [5, 2], [5, 3], [4, 3], [4, 4]]
+            + [[3, 4], [3, 3], [1, 3], [1, 1], [3, 1]],
+            [[7, 1], [7, 0], [8, 0], [8, 2], [7, 2], [7, 3], [6, 3], [6, 1]],
+            [[1, 1], [0, 1], [0, 0], [1, 0]],
+        ],
+    }
+    for operation, polygons in expected.items():
+        for parallel in (False, True):
+            result = gdstk.boolean(rects, clip, operation, parallel=parallel)
+            assert [p.points.tolist() for p in result] == polygons
+
+    merged = [
+        [[0, 0], [4, 0], [4, 1], [3, 1], [3, 2], [5, 2]]
+        + [[5, 4], [3, 4], [3, 3], [1, 3], [1, 1], [0, 1]],
+        [[8, 0], [8, 2], [7, 2], [7, 3], [6, 3], [6, 0]],
+    ]
+    assert [p.points.tolist() for p in gdstk.boolean(rects, [], "or")] == merged
+    dilated = [
+        [[2.5, 4.5], [2.5, 3.5], [0.5, 3.5], [0.5, 1.5], [-0.5, 1.5], [-0.5, -0.5]]
+        + [[4.5, -0.5], [4.5, 1.5], [5.5, 1.5], [5.5, -0.5], [8.5, -0.5], [8.5, 2.5]]
+        + [[7.5, 2.5], [7.5, 3.5], [5.5, 3.5], [5.5, 4.5]],
+    ]
+    for use_union in (False, True):
+        result = gdstk.offset(rects, 0.5, use_union=use_union)
+        assert [p.points.tolist() for p in result] == dilated
+
+    # The rectilinear engine covers the same region with different polygons
+    rectilinear = gdstk.boolean(rects, [], "or", rectilinear=True)
+    assert canonical(rectilinear) == canonical(gdstk.boolean(rects, [], "or"))
+    assert [p.points.tolist() for p in rectilinear] != merged
+
+
+@pytest.mark.parametrize("operation", ["or", "and", "xor", "not"])
+def test_boolean_manhattan(operation):
+    rng = numpy.random.default_rng(1)
+    operands = []
+    for _ in range(2):
+        polys = []
+        for x, y, w, h in rng.uniform((0, 0, 0.5, 0.5), (50, 50, 8, 8), (300, 4)):
+            polys.append(gdstk.rectangle((x, y), (x + w, y + h)))
+        operands.append(polys)
+    # A distant triangle makes the rectilinear engine fall back to Clipper
+    triangle = gdstk.regular_polygon((1000, 1000), 1, 3)
+
+    rectilinear = gdstk.boolean(*operands, operation, 1e-6, rectilinear=True)
+    general = gdstk.boolean(*operands, operation, 1e-6)
+    assert len(rectilinear) > 0
+    assert canonical(rectilinear) == canonical(general)
+    fallback = gdstk.boolean(
+        operands[0] + [triangle], operands[1], operation, 1e-6, rectilinear=True
+    )
+    assert canonical(fallback, 500) == canonical(general)
+
+
+@pytest.mark.parametrize("join", ["miter", "bevel", "round"])
+@pytest.mark.parametrize("use_union", [False, True])
+def test_offset_parallel(join, use_union):
+    rng = numpy.random.default_rng(0)
+    polys = []
+    for i, (x, y) in enumerate(rng.uniform(0, 300, (5000, 2))):
+        if i % 3 == 0:
+            polys.append(gdstk.regular_polygon((x, y), 0.8, 3 + i % 5, i))
+        else:
+            w, h = rng.uniform(0.2, 2, 2)
+            polys.append(gdstk.rectangle((x, y), (x + w, y + h)))
+
+    for distance in (0.5, -0.1):
+        serial = gdstk.offset(polys, distance, join, use_union=use_union)
+        parallel = gdstk.offset(polys, distance, join, use_union=use_union, parallel=True)
+        assert len(serial) > 0
+        assert canonical(parallel) == canonical(serial)
+
+
+@pytest.mark.parametrize("distance", [0.3, -0.2])
+@pytest.mark.parametrize("use_union", [False, True])
+def test_offset_manhattan(distance, use_union):
+    rng = numpy.random.default_rng(1)
+    polys = []
+    for x, y, w, h in rng.uniform((0, 0, 0.5, 0.5), (50, 50, 8, 8), (300, 4)):
+        polys.append(gdstk.rectangle((x, y), (x + w, y + h)))
+    rectilinear = gdstk.offset(
+        polys, distance, use_union=use_union, precision=1e-6, rectilinear=True
+    )
+    general = gdstk.offset(polys, distance, use_union=use_union, precision=1e-6)
+    assert len(rectilinear) > 0
+    assert canonical(rectilinear) == canonical(general)
@@ -15,6 +15,8 @@ import pytest
 
 import gdstk
 
+from conftest import assert_close
+
 
 @pytest.fixture
 def tree():
@@ -239,6 +241,180 @@ def test_rw_gds_filter(tmpdir, sample_library):
     assert c.references[0].repetition.v2 == pytest.approx((0.0, 8.0))
 
 
+def test_rw_gds_memory_map(tmpdir, sample_library):
+    fname = str(tmpdir.join("test.gds"))
+    sample_library.write_gds(fname, max_points=20)
+    lib1 = gdstk.read_gds(fname, unit=1e-3)
+    lib2 = gdstk.read_gds(fname, unit=1e-3, memory_map=True)
+
+    assert lib2.name == lib1.name
+    cells1 = {c.name: c for c in lib1.cells}
+    cells2 = {c.name: c for c in lib2.cells}
+    assert set(cells2.keys()) == set(cells1.keys())
+    for name, c1 in cells1.items():
+        c2 = cells2[name]
+        assert len(c2.polygons) == len(c1.polygons)
+        for p1, p2 in zip(c1.polygons, c2.polygons):
+            assert p2.layer == p1.layer and p2.datatype == p1.datatype
+            assert numpy.array_equal(p2.points, p1.points)
+        assert len(c2.paths) == len(c1.paths)
+        assert [lbl.text for lbl in c2.labels] == [lbl.text for lbl in c1.labels]
+        assert [r.cell.name for r in c2.references] == [
+            r.cell.name for r in c1.references
+        ]
+
+
+def test_rw_gds_parallel(tmpdir, sample_library):
+    fname = str(tmpdir.join("test.gds"))
+    sample_library.write_gds(fname, max_points=20)
+    lib1 = gdstk.read_gds(fname, unit=1e-3)
+    lib2 = gdstk.read_gds(fname, unit=1e-3, parallel=True)
+
+    assert lib2.name == lib1.name
+    assert [c.name for c in lib2.cells] == [c.name for c in lib1.cells]
+    for c1, c2 in zip(lib1.cells, lib2.cells):
+        assert len(c2.polygons) == len(c1.polygons)
+        for p1, p2 in zip(c1.polygons, c2.polygons):
+            assert p2.layer == p1.layer and p2.datatype == p1.datatype
+            assert numpy.array_equal(p2.points, p1.points)
+        assert len(c2.paths) == len(c1.paths)
+        assert [lbl.text for lbl in c2.labels] == [lbl.text for lbl in c1.labels]
+        assert [r.cell.name for r in c2.references] == [
+            r.cell.name for r in c1.references
+        ]
+        for r1, r2 in zip(c1.references, c2.references):
+            assert r2.cell is lib2[r1.cell.name]
+
+
+@pytest.mark.parametrize("compression_level", [0, 6])
+def test_write_oas_parallel(tmpdir, sample_library, compression_level):
+    fname1 = str(tmpdir.join("test1.oas"))
+    fname2 = str(tmpdir.join("test2.oas"))
+    sample_library.write_oas(
+        fname1, compression_level=compression_level, standard_properties=True
+    )
+    sample_library.write_oas(
+        fname2,
+        compression_level=compression_level,
+        standard_properties=True,
+        parallel=True,
+    )
+    with open(fname1, "rb") as f1, open(fname2, "rb") as f2:
+        assert f1.read() == f2.read()
+
+
+def test_write_oas_modal(tmpdir):
+    cell = gdstk.Cell("MODAL")
+    shape = gdstk.Polygon([(0, 0), (2, 0), (2, 3), (1, 1), (0, 3)], layer=1)
+    for i in range(100):
+        cell.add(shape.copy().translate(5 * i, 0))
+    for i in range(10):
+        cell.add(gdstk.rectangle((i, 0), (i + 1, 2), layer=i % 2, datatype=1))
+        cell.add(gdstk.Label("LBL", (i, 1), layer=2, texttype=i % 3))
+    lib = gdstk.Library()
+    lib.add(cell)
+    fname1 = str(tmpdir.join("test1.oas"))
+    fname2 = str(tmpdir.join("test2.oas"))
+    lib.write_oas(fname1, compression_level=0)
+    lib.write_oas(fname2, compression_level=0, sort_by_tag=True)
+    # Each polygon after the first only needs the record header and position
+    assert pathlib.Path(fname1).stat().st_size < 100 * 8 + 1024
+
+    cell1 = gdstk.read_oas(fname1).cells[0]
+    assert len(cell1.polygons) == len(cell.polygons)
+    for p1, p2 in zip(cell1.polygons, cell.polygons):
+        assert p1.layer == p2.layer and p1.datatype == p2.datatype
+        assert numpy.allclose(p1.points, p2.points)
+    assert [(lbl.layer, lbl.texttype, lbl.origin) for lbl in cell1.labels] == [
+        (lbl.layer, lbl.texttype, lbl.origin) for lbl in cell.labels
+    ]
+
+    cell2 = gdstk.read_oas(fname2).cells[0]
+    tags = [(p.layer, p.datatype) for p in cell2.polygons]
+    assert tags == sorted(tags, key=lambda t: (t[1], t[0]))
+    assert sorted(p.area() for p in cell2.polygons) == pytest.approx(
+        sorted(p.area() for p in cell.polygons)
+    )
+    assert [lbl.texttype for lbl in cell2.labels] == sorted(
+        lbl.texttype for lbl in cell.labels
+    )
+
+
+@pytest.mark.parametrize("ext", ["gds", "oas"])
+def test_write_extract_repetitions(tmpdir, ext):
+    ref_cell = gdstk.Cell("REF")
+    ref_cell.add(gdstk.rectangle((0, 0), (1, 1)))
+    cell = gdstk.Cell("MAIN")
+    for i in range(10):
+        cell.add(gdstk.regular_polygon((3 * i, 0), 1, 5))
+        cell.add(gdstk.Reference(ref_cell, (3 * i, 10)))
+    lib = gdstk.Library()
+    lib.add(cell, ref_cell)
+    fname1 = str(tmpdir.join("test1." + ext))
+    fname2 = str(tmpdir.join("test2." + ext))
+    if ext == "gds":
+        lib.write_gds(fname1)
+        lib.write_gds(fname2, extract_repetitions=True)
+        read = gdstk.read_gds
+    else:
+        lib.write_oas(fname1)
+        lib.write_oas(fname2, extract_repetitions=True)
+        read = gdstk.read_oas
+    assert len(cell.polygons) == 10 and len(cell.references) == 10
+    assert pathlib.Path(fname2).stat().st_size < pathlib.Path(fname1).stat().st_size
+
+    main = {c.name: c for c in read(fname2).cells}["MAIN"]
+    assert len(main.references) == 1
+    assert main.references[0].repetition.size == 10
+    assert len(main.polygons) == (10 if ext == "gds" else 1)
+    polygons = main.get_polygons()
+    assert len(polygons) == 20
+    original = {c.name: c for c in read(fname1).cells}["MAIN"]
+    assert sum(p.area() for p in polygons) == pytest.approx(
+        sum(p.area() for p in original.get_polygons())
+    )
+
+
+def test_rw_oas_parallel(tmpdir, sample_library):
+    fname = str(tmpdir.join("test.oas"))
+    sample_library.write_oas(fname, compression_level=6)
+    lib1 = gdstk.read_oas(fname, unit=1e-3)
+    lib2 = gdstk.read_oas(fname, unit=1e-3, parallel=True)
+
+    assert [c.name for c in lib2.cells] == [c.name for c in lib1.cells]
+    for c1, c2 in zip(lib1.cells, lib2.cells):
+        assert len(c2.polygons) == len(c1.polygons)
+        for p1, p2 in zip(c1.polygons, c2.polygons):
+            assert p2.layer == p1.layer and p2.datatype == p1.datatype
+            assert numpy.array_equal(p2.points, p1.points)
+        assert len(c2.paths) == len(c1.paths)
+        assert [lbl.text for lbl in c2.labels] == [lbl.text for lbl in c1.labels]
+        assert [r.cell.name for r in c2.references] == [
+            r.cell.name for r in c1.references
+        ]
+
+
+@pytest.mark.parametrize("ext", ["gds", "oas", "oas_offsets"])
+def test_read_cells(tmpdir, sample_library, ext):
+    fname = str(tmpdir.join("test." + ext[:3]))
+    read = gdstk.read_gds if ext == "gds" else gdstk.read_oas
+    if ext == "gds":
+        sample_library.write_gds(fname)
+    elif ext == "oas":
+        sample_library.write_oas(fname)
+    else:
+        # Cell offsets are used to read only the requested cells
+        sample_library.write_oas(fname, standard_properties=True)
+
+    lib = read(fname, cells=["gl_rw_gds_3"])
+    assert [c.name for c in lib.cells] == ["gl_rw_gds_1", "gl_rw_gds_3"]
+    assert lib["gl_rw_gds_3"].references[0].cell is lib["gl_rw_gds_1"]
+    assert len(lib["gl_rw_gds_1"].polygons) == 1
+
+    lib = read(fname, cells=[])
+    assert len(lib.cells) == 0
+
+
 def test_read_gds_missing_refs(tmpdir):
     c1 = gdstk.Cell("c1")
     c1.add(gdstk.rectangle((0, -1), (1, 2), 2, 4))
@@ -260,57 +436,62 @@ def test_read_gds_missing_refs(tmpdir):
     assert lib2.cells[0].name == "c2"
 
 
-# def test_rw_oas_filter(tmpdir, sample_library):
-#     fname = str(tmpdir.join("test.oas"))
-#     sample_library.write_oas(fname)
-#     library = gdstk.read_oas(fname, unit=1e-3, filter={(0, 0)})
-
-#     assert library.name == "LIB"
-#     assert len(library.cells) == 4
-#     cells = {c.name: c for c in library.cells}
-#     assert set(cells.keys()) == {
-#         "gl_rw_gds_1",
-#         "gl_rw_gds_2",
-#         "gl_rw_gds_3",
-#         "gl_rw_gds_4",
-#     }
-#     c = cells["gl_rw_gds_1"]
-#     assert len(c.polygons) == 0
-#     assert len(c.labels) == 1
-#     assert c.labels[0].text == "label"
-#     assert c.labels[0].origin[0] == 2 and c.labels[0].origin[1] == -2
-#     assert c.labels[0].anchor == "sw"
-#     assert c.labels[0].rotation == 0
-#     assert c.labels[0].magnification == 1
-#     assert c.labels[0].x_reflection == False
-#     assert c.labels[0].layer == 5
-#     assert c.labels[0].texttype == 6
-
-#     c = cells["gl_rw_gds_2"]
-#     assert len(c.polygons) == 1
-#     assert isinstance(c.polygons[0], gdstk.Polygon)
-
-#     c = cells["gl_rw_gds_3"]
-#     assert len(c.references) == 1
-#     assert isinstance(c.references[0], gdstk.Reference)
-#     assert c.references[0].cell == cells["gl_rw_gds_1"]
-#     assert c.references[0].origin[0] == 0 and c.references[0].origin[1] == 2
-#     assert c.references[0].rotation == -90
-#     assert c.references[0].magnification == 2
-#     assert c.references[0].x_reflection == True
-
-#     c = cells["gl_rw_gds_4"]
-#     assert len(c.references) == 1
-#     assert isinstance(c.references[0], gdstk.Reference)
-#     assert c.references[0].cell == cells["gl_rw_gds_2"]
-#     assert c.references[0].origin[0] == -2 and c.references[0].origin[1] == -4
-#     assert c.references[0].rotation == numpy.pi
-#     assert c.references[0].magnification == 0.5
-#     assert c.references[0].x_reflection == True
-#     assert c.references[0].repetition.columns == 2
-#     assert c.references[0].repetition.rows == 3
-#     assert c.references[0].repetition.v1 == (-2.0, 0.0)
-#     assert c.references[0].repetition.v2 == (0.0, 8.0)
+def test_rw_oas_filter(tmpdir, sample_library):
+    fname = str(tmpdir.join("test.oas"))
+    sample_library.write_oas(fname)
+    library = gdstk.read_oas(fname, unit=1e-3, filter={(0, 0)})
+
+    assert library.name == "LIB"
+    assert len(library.cells) == 4
+    cells = {c.name: c for c in library.cells}
+    assert set(cells.keys()) == {
+        "gl_rw_gds_1",
+        "gl_rw_gds_2",
+        "gl_rw_gds_3",
+        "gl_rw_gds_4",
+    }
+    c = cells["gl_rw_gds_1"]
+    assert len(c.polygons) == 0
+    assert len(c.labels) == 1
+    assert c.labels[0].text == "label"
+    assert c.labels[0].origin[0] == 2 and c.labels[0].origin[1] == -2
+    assert c.labels[0].anchor == "sw"
+    assert c.labels[0].rotation == 0
+    assert c.labels[0].magnification == 1
+    assert not c.labels[0].x_reflection
+    assert c.labels[0].layer == 5
+    assert c.labels[0].texttype == 6
+
+    c = cells["gl_rw_gds_2"]
+    assert len(c.polygons) == 1
+    assert isinstance(c.polygons[0], gdstk.Polygon)
+
+    c = cells["gl_rw_gds_3"]
+    assert len(c.references) == 1
+    assert isinstance(c.references[0], gdstk.Reference)
+    assert c.references[0].cell == cells["gl_rw_gds_1"]
+    assert c.references[0].origin[0] == 0 and c.references[0].origin[1] == 2
+    assert c.references[0].rotation == -90
+    assert c.references[0].magnification == 2
+    assert c.references[0].x_reflection
+
+    c = cells["gl_rw_gds_4"]
+    assert len(c.references) == 1
+    assert isinstance(c.references[0], gdstk.Reference)
+    assert c.references[0].cell == cells["gl_rw_gds_2"]
+    assert c.references[0].origin[0] == -2 and c.references[0].origin[1] == -4
+    assert c.references[0].rotation == numpy.pi
+    assert c.references[0].magnification == 0.5
+    assert c.references[0].x_reflection
+    assert c.references[0].repetition.columns == 2
+    assert c.references[0].repetition.rows == 3
+    assert c.references[0].repetition.v1 == (-2.0, 0.0)
+    assert c.references[0].repetition.v2 == (0.0, 8.0)
+
+    library = gdstk.read_oas(fname, filter=[], label_filter={(5, 1)})
+    cells = {c.name: c for c in library.cells}
+    assert all(len(c.polygons) == len(c.labels) == 0 for c in library.cells)
+    assert len(cells["gl_rw_gds_3"].references) == 1
 
 
 def test_rw_oas(tmpdir, sample_library):
@@ -463,6 +644,70 @@ def test_layers_and_types(sample_library):
     assert lt == {(5, 6)}
 
 
+@pytest.mark.parametrize("parallel", [False, True])
+def test_bounding_boxes_and_convex_hulls(sample_library, parallel):
+    c5 = gdstk.Cell("gl_rw_gds_5")
+    c5.add(gdstk.Reference(sample_library["gl_rw_gds_3"], (3, 0), rotation=0.3))
+    c5.add(gdstk.Reference(sample_library["gl_rw_gds_4"], (0, 5), rotation=numpy.pi / 2))
+    sample_library.add(c5, gdstk.Cell("empty"))
+
+    bbs = sample_library.bounding_boxes(parallel=parallel)
+    assert set(bbs) == {cell.name for cell in sample_library.cells}
+    assert bbs["empty"] is None
+    for cell in sample_library.cells:
+        if cell.name != "empty":
+            assert_close(bbs[cell.name], cell.bounding_box())
+
+    hulls = sample_library.convex_hulls(parallel=parallel)
+    assert set(hulls) == set(bbs)
+    assert hulls["empty"].shape == (0, 2)
+    for cell in sample_library.cells:
+        assert_close(hulls[cell.name], cell.convex_hull())
+
+
+def test_bounding_boxes_cache():
+    leaf = gdstk.Cell("LEAF")
+    rect = gdstk.rectangle((0, 0), (1, 1))
+    leaf.add(rect)
+    middle = gdstk.Cell("MIDDLE")
+    middle.add(gdstk.Reference(leaf, (10, 0)))
+    top = gdstk.Cell("TOP")
+    top.add(gdstk.Reference(middle, (0, 10), rotation=0.5))
+    other = gdstk.Cell("OTHER")
+    other.add(gdstk.rectangle((-1, -1), (0, 0)))
+    lib = gdstk.Library()
+    lib.add(leaf, middle, top, other)
+
+    def check(bbs):
+        assert set(bbs) == {cell.name for cell in lib.cells}
+        for cell in lib.cells:
+            assert_close(bbs[cell.name], cell.bounding_box())
+
+    check(lib.bounding_boxes())
+
+    # Changes propagate to the ancestors of the modified cell
+    leaf.add(gdstk.rectangle((5, 5), (6, 7)))
+    bbs = lib.bounding_boxes()
+    check(bbs)
+    assert_close(bbs["LEAF"], ((0, 0), (6, 7)))
+
+    # The cache is reused, so elements modified in place are only seen after
+    # mark_modified
+    rect.translate(-3, 0)
+    assert lib.bounding_boxes()["LEAF"] == ((0, 0), (6, 7))
+    assert leaf.mark_modified() is leaf
+    check(lib.bounding_boxes())
+    assert_close(lib.bounding_boxes()["LEAF"], ((-3, 0), (6, 7)))
+
+    hulls = lib.convex_hulls(parallel=True)
+    for cell in lib.cells:
+        assert_close(hulls[cell.name], cell.convex_hull())
+
+    # Cells removed from the library are left out
+    lib.remove(other)
+    assert set(lib.bounding_boxes()) == {"LEAF", "MIDDLE", "TOP"}
+
+
 def test_rename_cell():
     c1 = gdstk.Cell("C1")
     c2 = gdstk.Cell("C2")
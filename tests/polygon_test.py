@@ -80,6 +80,31 @@ def test_contain():
     assert r.contain_all(*pts[3]) == False
 
 
+@pytest.mark.parametrize("teeth", [2, 5, 1000])
+def test_comb_metrics(teeth):
+    # Teeth [2i, 2i + 1] × [1, 3] on top of a base [0, 2 teeth - 1] × [0, 1]
+    points = [(0, 0), (2 * teeth - 1, 0), (2 * teeth - 1, 3)]
+    for i in range(teeth - 1, 0, -1):
+        points.extend([(2 * i, 3), (2 * i, 1), (2 * i - 1, 1), (2 * i - 1, 3)])
+    points.append((0, 3))
+    comb = gdstk.Polygon(points)
+    assert comb.area() == 4 * teeth - 1
+    assert comb.perimeter() == 8 * teeth
+    assert comb.bounding_box() == ((0, 0), (2 * teeth - 1, 3))
+
+    inside = [(2 * i + 0.5, 2) for i in range(teeth)]
+    inside.extend((2 * i + 1.5, 0.5) for i in range(teeth - 1))
+    outside = [(2 * i + 1.5, 2) for i in range(teeth - 1)]
+    outside.extend([(-0.5, 2), (2 * teeth, 0.5)])
+    edges = [
+        (0.5 * (a[0] + b[0]), 0.5 * (a[1] + b[1])) for a, b in zip(points, points[1:])
+    ]
+    assert all(comb.contain(*inside))
+    assert not any(comb.contain(*outside))
+    assert all(comb.contain(*points))
+    assert all(comb.contain(*edges))
+
+
 def test_copy():
     points = [[-1, 0], [0, -2], [3, 0], [0, 4]]
     p1 = gdstk.Polygon(points, 5, 6)
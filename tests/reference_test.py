@@ -96,6 +96,42 @@ def test_label_bounding_box():
     assert_close(bb, ((x, y), (x, y)))
 
 
+@pytest.mark.parametrize("x_reflection", [False, True])
+@pytest.mark.parametrize("quarter", [-3, -2, -1, 1, 2, 3])
+def test_manhattan_rotation_exact(quarter, x_reflection):
+    c = gdstk.Cell("CELL")
+    c.add(gdstk.rectangle((1, 2), (4, 3)))
+    c.add(gdstk.Label("Label", (5, 7)))
+    ref = gdstk.Reference(
+        c,
+        (10, 20),
+        rotation=quarter * numpy.pi / 2,
+        x_reflection=x_reflection,
+        columns=2,
+        rows=3,
+        spacing=(10, 10),
+    )
+    ang = quarter * numpy.pi / 2
+    r = -1 if x_reflection else 1
+    ca = round(numpy.cos(ang))
+    sa = round(numpy.sin(ang))
+
+    def transform(p):
+        return (p[0] * ca - r * p[1] * sa + 10, p[0] * sa + r * p[1] * ca + 20)
+
+    polygons = ref.get_polygons()
+    assert len(polygons) == 6
+    pts = numpy.array(polygons[0].points)
+    assert numpy.array_equal(pts, numpy.round(pts))
+    assert sorted(map(tuple, pts)) == sorted(transform(p) for p in c.polygons[0].points)
+    (bb_min, bb_max) = ref.bounding_box()
+    assert numpy.array_equal(bb_min, numpy.round(bb_min))
+    assert numpy.array_equal(bb_max, numpy.round(bb_max))
+    for label in ref.get_labels():
+        assert label.origin == (round(label.origin[0]), round(label.origin[1]))
+    assert ref.get_labels()[0].origin == transform((5, 7))
+
+
 def _create_cell_reference(raw=False):
     if raw:
         c = gdstk.RawCell("CELL")